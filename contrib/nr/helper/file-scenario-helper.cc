@@ -21,35 +21,149 @@
 #include "file-scenario-helper.h"
 #include <ns3/core-module.h>
 #include <ns3/mobility-module.h>
+#include <ns3/csv-reader.h>
 
 #include <cmath>  // M_PI (but non-standard)
+#include <cstring>
+#include <fstream>
 #include <sstream>
 
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
 using namespace ns3;
 
 /** Unnamed namespace */
 namespace {
 
+/**
+ * \brief Header of a binary scenario file.
+ *
+ * The header is followed by numRecords position records (three doubles,
+ * X, Y and Z in meters) and, if FLAG_ATTRIBUTES is set, by numRecords
+ * FileScenarioHelper::UtTrafficAttributes records.
+ */
+struct BinaryScenarioHeader
+{
+  char m_magic[4];        //!< Always "NRSC"
+  uint16_t m_version;     //!< Format version
+  uint16_t m_flags;       //!< Combination of the FLAG_* values
+  uint32_t m_numRecords;  //!< Number of records
+  uint32_t m_reserved;    //!< Padding, keeps the positions 8-byte aligned
+};
+
+const char BINARY_SCENARIO_MAGIC[4] = {'N', 'R', 'S', 'C'};
+const uint16_t BINARY_SCENARIO_VERSION = 1;
+const uint16_t FLAG_UT_POSITIONS = 0x1;  //!< Records are UTs, not sites
+const uint16_t FLAG_ATTRIBUTES = 0x2;    //!< UT traffic attributes follow the positions
+
+static_assert (sizeof (BinaryScenarioHeader) == 16,
+               "Unexpected padding in BinaryScenarioHeader");
+static_assert (sizeof (FileScenarioHelper::UtTrafficAttributes) == 12,
+               "Unexpected padding in UtTrafficAttributes");
+
+/**
+ * \brief Read-only memory mapping of a whole file, unmapped on destruction.
+ */
+class MappedFile
+{
+public:
+  /**
+   * \brief Map the file
+   * \param filePath the file to map
+   */
+  explicit MappedFile (const std::string &filePath)
+  {
+    int fd = open (filePath.c_str (), O_RDONLY);
+    NS_ABORT_MSG_IF (fd < 0, "Can't open " << filePath);
+    struct stat st;
+    NS_ABORT_MSG_IF (fstat (fd, &st) != 0, "Can't stat " << filePath);
+    m_size = static_cast<std::size_t> (st.st_size);
+    if (m_size > 0)
+      {
+        m_data = mmap (nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        NS_ABORT_MSG_IF (m_data == MAP_FAILED, "Can't mmap " << filePath);
+        madvise (m_data, m_size, MADV_SEQUENTIAL);
+      }
+    close (fd);
+  }
+
+  ~MappedFile ()
+  {
+    if (m_data != nullptr)
+      {
+        munmap (m_data, m_size);
+      }
+  }
+
+  MappedFile (const MappedFile &) = delete;
+  MappedFile & operator = (const MappedFile &) = delete;
+
+  /**
+   * \return the beginning of the mapping
+   */
+  const uint8_t * Data () const
+  {
+    return static_cast<const uint8_t *> (m_data);
+  }
+
+  /**
+   * \return the size of the mapping, in bytes
+   */
+  std::size_t Size () const
+  {
+    return m_size;
+  }
+
+private:
+  void *m_data {nullptr};  //!< Mapped memory
+  std::size_t m_size {0};  //!< Size of the mapping
+};
+
+/**
+ * \brief Install a ConstantPositionMobilityModel on each node.
+ *
+ * Equivalent to MobilityHelper with a ListPositionAllocator, without
+ * copying the positions into the allocator one by one.
+ *
+ * \param nodes the nodes
+ * \param positions the positions, one per node
+ */
+static void
+InstallConstantPositions (const NodeContainer &nodes,
+                          const std::vector<Vector> &positions)
+{
+  NS_ASSERT (nodes.GetN () == positions.size ());
+  for (uint32_t i = 0; i < nodes.GetN (); ++i)
+    {
+      Ptr<ConstantPositionMobilityModel> mob = CreateObject<ConstantPositionMobilityModel> ();
+      mob->SetPosition (positions[i]);
+      nodes.Get (i)->AggregateObject (mob);
+    }
+}
+
 /**
  * \brief Creates a GNUPLOT with the deployment including base stations
  * (BS) and user terminals (UT). Positions and cell
  * radius must be given in meters
  *
  * \param sitePositioner Site position allocator
- * \param utPositioner Vector of user terminals positions
+ * \param utPositions Vector of user terminals positions
  * \param numSectors the plot deployment sector parameter
  * \param maxRadius the plot deployment max radius
  * \param effIsd the plot deployment ISD
  */
 static void
 PlotDeployment (const Ptr<const ListPositionAllocator> &sitePositioner,
-                const Ptr<const ListPositionAllocator> &utPositioner,
+                const std::vector<Vector> &utPositions,
                 const std::size_t numSectors,
                 const double maxRadius,
                 const double effIsd)
 {
   std::size_t numSites = sitePositioner->GetSize ();
-  std::size_t numUts = utPositioner->GetSize ();
+  std::size_t numUts = utPositions.size ();
   std::size_t numCells = numSites * numSectors;
   
   NS_ASSERT (numSites);
@@ -83,9 +197,8 @@ PlotDeployment (const Ptr<const ListPositionAllocator> &sitePositioner,
   /** \todo: Need to recalculate ranges if the scenario origin is different to (0,0) */
 
   // Plo the UEs first, so the sector arrows are on top
-  for (std::size_t utId = 0; utId < numUts; ++utId)
+  for (const auto &utPos : utPositions)
     {
-      Vector utPos = utPositioner->GetNext ();
       // set label at xPos, yPos, zPos "" point pointtype 7 pointsize 2
       topologyOutfile << "set label at " << utPos.x << " , " << utPos.y <<
           " point pointtype 7 pointsize 0.5 center" << std::endl;
@@ -158,6 +271,166 @@ FileScenarioHelper::Add (const std::string filePath,
   SetSitesNumber (numSites);
 }
 
+void
+FileScenarioHelper::AddBinary (const std::string filePath)
+{
+  MappedFile file (filePath);
+  NS_ABORT_MSG_IF (file.Size () < sizeof (BinaryScenarioHeader),
+                   filePath << " is too short to be a binary scenario file");
+
+  BinaryScenarioHeader header;
+  std::memcpy (&header, file.Data (), sizeof (header));
+  NS_ABORT_MSG_IF (std::memcmp (header.m_magic, BINARY_SCENARIO_MAGIC, 4) != 0,
+                   filePath << " is not a binary scenario file");
+  NS_ABORT_MSG_IF (header.m_version != BINARY_SCENARIO_VERSION,
+                   filePath << " has unsupported version " << header.m_version);
+
+  const std::size_t numRecords = header.m_numRecords;
+  const bool hasAttributes = header.m_flags & FLAG_ATTRIBUTES;
+  const std::size_t positionsSize = numRecords * 3 * sizeof (double);
+  const std::size_t attributesSize = hasAttributes ? numRecords * sizeof (UtTrafficAttributes) : 0;
+  NS_ABORT_MSG_IF (file.Size () < sizeof (header) + positionsSize + attributesSize,
+                   filePath << " is truncated: expected " << numRecords << " records");
+
+  const uint8_t *positions = file.Data () + sizeof (header);
+
+  if (! (header.m_flags & FLAG_UT_POSITIONS))
+    {
+      if (! m_bsPositioner)
+        {
+          m_bsPositioner = CreateObject<ListPositionAllocator> ();
+        }
+      for (std::size_t i = 0; i < numRecords; ++i)
+        {
+          double xyz[3];
+          std::memcpy (xyz, positions + i * sizeof (xyz), sizeof (xyz));
+          m_bsPositioner->Add (Vector (xyz[0], xyz[1], xyz[2]));
+        }
+      SetSitesNumber (m_bsPositioner->GetSize ());
+      return;
+    }
+
+  const std::size_t first = m_utPositions.size ();
+  m_utPositions.resize (first + numRecords);
+  for (std::size_t i = 0; i < numRecords; ++i)
+    {
+      double xyz[3];
+      std::memcpy (xyz, positions + i * sizeof (xyz), sizeof (xyz));
+      m_utPositions[first + i] = Vector (xyz[0], xyz[1], xyz[2]);
+    }
+
+  // Keep the attributes aligned with the positions, even when only some
+  // of the files carry them
+  if (hasAttributes || ! m_utAttributes.empty ())
+    {
+      m_utAttributes.resize (first);
+      m_utAttributes.resize (first + numRecords);
+      if (hasAttributes)
+        {
+          std::memcpy (m_utAttributes.data () + first, positions + positionsSize, attributesSize);
+        }
+    }
+
+  SetUtNumber (m_utPositions.size ());
+}
+
+std::size_t
+FileScenarioHelper::ConvertCsvToBinary (const std::string csvPath,
+                                        const std::string binaryPath,
+                                        bool utPositions,
+                                        char delimiter /* = ',' */)
+{
+  std::vector<double> positions;
+  std::vector<UtTrafficAttributes> attributes;
+  bool hasAttributes = false;
+
+  CsvReader csv (csvPath, delimiter);
+  while (csv.FetchNextRow ())
+    {
+      if (csv.IsBlankRow ())
+        {
+          continue;
+        }
+
+      double x = 0, y = 0, z = 0;
+      bool ok = csv.GetValue (0, x);
+      ok &= csv.GetValue (1, y);
+      NS_ABORT_MSG_UNLESS (ok, csvPath << ":" << csv.RowNumber () << " is missing X/Y");
+      if (csv.ColumnCount () > 2)
+        {
+          csv.GetValue (2, z);
+        }
+      positions.push_back (x);
+      positions.push_back (y);
+      positions.push_back (z);
+
+      UtTrafficAttributes attr;
+      if (utPositions && csv.ColumnCount () > 3)
+        {
+          uint32_t period = 0, urgency = 0;
+          csv.GetValue (3, period);
+          if (csv.ColumnCount () > 4)
+            {
+              csv.GetValue (4, attr.m_deadline);
+            }
+          if (csv.ColumnCount () > 5)
+            {
+              csv.GetValue (5, attr.m_packetSize);
+            }
+          if (csv.ColumnCount () > 6)
+            {
+              csv.GetValue (6, urgency);
+            }
+          NS_ABORT_MSG_IF (period > UINT8_MAX || urgency > UINT8_MAX,
+                           csvPath << ":" << csv.RowNumber () << " period or urgency out of range");
+          attr.m_cgPeriod = static_cast<uint8_t> (period);
+          attr.m_urgency = static_cast<uint8_t> (urgency);
+          hasAttributes = true;
+        }
+      attributes.push_back (attr);
+    }
+
+  BinaryScenarioHeader header;
+  std::memcpy (header.m_magic, BINARY_SCENARIO_MAGIC, 4);
+  header.m_version = BINARY_SCENARIO_VERSION;
+  header.m_flags = (utPositions ? FLAG_UT_POSITIONS : 0) | (hasAttributes ? FLAG_ATTRIBUTES : 0);
+  header.m_numRecords = static_cast<uint32_t> (attributes.size ());
+  header.m_reserved = 0;
+
+  std::ofstream out (binaryPath.c_str (), std::ios_base::out | std::ios_base::binary | std::ios_base::trunc);
+  NS_ABORT_MSG_IF (! out.is_open (), "Can't open " << binaryPath);
+  out.write (reinterpret_cast<const char *> (&header), sizeof (header));
+  out.write (reinterpret_cast<const char *> (positions.data ()), positions.size () * sizeof (double));
+  if (hasAttributes)
+    {
+      out.write (reinterpret_cast<const char *> (attributes.data ()),
+                 attributes.size () * sizeof (UtTrafficAttributes));
+    }
+  NS_ABORT_MSG_IF (! out.good (), "Error writing " << binaryPath);
+
+  return attributes.size ();
+}
+
+const std::vector<Vector> &
+FileScenarioHelper::GetUtPositions () const
+{
+  return m_utPositions;
+}
+
+bool
+FileScenarioHelper::HasUtTrafficAttributes () const
+{
+  return ! m_utAttributes.empty ();
+}
+
+const FileScenarioHelper::UtTrafficAttributes &
+FileScenarioHelper::GetUtTrafficAttributes (std::size_t utId) const
+{
+  NS_ASSERT_MSG (utId < m_utAttributes.size (),
+                 "No traffic attributes for UT " << utId);
+  return m_utAttributes[utId];
+}
+
 void
 FileScenarioHelper::CheckScenario (const char * where) const
 {
@@ -265,8 +538,24 @@ FileScenarioHelper::CreateScenario ()
   std::cout << effIsd << std::endl;
   
 
-  // Position the UEs uniformly in the sector annulus
   std::cout << "      UE positions" << std::endl;
+  double outerR = std::min (effIsd, m_isd);
+  if (! m_utPositions.empty ())
+    {
+      NS_ASSERT_MSG (m_utPositions.size () == m_numUt,
+                     "Loaded " << m_utPositions.size () << " UT positions, expected " << m_numUt);
+      std::cout << "        using " << m_utPositions.size () << " UT positions from file" << std::endl;
+      std::cout << "      UE mobility" << std::endl;
+      InstallConstantPositions (m_ut, m_utPositions);
+
+      std::cout << "      plot deployment" << std::endl;
+      PlotDeployment (m_bsPositioner, m_utPositions, sectors, maxRadius, outerR);
+
+      m_scenarioCreated = true;
+      return;
+    }
+
+  // Position the UEs uniformly in the sector annulus
   // equivalent for a hexagonal laydown:
   // between m_minBsUtDistance and m_isd / sqrt (3)
   std::cout << "        radius rng..." << std::flush;
@@ -274,7 +563,6 @@ FileScenarioHelper::CreateScenario ()
   std::cout << "setting stream..." << std::flush;
   r->SetStream (RngSeedManager::GetNextStreamIndex ());
   std::cout << "done" << std::endl;
-  const double outerR =std::min (effIsd, m_isd); // / std::sqrt(3);
   NS_ASSERT (m_minBsUtDistance < outerR);
   // Need to weight r to get uniform in the sector wedge
   // See https://stackoverflow.com/questions/5837572
@@ -289,7 +577,8 @@ FileScenarioHelper::CreateScenario ()
   theta->SetStream (RngSeedManager::GetNextStreamIndex ());
   std::cout << "done" << std::endl;
 
-  Ptr<ListPositionAllocator> utPositioner = CreateObject<ListPositionAllocator> ();;  
+  std::vector<Vector> utPositions;
+  utPositions.reserve (m_numUt);
   for (uint32_t utId = 0; utId < m_numUt; ++utId)
     {
       auto cellId = GetCellIndex (utId);
@@ -310,15 +599,14 @@ FileScenarioHelper::CreateScenario ()
       utPos.y += d * sin (t);
       utPos.z = m_utHeight;
       
-      utPositioner->Add (utPos);
+      utPositions.push_back (utPos);
     }
 
   std::cout << "      UE mobility" << std::endl;
-  mobility.SetPositionAllocator (utPositioner);
-  mobility.Install (m_ut);
+  InstallConstantPositions (m_ut, utPositions);
   
   std::cout << "      plot deployment" << std::endl;
-  PlotDeployment (m_bsPositioner, utPositioner, sectors, maxRadius, outerR);
+  PlotDeployment (m_bsPositioner, utPositions, sectors, maxRadius, outerR);
 
   m_scenarioCreated = true;
 }
@@ -25,6 +25,7 @@
 #include <ns3/ptr.h>
 #include <ns3/vector.h>
 
+#include <string>
 #include <vector>
 
 namespace ns3 {
@@ -39,12 +40,32 @@ class ListPositionAllocator;
  * First Add() the positions, then CreateScenario().
  * Most Get() functions won't be valid before those two steps.
  *
+ * For large deployments the positions can also be read from a compact
+ * binary file with AddBinary(), which is memory-mapped and copied in bulk.
+ * A binary file holds either site positions or user terminal positions;
+ * the latter can carry per-UE configured-grant traffic attributes
+ * (see UtTrafficAttributes). Binary files are produced once from a CSV
+ * file with ConvertCsvToBinary().
+ *
  * \todo Documentation, tests
  */
 class FileScenarioHelper : public NodeDistributionScenarioInterface
 {
 public:
 
+  /**
+   * \brief Per-UE traffic attributes that can be stored in a binary
+   * user terminal file, next to the UE position.
+   */
+  struct UtTrafficAttributes
+  {
+    uint8_t m_cgPeriod {0};    //!< Configured-grant period (ms)
+    uint8_t m_urgency {0};     //!< Packet urgency (0 means unspecified)
+    uint16_t m_reserved {0};   //!< Padding, keeps the record 4-byte aligned
+    uint32_t m_deadline {0};   //!< Packet deadline (us)
+    uint32_t m_packetSize {0}; //!< Packet size (bytes)
+  };
+
   /**
    * \brief ~FileScenarioHelper
    */
@@ -67,6 +88,60 @@ public:
    */
   void Add (const std::string filePath,
             char delimiter = ',');
+
+  /**
+   * \brief Add the positions stored in a binary scenario file.
+   *
+   * The file is memory-mapped and its records are copied in bulk. Site
+   * files append to the list of sites, exactly as Add() does; user terminal
+   * files append to the list of UT positions (and their traffic attributes,
+   * if present) and update the number of UTs accordingly. When UT positions
+   * have been loaded, CreateScenario() places the UTs there instead of
+   * dropping them randomly around the sites.
+   *
+   * \param [in] filePath The path to the binary file.
+   */
+  void AddBinary (const std::string filePath);
+
+  /**
+   * \brief Convert a CSV position file into the binary format read by
+   * AddBinary().
+   *
+   * Each CSV row holds X, Y and optionally Z (defaults to 0). For user
+   * terminal files, four more optional columns are read as the CG period
+   * (ms), the deadline (us), the packet size (bytes) and the urgency; if
+   * any row has them, the attributes are stored in the binary file.
+   *
+   * \param [in] csvPath The path to the input CSV file.
+   * \param [in] binaryPath The path to the output binary file.
+   * \param [in] utPositions true if the file lists user terminals,
+   *              false if it lists sites.
+   * \param [in] delimiter The delimiter character; see CsvReader.
+   * \return the number of records written
+   */
+  static std::size_t ConvertCsvToBinary (const std::string csvPath,
+                                         const std::string binaryPath,
+                                         bool utPositions,
+                                         char delimiter = ',');
+
+  /**
+   * \brief Get the UT positions loaded with AddBinary()
+   * \return the UT positions, in UT index order
+   */
+  const std::vector<Vector> & GetUtPositions () const;
+
+  /**
+   * \brief Check if the loaded UT file carried traffic attributes
+   * \return true if GetUtTrafficAttributes() can be called
+   */
+  bool HasUtTrafficAttributes () const;
+
+  /**
+   * \brief Get the traffic attributes of a UT
+   * \param utId the UT index
+   * \return the traffic attributes read from the binary file
+   */
+  const UtTrafficAttributes & GetUtTrafficAttributes (std::size_t utId) const;
   
   /**
    * \brief Get the site position corresponding to a given cell.
@@ -97,6 +172,9 @@ private:
    */
   Ptr<ListPositionAllocator> m_bsPositioner;
 
+  std::vector<Vector> m_utPositions; //!< UT positions read from binary files
+  std::vector<UtTrafficAttributes> m_utAttributes; //!< UT attributes read from binary files
+
 };
 
 } // namespace ns3
@@ -0,0 +1,423 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#include "nr-aoi-stats-calculator.h"
+
+#include <ns3/log.h>
+#include <ns3/abort.h>
+#include <ns3/string.h>
+#include <ns3/double.h>
+#include <ns3/simulator.h>
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NrAoiStatsCalculator");
+NS_OBJECT_ENSURE_REGISTERED (NrAoiStatsCalculator);
+
+NrAoiQuantileSketch::NrAoiQuantileSketch (double relativeAccuracy, double minValue, double maxValue)
+  : m_minValue (minValue)
+{
+  NS_ABORT_MSG_UNLESS (relativeAccuracy > 0.0 && relativeAccuracy < 1.0,
+                       "Relative accuracy must be in (0, 1)");
+  NS_ABORT_MSG_UNLESS (minValue > 0.0 && maxValue > minValue,
+                       "The range of the sketch must be 0 < min < max");
+  m_logGamma = std::log ((1.0 + relativeAccuracy) / (1.0 - relativeAccuracy));
+  m_bins.resize (static_cast<size_t> (std::ceil (std::log (maxValue / minValue) / m_logGamma)) + 1, 0);
+}
+
+void
+NrAoiQuantileSketch::Add (double value)
+{
+  size_t bin = 0;
+  if (value > m_minValue)
+    {
+      bin = std::min (static_cast<size_t> (std::ceil (std::log (value / m_minValue) / m_logGamma)),
+                      m_bins.size () - 1);
+    }
+  ++m_bins[bin];
+
+  if (m_count == 0)
+    {
+      m_min = value;
+      m_max = value;
+    }
+  else
+    {
+      m_min = std::min (m_min, value);
+      m_max = std::max (m_max, value);
+    }
+  ++m_count;
+}
+
+double
+NrAoiQuantileSketch::GetQuantile (double q) const
+{
+  NS_ASSERT (q >= 0.0 && q <= 1.0);
+  if (m_count == 0)
+    {
+      return 0.0;
+    }
+
+  // Rank of the quantile, starting from 0
+  double rank = q * (m_count - 1);
+  uint64_t cumulative = 0;
+  size_t bin = 0;
+  for (; bin < m_bins.size (); ++bin)
+    {
+      cumulative += m_bins[bin];
+      if (cumulative > rank)
+        {
+          break;
+        }
+    }
+
+  // The value in the middle of the bin, in relative terms, is within the
+  // relative accuracy from any value of the bin
+  double gamma = std::exp (m_logGamma);
+  double value = 2.0 * m_minValue * std::exp (bin * m_logGamma) / (gamma + 1.0);
+  return std::min (std::max (value, m_min), m_max);
+}
+
+uint64_t
+NrAoiQuantileSketch::GetCount () const
+{
+  return m_count;
+}
+
+void
+NrAoiQuantileSketch::Reset ()
+{
+  std::fill (m_bins.begin (), m_bins.end (), 0);
+  m_count = 0;
+  m_min = 0.0;
+  m_max = 0.0;
+}
+
+NrAoiStatsCalculator::AoiStats::AoiStats (double accuracy, double minValue, double maxValue)
+  : m_peakAoi (accuracy, minValue, maxValue),
+    m_delay (accuracy, minValue, maxValue)
+{
+}
+
+void
+NrAoiStatsCalculator::AoiStats::Reset ()
+{
+  m_updates = 0;
+  m_violations = 0;
+  m_aoiArea = 0.0;
+  m_observed = 0.0;
+  m_maxAoi = 0.0;
+  m_delaySum = 0.0;
+  m_peakAoi.Reset ();
+  m_delay.Reset ();
+}
+
+NrAoiStatsCalculator::AoiFlow::AoiFlow (double accuracy, double minValue, double maxValue)
+  : m_epoch (accuracy, minValue, maxValue),
+    m_total (accuracy, minValue, maxValue)
+{
+}
+
+NrAoiStatsCalculator::NrAoiStatsCalculator ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+NrAoiStatsCalculator::~NrAoiStatsCalculator ()
+{
+  NS_LOG_FUNCTION (this);
+}
+
+TypeId
+NrAoiStatsCalculator::GetTypeId (void)
+{
+  static TypeId tid =
+    TypeId ("ns3::NrAoiStatsCalculator")
+    .SetParent<Object> ()
+    .AddConstructor<NrAoiStatsCalculator> ()
+    .SetGroupName ("nr")
+    .AddAttribute ("StartTime", "Start time of the first epoch.",
+                   TimeValue (Seconds (0.)),
+                   MakeTimeAccessor (&NrAoiStatsCalculator::m_startTime),
+                   MakeTimeChecker ())
+    .AddAttribute ("EpochDuration",
+                   "Epoch duration. With 0, only the summary of the whole simulation is written.",
+                   TimeValue (Seconds (1.0)),
+                   MakeTimeAccessor (&NrAoiStatsCalculator::m_epochDuration),
+                   MakeTimeChecker ())
+    .AddAttribute ("Deadline",
+                   "Deadline of the packets, from their creation, unless set per UE.",
+                   TimeValue (MilliSeconds (10)),
+                   MakeTimeAccessor (&NrAoiStatsCalculator::m_defaultDeadline),
+                   MakeTimeChecker ())
+    .AddAttribute ("SketchAccuracy",
+                   "Relative accuracy of the AoI and delay percentiles.",
+                   DoubleValue (0.02),
+                   MakeDoubleAccessor (&NrAoiStatsCalculator::m_accuracy),
+                   MakeDoubleChecker<double> (0.0001, 0.5))
+    .AddAttribute ("SketchMinValue",
+                   "AoI and delay below this value are counted as this value in the percentiles.",
+                   TimeValue (MicroSeconds (10)),
+                   MakeTimeAccessor (&NrAoiStatsCalculator::m_sketchMin),
+                   MakeTimeChecker ())
+    .AddAttribute ("SketchMaxValue",
+                   "AoI and delay above this value are counted as this value in the percentiles.",
+                   TimeValue (Seconds (100)),
+                   MakeTimeAccessor (&NrAoiStatsCalculator::m_sketchMax),
+                   MakeTimeChecker ())
+    .AddAttribute ("OutputFilename",
+                   "Name of the file where the per-epoch results will be saved.",
+                   StringValue ("NrAoiStats.txt"),
+                   MakeStringAccessor (&NrAoiStatsCalculator::m_outputFilename),
+                   MakeStringChecker ())
+    .AddAttribute ("SummaryFilename",
+                   "Name of the file where the results of the whole simulation will be saved.",
+                   StringValue ("NrAoiStatsSummary.txt"),
+                   MakeStringAccessor (&NrAoiStatsCalculator::m_summaryFilename),
+                   MakeStringChecker ())
+  ;
+  return tid;
+}
+
+void
+NrAoiStatsCalculator::DoDispose ()
+{
+  NS_LOG_FUNCTION (this);
+  m_endEpochEvent.Cancel ();
+  if (m_started && !m_summaryWritten)
+    {
+      WriteSummary ();
+    }
+  Object::DoDispose ();
+}
+
+void
+NrAoiStatsCalculator::SetDeadline (uint16_t cellId, uint16_t rnti, const Time &deadline)
+{
+  NS_LOG_FUNCTION (this << cellId << rnti << deadline);
+  m_deadlines[(static_cast<uint32_t> (cellId) << 16) | rnti] = deadline;
+}
+
+Time
+NrAoiStatsCalculator::GetDeadline (uint16_t cellId, uint16_t rnti) const
+{
+  auto it = m_deadlines.find ((static_cast<uint32_t> (cellId) << 16) | rnti);
+  return it != m_deadlines.end () ? it->second : m_defaultDeadline;
+}
+
+uint64_t
+NrAoiStatsCalculator::GetFlowKey (uint16_t cellId, uint16_t rnti, uint8_t lcid)
+{
+  return (static_cast<uint64_t> (cellId) << 24) | (static_cast<uint64_t> (rnti) << 8) | lcid;
+}
+
+void
+NrAoiStatsCalculator::Integrate (AoiFlow *flow)
+{
+  // The AoI grows linearly between two updates: integrate the trapezoid
+  // from the last integration up to now
+  Time now = Simulator::Now ();
+  double from = (flow->m_lastIntegration - flow->m_lastCreation).GetSeconds ();
+  double to = (now - flow->m_lastCreation).GetSeconds ();
+  double duration = (now - flow->m_lastIntegration).GetSeconds ();
+
+  for (AoiStats *stats : {&flow->m_epoch, &flow->m_total})
+    {
+      stats->m_aoiArea += duration * (from + to) / 2.0;
+      stats->m_observed += duration;
+      stats->m_maxAoi = std::max (stats->m_maxAoi, to);
+    }
+  flow->m_lastIntegration = now;
+}
+
+void
+NrAoiStatsCalculator::AoiSample (uint16_t cellId, uint16_t rnti, uint8_t lcid, const Time &creationTime)
+{
+  NS_LOG_FUNCTION (this << cellId << rnti << static_cast<uint32_t> (lcid) << creationTime);
+
+  Time now = Simulator::Now ();
+
+  if (!m_started)
+    {
+      m_started = true;
+      m_epochStart = m_startTime;
+      if (m_epochDuration.IsStrictlyPositive ())
+        {
+          // First epoch end after now, on the epoch grid
+          while (m_epochStart + m_epochDuration <= now)
+            {
+              m_epochStart += m_epochDuration;
+            }
+          m_endEpochEvent = Simulator::Schedule (m_epochStart + m_epochDuration - now,
+                                                 &NrAoiStatsCalculator::EndEpoch, this);
+        }
+      // The summary is written even if the calculator outlives the simulation
+      Simulator::ScheduleDestroy (&NrAoiStatsCalculator::WriteSummary,
+                                  Ptr<NrAoiStatsCalculator> (this));
+    }
+
+  uint64_t key = GetFlowKey (cellId, rnti, lcid);
+  auto it = m_flows.find (key);
+  if (it == m_flows.end ())
+    {
+      it = m_flows.emplace (key, AoiFlow (m_accuracy, m_sketchMin.GetSeconds (),
+                                          m_sketchMax.GetSeconds ())).first;
+      it->second.m_lastCreation = creationTime;
+      it->second.m_lastIntegration = now;
+    }
+  AoiFlow &flow = it->second;
+
+  Integrate (&flow);
+
+  double delay = (now - creationTime).GetSeconds ();
+  bool violation = now - creationTime > GetDeadline (cellId, rnti);
+
+  // Only a packet fresher than the last one received updates the AoI
+  bool fresher = creationTime > flow.m_lastCreation;
+  double peakAoi = (now - flow.m_lastCreation).GetSeconds ();
+
+  for (AoiStats *stats : {&flow.m_epoch, &flow.m_total})
+    {
+      ++stats->m_updates;
+      stats->m_delaySum += delay;
+      stats->m_delay.Add (delay);
+      if (violation)
+        {
+          ++stats->m_violations;
+        }
+      if (fresher)
+        {
+          stats->m_peakAoi.Add (peakAoi);
+        }
+    }
+
+  if (fresher)
+    {
+      flow.m_lastCreation = creationTime;
+    }
+}
+
+void
+NrAoiStatsCalculator::AoiSampleCallback (Ptr<NrAoiStatsCalculator> aoiStats,
+                                         [[maybe_unused]] std::string path,
+                                         uint16_t cellId, uint16_t rnti, uint8_t lcid,
+                                         Time creationTime)
+{
+  aoiStats->AoiSample (cellId, rnti, lcid, creationTime);
+}
+
+void
+NrAoiStatsCalculator::EndEpoch ()
+{
+  NS_LOG_FUNCTION (this);
+
+  for (auto & it : m_flows)
+    {
+      Integrate (&it.second);
+    }
+
+  WriteResults (m_outputFilename, m_firstWrite, m_epochStart.GetSeconds (), true);
+  m_firstWrite = false;
+
+  for (auto & it : m_flows)
+    {
+      it.second.m_epoch.Reset ();
+    }
+
+  m_epochStart += m_epochDuration;
+  m_endEpochEvent = Simulator::Schedule (m_epochDuration, &NrAoiStatsCalculator::EndEpoch, this);
+}
+
+void
+NrAoiStatsCalculator::WriteSummary ()
+{
+  NS_LOG_FUNCTION (this);
+  if (m_summaryWritten)
+    {
+      return;
+    }
+
+  for (auto & it : m_flows)
+    {
+      Integrate (&it.second);
+    }
+  WriteResults (m_summaryFilename, true, m_startTime.GetSeconds (), false);
+  m_summaryWritten = true;
+}
+
+void
+NrAoiStatsCalculator::WriteResults (const std::string &filename, bool truncate, double start, bool epoch)
+{
+  NS_LOG_FUNCTION (this << filename);
+  NS_LOG_INFO ("Write AoI stats in " << filename);
+
+  std::ofstream outFile;
+  outFile.open (filename.c_str (), truncate ? std::ios_base::out : std::ios_base::app);
+  if (!outFile.is_open ())
+    {
+      NS_LOG_ERROR ("Can't open file " << filename.c_str ());
+      return;
+    }
+
+  if (truncate)
+    {
+      outFile << "% start(s)\tend(s)\tCellId\tRNTI\tLCID\tnUpdates\t";
+      outFile << "meanAoi(s)\tmaxAoi(s)\tpeakAoiP50(s)\tpeakAoiP99(s)\tpeakAoiP999(s)\t";
+      outFile << "meanDelay(s)\tdelayP50(s)\tdelayP99(s)\tdelayP999(s)\tdeadlineViolationRatio";
+      outFile << std::endl;
+    }
+
+  // Sorted output, independent of the hashing of the flows
+  std::vector<uint64_t> keys;
+  keys.reserve (m_flows.size ());
+  for (const auto & it : m_flows)
+    {
+      keys.push_back (it.first);
+    }
+  std::sort (keys.begin (), keys.end ());
+
+  double end = Simulator::Now ().GetSeconds ();
+  for (uint64_t key : keys)
+    {
+      const AoiFlow &flow = m_flows.at (key);
+      const AoiStats &stats = epoch ? flow.m_epoch : flow.m_total;
+
+      outFile << start << "\t";
+      outFile << end << "\t";
+      outFile << (key >> 24) << "\t";
+      outFile << ((key >> 8) & 0xFFFF) << "\t";
+      outFile << (key & 0xFF) << "\t";
+      outFile << stats.m_updates << "\t";
+      outFile << (stats.m_observed > 0.0 ? stats.m_aoiArea / stats.m_observed : 0.0) << "\t";
+      outFile << stats.m_maxAoi << "\t";
+      outFile << stats.m_peakAoi.GetQuantile (0.5) << "\t";
+      outFile << stats.m_peakAoi.GetQuantile (0.99) << "\t";
+      outFile << stats.m_peakAoi.GetQuantile (0.999) << "\t";
+      outFile << (stats.m_updates > 0 ? stats.m_delaySum / stats.m_updates : 0.0) << "\t";
+      outFile << stats.m_delay.GetQuantile (0.5) << "\t";
+      outFile << stats.m_delay.GetQuantile (0.99) << "\t";
+      outFile << stats.m_delay.GetQuantile (0.999) << "\t";
+      outFile << (stats.m_updates > 0 ? static_cast<double> (stats.m_violations) / stats.m_updates : 0.0);
+      outFile << std::endl;
+    }
+
+  outFile.close ();
+}
+
+} // namespace ns3
@@ -0,0 +1,271 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <ns3/object.h>
+#include <ns3/nstime.h>
+#include <ns3/event-id.h>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+
+namespace ns3 {
+
+/**
+ * \ingroup utils
+ *
+ * \brief Streaming quantile estimator with constant memory
+ *
+ * The values are counted in logarithmic bins: bin i holds the values in
+ * (gamma^(i-1), gamma^i] (scaled by the minimum value), with
+ * gamma = (1 + a) / (1 - a). Any quantile is then returned with a relative
+ * error of at most a, whatever the number of values added. The number of
+ * bins is fixed at construction by the accuracy and by the range of the
+ * values; the values outside the range are counted in the first or last bin.
+ */
+class NrAoiQuantileSketch
+{
+public:
+  /**
+   * \brief NrAoiQuantileSketch constructor
+   * \param relativeAccuracy relative accuracy a of the quantiles, in (0, 1)
+   * \param minValue smallest value to be told apart (> 0)
+   * \param maxValue largest value to be told apart (> minValue)
+   */
+  NrAoiQuantileSketch (double relativeAccuracy, double minValue, double maxValue);
+
+  /**
+   * \brief Add a value
+   * \param value the value
+   */
+  void Add (double value);
+
+  /**
+   * \brief Get a quantile of the values added
+   * \param q the quantile, in [0, 1]
+   * \return the estimate of the quantile, or 0 if no value was added
+   */
+  double GetQuantile (double q) const;
+
+  /**
+   * \return the number of values added
+   */
+  uint64_t GetCount () const;
+
+  /**
+   * \brief Forget all the values added
+   */
+  void Reset ();
+
+private:
+  double m_minValue {0.0};          //!< Smallest value to be told apart
+  double m_logGamma {0.0};          //!< Logarithm of the bin ratio gamma
+  std::vector<uint32_t> m_bins;     //!< Counters of the bins
+  uint64_t m_count {0};             //!< Number of values added
+  double m_min {0.0};               //!< Smallest value added
+  double m_max {0.0};               //!< Largest value added
+};
+
+/**
+ * \ingroup utils
+ *
+ * \brief Age of Information statistics of the UL flows
+ *
+ * This class is a trace sink for the ns3::NrGnbMac::AoiSample trace source.
+ * For each flow (cell id, RNTI, LCID) it follows the AoI at the gNB, i.e.,
+ * the time elapsed since the creation of the freshest packet received, and
+ * calculates:
+ *
+ *   - Number of updates (packets) received
+ *   - Time-average AoI and maximum AoI
+ *   - Peak AoI (the AoI just before each update): p50, p99 and p99.9
+ *   - Delay of the updates: average, p50, p99 and p99.9
+ *   - Ratio of the updates received after their deadline
+ *
+ * The memory used by a flow does not depend on the number of packets: the
+ * percentiles come from NrAoiQuantileSketch.
+ *
+ * The statistics of each epoch are appended to the output file at the end
+ * of the epoch, and the statistics of the whole simulation are written to
+ * the summary file when the simulation is destroyed.
+ */
+class NrAoiStatsCalculator : public Object
+{
+public:
+  /**
+   * \brief NrAoiStatsCalculator constructor
+   */
+  NrAoiStatsCalculator ();
+  /**
+   * \brief ~NrAoiStatsCalculator
+   */
+  virtual ~NrAoiStatsCalculator () override;
+
+  /**
+   * \brief Get the type ID
+   * \return the type ID
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief Set the deadline of the packets of a UE
+   *
+   * It overrides the Deadline attribute for all the LCs of the UE.
+   *
+   * \param cellId Cell id of the gNB of the UE
+   * \param rnti RNTI of the UE
+   * \param deadline deadline of the packets
+   */
+  void SetDeadline (uint16_t cellId, uint16_t rnti, const Time &deadline);
+
+  /**
+   * \brief Notifies the stats calculator that an AoI-tagged packet has been received
+   * \param cellId Cell id of the gNB
+   * \param rnti RNTI of the UE
+   * \param lcid LC ID of the packet
+   * \param creationTime creation time of the packet
+   */
+  void AoiSample (uint16_t cellId, uint16_t rnti, uint8_t lcid, const Time &creationTime);
+
+  /**
+   * \brief Trace sink for the ns3::NrGnbMac::AoiSample trace source
+   * \param aoiStats the stats calculator
+   * \param path the trace source path
+   * \param cellId Cell id of the gNB
+   * \param rnti RNTI of the UE
+   * \param lcid LC ID of the packet
+   * \param creationTime creation time of the packet
+   */
+  static void AoiSampleCallback (Ptr<NrAoiStatsCalculator> aoiStats, std::string path,
+                                 uint16_t cellId, uint16_t rnti, uint8_t lcid,
+                                 Time creationTime);
+
+protected:
+  virtual void DoDispose () override;
+
+private:
+  /**
+   * \brief Statistics of a flow over a period of time
+   */
+  struct AoiStats
+  {
+    /**
+     * \brief AoiStats constructor
+     * \param accuracy relative accuracy of the sketches
+     * \param minValue smallest value of the sketches, in seconds
+     * \param maxValue largest value of the sketches, in seconds
+     */
+    AoiStats (double accuracy, double minValue, double maxValue);
+
+    /**
+     * \brief Forget the statistics
+     */
+    void Reset ();
+
+    uint64_t m_updates {0};              //!< Updates received
+    uint64_t m_violations {0};           //!< Updates received after their deadline
+    double m_aoiArea {0.0};              //!< Integral of the AoI over time, in s^2
+    double m_observed {0.0};             //!< Time over which the AoI is integrated, in s
+    double m_maxAoi {0.0};               //!< Largest AoI, in s
+    double m_delaySum {0.0};             //!< Sum of the delays, in s
+    NrAoiQuantileSketch m_peakAoi;       //!< Peak AoI, in s
+    NrAoiQuantileSketch m_delay;         //!< Delay of the updates, in s
+  };
+
+  /**
+   * \brief AoI of a flow
+   */
+  struct AoiFlow
+  {
+    /**
+     * \brief AoiFlow constructor
+     * \param accuracy relative accuracy of the sketches
+     * \param minValue smallest value of the sketches, in seconds
+     * \param maxValue largest value of the sketches, in seconds
+     */
+    AoiFlow (double accuracy, double minValue, double maxValue);
+
+    Time m_lastCreation;     //!< Creation time of the freshest packet received
+    Time m_lastIntegration;  //!< Time up to which the AoI has been integrated
+    AoiStats m_epoch;        //!< Statistics of the current epoch
+    AoiStats m_total;        //!< Statistics of the whole simulation
+  };
+
+  /**
+   * \brief Build the key of a flow
+   * \param cellId Cell id
+   * \param rnti RNTI
+   * \param lcid LC ID
+   * \return the key
+   */
+  static uint64_t GetFlowKey (uint16_t cellId, uint16_t rnti, uint8_t lcid);
+
+  /**
+   * \brief Integrate the AoI of a flow up to now
+   * \param flow the flow
+   */
+  static void Integrate (AoiFlow *flow);
+
+  /**
+   * \brief Get the deadline of the packets of a flow
+   * \param cellId Cell id
+   * \param rnti RNTI
+   * \return the deadline
+   */
+  Time GetDeadline (uint16_t cellId, uint16_t rnti) const;
+
+  /**
+   * \brief Close the epoch: write and reset its statistics
+   */
+  void EndEpoch ();
+
+  /**
+   * \brief Write the statistics of the whole simulation
+   */
+  void WriteSummary ();
+
+  /**
+   * \brief Write the statistics of all the flows
+   * \param filename the output file
+   * \param truncate if true, start a new file with the column header
+   * \param start start of the period, in seconds
+   * \param epoch true for the epoch statistics, false for the whole simulation
+   */
+  void WriteResults (const std::string &filename, bool truncate, double start, bool epoch);
+
+  std::unordered_map<uint64_t, AoiFlow> m_flows;   //!< Flows, by GetFlowKey
+  std::unordered_map<uint32_t, Time> m_deadlines;  //!< Per-UE deadlines, by cell id and RNTI
+
+  Time m_startTime;              //!< Start of the first epoch
+  Time m_epochDuration;          //!< Duration of an epoch (0 to disable)
+  Time m_epochStart;             //!< Start of the current epoch
+  Time m_defaultDeadline;        //!< Deadline of the packets
+  double m_accuracy {0.0};       //!< Relative accuracy of the sketches
+  Time m_sketchMin;              //!< Smallest value of the sketches
+  Time m_sketchMax;              //!< Largest value of the sketches
+  std::string m_outputFilename;  //!< Per-epoch output file
+  std::string m_summaryFilename; //!< Whole simulation output file
+
+  bool m_started {false};        //!< True after the first sample
+  bool m_firstWrite {true};      //!< True if the output file has not been written yet
+  bool m_summaryWritten {false}; //!< True if the summary has been written
+  EventId m_endEpochEvent;       //!< Event of the end of the current epoch
+};
+
+} // namespace ns3
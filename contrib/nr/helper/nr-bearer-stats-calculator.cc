@@ -32,6 +32,7 @@
 #include <ns3/log.h>
 #include <vector>
 #include <algorithm>
+#include <cmath>
 
 namespace ns3 {
 
@@ -138,18 +139,106 @@ NrBearerStatsCalculator::GetEpoch () const
   return m_epochDuration;
 }
 
+void
+NrBearerStatsCalculator::ValueStats::Update (double value)
+{
+  // Welford's algorithm, as in MinMaxAvgTotalCalculator
+  ++m_count;
+  if (m_count == 1)
+    {
+      m_min = value;
+      m_max = value;
+      m_mean = value;
+      m_s = 0.0;
+      return;
+    }
+  m_min = std::min (m_min, value);
+  m_max = std::max (m_max, value);
+  double meanPrev = m_mean;
+  m_mean = meanPrev + (value - meanPrev) / m_count;
+  m_s += (value - meanPrev) * (value - m_mean);
+}
+
+std::vector<double>
+NrBearerStatsCalculator::ValueStats::Get () const
+{
+  if (m_count == 0)
+    {
+      return std::vector<double> (4, 0.0);
+    }
+  double stddev = m_count > 1 ? std::sqrt (m_s / (m_count - 1)) : 0.0;
+  return {m_mean, stddev, m_min, m_max};
+}
+
+NrBearerStatsCalculator::BearerRecord &
+NrBearerStatsCalculator::GetRecord (uint64_t imsi, uint8_t lcid)
+{
+  NS_ASSERT_MSG (imsi < (1ULL << 56), "IMSI " << imsi << " does not fit the bearer key");
+  uint64_t key = (imsi << 8) | lcid;
+
+  auto it = m_bearerIndex.find (key);
+  if (it == m_bearerIndex.end ())
+    {
+      NS_LOG_DEBUG (this << " Creating stats for IMSI " << imsi << " and LCID " << (uint32_t) lcid);
+      it = m_bearerIndex.emplace (key, static_cast<uint32_t> (m_bearers.size ())).first;
+      m_bearers.emplace_back ();
+      m_bearers.back ().m_pair = ImsiLcidPair_t (imsi, lcid);
+      m_bearers.back ().m_epoch = m_epoch;
+    }
+
+  BearerRecord &record = m_bearers[it->second];
+  if (record.m_epoch != m_epoch)
+    {
+      // First update in this epoch: the statistics are those of an old epoch
+      record.m_ul = DirectionStats ();
+      record.m_dl = DirectionStats ();
+      record.m_epoch = m_epoch;
+    }
+  return record;
+}
+
+const NrBearerStatsCalculator::BearerRecord *
+NrBearerStatsCalculator::FindRecord (uint64_t imsi, uint8_t lcid) const
+{
+  auto it = m_bearerIndex.find ((imsi << 8) | lcid);
+  if (it == m_bearerIndex.end () || m_bearers[it->second].m_epoch != m_epoch)
+    {
+      return nullptr;
+    }
+  return &m_bearers[it->second];
+}
+
+std::vector<const NrBearerStatsCalculator::BearerRecord *>
+NrBearerStatsCalculator::GetEpochRecords () const
+{
+  std::vector<const BearerRecord *> records;
+  for (const auto & record : m_bearers)
+    {
+      if (record.m_epoch == m_epoch)
+        {
+          records.push_back (&record);
+        }
+    }
+  std::sort (records.begin (), records.end (),
+             [] (const BearerRecord *a, const BearerRecord *b)
+             {
+               return a->m_pair < b->m_pair;
+             });
+  return records;
+}
+
 void
 NrBearerStatsCalculator::UlTxPdu (uint16_t cellId, uint64_t imsi, uint16_t rnti, uint8_t lcid, uint32_t packetSize)
 {
   NS_LOG_FUNCTION (this);
 
-  ImsiLcidPair_t p (imsi, lcid);
   if (Simulator::Now () >= m_startTime)
     {
-      m_ulCellId[p] = cellId;
-      m_flowId[p] = LteFlowId_t (rnti, lcid);
-      m_ulTxPackets[p]++;
-      m_ulTxData[p] += packetSize;
+      BearerRecord &record = GetRecord (imsi, lcid);
+      record.m_ul.m_cellId = cellId;
+      record.m_flowId = LteFlowId_t (rnti, lcid);
+      record.m_ul.m_txPackets++;
+      record.m_ul.m_txData += packetSize;
     }
   m_pendingOutput = true;
 }
@@ -159,13 +248,13 @@ NrBearerStatsCalculator::DlTxPdu (uint16_t cellId, uint64_t imsi, uint16_t rnti,
 {
   NS_LOG_FUNCTION (this);
 
-  ImsiLcidPair_t p (imsi, lcid);
   if (Simulator::Now () >= m_startTime)
     {
-      m_dlCellId[p] = cellId;
-      m_flowId[p] = LteFlowId_t (rnti, lcid);
-      m_dlTxPackets[p]++;
-      m_dlTxData[p] += packetSize;
+      BearerRecord &record = GetRecord (imsi, lcid);
+      record.m_dl.m_cellId = cellId;
+      record.m_flowId = LteFlowId_t (rnti, lcid);
+      record.m_dl.m_txPackets++;
+      record.m_dl.m_txData += packetSize;
     }
   m_pendingOutput = true;
 }
@@ -176,22 +265,14 @@ NrBearerStatsCalculator::UlRxPdu (uint16_t cellId, uint64_t imsi, uint16_t rnti,
 {
   NS_LOG_FUNCTION (this);
 
-  ImsiLcidPair_t p (imsi, lcid);
   if (Simulator::Now () >= m_startTime)
     {
-      m_ulCellId[p] = cellId;
-      m_ulRxPackets[p]++;
-      m_ulRxData[p] += packetSize;
-
-      Uint64StatsMap::iterator it = m_ulDelay.find (p);
-      if (it == m_ulDelay.end ())
-        {
-          NS_LOG_DEBUG (this << " Creating UL stats calculators for IMSI " << p.m_imsi << " and LCID " << (uint32_t) p.m_lcId);
-          m_ulDelay[p] = CreateObject<MinMaxAvgTotalCalculator<uint64_t> > ();
-          m_ulPduSize[p] = CreateObject<MinMaxAvgTotalCalculator<uint32_t> > ();
-        }
-      m_ulDelay[p]->Update (delay);
-      m_ulPduSize[p]->Update (packetSize);
+      BearerRecord &record = GetRecord (imsi, lcid);
+      record.m_ul.m_cellId = cellId;
+      record.m_ul.m_rxPackets++;
+      record.m_ul.m_rxData += packetSize;
+      record.m_ul.m_delay.Update (delay);
+      record.m_ul.m_pduSize.Update (packetSize);
     }
   m_pendingOutput = true;
 }
@@ -201,22 +282,14 @@ NrBearerStatsCalculator::DlRxPdu (uint16_t cellId, uint64_t imsi, uint16_t rnti,
 {
   NS_LOG_FUNCTION (this);
 
-  ImsiLcidPair_t p (imsi, lcid);
   if (Simulator::Now () >= m_startTime)
     {
-      m_dlCellId[p] = cellId;
-      m_dlRxPackets[p]++;
-      m_dlRxData[p] += packetSize;
-
-      Uint64StatsMap::iterator it = m_dlDelay.find (p);
-      if (it == m_dlDelay.end ())
-        {
-          NS_LOG_DEBUG (this << " Creating DL stats calculators for IMSI " << p.m_imsi << " and LCID " << (uint32_t) p.m_lcId);
-          m_dlDelay[p] = CreateObject<MinMaxAvgTotalCalculator<uint64_t> > ();
-          m_dlPduSize[p] = CreateObject<MinMaxAvgTotalCalculator<uint32_t> > ();
-        }
-      m_dlDelay[p]->Update (delay);
-      m_dlPduSize[p]->Update (packetSize);
+      BearerRecord &record = GetRecord (imsi, lcid);
+      record.m_dl.m_cellId = cellId;
+      record.m_dl.m_rxPackets++;
+      record.m_dl.m_rxData += packetSize;
+      record.m_dl.m_delay.Update (delay);
+      record.m_dl.m_pduSize.Update (packetSize);
     }
   m_pendingOutput = true;
 }
@@ -283,40 +356,31 @@ NrBearerStatsCalculator::WriteUlResults (std::ofstream& outFile)
 {
   NS_LOG_FUNCTION (this);
 
-  // Get the unique IMSI / LCID list
-
-  std::vector < ImsiLcidPair_t > pairVector;
-  for (Uint32Map::iterator it = m_ulTxPackets.begin (); it != m_ulTxPackets.end (); ++it)
+  Time endTime = m_startTime + m_epochDuration;
+  for (const BearerRecord *record : GetEpochRecords ())
     {
-      if (find (pairVector.begin (), pairVector.end (), (*it).first) == pairVector.end ())
+      const DirectionStats &ul = record->m_ul;
+      if (ul.m_txPackets == 0)
         {
-          pairVector.push_back ((*it).first);
+          continue;
         }
-    }
-
-  Time endTime = m_startTime + m_epochDuration;
-  for (std::vector<ImsiLcidPair_t>::iterator it = pairVector.begin (); it != pairVector.end (); ++it)
-    {
-      ImsiLcidPair_t p = *it;
       outFile << m_startTime.GetSeconds () << "\t";
       outFile << endTime.GetSeconds () << "\t";
-      outFile << GetUlCellId (p.m_imsi, p.m_lcId) << "\t";
-      outFile << p.m_imsi << "\t";
-      outFile << m_flowId[p].m_rnti << "\t";
-      outFile << (uint32_t) m_flowId[p].m_lcId << "\t";
-      outFile << GetUlTxPackets (p.m_imsi, p.m_lcId) << "\t";
-      outFile << GetUlTxData (p.m_imsi, p.m_lcId) << "\t";
-      outFile << GetUlRxPackets (p.m_imsi, p.m_lcId) << "\t";
-      outFile << GetUlRxData (p.m_imsi, p.m_lcId) << "\t";
-      std::vector<double> stats = GetUlDelayStats (p.m_imsi, p.m_lcId);
-      for (std::vector<double>::iterator it = stats.begin (); it != stats.end (); ++it)
+      outFile << ul.m_cellId << "\t";
+      outFile << record->m_pair.m_imsi << "\t";
+      outFile << record->m_flowId.m_rnti << "\t";
+      outFile << (uint32_t) record->m_flowId.m_lcId << "\t";
+      outFile << ul.m_txPackets << "\t";
+      outFile << ul.m_txData << "\t";
+      outFile << ul.m_rxPackets << "\t";
+      outFile << ul.m_rxData << "\t";
+      for (double stat : ul.m_delay.Get ())
         {
-          outFile << (*it) * 1e-9 << "\t";
+          outFile << stat * 1e-9 << "\t";
         }
-      stats = GetUlPduSizeStats (p.m_imsi, p.m_lcId);
-      for (std::vector<double>::iterator it = stats.begin (); it != stats.end (); ++it)
+      for (double stat : ul.m_pduSize.Get ())
         {
-          outFile << (*it) << "\t";
+          outFile << stat << "\t";
         }
       outFile << std::endl;
     }
@@ -329,39 +393,31 @@ NrBearerStatsCalculator::WriteDlResults (std::ofstream& outFile)
 {
   NS_LOG_FUNCTION (this);
 
-  // Get the unique IMSI list
-  std::vector < ImsiLcidPair_t > pairVector;
-  for (Uint32Map::iterator it = m_dlTxPackets.begin (); it != m_dlTxPackets.end (); ++it)
+  Time endTime = m_startTime + m_epochDuration;
+  for (const BearerRecord *record : GetEpochRecords ())
     {
-      if (find (pairVector.begin (), pairVector.end (), (*it).first) == pairVector.end ())
+      const DirectionStats &dl = record->m_dl;
+      if (dl.m_txPackets == 0)
         {
-          pairVector.push_back ((*it).first);
+          continue;
         }
-    }
-
-  Time endTime = m_startTime + m_epochDuration;
-  for (std::vector<ImsiLcidPair_t>::iterator pair = pairVector.begin (); pair != pairVector.end (); ++pair)
-    {
-      ImsiLcidPair_t p = *pair;
       outFile << m_startTime.GetSeconds () << "\t";
       outFile << endTime.GetSeconds () << "\t";
-      outFile << GetDlCellId (p.m_imsi, p.m_lcId) << "\t";
-      outFile << p.m_imsi << "\t";
-      outFile << m_flowId[p].m_rnti << "\t";
-      outFile << (uint32_t) m_flowId[p].m_lcId << "\t";
-      outFile << GetDlTxPackets (p.m_imsi, p.m_lcId) << "\t";
-      outFile << GetDlTxData (p.m_imsi, p.m_lcId) << "\t";
-      outFile << GetDlRxPackets (p.m_imsi, p.m_lcId) << "\t";
-      outFile << GetDlRxData (p.m_imsi, p.m_lcId) << "\t";
-      std::vector<double> stats = GetDlDelayStats (p.m_imsi, p.m_lcId);
-      for (std::vector<double>::iterator it = stats.begin (); it != stats.end (); ++it)
+      outFile << dl.m_cellId << "\t";
+      outFile << record->m_pair.m_imsi << "\t";
+      outFile << record->m_flowId.m_rnti << "\t";
+      outFile << (uint32_t) record->m_flowId.m_lcId << "\t";
+      outFile << dl.m_txPackets << "\t";
+      outFile << dl.m_txData << "\t";
+      outFile << dl.m_rxPackets << "\t";
+      outFile << dl.m_rxData << "\t";
+      for (double stat : dl.m_delay.Get ())
         {
-          outFile << (*it) * 1e-9 << "\t";
+          outFile << stat * 1e-9 << "\t";
         }
-      stats = GetDlPduSizeStats (p.m_imsi, p.m_lcId);
-      for (std::vector<double>::iterator it = stats.begin (); it != stats.end (); ++it)
+      for (double stat : dl.m_pduSize.Get ())
         {
-          outFile << (*it) << "\t";
+          outFile << stat << "\t";
         }
       outFile << std::endl;
     }
@@ -374,19 +430,9 @@ NrBearerStatsCalculator::ResetResults (void)
 {
   NS_LOG_FUNCTION (this);
 
-  m_ulTxPackets.erase (m_ulTxPackets.begin (), m_ulTxPackets.end ());
-  m_ulRxPackets.erase (m_ulRxPackets.begin (), m_ulRxPackets.end ());
-  m_ulRxData.erase (m_ulRxData.begin (), m_ulRxData.end ());
-  m_ulTxData.erase (m_ulTxData.begin (), m_ulTxData.end ());
-  m_ulDelay.erase (m_ulDelay.begin (), m_ulDelay.end ());
-  m_ulPduSize.erase (m_ulPduSize.begin (), m_ulPduSize.end ());
-
-  m_dlTxPackets.erase (m_dlTxPackets.begin (), m_dlTxPackets.end ());
-  m_dlRxPackets.erase (m_dlRxPackets.begin (), m_dlRxPackets.end ());
-  m_dlRxData.erase (m_dlRxData.begin (), m_dlRxData.end ());
-  m_dlTxData.erase (m_dlTxData.begin (), m_dlTxData.end ());
-  m_dlDelay.erase (m_dlDelay.begin (), m_dlDelay.end ());
-  m_dlPduSize.erase (m_dlPduSize.begin (), m_dlPduSize.end ());
+  // The records are kept: each one is reset at its first update in the
+  // new epoch, and until then it is ignored as stale
+  ++m_epoch;
 }
 
 void
@@ -412,201 +458,138 @@ uint32_t
 NrBearerStatsCalculator::GetUlTxPackets (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_ulTxPackets[p];
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  return record != nullptr ? record->m_ul.m_txPackets : 0;
 }
 
 uint32_t
 NrBearerStatsCalculator::GetUlRxPackets (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_ulRxPackets[p];
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  return record != nullptr ? record->m_ul.m_rxPackets : 0;
 }
 
 uint64_t
 NrBearerStatsCalculator::GetUlTxData (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_ulTxData[p];
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  return record != nullptr ? record->m_ul.m_txData : 0;
 }
 
 uint64_t
 NrBearerStatsCalculator::GetUlRxData (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_ulRxData[p];
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  return record != nullptr ? record->m_ul.m_rxData : 0;
+}
+
+uint32_t
+NrBearerStatsCalculator::GetUlCellId (uint64_t imsi, uint8_t lcid)
+{
+  NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  return record != nullptr ? record->m_ul.m_cellId : 0;
 }
 
 double
 NrBearerStatsCalculator::GetUlDelay (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  Uint64StatsMap::iterator it = m_ulDelay.find (p);
-  if (it == m_ulDelay.end ())
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  if (record == nullptr || record->m_ul.m_delay.m_count == 0)
     {
       NS_LOG_ERROR ("UL delay for " << imsi << " - " << (uint16_t) lcid << " not found");
       return 0;
-
     }
-  return m_ulDelay[p]->getMean ();
+  return record->m_ul.m_delay.m_mean;
 }
 
 std::vector<double>
 NrBearerStatsCalculator::GetUlDelayStats (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  std::vector<double> stats;
-  Uint64StatsMap::iterator it = m_ulDelay.find (p);
-  if (it == m_ulDelay.end ())
-    {
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      return stats;
-
-    }
-  stats.push_back (m_ulDelay[p]->getMean ());
-  stats.push_back (m_ulDelay[p]->getStddev ());
-  stats.push_back (m_ulDelay[p]->getMin ());
-  stats.push_back (m_ulDelay[p]->getMax ());
-  return stats;
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  return record != nullptr ? record->m_ul.m_delay.Get () : std::vector<double> (4, 0.0);
 }
 
 std::vector<double>
 NrBearerStatsCalculator::GetUlPduSizeStats (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  std::vector<double> stats;
-  Uint32StatsMap::iterator it = m_ulPduSize.find (p);
-  if (it == m_ulPduSize.end ())
-    {
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      return stats;
-
-    }
-  stats.push_back (m_ulPduSize[p]->getMean ());
-  stats.push_back (m_ulPduSize[p]->getStddev ());
-  stats.push_back (m_ulPduSize[p]->getMin ());
-  stats.push_back (m_ulPduSize[p]->getMax ());
-  return stats;
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  return record != nullptr ? record->m_ul.m_pduSize.Get () : std::vector<double> (4, 0.0);
 }
 
 uint32_t
 NrBearerStatsCalculator::GetDlTxPackets (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_dlTxPackets[p];
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  return record != nullptr ? record->m_dl.m_txPackets : 0;
 }
 
 uint32_t
 NrBearerStatsCalculator::GetDlRxPackets (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_dlRxPackets[p];
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  return record != nullptr ? record->m_dl.m_rxPackets : 0;
 }
 
 uint64_t
 NrBearerStatsCalculator::GetDlTxData (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_dlTxData[p];
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  return record != nullptr ? record->m_dl.m_txData : 0;
 }
 
 uint64_t
 NrBearerStatsCalculator::GetDlRxData (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_dlRxData[p];
-}
-
-uint32_t
-NrBearerStatsCalculator::GetUlCellId (uint64_t imsi, uint8_t lcid)
-{
-  NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_ulCellId[p];
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  return record != nullptr ? record->m_dl.m_rxData : 0;
 }
 
 uint32_t
 NrBearerStatsCalculator::GetDlCellId (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  return m_dlCellId[p];
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  return record != nullptr ? record->m_dl.m_cellId : 0;
 }
 
 double
 NrBearerStatsCalculator::GetDlDelay (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  Uint64StatsMap::iterator it = m_dlDelay.find (p);
-  if (it == m_dlDelay.end ())
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  if (record == nullptr || record->m_dl.m_delay.m_count == 0)
     {
-      NS_LOG_ERROR ("DL delay for " << imsi << " not found");
+      NS_LOG_ERROR ("DL delay for " << imsi << " - " << (uint16_t) lcid << " not found");
       return 0;
     }
-  return m_dlDelay[p]->getMean ();
+  return record->m_dl.m_delay.m_mean;
 }
 
 std::vector<double>
 NrBearerStatsCalculator::GetDlDelayStats (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  std::vector<double> stats;
-  Uint64StatsMap::iterator it = m_dlDelay.find (p);
-  if (it == m_dlDelay.end ())
-    {
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      return stats;
-
-    }
-  stats.push_back (m_dlDelay[p]->getMean ());
-  stats.push_back (m_dlDelay[p]->getStddev ());
-  stats.push_back (m_dlDelay[p]->getMin ());
-  stats.push_back (m_dlDelay[p]->getMax ());
-  return stats;
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  return record != nullptr ? record->m_dl.m_delay.Get () : std::vector<double> (4, 0.0);
 }
 
 std::vector<double>
 NrBearerStatsCalculator::GetDlPduSizeStats (uint64_t imsi, uint8_t lcid)
 {
   NS_LOG_FUNCTION (this << imsi << (uint16_t) lcid);
-  ImsiLcidPair_t p (imsi, lcid);
-  std::vector<double> stats;
-  Uint32StatsMap::iterator it = m_dlPduSize.find (p);
-  if (it == m_dlPduSize.end ())
-    {
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      stats.push_back (0.0);
-      return stats;
-
-    }
-  stats.push_back (m_dlPduSize[p]->getMean ());
-  stats.push_back (m_dlPduSize[p]->getStddev ());
-  stats.push_back (m_dlPduSize[p]->getMin ());
-  stats.push_back (m_dlPduSize[p]->getMax ());
-  return stats;
+  const BearerRecord *record = FindRecord (imsi, lcid);
+  return record != nullptr ? record->m_dl.m_pduSize.Get () : std::vector<double> (4, 0.0);
 }
 
 
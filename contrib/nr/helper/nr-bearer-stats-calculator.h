@@ -36,6 +36,8 @@
 #include "ns3/lte-common.h"
 #include <string>
 #include <map>
+#include <vector>
+#include <unordered_map>
 #include <fstream>
 #include "nr-bearer-stats-simple.h"
 
@@ -311,22 +313,79 @@ private:
    */
   void EndEpoch (void);
 
+  /**
+   * Streaming average, min, max and standard deviation of a value
+   */
+  struct ValueStats
+  {
+    /**
+     * Adds a value
+     * @param value the value
+     */
+    void Update (double value);
+    /**
+     * @return average, min, max and standard deviation of the values, or zeros without values
+     */
+    std::vector<double> Get () const;
+
+    uint32_t m_count {0}; //!< Number of values
+    double m_mean {0.0};  //!< Average of the values
+    double m_s {0.0};     //!< Sum of the squared differences from the average
+    double m_min {0.0};   //!< Smallest value
+    double m_max {0.0};   //!< Largest value
+  };
+
+  /**
+   * Statistics of a bearer in one direction
+   */
+  struct DirectionStats
+  {
+    uint32_t m_cellId {0};    //!< CellId of the attached Enb
+    uint32_t m_txPackets {0}; //!< Number of TX Packets
+    uint32_t m_rxPackets {0}; //!< Number of RX Packets
+    uint64_t m_txData {0};    //!< Amount of TX Data
+    uint64_t m_rxData {0};    //!< Amount of RX Data
+    ValueStats m_delay;       //!< Delay
+    ValueStats m_pduSize;     //!< PDU Size
+  };
+
+  /**
+   * All the statistics of a bearer, in a single record
+   */
+  struct BearerRecord
+  {
+    ImsiLcidPair_t m_pair;    //!< (IMSI, LCID) pair of the bearer
+    LteFlowId_t m_flowId;     //!< (RNTI, LCID) of the bearer
+    uint64_t m_epoch {0};     //!< Epoch of the statistics
+    DirectionStats m_ul;      //!< UL statistics
+    DirectionStats m_dl;      //!< DL statistics
+  };
+
+  /**
+   * Gets the record of a bearer to be updated, creating it the first time
+   * and resetting its statistics the first time in an epoch
+   * @param imsi IMSI of the UE
+   * @param lcid LCID
+   * @return the record of the bearer
+   */
+  BearerRecord & GetRecord (uint64_t imsi, uint8_t lcid);
+  /**
+   * Finds the record of a bearer with statistics in the on going epoch
+   * @param imsi IMSI of the UE
+   * @param lcid LCID
+   * @return the record of the bearer, or nullptr
+   */
+  const BearerRecord * FindRecord (uint64_t imsi, uint8_t lcid) const;
+  /**
+   * Gets the records with statistics in the on going epoch, in (IMSI, LCID) order
+   * @return the records
+   */
+  std::vector<const BearerRecord *> GetEpochRecords () const;
+
   EventId m_endEpochEvent; //!< Event id for next end epoch event
-  FlowIdMap m_flowId; //!< List of FlowIds, ie. (RNTI, LCID) by (IMSI, LCID) pair
-  Uint32Map m_dlCellId; //!< List of DL CellIds by (IMSI, LCID) pair
-  Uint32Map m_dlTxPackets; //!< Number of DL TX Packets by (IMSI, LCID) pair
-  Uint32Map m_dlRxPackets; //!< Number of DL RX Packets by (IMSI, LCID) pair
-  Uint64Map m_dlTxData; //!< Amount of DL TX Data by (IMSI, LCID) pair
-  Uint64Map m_dlRxData; //!< Amount of DL RX Data by (IMSI, LCID) pair
-  Uint64StatsMap m_dlDelay; //!< DL delay by (IMSI, LCID) pair
-  Uint32StatsMap m_dlPduSize; //!< DL PDU Size by (IMSI, LCID) pair
-  Uint32Map m_ulCellId; //!< List of UL CellIds by (IMSI, LCID) pair
-  Uint32Map m_ulTxPackets; //!< Number of UL TX Packets by (IMSI, LCID) pair
-  Uint32Map m_ulRxPackets; //!< Number of UL RX Packets by (IMSI, LCID) pair
-  Uint64Map m_ulTxData; //!< Amount of UL TX Data by (IMSI, LCID) pair
-  Uint64Map m_ulRxData; //!< Amount of UL RX Data by (IMSI, LCID) pair
-  Uint64StatsMap m_ulDelay; //!< UL delay by (IMSI, LCID) pair
-  Uint32StatsMap m_ulPduSize; //!< UL PDU Size by (IMSI, LCID) pair
+  std::vector<BearerRecord> m_bearers; //!< Records of all the bearers ever seen
+  std::unordered_map<uint64_t, uint32_t> m_bearerIndex; //!< Index in m_bearers, by (IMSI, LCID) key
+  uint64_t m_epoch {0}; //!< On going epoch, to tell the stale records
   /**
    * Start time of the on going epoch
    */
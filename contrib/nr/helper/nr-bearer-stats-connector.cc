@@ -32,24 +32,19 @@
 #include <ns3/log.h>
 
 
-#include <ns3/lte-enb-rrc.h>
-#include <ns3/lte-enb-net-device.h>
-#include <ns3/lte-ue-rrc.h>
-#include <ns3/lte-ue-net-device.h>
+#include <ns3/lte-radio-bearer-info.h>
+#include <ns3/lte-rlc.h>
+#include <ns3/lte-pdcp.h>
+#include <ns3/nr-gnb-net-device.h>
+#include <ns3/nr-ue-net-device.h>
+#include <ns3/node-list.h>
+#include <ns3/pointer.h>
+#include <ns3/object-map.h>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("NrBearerStatsConnector");
 
-/**
-  * Less than operator for CellIdRnti, because it is used as key in map
-  */
-bool
-operator < (const NrBearerStatsConnector::CellIdRnti& a, const NrBearerStatsConnector::CellIdRnti& b)
-{
-  return ( (a.cellId < b.cellId) || ( (a.cellId == b.cellId) && (a.rnti < b.rnti) ) );
-}
-
 /**
  * This structure is used as interface between trace
  * sources and NrBearerStatsCalculator. It stores
@@ -67,49 +62,46 @@ public:
 /**
  * Callback function for DL TX statistics for both RLC and PDCP
  * /param arg
- * /param path
  * /param rnti
  * /param lcid
  * /param packetSize
  */
 void
-DlTxPduCallback (Ptr<NrBoundCallbackArgument> arg, std::string path,
+DlTxPduCallback (Ptr<NrBoundCallbackArgument> arg,
                  uint16_t rnti, uint8_t lcid, uint32_t packetSize)
 {
-  NS_LOG_FUNCTION (path << rnti << (uint16_t)lcid << packetSize);
+  NS_LOG_FUNCTION (rnti << (uint16_t)lcid << packetSize);
   arg->stats->DlTxPdu (arg->cellId, arg->imsi, rnti, lcid, packetSize);
 }
 
 /**
  * Callback function for DL RX statistics for both RLC and PDCP
  * /param arg
- * /param path
  * /param rnti
  * /param lcid
  * /param packetSize
  * /param delay
  */
 void
-DlRxPduCallback (Ptr<NrBoundCallbackArgument> arg, std::string path,
+DlRxPduCallback (Ptr<NrBoundCallbackArgument> arg,
                  uint16_t rnti, uint8_t lcid, uint32_t packetSize, uint64_t delay)
 {
-  NS_LOG_FUNCTION (path << rnti << (uint16_t)lcid << packetSize << delay);
+  NS_LOG_FUNCTION (rnti << (uint16_t)lcid << packetSize << delay);
   arg->stats->DlRxPdu (arg->cellId, arg->imsi, rnti, lcid, packetSize, delay);
 }
 
 /**
  * Callback function for UL TX statistics for both RLC and PDCP
  * /param arg
- * /param path
  * /param rnti
  * /param lcid
  * /param packetSize
  */
 void
-UlTxPduCallback (Ptr<NrBoundCallbackArgument> arg, std::string path,
+UlTxPduCallback (Ptr<NrBoundCallbackArgument> arg,
                  uint16_t rnti, uint8_t lcid, uint32_t packetSize)
 {
-  NS_LOG_FUNCTION (path << rnti << (uint16_t)lcid << packetSize);
+  NS_LOG_FUNCTION (rnti << (uint16_t)lcid << packetSize);
 
   arg->stats->UlTxPdu (arg->cellId, arg->imsi, rnti, lcid, packetSize);
 }
@@ -117,22 +109,99 @@ UlTxPduCallback (Ptr<NrBoundCallbackArgument> arg, std::string path,
 /**
  * Callback function for UL RX statistics for both RLC and PDCP
  * /param arg
- * /param path
  * /param rnti
  * /param lcid
  * /param packetSize
  * /param delay
  */
 void
-UlRxPduCallback (Ptr<NrBoundCallbackArgument> arg, std::string path,
+UlRxPduCallback (Ptr<NrBoundCallbackArgument> arg,
                  uint16_t rnti, uint8_t lcid, uint32_t packetSize, uint64_t delay)
 {
-  NS_LOG_FUNCTION (path << rnti << (uint16_t)lcid << packetSize << delay);
+  NS_LOG_FUNCTION (rnti << (uint16_t)lcid << packetSize << delay);
 
   arg->stats->UlRxPdu (arg->cellId, arg->imsi, rnti, lcid, packetSize, delay);
 }
 
+/**
+ * Creates the argument bound to the PDU trace sinks of a UE
+ * /param stats
+ * /param imsi
+ * /param cellId
+ * /return the argument, or nullptr if stats is nullptr
+ */
+Ptr<NrBoundCallbackArgument>
+CreateBoundCallbackArgument (Ptr<NrBearerStatsBase> stats, uint64_t imsi, uint16_t cellId)
+{
+  if (stats == nullptr)
+    {
+      return nullptr;
+    }
+  Ptr<NrBoundCallbackArgument> arg = Create<NrBoundCallbackArgument> ();
+  arg->imsi = imsi;
+  arg->cellId = cellId;
+  arg->stats = stats;
+  return arg;
+}
+
+/**
+ * Connects the TxPDU and RxPDU trace sources of a RLC or PDCP entity.
+ * At the UE TX is UL and RX is DL, at the eNB the opposite.
+ * /param entity the RLC or PDCP entity, can be nullptr
+ * /param arg the bound argument, can be nullptr
+ * /param atUe true if the entity is at the UE
+ */
+void
+ConnectPduTraces (Ptr<Object> entity, Ptr<NrBoundCallbackArgument> arg, bool atUe)
+{
+  if (entity == nullptr || arg == nullptr)
+    {
+      return;
+    }
+  if (atUe)
+    {
+      entity->TraceConnectWithoutContext ("TxPDU", MakeBoundCallback (&UlTxPduCallback, arg));
+      entity->TraceConnectWithoutContext ("RxPDU", MakeBoundCallback (&DlRxPduCallback, arg));
+    }
+  else
+    {
+      entity->TraceConnectWithoutContext ("RxPDU", MakeBoundCallback (&UlRxPduCallback, arg));
+      entity->TraceConnectWithoutContext ("TxPDU", MakeBoundCallback (&DlTxPduCallback, arg));
+    }
+}
+
+/**
+ * Gets a signaling radio bearer of a UE RRC or of an eNB UE manager
+ * /param owner the UE RRC or the UE manager
+ * /param name "Srb0" or "Srb1"
+ * /return the bearer, or nullptr if not set up
+ */
+Ptr<LteSignalingRadioBearerInfo>
+GetSrb (Ptr<Object> owner, const std::string &name)
+{
+  PointerValue srb;
+  owner->GetAttribute (name, srb);
+  return srb.Get<LteSignalingRadioBearerInfo> ();
+}
 
+/**
+ * Gets the data radio bearers of a UE RRC or of an eNB UE manager
+ * /param owner the UE RRC or the UE manager
+ * /return the bearers
+ */
+std::vector<Ptr<LteDataRadioBearerInfo> >
+GetDrbs (Ptr<Object> owner)
+{
+  ObjectMapValue drbMap;
+  owner->GetAttribute ("DataRadioBearerMap", drbMap);
+  std::vector<Ptr<LteDataRadioBearerInfo> > drbs;
+  drbs.reserve (drbMap.GetN ());
+  for (auto it = drbMap.Begin (); it != drbMap.End (); ++it)
+    {
+      drbs.push_back (DynamicCast<LteDataRadioBearerInfo> (it->second));
+    }
+  return drbs;
+}
 
 NrBearerStatsConnector::NrBearerStatsConnector ()
   : m_connected (false)
@@ -159,295 +228,240 @@ NrBearerStatsConnector::EnsureConnected ()
   NS_LOG_FUNCTION (this);
   if (!m_connected)
     {
-      Config::Connect ("/NodeList/*/DeviceList/*/LteEnbRrc/NewUeContext",
-                       MakeBoundCallback (&NrBearerStatsConnector::NotifyNewUeContextEnb, this));
-      Config::Connect ("/NodeList/*/DeviceList/*/LteUeRrc/RandomAccessSuccessful",
-                       MakeBoundCallback (&NrBearerStatsConnector::NotifyRandomAccessSuccessfulUe, this));
-      Config::Connect ("/NodeList/*/DeviceList/*/LteEnbRrc/ConnectionReconfiguration",
-                       MakeBoundCallback (&NrBearerStatsConnector::NotifyConnectionReconfigurationEnb, this));
-      Config::Connect ("/NodeList/*/DeviceList/*/LteUeRrc/ConnectionReconfiguration",
-                       MakeBoundCallback (&NrBearerStatsConnector::NotifyConnectionReconfigurationUe, this));
-      Config::Connect ("/NodeList/*/DeviceList/*/LteEnbRrc/HandoverStart",
-                       MakeBoundCallback (&NrBearerStatsConnector::NotifyHandoverStartEnb, this));
-      Config::Connect ("/NodeList/*/DeviceList/*/LteUeRrc/HandoverStart",
-                       MakeBoundCallback (&NrBearerStatsConnector::NotifyHandoverStartUe, this));
-      Config::Connect ("/NodeList/*/DeviceList/*/LteEnbRrc/HandoverEndOk",
-                       MakeBoundCallback (&NrBearerStatsConnector::NotifyHandoverEndOkEnb, this));
-      Config::Connect ("/NodeList/*/DeviceList/*/LteUeRrc/HandoverEndOk",
-                       MakeBoundCallback (&NrBearerStatsConnector::NotifyHandoverEndOkUe, this));
+      // A single walk over the installed devices: the RRC trace sources are
+      // connected on the objects, with the RRC bound as context, instead of
+      // resolving a wildcard path for each of them
+      for (NodeList::Iterator node = NodeList::Begin (); node != NodeList::End (); ++node)
+        {
+          for (uint32_t i = 0; i < (*node)->GetNDevices (); ++i)
+            {
+              Ptr<NetDevice> device = (*node)->GetDevice (i);
+              Ptr<NrGnbNetDevice> gnbDevice = DynamicCast<NrGnbNetDevice> (device);
+              if (gnbDevice != nullptr)
+                {
+                  ConnectEnbRrc (gnbDevice->GetRrc ());
+                  continue;
+                }
+              Ptr<NrUeNetDevice> ueDevice = DynamicCast<NrUeNetDevice> (device);
+              if (ueDevice != nullptr)
+                {
+                  ConnectUeRrc (ueDevice->GetRrc ());
+                }
+            }
+        }
       m_connected = true;
     }
 }
 
 void
-NrBearerStatsConnector::NotifyRandomAccessSuccessfulUe (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::ConnectEnbRrc (Ptr<LteEnbRrc> rrc)
+{
+  NS_LOG_FUNCTION (this << rrc);
+  rrc->TraceConnectWithoutContext ("NewUeContext",
+                                   MakeBoundCallback (&NrBearerStatsConnector::NotifyNewUeContextEnb, this, rrc));
+  rrc->TraceConnectWithoutContext ("ConnectionReconfiguration",
+                                   MakeBoundCallback (&NrBearerStatsConnector::NotifyConnectionReconfigurationEnb, this, rrc));
+  rrc->TraceConnectWithoutContext ("HandoverStart",
+                                   MakeBoundCallback (&NrBearerStatsConnector::NotifyHandoverStartEnb, this, rrc));
+  rrc->TraceConnectWithoutContext ("HandoverEndOk",
+                                   MakeBoundCallback (&NrBearerStatsConnector::NotifyHandoverEndOkEnb, this, rrc));
+}
+
+void
+NrBearerStatsConnector::ConnectUeRrc (Ptr<LteUeRrc> rrc)
+{
+  NS_LOG_FUNCTION (this << rrc);
+  rrc->TraceConnectWithoutContext ("RandomAccessSuccessful",
+                                   MakeBoundCallback (&NrBearerStatsConnector::NotifyRandomAccessSuccessfulUe, this, rrc));
+  rrc->TraceConnectWithoutContext ("ConnectionReconfiguration",
+                                   MakeBoundCallback (&NrBearerStatsConnector::NotifyConnectionReconfigurationUe, this, rrc));
+  rrc->TraceConnectWithoutContext ("HandoverStart",
+                                   MakeBoundCallback (&NrBearerStatsConnector::NotifyHandoverStartUe, this, rrc));
+  rrc->TraceConnectWithoutContext ("HandoverEndOk",
+                                   MakeBoundCallback (&NrBearerStatsConnector::NotifyHandoverEndOkUe, this, rrc));
+}
+
+void
+NrBearerStatsConnector::NotifyRandomAccessSuccessfulUe (NrBearerStatsConnector* c, Ptr<LteUeRrc> rrc, uint64_t imsi, uint16_t cellId, uint16_t rnti)
 {
-  c->ConnectSrb0Traces (context, imsi, cellId, rnti);
+  c->ConnectSrb0Traces (rrc, imsi, cellId, rnti);
 }
 
 void
-NrBearerStatsConnector::NotifyConnectionSetupUe (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::NotifyConnectionSetupUe (NrBearerStatsConnector* c, Ptr<LteUeRrc> rrc, uint64_t imsi, uint16_t cellId, uint16_t rnti)
 {
-  c->ConnectSrb1TracesUe (context, imsi, cellId, rnti);
+  c->ConnectSrb1TracesUe (rrc, imsi, cellId, rnti);
 }
 
 void
-NrBearerStatsConnector::NotifyConnectionReconfigurationUe (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::NotifyConnectionReconfigurationUe (NrBearerStatsConnector* c, Ptr<LteUeRrc> rrc, uint64_t imsi, uint16_t cellId, uint16_t rnti)
 {
-  c->ConnectTracesUeIfFirstTime (context, imsi, cellId, rnti);
+  c->ConnectTracesUeIfFirstTime (rrc, imsi, cellId, rnti);
 }
 
 void
-NrBearerStatsConnector::NotifyHandoverStartUe (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti, uint16_t targetCellId)
+NrBearerStatsConnector::NotifyHandoverStartUe (NrBearerStatsConnector* c, Ptr<LteUeRrc> rrc, uint64_t imsi, uint16_t cellId, uint16_t rnti, uint16_t targetCellId)
 {
-  c->DisconnectTracesUe (context, imsi, cellId, rnti);
+  c->DisconnectTracesUe (rrc, imsi, cellId, rnti);
 }
 
 void
-NrBearerStatsConnector::NotifyHandoverEndOkUe (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::NotifyHandoverEndOkUe (NrBearerStatsConnector* c, Ptr<LteUeRrc> rrc, uint64_t imsi, uint16_t cellId, uint16_t rnti)
 {
-  c->ConnectTracesUe (context, imsi, cellId, rnti);
+  c->ConnectTracesUe (rrc, imsi, cellId, rnti);
 }
 
 void
-NrBearerStatsConnector::NotifyNewUeContextEnb (NrBearerStatsConnector* c, std::string context, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::NotifyNewUeContextEnb (NrBearerStatsConnector* c, Ptr<LteEnbRrc> rrc, uint16_t cellId, uint16_t rnti)
 {
-  c->StoreUeManagerPath (context, cellId, rnti);
+  c->StoreUeManager (rrc, cellId, rnti);
 }
 
 void
-NrBearerStatsConnector::NotifyConnectionReconfigurationEnb (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::NotifyConnectionReconfigurationEnb (NrBearerStatsConnector* c, Ptr<LteEnbRrc> rrc, uint64_t imsi, uint16_t cellId, uint16_t rnti)
 {
-  c->ConnectTracesEnbIfFirstTime (context, imsi, cellId, rnti);
+  c->ConnectTracesEnbIfFirstTime (rrc, imsi, cellId, rnti);
 }
 
 void
-NrBearerStatsConnector::NotifyHandoverStartEnb (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti, uint16_t targetCellId)
+NrBearerStatsConnector::NotifyHandoverStartEnb (NrBearerStatsConnector* c, Ptr<LteEnbRrc> rrc, uint64_t imsi, uint16_t cellId, uint16_t rnti, uint16_t targetCellId)
 {
-  c->DisconnectTracesEnb (context, imsi, cellId, rnti);
+  c->DisconnectTracesEnb (rrc, imsi, cellId, rnti);
 }
 
 void
-NrBearerStatsConnector::NotifyHandoverEndOkEnb (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::NotifyHandoverEndOkEnb (NrBearerStatsConnector* c, Ptr<LteEnbRrc> rrc, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+{
+  c->ConnectTracesEnb (rrc, imsi, cellId, rnti);
+}
+
+uint32_t
+NrBearerStatsConnector::GetCellIdRntiKey (uint16_t cellId, uint16_t rnti)
 {
-  c->ConnectTracesEnb (context, imsi, cellId, rnti);
+  return (static_cast<uint32_t> (cellId) << 16) | rnti;
 }
 
 void
-NrBearerStatsConnector::StoreUeManagerPath (std::string context, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::StoreUeManager (Ptr<LteEnbRrc> rrc, uint16_t cellId, uint16_t rnti)
 {
-  NS_LOG_FUNCTION (this << context << cellId << rnti);
-  std::ostringstream ueManagerPath;
-  ueManagerPath <<  context.substr (0, context.rfind ("/")) << "/UeMap/" << (uint32_t) rnti;
-  CellIdRnti key;
-  key.cellId = cellId;
-  key.rnti = rnti;
-  m_ueManagerPathByCellIdRnti[key] = ueManagerPath.str ();
+  NS_LOG_FUNCTION (this << cellId << rnti);
+  m_ueManagerByCellIdRnti[GetCellIdRntiKey (cellId, rnti)] = rrc->GetUeManager (rnti);
 }
 
 void
-NrBearerStatsConnector::ConnectSrb0Traces (std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::ConnectSrb0Traces (Ptr<LteUeRrc> ueRrc, uint64_t imsi, uint16_t cellId, uint16_t rnti)
 {
   NS_LOG_FUNCTION (this << imsi << cellId << rnti);
-  std::string ueRrcPath =  context.substr (0, context.rfind ("/"));
-  CellIdRnti key;
-  key.cellId = cellId;
-  key.rnti = rnti;
-  std::map<CellIdRnti, std::string>::iterator it = m_ueManagerPathByCellIdRnti.find (key);
-  NS_ASSERT (it != m_ueManagerPathByCellIdRnti.end ());
-  std::string ueManagerPath = it->second;
-  NS_LOG_LOGIC (this << " ueManagerPath: " << ueManagerPath);
-  m_ueManagerPathByCellIdRnti.erase (it);
-
-  if (m_rlcStats)
-    {
-      Ptr<NrBoundCallbackArgument> arg = Create<NrBoundCallbackArgument> ();
-      arg->imsi = imsi;
-      arg->cellId = cellId;
-      arg->stats = m_rlcStats;
-
-      // diconnect eventually previously connected SRB0 both at UE and eNB
-      Config::Disconnect (ueRrcPath + "/Srb0/LteRlc/TxPDU",
-                          MakeBoundCallback (&UlTxPduCallback, arg));
-      Config::Disconnect (ueRrcPath + "/Srb0/LteRlc/RxPDU",
-                          MakeBoundCallback (&DlRxPduCallback, arg));
-      Config::Disconnect (ueManagerPath + "/Srb0/LteRlc/TxPDU",
-                          MakeBoundCallback (&DlTxPduCallback, arg));
-      Config::Disconnect (ueManagerPath + "/Srb0/LteRlc/RxPDU",
-                          MakeBoundCallback (&UlRxPduCallback, arg));
+  auto it = m_ueManagerByCellIdRnti.find (GetCellIdRntiKey (cellId, rnti));
+  NS_ASSERT (it != m_ueManagerByCellIdRnti.end ());
+  Ptr<UeManager> ueManager = it->second;
+  m_ueManagerByCellIdRnti.erase (it);
+
+  Ptr<LteSignalingRadioBearerInfo> ueSrb0 = GetSrb (ueRrc, "Srb0");
+  Ptr<LteSignalingRadioBearerInfo> enbSrb0 = GetSrb (ueManager, "Srb0");
+  Ptr<LteSignalingRadioBearerInfo> enbSrb1 = GetSrb (ueManager, "Srb1");
 
+  Ptr<NrBoundCallbackArgument> rlcArg = CreateBoundCallbackArgument (m_rlcStats, imsi, cellId);
+  if (rlcArg != nullptr)
+    {
       // connect SRB0 both at UE and eNB
-      Config::Connect (ueRrcPath + "/Srb0/LteRlc/TxPDU",
-                       MakeBoundCallback (&UlTxPduCallback, arg));
-      Config::Connect (ueRrcPath + "/Srb0/LteRlc/RxPDU",
-                       MakeBoundCallback (&DlRxPduCallback, arg));
-      Config::Connect (ueManagerPath + "/Srb0/LteRlc/TxPDU",
-                       MakeBoundCallback (&DlTxPduCallback, arg));
-      Config::Connect (ueManagerPath + "/Srb0/LteRlc/RxPDU",
-                       MakeBoundCallback (&UlRxPduCallback, arg));
+      ConnectPduTraces (ueSrb0 ? ueSrb0->m_rlc : nullptr, rlcArg, true);
+      ConnectPduTraces (enbSrb0 ? enbSrb0->m_rlc : nullptr, rlcArg, false);
 
       // connect SRB1 at eNB only (at UE SRB1 will be setup later)
-      Config::Connect (ueManagerPath + "/Srb1/LteRlc/TxPDU",
-                       MakeBoundCallback (&DlTxPduCallback, arg));
-      Config::Connect (ueManagerPath + "/Srb1/LteRlc/RxPDU",
-                       MakeBoundCallback (&UlRxPduCallback, arg));
+      ConnectPduTraces (enbSrb1 ? enbSrb1->m_rlc : nullptr, rlcArg, false);
     }
-  if (m_pdcpStats)
+  Ptr<NrBoundCallbackArgument> pdcpArg = CreateBoundCallbackArgument (m_pdcpStats, imsi, cellId);
+  if (pdcpArg != nullptr)
     {
-      Ptr<NrBoundCallbackArgument> arg = Create<NrBoundCallbackArgument> ();
-      arg->imsi = imsi;
-      arg->cellId = cellId;
-      arg->stats = m_pdcpStats;
-
       // connect SRB1 at eNB only (at UE SRB1 will be setup later)
-      Config::Connect (ueManagerPath + "/Srb1/LtePdcp/RxPDU",
-                       MakeBoundCallback (&UlRxPduCallback, arg));
-      Config::Connect (ueManagerPath + "/Srb1/LtePdcp/TxPDU",
-                       MakeBoundCallback (&DlTxPduCallback, arg));
+      ConnectPduTraces (enbSrb1 ? enbSrb1->m_pdcp : nullptr, pdcpArg, false);
     }
 }
 
 void
-NrBearerStatsConnector::ConnectSrb1TracesUe (std::string ueRrcPath, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::ConnectSrb1TracesUe (Ptr<LteUeRrc> ueRrc, uint64_t imsi, uint16_t cellId, uint16_t rnti)
 {
   NS_LOG_FUNCTION (this << imsi << cellId << rnti);
-  if (m_rlcStats)
+  Ptr<LteSignalingRadioBearerInfo> srb1 = GetSrb (ueRrc, "Srb1");
+  if (srb1 == nullptr)
     {
-      Ptr<NrBoundCallbackArgument> arg = Create<NrBoundCallbackArgument> ();
-      arg->imsi = imsi;
-      arg->cellId = cellId;
-      arg->stats = m_rlcStats;
-      Config::Connect (ueRrcPath + "/Srb1/LteRlc/TxPDU",
-                       MakeBoundCallback (&UlTxPduCallback, arg));
-      Config::Connect (ueRrcPath + "/Srb1/LteRlc/RxPDU",
-                       MakeBoundCallback (&DlRxPduCallback, arg));
-    }
-  if (m_pdcpStats)
-    {
-      Ptr<NrBoundCallbackArgument> arg = Create<NrBoundCallbackArgument> ();
-      arg->imsi = imsi;
-      arg->cellId = cellId;
-      arg->stats = m_pdcpStats;
-      Config::Connect (ueRrcPath + "/Srb1/LtePdcp/RxPDU",
-                       MakeBoundCallback (&DlRxPduCallback, arg));
-      Config::Connect (ueRrcPath + "/Srb1/LtePdcp/TxPDU",
-                       MakeBoundCallback (&UlTxPduCallback, arg));
+      return;
     }
+  ConnectPduTraces (srb1->m_rlc, CreateBoundCallbackArgument (m_rlcStats, imsi, cellId), true);
+  ConnectPduTraces (srb1->m_pdcp, CreateBoundCallbackArgument (m_pdcpStats, imsi, cellId), true);
 }
 
 void
-NrBearerStatsConnector::ConnectTracesUeIfFirstTime (std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::ConnectTracesUeIfFirstTime (Ptr<LteUeRrc> ueRrc, uint64_t imsi, uint16_t cellId, uint16_t rnti)
 {
-  NS_LOG_FUNCTION (this << context);
+  NS_LOG_FUNCTION (this << imsi);
   if (m_imsiSeenUe.find (imsi) == m_imsiSeenUe.end ())
     {
       m_imsiSeenUe.insert (imsi);
-      ConnectTracesUe (context, imsi, cellId, rnti);
+      ConnectTracesUe (ueRrc, imsi, cellId, rnti);
     }
 }
 
 void
-NrBearerStatsConnector::ConnectTracesEnbIfFirstTime (std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::ConnectTracesEnbIfFirstTime (Ptr<LteEnbRrc> enbRrc, uint64_t imsi, uint16_t cellId, uint16_t rnti)
 {
-  NS_LOG_FUNCTION (this << context);
+  NS_LOG_FUNCTION (this << imsi);
   if (m_imsiSeenEnb.find (imsi) == m_imsiSeenEnb.end ())
     {
       m_imsiSeenEnb.insert (imsi);
-      ConnectTracesEnb (context, imsi, cellId, rnti);
+      ConnectTracesEnb (enbRrc, imsi, cellId, rnti);
     }
 }
 
 void
-NrBearerStatsConnector::ConnectTracesUe (std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::ConnectRadioBearers (Ptr<Object> owner, bool withSrb0, bool atUe, uint64_t imsi, uint16_t cellId)
 {
-  NS_LOG_FUNCTION (this << context);
-  NS_LOG_LOGIC (this << "expected context should match /NodeList/*/DeviceList/*/LteUeRrc/");
-  std::string basePath = context.substr (0, context.rfind ("/"));
-  if (m_rlcStats)
-    {
-      Ptr<NrBoundCallbackArgument> arg = Create<NrBoundCallbackArgument> ();
-      arg->imsi = imsi;
-      arg->cellId = cellId;
-      arg->stats = m_rlcStats;
-      Config::Connect (basePath + "/DataRadioBearerMap/*/LteRlc/TxPDU",
-                       MakeBoundCallback (&UlTxPduCallback, arg));
-      Config::Connect (basePath + "/DataRadioBearerMap/*/LteRlc/RxPDU",
-                       MakeBoundCallback (&DlRxPduCallback, arg));
-      Config::Connect (basePath + "/Srb1/LteRlc/TxPDU",
-                       MakeBoundCallback (&UlTxPduCallback, arg));
-      Config::Connect (basePath + "/Srb1/LteRlc/RxPDU",
-                       MakeBoundCallback (&DlRxPduCallback, arg));
+  NS_LOG_FUNCTION (this << owner << withSrb0 << atUe << imsi << cellId);
+  Ptr<NrBoundCallbackArgument> rlcArg = CreateBoundCallbackArgument (m_rlcStats, imsi, cellId);
+  Ptr<NrBoundCallbackArgument> pdcpArg = CreateBoundCallbackArgument (m_pdcpStats, imsi, cellId);
 
+  for (const auto & drb : GetDrbs (owner))
+    {
+      ConnectPduTraces (drb->m_rlc, rlcArg, atUe);
+      ConnectPduTraces (drb->m_pdcp, pdcpArg, atUe);
     }
-  if (m_pdcpStats)
+  if (withSrb0)
     {
-      Ptr<NrBoundCallbackArgument> arg = Create<NrBoundCallbackArgument> ();
-      arg->imsi = imsi;
-      arg->cellId = cellId;
-      arg->stats = m_pdcpStats;
-      Config::Connect (basePath + "/DataRadioBearerMap/*/LtePdcp/RxPDU",
-                       MakeBoundCallback (&DlRxPduCallback, arg));
-      Config::Connect (basePath + "/DataRadioBearerMap/*/LtePdcp/TxPDU",
-                       MakeBoundCallback (&UlTxPduCallback, arg));
-      Config::Connect (basePath + "/Srb1/LtePdcp/RxPDU",
-                       MakeBoundCallback (&DlRxPduCallback, arg));
-      Config::Connect (basePath + "/Srb1/LtePdcp/TxPDU",
-                       MakeBoundCallback (&UlTxPduCallback, arg));
+      Ptr<LteSignalingRadioBearerInfo> srb0 = GetSrb (owner, "Srb0");
+      ConnectPduTraces (srb0 ? srb0->m_rlc : nullptr, rlcArg, atUe);
+    }
+  Ptr<LteSignalingRadioBearerInfo> srb1 = GetSrb (owner, "Srb1");
+  if (srb1 != nullptr)
+    {
+      ConnectPduTraces (srb1->m_rlc, rlcArg, atUe);
+      ConnectPduTraces (srb1->m_pdcp, pdcpArg, atUe);
     }
 }
 
 void
-NrBearerStatsConnector::ConnectTracesEnb (std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::ConnectTracesUe (Ptr<LteUeRrc> ueRrc, uint64_t imsi, uint16_t cellId, uint16_t rnti)
 {
-  NS_LOG_FUNCTION (this << context);
-  NS_LOG_LOGIC (this << "expected context  should match /NodeList/*/DeviceList/*/LteEnbRrc/");
-  std::ostringstream basePath;
-  basePath <<  context.substr (0, context.rfind ("/")) << "/UeMap/" << (uint32_t) rnti;
-  if (m_rlcStats)
-    {
-      Ptr<NrBoundCallbackArgument> arg = Create<NrBoundCallbackArgument> ();
-      arg->imsi = imsi;
-      arg->cellId = cellId;
-      arg->stats = m_rlcStats;
-      Config::Connect (basePath.str () + "/DataRadioBearerMap/*/LteRlc/RxPDU",
-                       MakeBoundCallback (&UlRxPduCallback, arg));
-      Config::Connect (basePath.str () + "/DataRadioBearerMap/*/LteRlc/TxPDU",
-                       MakeBoundCallback (&DlTxPduCallback, arg));
-      Config::Connect (basePath.str () + "/Srb0/LteRlc/RxPDU",
-                       MakeBoundCallback (&UlRxPduCallback, arg));
-      Config::Connect (basePath.str () + "/Srb0/LteRlc/TxPDU",
-                       MakeBoundCallback (&DlTxPduCallback, arg));
-      Config::Connect (basePath.str () + "/Srb1/LteRlc/RxPDU",
-                       MakeBoundCallback (&UlRxPduCallback, arg));
-      Config::Connect (basePath.str () + "/Srb1/LteRlc/TxPDU",
-                       MakeBoundCallback (&DlTxPduCallback, arg));
-    }
-  if (m_pdcpStats)
-    {
-      Ptr<NrBoundCallbackArgument> arg = Create<NrBoundCallbackArgument> ();
-      arg->imsi = imsi;
-      arg->cellId = cellId;
-      arg->stats = m_pdcpStats;
-      Config::Connect (basePath.str () + "/DataRadioBearerMap/*/LtePdcp/TxPDU",
-                       MakeBoundCallback (&DlTxPduCallback, arg));
-      Config::Connect (basePath.str () + "/DataRadioBearerMap/*/LtePdcp/RxPDU",
-                       MakeBoundCallback (&UlRxPduCallback, arg));
-      Config::Connect (basePath.str () + "/Srb1/LtePdcp/TxPDU",
-                       MakeBoundCallback (&DlTxPduCallback, arg));
-      Config::Connect (basePath.str () + "/Srb1/LtePdcp/RxPDU",
-                       MakeBoundCallback (&UlRxPduCallback, arg));
-    }
+  NS_LOG_FUNCTION (this << imsi << cellId << rnti);
+  ConnectRadioBearers (ueRrc, false, true, imsi, cellId);
+}
+
+void
+NrBearerStatsConnector::ConnectTracesEnb (Ptr<LteEnbRrc> enbRrc, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+{
+  NS_LOG_FUNCTION (this << imsi << cellId << rnti);
+  ConnectRadioBearers (enbRrc->GetUeManager (rnti), true, false, imsi, cellId);
 }
 
 void
-NrBearerStatsConnector::DisconnectTracesUe (std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::DisconnectTracesUe (Ptr<LteUeRrc> ueRrc, uint64_t imsi, uint16_t cellId, uint16_t rnti)
 {
   NS_LOG_FUNCTION (this);
 }
 
 
 void
-NrBearerStatsConnector::DisconnectTracesEnb (std::string context, uint64_t imsi, uint16_t cellId, uint16_t rnti)
+NrBearerStatsConnector::DisconnectTracesEnb (Ptr<LteEnbRrc> enbRrc, uint64_t imsi, uint16_t cellId, uint16_t rnti)
 {
   NS_LOG_FUNCTION (this);
 }
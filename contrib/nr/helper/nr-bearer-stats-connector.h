@@ -34,9 +34,11 @@
 #include <ns3/config.h>
 #include <ns3/simple-ref-count.h>
 #include <ns3/ptr.h>
+#include <ns3/lte-enb-rrc.h>
+#include <ns3/lte-ue-rrc.h>
 
 #include <set>
-#include <map>
+#include <unordered_map>
 
 namespace ns3 {
 
@@ -72,7 +74,8 @@ public:
   void EnablePdcpStats (Ptr<NrBearerStatsBase> pdcpStats);
 
   /**
-   * Connects trace sinks to appropriate trace sources
+   * Connects trace sinks to appropriate trace sources, on the RRC of the
+   * gNB and UE devices installed so far
    */
   void EnsureConnected ();
 
@@ -82,100 +85,100 @@ public:
    * Function hooked to RandomAccessSuccessful trace source at UE RRC,
    * which is fired upon successful completion of the random access procedure
    * \param c
-   * \param context
+   * \param rrc
    * \param imsi
    * \param cellid
    * \param rnti
    */
-  static void NotifyRandomAccessSuccessfulUe (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellid, uint16_t rnti);
+  static void NotifyRandomAccessSuccessfulUe (NrBearerStatsConnector* c, Ptr<LteUeRrc> rrc, uint64_t imsi, uint16_t cellid, uint16_t rnti);
 
   /**
    * Sink connected source of UE Connection Setup trace. Not used.
    * \param c
-   * \param context
+   * \param rrc
    * \param imsi
    * \param cellid
    * \param rnti
    */
-  static void NotifyConnectionSetupUe (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellid, uint16_t rnti);
+  static void NotifyConnectionSetupUe (NrBearerStatsConnector* c, Ptr<LteUeRrc> rrc, uint64_t imsi, uint16_t cellid, uint16_t rnti);
 
   /**
    * Function hooked to ConnectionReconfiguration trace source at UE RRC,
    * which is fired upon RRC connection reconfiguration
    * \param c
-   * \param context
+   * \param rrc
    * \param imsi
    * \param cellid
    * \param rnti
    */
-  static void NotifyConnectionReconfigurationUe (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellid, uint16_t rnti);
+  static void NotifyConnectionReconfigurationUe (NrBearerStatsConnector* c, Ptr<LteUeRrc> rrc, uint64_t imsi, uint16_t cellid, uint16_t rnti);
 
   /**
    * Function hooked to HandoverStart trace source at UE RRC,
    * which is fired upon start of a handover procedure
    * \param c
-   * \param context
+   * \param rrc
    * \param imsi
    * \param cellid
    * \param rnti
    * \param targetCellId
    */
-  static void NotifyHandoverStartUe (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellid, uint16_t rnti, uint16_t targetCellId);
+  static void NotifyHandoverStartUe (NrBearerStatsConnector* c, Ptr<LteUeRrc> rrc, uint64_t imsi, uint16_t cellid, uint16_t rnti, uint16_t targetCellId);
 
   /**
    * Function hooked to HandoverStart trace source at UE RRC,
    * which is fired upon successful termination of a handover procedure
    * \param c
-   * \param context
+   * \param rrc
    * \param imsi
    * \param cellid
    * \param rnti
    */
-  static void NotifyHandoverEndOkUe (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellid, uint16_t rnti);
+  static void NotifyHandoverEndOkUe (NrBearerStatsConnector* c, Ptr<LteUeRrc> rrc, uint64_t imsi, uint16_t cellid, uint16_t rnti);
 
   /**
    * Function hooked to NewUeContext trace source at eNB RRC,
    * which is fired upon creation of a new UE context
    * \param c
-   * \param context
+   * \param rrc
    * \param cellid
    * \param rnti
    */
-  static void NotifyNewUeContextEnb (NrBearerStatsConnector* c, std::string context, uint16_t cellid, uint16_t rnti);
+  static void NotifyNewUeContextEnb (NrBearerStatsConnector* c, Ptr<LteEnbRrc> rrc, uint16_t cellid, uint16_t rnti);
 
   /**
    * Function hooked to ConnectionReconfiguration trace source at eNB RRC,
    * which is fired upon RRC connection reconfiguration
    * \param c
-   * \param context
+   * \param rrc
    * \param imsi
    * \param cellid
    * \param rnti
    */
-  static void NotifyConnectionReconfigurationEnb (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellid, uint16_t rnti);
+  static void NotifyConnectionReconfigurationEnb (NrBearerStatsConnector* c, Ptr<LteEnbRrc> rrc, uint64_t imsi, uint16_t cellid, uint16_t rnti);
 
   /**
    * Function hooked to HandoverStart trace source at eNB RRC,
    * which is fired upon start of a handover procedure
    * \param c
-   * \param context
+   * \param rrc
    * \param imsi
    * \param cellid
    * \param rnti
    * \param targetCellId
    */
-  static void NotifyHandoverStartEnb (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellid, uint16_t rnti, uint16_t targetCellId);
+  static void NotifyHandoverStartEnb (NrBearerStatsConnector* c, Ptr<LteEnbRrc> rrc, uint64_t imsi, uint16_t cellid, uint16_t rnti, uint16_t targetCellId);
 
   /**
    * Function hooked to HandoverEndOk trace source at eNB RRC,
    * which is fired upon successful termination of a handover procedure
    * \param c
-   * \param context
+   * \param rrc
    * \param imsi
    * \param cellid
    * \param rnti
    */
-  static void NotifyHandoverEndOkEnb (NrBearerStatsConnector* c, std::string context, uint64_t imsi, uint16_t cellid, uint16_t rnti);
+  static void NotifyHandoverEndOkEnb (NrBearerStatsConnector* c, Ptr<LteEnbRrc> rrc, uint64_t imsi, uint16_t cellid, uint16_t rnti);
 
   /**
    * \return RLC stats
@@ -188,89 +191,120 @@ public:
 
 private:
   /**
-   * Creates UE Manager path and stores it in m_ueManagerPathByCellIdRnti
-   * \param ueManagerPath
+   * Connects the trace sources of an eNB RRC to the sinks of this connector
+   * \param rrc
+   */
+  void ConnectEnbRrc (Ptr<LteEnbRrc> rrc);
+
+  /**
+   * Connects the trace sources of a UE RRC to the sinks of this connector
+   * \param rrc
+   */
+  void ConnectUeRrc (Ptr<LteUeRrc> rrc);
+
+  /**
+   * Gets the key of m_ueManagerByCellIdRnti
+   * \param cellId
+   * \param rnti
+   * \return the key
+   */
+  static uint32_t GetCellIdRntiKey (uint16_t cellId, uint16_t rnti);
+
+  /**
+   * Stores the UE Manager of a new UE context in m_ueManagerByCellIdRnti
+   * \param rrc
    * \param cellId
    * \param rnti
    */
-  void StoreUeManagerPath (std::string ueManagerPath, uint16_t cellId, uint16_t rnti);
+  void StoreUeManager (Ptr<LteEnbRrc> rrc, uint16_t cellId, uint16_t rnti);
+
+  /**
+   * Connects the trace sources of the DRBs and of SRB1 (and SRB0, if asked)
+   * of a UE RRC or of an eNB UE manager to RLC and PDCP calculators
+   * \param owner the UE RRC or the UE manager
+   * \param withSrb0 true to connect also SRB0
+   * \param atUe true if owner is a UE RRC
+   * \param imsi
+   * \param cellId
+   */
+  void ConnectRadioBearers (Ptr<Object> owner, bool withSrb0, bool atUe, uint64_t imsi, uint16_t cellId);
 
   /**
    * Connects Srb0 trace sources at UE and eNB to RLC and PDCP calculators,
    * and Srb1 trace sources at eNB to RLC and PDCP calculators,
-   * \param ueRrcPath
+   * \param ueRrc
    * \param imsi
    * \param cellId
    * \param rnti
    */
-  void ConnectSrb0Traces (std::string ueRrcPath, uint64_t imsi, uint16_t cellId, uint16_t rnti);
+  void ConnectSrb0Traces (Ptr<LteUeRrc> ueRrc, uint64_t imsi, uint16_t cellId, uint16_t rnti);
 
   /**
    * Connects Srb1 trace sources at UE to RLC and PDCP calculators
-   * \param ueRrcPath
+   * \param ueRrc
    * \param imsi
    * \param cellId
    * \param rnti
    */
-  void ConnectSrb1TracesUe (std::string ueRrcPath, uint64_t imsi, uint16_t cellId, uint16_t rnti);
+  void ConnectSrb1TracesUe (Ptr<LteUeRrc> ueRrc, uint64_t imsi, uint16_t cellId, uint16_t rnti);
 
   /**
    * Connects all trace sources at UE to RLC and PDCP calculators.
    * This function can connect traces only once for UE.
-   * \param context
+   * \param ueRrc
    * \param imsi
    * \param cellid
    * \param rnti
    */
-  void ConnectTracesUeIfFirstTime (std::string context, uint64_t imsi, uint16_t cellid, uint16_t rnti);
+  void ConnectTracesUeIfFirstTime (Ptr<LteUeRrc> ueRrc, uint64_t imsi, uint16_t cellid, uint16_t rnti);
 
   /**
    * Connects all trace sources at eNB to RLC and PDCP calculators.
    * This function can connect traces only once for eNB.
-   * \param context
+   * \param enbRrc
    * \param imsi
    * \param cellid
    * \param rnti
    */
-  void ConnectTracesEnbIfFirstTime (std::string context, uint64_t imsi, uint16_t cellid, uint16_t rnti);
+  void ConnectTracesEnbIfFirstTime (Ptr<LteEnbRrc> enbRrc, uint64_t imsi, uint16_t cellid, uint16_t rnti);
 
   /**
    * Connects all trace sources at UE to RLC and PDCP calculators.
-   * \param context
+   * \param ueRrc
    * \param imsi
    * \param cellid
    * \param rnti
    */
-  void ConnectTracesUe (std::string context, uint64_t imsi, uint16_t cellid, uint16_t rnti);
+  void ConnectTracesUe (Ptr<LteUeRrc> ueRrc, uint64_t imsi, uint16_t cellid, uint16_t rnti);
 
   /**
    * Disconnects all trace sources at UE to RLC and PDCP calculators.
    * Function is not implemented.
-   * \param context
+   * \param ueRrc
    * \param imsi
    * \param cellid
    * \param rnti
    */
-  void DisconnectTracesUe (std::string context, uint64_t imsi, uint16_t cellid, uint16_t rnti);
+  void DisconnectTracesUe (Ptr<LteUeRrc> ueRrc, uint64_t imsi, uint16_t cellid, uint16_t rnti);
 
   /**
    * Connects all trace sources at eNB to RLC and PDCP calculators
-   * \param context
+   * \param enbRrc
    * \param imsi
    * \param cellid
    * \param rnti
    */
-  void ConnectTracesEnb (std::string context, uint64_t imsi, uint16_t cellid, uint16_t rnti);
+  void ConnectTracesEnb (Ptr<LteEnbRrc> enbRrc, uint64_t imsi, uint16_t cellid, uint16_t rnti);
 
   /**
    * Disconnects all trace sources at eNB to RLC and PDCP calculators.
    * Function is not implemented.
-   * \param context
+   * \param enbRrc
    * \param imsi
    * \param cellid
    * \param rnti
    */
-  void DisconnectTracesEnb (std::string context, uint64_t imsi, uint16_t cellid, uint16_t rnti);
+  void DisconnectTracesEnb (Ptr<LteEnbRrc> enbRrc, uint64_t imsi, uint16_t cellid, uint16_t rnti);
 
   Ptr<NrBearerStatsBase> m_rlcStats; //!< Calculator for RLC Statistics
   Ptr<NrBearerStatsBase> m_pdcpStats; //!< Calculator for PDCP Statistics
@@ -280,23 +314,10 @@ private:
   std::set<uint64_t> m_imsiSeenEnb; //!< stores all eNBs for which RLC and PDCP traces were connected
 
   /**
-   * Struct used as key in m_ueManagerPathByCellIdRnti map
-   */
-  struct CellIdRnti
-  {
-    uint16_t cellId; //!< cellId
-    uint16_t rnti; //!< rnti
-  };
-
-  /**
-   * Less than operator for CellIdRnti, because it is used as key in map
-   */
-  friend bool operator < (const CellIdRnti &a, const CellIdRnti &b);
-
-  /**
-   * List UE Manager Paths by CellIdRnti
+   * UE Managers of the new UE contexts, by GetCellIdRntiKey, until the
+   * random access of the UE succeeds
    */
-  std::map<CellIdRnti, std::string> m_ueManagerPathByCellIdRnti;
+  std::unordered_map<uint32_t, Ptr<UeManager> > m_ueManagerByCellIdRnti;
 
 };
 
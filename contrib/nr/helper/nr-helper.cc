@@ -43,6 +43,7 @@
 #include <ns3/nr-phy-rx-trace.h>
 #include <ns3/nr-mac-rx-trace.h>
 #include "nr-bearer-stats-calculator.h"
+#include "nr-aoi-stats-calculator.h"
 #include <ns3/bandwidth-part-ue.h>
 #include <ns3/beam-manager.h>
 #include <ns3/three-gpp-propagation-loss-model.h>
@@ -430,6 +431,23 @@ NrHelper::GetScheduler(const Ptr<NetDevice> &gnbDevice, uint32_t bwpIndex)
   return netDevice->GetScheduler (bwpIndex);
 }
 
+void
+NrHelper::SetCgTrafficProfile (const NetDeviceContainer &ueDevices, uint8_t lcid,
+                               const NrCgTrafficProfile &profile)
+{
+  NS_LOG_FUNCTION (static_cast<uint32_t> (lcid));
+
+  for (auto it = ueDevices.Begin (); it != ueDevices.End (); ++it)
+    {
+      Ptr<NrUeNetDevice> netDevice = DynamicCast<NrUeNetDevice> (*it);
+      NS_ABORT_MSG_IF (netDevice == nullptr, "SetCgTrafficProfile needs UE devices");
+      for (uint32_t bwp = 0; bwp < netDevice->GetCcMapSize (); ++bwp)
+        {
+          GetUeMac (*it, bwp)->SetCgTrafficProfile (lcid, profile);
+        }
+    }
+}
+
 void
 NrHelper::SetHarqEnabled (bool harqEnabled)
 {
@@ -1680,6 +1698,25 @@ NrHelper::EnableUlMacSchedTraces ()
                    MakeBoundCallback (&NrMacSchedulingStats::UlSchedulingCallback, m_macSchedStats));
 }
 
+void
+NrHelper::EnableAoiTraces ()
+{
+  NS_LOG_FUNCTION_NOARGS ();
+  if (m_aoiStats != nullptr)
+    {
+      return; // already connected
+    }
+  m_aoiStats = CreateObject<NrAoiStatsCalculator> ();
+  Config::Connect ("/NodeList/*/DeviceList/*/BandwidthPartMap/*/NrGnbMac/AoiSample",
+                   MakeBoundCallback (&NrAoiStatsCalculator::AoiSampleCallback, m_aoiStats));
+}
+
+Ptr<NrAoiStatsCalculator>
+NrHelper::GetAoiStatsCalculator (void)
+{
+  return m_aoiStats;
+}
+
 void
 NrHelper::EnablePathlossTraces ()
 {
@@ -44,6 +44,7 @@ class NrGnbMac;
 class EpcHelper;
 class EpcTft;
 class NrBearerStatsCalculator;
+class NrAoiStatsCalculator;
 class NrMacRxTrace;
 class NrPhyRxTrace;
 class ComponentCarrierEnb;
@@ -305,6 +306,17 @@ public:
    */
   static Ptr<NrMacScheduler> GetScheduler (const Ptr<NetDevice> &gnbDevice, uint32_t bwpIndex);
 
+  /**
+   * \brief Set the configured-grant traffic profile of a LC in the UEs specified
+   * \param ueDevices UE devices, obtained from InstallUeDevice()
+   * \param lcid the LC ID
+   * \param profile the profile (see NrUeMac::SetCgTrafficProfile)
+   *
+   * The profile is set in the MAC of every BWP of the UEs.
+   */
+  static void SetCgTrafficProfile (const NetDeviceContainer &ueDevices, uint8_t lcid,
+                                   const NrCgTrafficProfile &profile);
+
   /**
    * \brief Attach the UE specified to the closest GNB
    * \param ueDevices UE devices to attach
@@ -325,6 +337,7 @@ public:
    * RLC traces
    * PDCP traces
    *
+   * The AoI traces are not included: see EnableAoiTraces
    */
   void EnableTraces ();
 
@@ -823,6 +836,17 @@ public:
    */
   void EnableUlMacSchedTraces (void);
 
+  /**
+   * Enable the AoI statistics of the UL flows, from the AoiSample trace of the gNB MACs.
+   * They are not enabled by EnableTraces: call this method to write them.
+   */
+  void EnableAoiTraces (void);
+
+  /**
+   * \return The NrAoiStatsCalculator stats calculator object, or nullptr if the AoI traces are not enabled
+   */
+  Ptr<NrAoiStatsCalculator> GetAoiStatsCalculator (void);
+
   /**
    * \brief Enable trace sinks for DL and UL pathloss
    */
@@ -937,6 +961,7 @@ private:
   std::map<uint8_t, ComponentCarrier> m_componentCarrierPhyParams; //!< component carrier map
   std::vector< Ptr <Object> > m_channelObjectsWithAssignedStreams; //!< channel and propagation objects to which NrHelper has assigned streams in order to avoid double assignments
   Ptr<NrMacSchedulingStats> m_macSchedStats; //!<< Pointer to NrMacStatsCalculator
+  Ptr<NrAoiStatsCalculator> m_aoiStats; //!< Pointer to the AoI stats calculator
   //Configured Grant
   bool m_configuredGrant{false};
 
@@ -19,6 +19,8 @@
 
 #include "nr-spectrum-value-helper.h"
 #include <map>
+#include <unordered_map>
+#include <algorithm>
 #include <cmath>
 #include <ns3/log.h>
 #include <ns3/fatal-error.h>
@@ -69,6 +71,69 @@ operator < (const NrSpectrumModelId& a, const NrSpectrumModelId& b)
 
 static std::map<NrSpectrumModelId, Ptr<SpectrumModel> > g_nrSpectrumModelMap; ///< nr spectrum model map
 
+/**
+ * \brief Key of the TX PSD cache
+ */
+struct NrTxPsdId
+{
+  SpectrumModelUid_t smUid;   ///< spectrum model UID
+  double powerTx;             ///< total power in dBm
+  uint32_t numRbPerRbg;       ///< RBs per RBG
+  uint8_t allocationType;     ///< power allocation type
+  std::vector<uint8_t> rbgBitmask; ///< RBG bitmask
+
+  /**
+   * \brief Equality operator
+   * \param o other key
+   * \return true if all the fields are equal
+   */
+  bool operator == (const NrTxPsdId &o) const
+  {
+    return smUid == o.smUid && powerTx == o.powerTx && numRbPerRbg == o.numRbPerRbg
+      && allocationType == o.allocationType && rbgBitmask == o.rbgBitmask;
+  }
+};
+
+/**
+ * \brief Hash of the TX PSD cache key
+ */
+struct NrTxPsdIdHash
+{
+  /**
+   * \brief FNV-1a over the key fields and the bitmask
+   * \param k the key
+   * \return the hash
+   */
+  std::size_t operator () (const NrTxPsdId &k) const
+  {
+    uint64_t h = 14695981039346656037ULL;
+    auto mix = [&h] (uint64_t v)
+      {
+        h ^= v;
+        h *= 1099511628211ULL;
+      };
+    mix (k.smUid);
+    mix (std::hash<double> () (k.powerTx));
+    mix (k.numRbPerRbg);
+    mix (k.allocationType);
+    for (auto b : k.rbgBitmask)
+      {
+        mix (b);
+      }
+    return static_cast<std::size_t> (h);
+  }
+};
+
+/**
+ * Maximum number of cached TX PSDs. Closed-loop power control can produce
+ * many distinct powers; when the cache is full it is simply emptied.
+ */
+static const std::size_t MAX_TX_PSD_CACHE_SIZE = 4096;
+
+static std::unordered_map<NrTxPsdId, Ptr<SpectrumValue>, NrTxPsdIdHash> g_nrTxPsdCache; ///< TX PSD cache
+static uint64_t g_nrTxPsdCacheHits = 0;    ///< TX PSD cache hits
+static uint64_t g_nrTxPsdCacheMisses = 0;  ///< TX PSD cache misses
+
 Ptr<const SpectrumModel>
 NrSpectrumValueHelper::GetSpectrumModel (uint32_t numRbs, double centerFrequency, double subcarrierSpacing)
 {
@@ -170,6 +235,109 @@ NrSpectrumValueHelper::CreateTxPowerSpectralDensity (double powerTx, const std::
 }
 
 
+Ptr<SpectrumValue>
+NrSpectrumValueHelper::CreateTxPowerSpectralDensity (double powerTx, const std::vector<uint8_t> &rbgBitmask,
+                                                     uint32_t numRbPerRbg,
+                                                     const Ptr<const SpectrumModel>& txSm,
+                                                     enum PowerAllocationType allocationType)
+{
+  NS_LOG_FUNCTION (powerTx << numRbPerRbg << txSm << allocationType);
+  Ptr<SpectrumValue> txPsd = Create <SpectrumValue> (txSm);
+  double subbandWidth = (txSm->Begin()->fh - txSm->Begin()->fl);
+  NS_ABORT_MSG_IF(subbandWidth < 180000, "Erroneous spectrum model. RB width should be equal or greater than 180KHz");
+
+  std::size_t numActiveRbs = 0;
+  switch (allocationType)
+  {
+    case UNIFORM_POWER_ALLOCATION_BW:
+      numActiveRbs = txSm->GetNumBands ();
+      break;
+    case UNIFORM_POWER_ALLOCATION_USED:
+      numActiveRbs = std::count (rbgBitmask.begin (), rbgBitmask.end (), 1) * numRbPerRbg;
+      break;
+    default:
+      NS_FATAL_ERROR ("Unknown power allocation type.");
+  }
+  if (numActiveRbs == 0)
+    {
+      return txPsd;
+    }
+
+  double powerTxW = std::pow (10., (powerTx - 30) / 10);
+  double txPowerDensity = powerTxW / (subbandWidth * numActiveRbs);
+
+  // Fill each run of consecutive active RBGs with one contiguous store,
+  // which the compiler turns into vector stores
+  Values::iterator values = txPsd->ValuesBegin ();
+  std::size_t numRbgs = rbgBitmask.size ();
+  std::size_t rbg = 0;
+  while (rbg < numRbgs)
+    {
+      if (rbgBitmask[rbg] != 1)
+        {
+          ++rbg;
+          continue;
+        }
+      std::size_t runStart = rbg;
+      while (rbg < numRbgs && rbgBitmask[rbg] == 1)
+        {
+          ++rbg;
+        }
+      NS_ASSERT (rbg * numRbPerRbg <= txSm->GetNumBands ());
+      std::fill (values + runStart * numRbPerRbg, values + rbg * numRbPerRbg, txPowerDensity);
+    }
+  NS_LOG_LOGIC (*txPsd);
+  return txPsd;
+}
+
+Ptr<SpectrumValue>
+NrSpectrumValueHelper::GetCachedTxPowerSpectralDensity (double powerTx, const std::vector<uint8_t> &rbgBitmask,
+                                                        uint32_t numRbPerRbg,
+                                                        const Ptr<const SpectrumModel>& txSm,
+                                                        enum PowerAllocationType allocationType)
+{
+  NS_LOG_FUNCTION (powerTx << numRbPerRbg << txSm << allocationType);
+  NrTxPsdId key {txSm->GetUid (), powerTx, numRbPerRbg,
+                 static_cast<uint8_t> (allocationType), rbgBitmask};
+
+  auto it = g_nrTxPsdCache.find (key);
+  if (it != g_nrTxPsdCache.end ())
+    {
+      ++g_nrTxPsdCacheHits;
+      return it->second;
+    }
+
+  ++g_nrTxPsdCacheMisses;
+  if (g_nrTxPsdCache.size () >= MAX_TX_PSD_CACHE_SIZE)
+    {
+      NS_LOG_INFO ("TX PSD cache full, emptying it");
+      g_nrTxPsdCache.clear ();
+    }
+  Ptr<SpectrumValue> txPsd = CreateTxPowerSpectralDensity (powerTx, rbgBitmask, numRbPerRbg, txSm, allocationType);
+  g_nrTxPsdCache.emplace (std::move (key), txPsd);
+  return txPsd;
+}
+
+void
+NrSpectrumValueHelper::ClearTxPsdCache ()
+{
+  g_nrTxPsdCache.clear ();
+  g_nrTxPsdCacheHits = 0;
+  g_nrTxPsdCacheMisses = 0;
+}
+
+uint64_t
+NrSpectrumValueHelper::GetTxPsdCacheHits ()
+{
+  return g_nrTxPsdCacheHits;
+}
+
+uint64_t
+NrSpectrumValueHelper::GetTxPsdCacheMisses ()
+{
+  return g_nrTxPsdCacheMisses;
+}
+
 Ptr<SpectrumValue>
 NrSpectrumValueHelper::CreateNoisePowerSpectralDensity (double noiseFigureDb, const Ptr<const SpectrumModel>& spectrumModel)
 {
@@ -67,6 +67,65 @@ public:
                                                                 const Ptr<const SpectrumModel>& txSm,
                                                                 enum PowerAllocationType allocationType);
 
+  /**
+   * \brief Create SpectrumValue that will represent transmit power spectral density,
+   * directly from the RBG bitmask of the DCI.
+   *
+   * Equivalent to CreateTxPowerSpectralDensity () called with the RBs of
+   * NrPhy::FromRBGBitmaskToRBAssignment (), but the bands of each run of
+   * active RBGs are filled with a single contiguous store, without
+   * expanding the bitmask into a vector of RB indexes.
+   *
+   * \param powerTx total power in dBm
+   * \param rbgBitmask the RBG bitmask of the transmission
+   * \param numRbPerRbg number of RBs in each RBG
+   * \param txSm spectrumModel to be used to create this SpectrumValue
+   * \param allocationType power allocation type to be used
+   * \return spectrum value representing power spectral density for given parameters
+   */
+  static Ptr<SpectrumValue> CreateTxPowerSpectralDensity (double powerTx, const std::vector<uint8_t> &rbgBitmask,
+                                                          uint32_t numRbPerRbg,
+                                                          const Ptr<const SpectrumModel>& txSm,
+                                                          enum PowerAllocationType allocationType);
+
+  /**
+   * \brief Obtain from a global cache, or create and cache, the transmit power
+   * spectral density for the given RBG bitmask.
+   *
+   * The returned SpectrumValue is shared by all the callers that ask for the
+   * same (spectrum model, power, RBG bitmask, allocation type), and therefore
+   * it MUST NOT be modified. Periodic transmissions (e.g., configured grant)
+   * that reuse the same mask with the same power hit the cache every time.
+   *
+   * \param powerTx total power in dBm
+   * \param rbgBitmask the RBG bitmask of the transmission
+   * \param numRbPerRbg number of RBs in each RBG
+   * \param txSm spectrumModel to be used to create this SpectrumValue
+   * \param allocationType power allocation type to be used
+   * \return the shared, immutable, spectrum value
+   */
+  static Ptr<SpectrumValue> GetCachedTxPowerSpectralDensity (double powerTx, const std::vector<uint8_t> &rbgBitmask,
+                                                             uint32_t numRbPerRbg,
+                                                             const Ptr<const SpectrumModel>& txSm,
+                                                             enum PowerAllocationType allocationType);
+
+  /**
+   * \brief Empty the TX PSD cache and reset its statistics
+   */
+  static void ClearTxPsdCache ();
+
+  /**
+   * \brief Get the number of TX PSD requests served from the cache
+   * \return the number of cache hits since the last ClearTxPsdCache ()
+   */
+  static uint64_t GetTxPsdCacheHits ();
+
+  /**
+   * \brief Get the number of TX PSD requests that created a new SpectrumValue
+   * \return the number of cache misses since the last ClearTxPsdCache ()
+   */
+  static uint64_t GetTxPsdCacheMisses ();
+
   /**
    * \brief Create a SpectrumValue that models the power spectral density of AWGN
    * \param noiseFigure the noise figure in dB  w.r.t. a reference temperature of 290K
@@ -1,5 +1,8 @@
 /* a-packet-tags.h */
 
+// 새 코드에서는 세 태그를 하나로 합친 NrAoiMetadataTag (nr-aoi-metadata-tag.h)를 사용하세요.
+// 이 태그들은 기존 시나리오와의 호환을 위해 남겨둡니다 (NrUlTbTag::ExtractSubPdu가 변환).
+
 #ifndef PACKET_TAGS_H
 #define PACKET_TAGS_H
 
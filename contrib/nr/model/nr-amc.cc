@@ -23,6 +23,8 @@
 #include <ns3/math.h>
 #include <ns3/enum.h>
 #include <ns3/uinteger.h>
+#include <ns3/boolean.h>
+#include <ns3/abort.h>
 #include "nr-error-model.h"
 #include "nr-lte-mi-error-model.h"
 #include "lena-error-model.h"
@@ -46,6 +48,7 @@ NrAmc::SetDlMode ()
 {
   NS_LOG_FUNCTION (this);
   m_emMode = NrErrorModel::DL;
+  ClearTbsTable ();
 }
 
 void
@@ -53,6 +56,7 @@ NrAmc::SetUlMode ()
 {
   NS_LOG_FUNCTION (this);
   m_emMode = NrErrorModel::UL;
+  ClearTbsTable ();
 }
 
 TypeId
@@ -81,6 +85,18 @@ NrAmc::GetTypeId (void)
                    MakeTypeIdAccessor (&NrAmc::SetErrorModelType,
                                        &NrAmc::GetErrorModelType),
                    MakeTypeIdChecker ())
+    .AddAttribute ("BinaryMcsSearch",
+                   "When AmcModel is ErrorModel, search the MCS by bisection instead of "
+                   "evaluating all the MCSs (the TBLER must be non-decreasing with the MCS)",
+                   BooleanValue (true),
+                   MakeBooleanAccessor (&NrAmc::m_binaryMcsSearch),
+                   MakeBooleanChecker ())
+    .AddAttribute ("VerifyMcsSearch",
+                   "Cross-check the result of the MCS bisection with the exhaustive search, "
+                   "and abort in case of mismatch",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NrAmc::m_verifyMcsSearch),
+                   MakeBooleanChecker ())
     .AddConstructor <NrAmc> ()
   ;
   return tid;
@@ -121,9 +137,20 @@ NrAmc::GetNumRefScPerRb () const
 void NrAmc::SetNumRefScPerRb(uint8_t nref)
 {
   NS_LOG_FUNCTION (this);
+  if (nref != m_numRefScPerRb)
+    {
+      ClearTbsTable ();
+    }
   m_numRefScPerRb = nref;
 }
 
+void
+NrAmc::ClearTbsTable ()
+{
+  NS_LOG_FUNCTION (this);
+  m_tbsTable.clear ();
+}
+
 uint32_t
 NrAmc::CalculateTbSize (uint8_t mcs, uint32_t nprb) const
 {
@@ -132,6 +159,44 @@ NrAmc::CalculateTbSize (uint8_t mcs, uint32_t nprb) const
   NS_ASSERT_MSG (mcs <= m_errorModel->GetMaxMcs (), "MCS=" << static_cast<uint32_t> (mcs) <<
                  " while maximum MCS is " << static_cast<uint32_t> (m_errorModel->GetMaxMcs ()));
 
+  if (nprb > MAX_TBS_TABLE_PRB)
+    {
+      return ComputeTbSize (mcs, nprb);
+    }
+
+  if (m_tbsTable.empty ())
+    {
+      m_tbsTable.assign ((m_errorModel->GetMaxMcs () + 1) * (MAX_TBS_TABLE_PRB + 1), UINT32_MAX);
+    }
+
+  uint32_t & tbSize = m_tbsTable[mcs * (MAX_TBS_TABLE_PRB + 1) + nprb];
+  if (tbSize == UINT32_MAX)
+    {
+      tbSize = ComputeTbSize (mcs, nprb);
+    }
+
+  return tbSize;
+}
+
+void
+NrAmc::CalculateTbSizes (uint8_t mcs, uint32_t minPrb, uint32_t maxPrb,
+                         std::vector<uint32_t> *tbSizes) const
+{
+  NS_LOG_FUNCTION (this << static_cast<uint32_t> (mcs) << minPrb << maxPrb);
+  NS_ASSERT (minPrb <= maxPrb);
+
+  tbSizes->resize (maxPrb - minPrb + 1);
+  for (uint32_t nprb = minPrb; nprb <= maxPrb; ++nprb)
+    {
+      (*tbSizes)[nprb - minPrb] = CalculateTbSize (mcs, nprb);
+    }
+}
+
+uint32_t
+NrAmc::ComputeTbSize (uint8_t mcs, uint32_t nprb) const
+{
+  NS_LOG_FUNCTION (this << static_cast<uint32_t> (mcs) << nprb);
+
   uint32_t payloadSize = GetPayloadSize (mcs, nprb);
   uint32_t tbSize = payloadSize;
 
@@ -161,6 +226,18 @@ NrAmc::GetPayloadSize (uint8_t mcs, uint32_t nprb) const
                                        mcs, nprb, m_emMode);
 }
 
+void
+NrAmc::GetSpectralEfficiencies (const double *sinr, size_t n, double *se) const
+{
+  NS_LOG_FUNCTION (this << n);
+  // SINR / (-ln(5*BER)/1.5), see CreateCqiFeedbackWbTdma
+  const double invGap = 1.5 / (-std::log (5.0 * GetBer ()));
+  for (size_t i = 0; i < n; ++i)
+    {
+      se[i] = std::log2 (1.0 + sinr[i] * invGap);
+    }
+}
+
 uint8_t
 NrAmc::CreateCqiFeedbackWbTdma (const SpectrumValue& sinr, uint8_t &mcs) const
 {
@@ -238,27 +315,28 @@ NrAmc::CreateCqiFeedbackWbTdma (const SpectrumValue& sinr, uint8_t &mcs) const
         }
       sinrAvg /= rbMap.size ();
 
-      mcs = 0;
-      Ptr<NrErrorModelOutput> output;
-      while (mcs <= m_errorModel->GetMaxMcs ())
+      uint32_t firstFailing;
+      if (m_binaryMcsSearch)
         {
-          output = m_errorModel->GetTbDecodificationStats (sinr, rbMap,
-                                                           CalculateTbSize (mcs, rbMap.size ()),
-                                                           mcs,
-                                                           NrErrorModel::NrErrorModelHistory ());
-          if (output->m_tbler > 0.1)
+          firstFailing = FindFirstFailingMcsBinary (sinr, rbMap);
+          if (m_verifyMcsSearch)
             {
-              break;
+              uint32_t linear = FindFirstFailingMcsLinear (sinr, rbMap);
+              NS_ABORT_MSG_IF (linear != firstFailing,
+                               "MCS bisection found " << firstFailing <<
+                               " as first MCS over the target TBLER, exhaustive search found " << linear);
             }
-          mcs++;
         }
-
-      if (mcs > 0)
+      else
         {
-          mcs--;
+          firstFailing = FindFirstFailingMcsLinear (sinr, rbMap);
         }
 
-      if ((output->m_tbler > 0.1) && (mcs == 0))
+      mcs = firstFailing > 0 ? static_cast<uint8_t> (firstFailing - 1) : 0;
+
+      // as in the exhaustive search, MCS 0 (and CQI 0) is reported if either
+      // MCS 0 or MCS 1 do not guarantee the target TBLER
+      if (firstFailing <= 1 && firstFailing <= m_errorModel->GetMaxMcs ())
         {
           cqi = 0;
         }
@@ -280,6 +358,57 @@ NrAmc::CreateCqiFeedbackWbTdma (const SpectrumValue& sinr, uint8_t &mcs) const
   return cqi;
 }
 
+bool
+NrAmc::IsMcsDecodable (const SpectrumValue& sinr, const std::vector<int> &rbMap, uint8_t mcs) const
+{
+  NS_LOG_FUNCTION (this << static_cast<uint32_t> (mcs));
+  Ptr<NrErrorModelOutput> output;
+  output = m_errorModel->GetTbDecodificationStats (sinr, rbMap,
+                                                   CalculateTbSize (mcs, rbMap.size ()),
+                                                   mcs,
+                                                   NrErrorModel::NrErrorModelHistory ());
+  return output->m_tbler <= 0.1;
+}
+
+uint32_t
+NrAmc::FindFirstFailingMcsLinear (const SpectrumValue& sinr, const std::vector<int> &rbMap) const
+{
+  NS_LOG_FUNCTION (this);
+  uint32_t mcs = 0;
+  while (mcs <= m_errorModel->GetMaxMcs ())
+    {
+      if (! IsMcsDecodable (sinr, rbMap, static_cast<uint8_t> (mcs)))
+        {
+          break;
+        }
+      mcs++;
+    }
+  return mcs;
+}
+
+uint32_t
+NrAmc::FindFirstFailingMcsBinary (const SpectrumValue& sinr, const std::vector<int> &rbMap) const
+{
+  NS_LOG_FUNCTION (this);
+  // invariant: all the MCSs below low are decodable, high is not (or it is
+  // past the maximum MCS)
+  uint32_t low = 0;
+  uint32_t high = m_errorModel->GetMaxMcs () + 1;
+  while (low < high)
+    {
+      uint32_t mid = low + (high - low) / 2;
+      if (IsMcsDecodable (sinr, rbMap, static_cast<uint8_t> (mid)))
+        {
+          low = mid + 1;
+        }
+      else
+        {
+          high = mid;
+        }
+    }
+  return low;
+}
+
 uint8_t
 NrAmc::GetCqiFromSpectralEfficiency (double s) const
 {
@@ -339,6 +468,7 @@ NrAmc::SetErrorModelType (const TypeId &type)
   factory.SetTypeId (m_errorModelType);
   m_errorModel = DynamicCast<NrErrorModel> (factory.Create ());
   NS_ASSERT (m_errorModel != nullptr);
+  ClearTbsTable ();
 }
 
 TypeId
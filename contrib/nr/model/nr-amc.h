@@ -21,6 +21,7 @@
 
 #include <ns3/nr-phy-mac-common.h>
 #include <ns3/nr-error-model.h>
+#include <vector>
 
 namespace ns3 {
 
@@ -129,6 +130,12 @@ public:
    * which the gNB/UE has transmitted power, and from which the SINR can be
    * measured, during 1 OFDM symbol, is assumed.
    *
+   * With the ErrorModel AMC model, the highest MCS that guarantees a TBLER
+   * of at most 10% is searched. By default (attribute BinaryMcsSearch), the
+   * search is a bisection, which relies on the TBLER being non-decreasing
+   * with the MCS; the attribute VerifyMcsSearch cross-checks every result
+   * against the exhaustive search.
+   *
    * \param sinr the sinr values
    * \param mcsWb The calculated MCS
    * \return The calculated CQI
@@ -149,6 +156,19 @@ public:
    */
   uint8_t GetMcsFromSpectralEfficiency (double s) const;
 
+  /**
+   * \brief Compute the spectral efficiency of a set of SINR values (Shannon bound)
+   * \param sinr SINR values, in linear units
+   * \param n number of values
+   * \param se output, the spectral efficiency of each value (at least n elements)
+   *
+   * Batched version of the formula used in CreateCqiFeedbackWbTdma by the
+   * Shannon model. The loop has no branches and works on contiguous arrays,
+   * so that the compiler can vectorize it when a vector math library is
+   * available.
+   */
+  void GetSpectralEfficiencies (const double *sinr, size_t n, double *se) const;
+
  /**
   * \brief Get the maximum MCS (depends on the underlying error model)
   * \return the maximum MCS
@@ -183,12 +203,35 @@ public:
    * It depends on the error model and the "mode" configured with SetMode().
    * Please note that this function expects in input the RB, not the RBG of the transmission.
    *
+   * The values for up to MAX_TBS_TABLE_PRB RBs are computed once and then
+   * stored in a table, which is invalidated when the number of reference
+   * subcarriers, the error model type, or the mode change.
+   *
    * \param mcs the MCS of the transmission
    * \param nprb The number of physical resource blocks used in the transmission
    * \return the TBS in bytes
    */
   uint32_t CalculateTbSize (uint8_t mcs, uint32_t nprb) const;
 
+  /**
+   * \brief Calculate the TransportBlock sizes (in bytes) for a range of RB numbers
+   *
+   * Equivalent to calling CalculateTbSize for each value of nprb in
+   * [minPrb, maxPrb], but without the per-call overhead.
+   *
+   * \param mcs the MCS of the transmission
+   * \param minPrb the first number of physical resource blocks
+   * \param maxPrb the last number of physical resource blocks (included)
+   * \param tbSizes vector that will be filled with the TBS in bytes, starting from minPrb
+   */
+  void CalculateTbSizes (uint8_t mcs, uint32_t minPrb, uint32_t maxPrb,
+                         std::vector<uint32_t> *tbSizes) const;
+
+  /**
+   * \brief Maximum number of RBs whose TBS is stored in the table (275, the NR maximum)
+   */
+  static const uint32_t MAX_TBS_TABLE_PRB = 275;
+
   /**
    * \brief Calculate the Payload Size (in bytes) from MCS and the number of RB
    * \param mcs MCS of the transmission
@@ -203,13 +246,58 @@ private:
    */
   double GetBer () const;
 
+  /**
+   * \brief Compute the TransportBlock size (in bytes), without looking into the table
+   * \param mcs the MCS of the transmission
+   * \param nprb The number of physical resource blocks used in the transmission
+   * \return the TBS in bytes
+   */
+  uint32_t ComputeTbSize (uint8_t mcs, uint32_t nprb) const;
+
+  /**
+   * \brief Check if a MCS guarantees the target TBLER (10%)
+   * \param sinr the sinr values
+   * \param rbMap the RBs with signal
+   * \param mcs the MCS to evaluate
+   * \return true if the TBLER of a TB with such MCS is at most 10%
+   */
+  bool IsMcsDecodable (const SpectrumValue& sinr, const std::vector<int> &rbMap, uint8_t mcs) const;
+
+  /**
+   * \brief Find the first MCS that does not guarantee the target TBLER, trying all the MCSs
+   * \param sinr the sinr values
+   * \param rbMap the RBs with signal
+   * \return the first MCS with a TBLER over 10%, or GetMaxMcs () + 1 if none
+   */
+  uint32_t FindFirstFailingMcsLinear (const SpectrumValue& sinr, const std::vector<int> &rbMap) const;
+
+  /**
+   * \brief Find the first MCS that does not guarantee the target TBLER, by bisection
+   * \param sinr the sinr values
+   * \param rbMap the RBs with signal
+   * \return the first MCS with a TBLER over 10%, or GetMaxMcs () + 1 if none
+   */
+  uint32_t FindFirstFailingMcsBinary (const SpectrumValue& sinr, const std::vector<int> &rbMap) const;
+
+  /**
+   * \brief Invalidate the TBS table
+   */
+  void ClearTbsTable ();
+
 private:
   AmcModel m_amcModel;             //!< Type of the CQI feedback model
   Ptr<NrErrorModel> m_errorModel;  //!< Pointer to an instance of ErrorModel
   TypeId m_errorModelType;         //!< Type of the error model
   uint8_t m_numRefScPerRb {1};     //!< number of reference subcarriers per RB
   NrErrorModel::Mode m_emMode {NrErrorModel::DL}; //!< Error model mode
+  bool m_binaryMcsSearch {true};   //!< Search the MCS by bisection (attribute)
+  bool m_verifyMcsSearch {false};  //!< Cross-check the bisection with the exhaustive search (attribute)
   static const unsigned int m_crcLen = 24 / 8; //!< CRC length (in bytes)
+  /**
+   * \brief TBS for each (MCS, number of RBs), at mcs * (MAX_TBS_TABLE_PRB + 1) + nprb;
+   * UINT32_MAX marks the values not computed yet
+   */
+  mutable std::vector<uint32_t> m_tbsTable;
 };
 
 } // end namespace ns3
@@ -0,0 +1,163 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "nr-aoi-metadata-tag.h"
+#include <ns3/log.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NrAoiMetadataTag");
+NS_OBJECT_ENSURE_REGISTERED (NrAoiMetadataTag);
+
+TypeId
+NrAoiMetadataTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::NrAoiMetadataTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("nr")
+    .AddConstructor<NrAoiMetadataTag> ()
+  ;
+  return tid;
+}
+
+TypeId
+NrAoiMetadataTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+NrAoiMetadataTag::NrAoiMetadataTag (const Time &creationTime, uint32_t ueId,
+                                    uint32_t urgency, uint32_t seqNum)
+{
+  SetCreationTimeValue (creationTime);
+  SetUeId (ueId);
+  SetUrgency (urgency);
+  SetSequenceNumber (seqNum);
+}
+
+void
+NrAoiMetadataTag::SetCreationTime (uint64_t time)
+{
+  SetCreationTimeValue (MilliSeconds (time));
+}
+
+uint64_t
+NrAoiMetadataTag::GetCreationTime () const
+{
+  return m_creationTimeNs / 1000000;
+}
+
+void
+NrAoiMetadataTag::SetCreationTimeValue (const Time &time)
+{
+  NS_ASSERT (! time.IsNegative ());
+  m_creationTimeNs = static_cast<uint64_t> (time.GetNanoSeconds ());
+}
+
+Time
+NrAoiMetadataTag::GetCreationTimeValue () const
+{
+  return NanoSeconds (m_creationTimeNs);
+}
+
+void
+NrAoiMetadataTag::SetUeId (uint32_t ueId)
+{
+  NS_ABORT_MSG_IF (ueId > UINT16_MAX, "UE id " << ueId << " does not fit the tag");
+  m_ueId = static_cast<uint16_t> (ueId);
+}
+
+uint32_t
+NrAoiMetadataTag::GetUeId () const
+{
+  return m_ueId;
+}
+
+void
+NrAoiMetadataTag::SetUrgency (uint32_t urgency)
+{
+  NS_ABORT_MSG_IF (urgency > UINT8_MAX, "Urgency " << urgency << " does not fit the tag");
+  m_urgency = static_cast<uint8_t> (urgency);
+}
+
+uint32_t
+NrAoiMetadataTag::GetUrgency () const
+{
+  return m_urgency;
+}
+
+void
+NrAoiMetadataTag::SetTrafficClass (uint8_t trafficClass)
+{
+  m_trafficClass = trafficClass;
+}
+
+uint8_t
+NrAoiMetadataTag::GetTrafficClass () const
+{
+  return m_trafficClass;
+}
+
+void
+NrAoiMetadataTag::SetSequenceNumber (uint32_t seqNum)
+{
+  m_seqNum = seqNum;
+}
+
+uint32_t
+NrAoiMetadataTag::GetSequenceNumber () const
+{
+  return m_seqNum;
+}
+
+void
+NrAoiMetadataTag::Serialize (TagBuffer i) const
+{
+  i.WriteU64 (m_creationTimeNs);
+  i.WriteU16 (m_ueId);
+  i.WriteU8 (m_urgency);
+  i.WriteU8 (m_trafficClass);
+  i.WriteU32 (m_seqNum);
+}
+
+void
+NrAoiMetadataTag::Deserialize (TagBuffer i)
+{
+  m_creationTimeNs = i.ReadU64 ();
+  m_ueId = i.ReadU16 ();
+  m_urgency = i.ReadU8 ();
+  m_trafficClass = i.ReadU8 ();
+  m_seqNum = i.ReadU32 ();
+}
+
+uint32_t
+NrAoiMetadataTag::GetSerializedSize () const
+{
+  return 16;
+}
+
+void
+NrAoiMetadataTag::Print (std::ostream &os) const
+{
+  os << "CreationTime=" << m_creationTimeNs << "ns UeId=" << m_ueId <<
+    " Urgency=" << static_cast<uint32_t> (m_urgency) <<
+    " TrafficClass=" << static_cast<uint32_t> (m_trafficClass) <<
+    " SeqNum=" << m_seqNum;
+}
+
+} // namespace ns3
@@ -0,0 +1,149 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <ns3/tag.h>
+#include <ns3/nstime.h>
+
+namespace ns3 {
+
+/**
+ * \ingroup utils
+ * \brief Per-packet metadata for the Age of Information (AoI) statistics
+ *
+ * A single packet tag that replaces PacketCreationTimeTag, PacketUeIdTag
+ * and PacketUrgencyTag (a-packet-tags.h): one insertion in the tag list,
+ * and one lookup to read everything back. It also carries a traffic class
+ * and a per-flow sequence number, with which the gNB can count lost and
+ * reordered packets.
+ *
+ * The serialization takes 16 bytes:
+ *
+ * \verbatim
+ +--------------------------------+--------+-------+-------+---------------+
+ | creation time (ns)             | UE id  | urg.  | class | sequence num. |
+ | 8 bytes                        | 2 B    | 1 B   | 1 B   | 4 bytes       |
+ +--------------------------------+--------+-------+-------+---------------+
+\endverbatim
+ *
+ * The accessors of the old tags are kept, with the same units (e.g., the
+ * creation time in ms), so that the code using them only changes the tag type.
+ */
+class NrAoiMetadataTag : public Tag
+{
+public:
+  /**
+   * \brief Get the object TypeId
+   * \return the object type id
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief Get the InstanceTypeId
+   * \return the TypeId of the instance
+   */
+  virtual TypeId GetInstanceTypeId (void) const override;
+
+  /**
+   * \brief Create an empty NrAoiMetadataTag
+   */
+  NrAoiMetadataTag () = default;
+
+  /**
+   * \brief Create a NrAoiMetadataTag
+   * \param creationTime creation time of the packet
+   * \param ueId UE id (at most 65535)
+   * \param urgency urgency of the packet (at most 255)
+   * \param seqNum sequence number of the packet in its flow
+   */
+  NrAoiMetadataTag (const Time &creationTime, uint32_t ueId, uint32_t urgency, uint32_t seqNum);
+
+  /**
+   * \brief Set the creation time (PacketCreationTimeTag compatible)
+   * \param time creation time in ms
+   */
+  void SetCreationTime (uint64_t time);
+  /**
+   * \return the creation time in ms (PacketCreationTimeTag compatible)
+   */
+  uint64_t GetCreationTime () const;
+  /**
+   * \brief Set the creation time, with ns resolution
+   * \param time creation time
+   */
+  void SetCreationTimeValue (const Time &time);
+  /**
+   * \return the creation time, with ns resolution
+   */
+  Time GetCreationTimeValue () const;
+
+  /**
+   * \brief Set the UE id (PacketUeIdTag compatible)
+   * \param ueId UE id; it must fit 16 bits
+   */
+  void SetUeId (uint32_t ueId);
+  /**
+   * \return the UE id
+   */
+  uint32_t GetUeId () const;
+
+  /**
+   * \brief Set the urgency (PacketUrgencyTag compatible)
+   * \param urgency the urgency; it must fit 8 bits
+   */
+  void SetUrgency (uint32_t urgency);
+  /**
+   * \return the urgency
+   */
+  uint32_t GetUrgency () const;
+
+  /**
+   * \brief Set the traffic class
+   * \param trafficClass the traffic class
+   */
+  void SetTrafficClass (uint8_t trafficClass);
+  /**
+   * \return the traffic class
+   */
+  uint8_t GetTrafficClass () const;
+
+  /**
+   * \brief Set the sequence number of the packet in its flow
+   * \param seqNum the sequence number
+   */
+  void SetSequenceNumber (uint32_t seqNum);
+  /**
+   * \return the sequence number of the packet in its flow
+   */
+  uint32_t GetSequenceNumber () const;
+
+  // inherited
+  virtual void Serialize (TagBuffer i) const override;
+  virtual void Deserialize (TagBuffer i) override;
+  virtual uint32_t GetSerializedSize () const override;
+  virtual void Print (std::ostream &os) const override;
+
+private:
+  uint64_t m_creationTimeNs {0}; //!< Creation time (ns)
+  uint16_t m_ueId {0};           //!< UE id
+  uint8_t m_urgency {0};         //!< Urgency
+  uint8_t m_trafficClass {0};    //!< Traffic class
+  uint32_t m_seqNum {0};         //!< Sequence number in the flow
+};
+
+} // namespace ns3
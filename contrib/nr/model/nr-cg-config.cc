@@ -0,0 +1,84 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "nr-cg-config.h"
+
+#include <ns3/log.h>
+#include <ns3/abort.h>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NrCgConfig");
+
+NrCgConfig::NrCgConfig (uint32_t period)
+  : m_period (period)
+{
+  NS_ASSERT (period > 0);
+}
+
+std::shared_ptr<const NrCgConfig>
+NrCgConfig::AddOccasion (const std::shared_ptr<DciInfoElementTdma> &dci, uint64_t firstSlot) const
+{
+  NS_LOG_FUNCTION (this << firstSlot);
+  NS_ABORT_MSG_IF (m_occasions.size () >= MAX_OCCASIONS,
+                   "Reached the maximum number of CG occasions in a period");
+
+  auto config = std::make_shared<NrCgConfig> (*this);
+  config->m_occasions.push_back (Occasion {dci, firstSlot});
+  return config;
+}
+
+bool
+NrCgConfig::HasOccasion (uint64_t firstSlot, uint8_t symStart) const
+{
+  for (const auto & occasion : m_occasions)
+    {
+      if (occasion.m_firstSlot == firstSlot && occasion.m_dci->m_symStart == symStart)
+        {
+          return true;
+        }
+    }
+  return false;
+}
+
+uint32_t
+NrCgConfig::GetPeriod () const
+{
+  return m_period;
+}
+
+size_t
+NrCgConfig::GetNumOccasions () const
+{
+  return m_occasions.size ();
+}
+
+const NrCgConfig::Occasion &
+NrCgConfig::GetOccasion (size_t i) const
+{
+  return m_occasions.at (i);
+}
+
+bool
+NrCgConfig::IsOccasionSlot (size_t i, uint64_t slot) const
+{
+  const auto & occasion = m_occasions.at (i);
+  return slot >= occasion.m_firstSlot && (slot - occasion.m_firstSlot) % m_period == 0;
+}
+
+} // namespace ns3
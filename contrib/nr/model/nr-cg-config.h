@@ -0,0 +1,104 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include "nr-phy-mac-common.h"
+#include <memory>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup ue-mac
+ * \brief Configured-grant configuration of an UE
+ *
+ * The configuration is the list of the CG occasions granted to the UE
+ * (the DCI of each occasion, and the slot of its first transmission), and
+ * the period of the occasions. The occasion i is in the slots
+ * m_firstSlot + k * period, k >= 0, so that both the UE MAC and the UE PHY
+ * derive the occasions of a slot arithmetically from the same object,
+ * instead of keeping (and moving forward, every period) their own copies.
+ *
+ * The object is immutable once shared: AddOccasion returns a new
+ * configuration, that the UE MAC passes to the PHY with
+ * NrPhySapProvider::SetCgConfig.
+ */
+class NrCgConfig
+{
+public:
+  /**
+   * \brief Maximum number of occasions in a period
+   */
+  static const size_t MAX_OCCASIONS = 100;
+
+  /**
+   * \brief A CG occasion
+   */
+  struct Occasion
+  {
+    std::shared_ptr<DciInfoElementTdma> m_dci; //!< DCI of the occasion
+    uint64_t m_firstSlot {0};                   //!< Slot (SfnSf::Normalize) of the first transmission
+  };
+
+  /**
+   * \brief NrCgConfig constructor
+   * \param period period of the occasions, in slots (greater than 0)
+   */
+  NrCgConfig (uint32_t period);
+
+  /**
+   * \brief Create the configuration with a new occasion
+   * \param dci DCI of the occasion
+   * \param firstSlot slot (SfnSf::Normalize) of the first transmission
+   * \return a new configuration, with the occasions of this one and the new one
+   */
+  std::shared_ptr<const NrCgConfig> AddOccasion (const std::shared_ptr<DciInfoElementTdma> &dci,
+                                                 uint64_t firstSlot) const;
+  /**
+   * \param firstSlot slot (SfnSf::Normalize) of the first transmission
+   * \param symStart first symbol of the occasion
+   * \return true if there is an occasion starting at the same slot and symbol
+   */
+  bool HasOccasion (uint64_t firstSlot, uint8_t symStart) const;
+
+  /**
+   * \return the period of the occasions, in slots
+   */
+  uint32_t GetPeriod () const;
+  /**
+   * \return the number of occasions in a period
+   */
+  size_t GetNumOccasions () const;
+  /**
+   * \param i index of the occasion
+   * \return the occasion
+   */
+  const Occasion & GetOccasion (size_t i) const;
+  /**
+   * \param i index of the occasion
+   * \param slot a slot (SfnSf::Normalize)
+   * \return true if the occasion i has a transmission in the slot
+   */
+  bool IsOccasionSlot (size_t i, uint64_t slot) const;
+
+private:
+  uint32_t m_period {0};             //!< Period of the occasions, in slots
+  std::vector<Occasion> m_occasions; //!< Occasions of a period
+};
+
+} // namespace ns3
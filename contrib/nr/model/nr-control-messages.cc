@@ -449,6 +449,25 @@ NrCGRMessage::GetTrafficDeadline () const
   return m_traffDeadlineTime;
 }
 
+void
+NrCGRMessage::SetTrafficProfile (const NrCgTrafficProfile &profile)
+{
+  m_trafficProfile = profile;
+  m_hasTrafficProfile = true;
+}
+
+bool
+NrCGRMessage::HasTrafficProfile () const
+{
+  return m_hasTrafficProfile;
+}
+
+const NrCgTrafficProfile &
+NrCGRMessage::GetTrafficProfile () const
+{
+  return m_trafficProfile;
+}
+
 // void NrCGRMessage::SetAge(uint64_t age)
 // {
 //     m_age = age;
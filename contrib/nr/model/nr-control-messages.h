@@ -573,6 +573,12 @@ public:
 
   void SetTrafficDeadline (Time traffDeadlineTime);
 
+  /**
+   * \brief Set the traffic profile of the CG LC
+   * \param profile the profile
+   */
+  void SetTrafficProfile (const NrCgTrafficProfile &profile);
+
   //void SetAge (uint64_t age);
 
   /**
@@ -591,6 +597,16 @@ public:
 
   Time GetTrafficDeadline (void) const;
 
+  /**
+   * \return true if the UE set the traffic profile of the CG LC
+   */
+  bool HasTrafficProfile (void) const;
+
+  /**
+   * \return the traffic profile of the CG LC (valid if HasTrafficProfile)
+   */
+  const NrCgTrafficProfile & GetTrafficProfile (void) const;
+
   uint64_t GetAge (void) const;
 
 private:
@@ -600,6 +616,8 @@ private:
   uint8_t m_traffP {0}; //!< CG Traffic periodicity
   Time m_traffStartTime; //!< CG Traffic generation time
   Time m_traffDeadlineTime; //!< CG Traffic maximum deadline
+  bool m_hasTrafficProfile {false}; //!< True if m_trafficProfile is set
+  NrCgTrafficProfile m_trafficProfile; //!< CG Traffic profile of the LC
   uint64_t m_age {0};
 };
 
@@ -54,26 +54,19 @@ NrEesmCc::ComputeSINR (const SpectrumValue& sinr, const std::vector<int>& map, u
   // HARQ CHASE COMBINING: update SINReff, but not ECR after retx
   // repetition of coded bits
 
-  // make a vector of history that contains the last tx (but without modifying
-  // sinrHistory, as it will be modified by the caller when it will be the time)
-  Ptr<NrEesmErrorModelOutput> last = Create<NrEesmErrorModelOutput> (0.0);
-  last->m_map = map;
-  last->m_sinr = sinr;
-
-  NrErrorModel::NrErrorModelHistory total = sinrHistory;
-  total.push_back (last);
-
-  // evaluate SINR_eff over "total", as per Chase Combining
-
+  // the history stores, for each previous tx, the SINR of its active RBs;
+  // the last tx is taken directly from the parameters (the history will be
+  // modified by the caller when it will be the time)
   NS_ASSERT (sinr.GetSpectrumModel()->GetNumBands() == sinr.GetValuesN());
+  NS_ASSERT (sinrHistory.m_rbSinrLen.size () == sinrHistory.m_numTx);
+
+  // evaluate SINR_eff over the history plus the last tx, as per Chase Combining
 
   SpectrumValue sinr_sum (sinr.GetSpectrumModel());
-  uint32_t historySize = static_cast<uint32_t> (total.size ());
-  uint32_t maxRBUsed = 0;
-  for (uint32_t i = 0; i < historySize; ++i)
+  uint32_t maxRBUsed = static_cast<uint32_t> (map.size ());
+  for (const auto & len : sinrHistory.m_rbSinrLen)
     {
-      Ptr<NrEesmErrorModelOutput> output = DynamicCast<NrEesmErrorModelOutput> (total.at(i));
-      maxRBUsed = std::max (maxRBUsed, static_cast<uint32_t> (output->m_map.size ()));
+      maxRBUsed = std::max (maxRBUsed, static_cast<uint32_t> (len));
     }
 
   std::vector<int> map_sum;
@@ -99,23 +92,25 @@ NrEesmCc::ComputeSINR (const SpectrumValue& sinr, const std::vector<int>& map, u
    *
    * (the value at SINR_SUM[0] is SINR{1}[2] + SINR{2}[0] + SINR{3}[0])
    */
-  for (uint32_t i = 0; i < historySize; ++i)
+  NS_LOG_INFO ("\tHISTORY:");
+  auto rbSinr = sinrHistory.m_rbSinr.cbegin ();
+  for (const auto & len : sinrHistory.m_rbSinrLen)
     {
-      Ptr<NrEesmErrorModelOutput> output = DynamicCast<NrEesmErrorModelOutput> (total.at(i));
-      uint32_t size = output->m_map.size ();
       for (uint32_t j = 0 ; j < maxRBUsed; ++j)
         {
-          sinr_sum[j] += output->m_sinr [ output->m_map [ j % size ] ];
+          sinr_sum[j] += *(rbSinr + (j % len));
         }
+      NS_LOG_INFO ("\tSINR of " << len << " RBs, first: " << *rbSinr);
+      rbSinr += len;
     }
 
-  NS_LOG_INFO ("\tHISTORY:");
-  for (const auto & element : total)
+  uint32_t size = map.size ();
+  for (uint32_t j = 0 ; j < maxRBUsed; ++j)
     {
-      Ptr<NrEesmErrorModelOutput> output = DynamicCast<NrEesmErrorModelOutput> (element);
-      NS_LOG_INFO ("\tMAP:" << PrintMap (output->m_map));
-      NS_LOG_INFO ("\tSINR: " << output->m_sinr);
+      sinr_sum[j] += *(sinr.ConstValuesBegin () + map [ j % size ]);
     }
+  NS_LOG_INFO ("\tMAP:" << PrintMap (map));
+  NS_LOG_INFO ("\tSINR: " << sinr);
 
   NS_LOG_INFO ("MAP_SUM: " << PrintMap (map_sum));
   NS_LOG_INFO ("SINR_SUM: " << sinr_sum);
@@ -296,11 +296,11 @@ NrEesmErrorModel::GetTbBitDecodificationStats (const SpectrumValue& sinr,
   double sinrExpSum = SinrExp (sinr, map, mcs);  // exponential sum of SINRs for this tx
 
   NS_LOG_DEBUG (" mcs " << +mcs << " TBSize in bit " << sizeBit <<
-                " history elements: " << sinrHistory.size () << " SINR of the tx: " <<
+                " history elements: " << sinrHistory.m_numTx << " SINR of the tx: " <<
                 tbSinr << std::endl << "MAP: " << PrintMap (map) << std::endl <<
                 "SINR: " << sinr);
 
-  if (sinrHistory.size () > 0)
+  if (sinrHistory.m_numTx > 0)
     {
       SINR = ComputeSINR (sinr, map, mcs, sizeBit, sinrHistory);
     }
@@ -320,7 +320,7 @@ NrEesmErrorModel::GetTbBitDecodificationStats (const SpectrumValue& sinr,
                " CBs of " << K << " bits");
 
   uint8_t mcs_eq = mcs;
-  if ((sinrHistory.size () > 0) && (mcs > 0))
+  if ((sinrHistory.m_numTx > 0) && (mcs > 0))
     {
       mcs_eq = GetMcsEq (mcs);
     }
@@ -346,14 +346,13 @@ NrEesmErrorModel::GetTbBitDecodificationStats (const SpectrumValue& sinr,
   ret->m_sinrEff = SINR;
   ret->m_sinr = sinr;
   ret->m_map = map;
-  if (sinrHistory.size () == 0)
+  if (sinrHistory.m_numTx == 0)
     {
       ret->m_sinrExp =  sinrExpSum;  // it is first tx!
     }
   else
     {
-      double m_sinrExpPrevious = DynamicCast<NrEesmErrorModelOutput> (sinrHistory.back ())->m_sinrExp;
-      ret->m_sinrExp = m_sinrExpPrevious + sinrExpSum;  // it sums over previous tx (recursively)
+      ret->m_sinrExp = sinrHistory.m_sinrExp + sinrExpSum;  // it sums over previous tx (recursively)
     }
   ret->m_infoBits = sizeBit;
   ret->m_codeBits = sizeBit / GetMcsEcrTable ()->at (mcs);
@@ -47,6 +47,23 @@ struct NrEesmErrorModelOutput : public NrErrorModelOutput
   {
   }
 
+  void AddToHistory (NrErrorModelHarqHistory *history) const override
+  {
+    if (history->m_numTx == 0)
+      {
+        history->m_infoBits = m_infoBits;
+      }
+    history->m_codeBits += m_codeBits;
+    history->m_mapSize += static_cast<uint32_t> (m_map.size ());
+    history->m_sinrExp = m_sinrExp; // already summed over the previous tx
+    for (const auto & rb : m_map)
+      {
+        history->m_rbSinr.push_back (*(m_sinr.ConstValuesBegin () + rb));
+      }
+    history->m_rbSinrLen.push_back (static_cast<uint16_t> (m_map.size ()));
+    NrErrorModelOutput::AddToHistory (history);
+  }
+
   double m_sinrExp {0.0};   //!< Sum of exponential SINR (needed for HARQ-IR)
   double m_sinrEff {0.0};   //!< The effective SINR (needed just for the test)
   SpectrumValue m_sinr;     //!< perceived SINRs in the whole bandwidth
@@ -54,30 +54,22 @@ NrEesmIr::ComputeSINR (const SpectrumValue &sinr, const std::vector<int> &map,
   // no repetition of coded bits.
 
   // compute equivalent effective code rate after retransmissions and total map size
-  uint32_t codeBitsSum = 0;
-  uint32_t infoBits = DynamicCast<NrEesmErrorModelOutput> (sinrHistory.front ())->m_infoBits;  // information bits of the first TB
-  double mapSumSize = 0.0;
+  uint32_t infoBits = sinrHistory.m_infoBits;  // information bits of the first TB
+  uint32_t codeBitsSum = sinrHistory.m_codeBits;
+  double mapSumSize = sinrHistory.m_mapSize;
 
-  for (const Ptr<NrErrorModelOutput> & output : sinrHistory)
-    {
-      Ptr<NrEesmErrorModelOutput> sinrHistorytemp = DynamicCast<NrEesmErrorModelOutput> (output);
-      NS_ASSERT (sinrHistorytemp != nullptr);
-
-      NS_LOG_DEBUG (" Exponential SINR sum " << sinrHistorytemp->m_sinrExp <<
-                    " codeBits " << sinrHistorytemp->m_codeBits <<
-                    " infoBits: " << sinrHistorytemp->m_infoBits);
+  NS_LOG_DEBUG (" Exponential SINR sum " << sinrHistory.m_sinrExp <<
+                " codeBits " << codeBitsSum <<
+                " infoBits: " << infoBits);
 
-      codeBitsSum += sinrHistorytemp->m_codeBits;
-      mapSumSize += sinrHistorytemp->m_map.size();
-    }
   mapSumSize += map.size();
   codeBitsSum += sizeBit / GetMcsEcrTable()->at (mcs);;
   const_cast<NrEesmIr*> (this)->m_Reff = infoBits / static_cast<double> (codeBitsSum);
 
-  NS_LOG_INFO (" Reff " << m_Reff << " HARQ history (previous) " << sinrHistory.size ());
+  NS_LOG_INFO (" Reff " << m_Reff << " HARQ history (previous) " << sinrHistory.m_numTx);
 
   // compute effective SINR with expSINR_previousTx and mapSumSize
-  double expSINR_previousTx = DynamicCast<NrEesmErrorModelOutput> (sinrHistory.back ())->m_sinrExp;
+  double expSINR_previousTx = sinrHistory.m_sinrExp;
   return SinrEff (sinr, map, mcs, expSINR_previousTx, mapSumSize);
 }
 
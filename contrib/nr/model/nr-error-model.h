@@ -24,6 +24,43 @@
 
 namespace ns3 {
 
+/**
+ * \ingroup error-models
+ * \brief Compact HARQ history of a process
+ *
+ * Instead of keeping the outputs of all the previous transmissions (each one
+ * with a copy of the SINR vector and of the RB map), the history accumulates
+ * only the terms that the combining methods use. Reset () clears the vectors
+ * without releasing their memory, so a process does not allocate anymore
+ * once it has seen its longest retransmission chain.
+ */
+struct NrErrorModelHarqHistory
+{
+  /**
+   * \brief Forget the previous transmissions
+   */
+  void Reset ()
+  {
+    m_numTx = 0;
+    m_infoBits = 0;
+    m_codeBits = 0;
+    m_mapSize = 0;
+    m_sinrExp = 0.0;
+    m_miCodeBits = 0.0;
+    m_rbSinr.clear ();
+    m_rbSinrLen.clear ();
+  }
+
+  uint32_t m_numTx      {0};   //!< Number of previous transmissions
+  uint32_t m_infoBits   {0};   //!< Number of info bits of the first transmission
+  uint32_t m_codeBits   {0};   //!< Sum of the code bits of the previous transmissions
+  uint32_t m_mapSize    {0};   //!< Sum of the RB map sizes of the previous transmissions
+  double m_sinrExp      {0.0}; //!< Accumulated sum of exponential SINR (EESM-IR)
+  double m_miCodeBits   {0.0}; //!< Sum of the MI weighted by the code bits (LTE MI)
+  std::vector<double> m_rbSinr;      //!< SINR of the active RBs of each transmission, concatenated (EESM-CC)
+  std::vector<uint16_t> m_rbSinrLen; //!< Number of active RBs of each transmission stored in m_rbSinr
+};
+
 /**
  * \ingroup error-models
  * \brief Store the output of an NRErrorModel
@@ -50,6 +87,18 @@ struct NrErrorModelOutput : public SimpleRefCount<NrErrorModelOutput>
   {
   }
 
+  /**
+   * \brief Fold this output into the HARQ history of its process
+   * \param history the history to update
+   *
+   * Outputs of error models that combine the retransmissions should
+   * store their own terms, and then call this method.
+   */
+  virtual void AddToHistory (NrErrorModelHarqHistory *history) const
+  {
+    ++history->m_numTx;
+  }
+
   double m_tbler     {0.0}; //!< Transport Block Error Rate
 };
 
@@ -114,13 +163,12 @@ public:
   };
 
   /**
-   * \brief Vector of previous output
-   *
+   * \brief History of the previous outputs
    *
-   * Used in case of HARQ: any result will be stored in this vector and used
-   * to decode next retransmissions.
+   * Used in case of HARQ: any result will be folded in the history (see
+   * NrErrorModelOutput::AddToHistory) and used to decode next retransmissions.
    */
-  typedef std::vector<Ptr<NrErrorModelOutput> > NrErrorModelHistory;
+  typedef NrErrorModelHarqHistory NrErrorModelHistory;
 
   /**
    * \brief Get an output for the decodification error probability of a given
@@ -26,6 +26,7 @@
   while (false);
 
 #include "nr-gnb-mac.h"
+#include "nr-profiler.h"
 #include "nr-phy-mac-common.h"
 #include "nr-mac-sched-sap.h"
 #include "nr-mac-scheduler.h"
@@ -34,6 +35,7 @@
 #include "nr-mac-header-vs.h"
 #include "nr-mac-header-fs-ul.h"
 #include "nr-mac-short-bsr-ce.h"
+#include "nr-mac-long-bsr-ce.h"
 
 #include <ns3/lte-radio-bearer-tag.h>
 #include <ns3/log.h>
@@ -270,6 +272,8 @@ public:
   virtual uint16_t GetCellId () const override;
   virtual uint32_t GetSymbolsPerSlot () const override;
   virtual Time GetSlotPeriod () const override;
+  virtual std::vector<LteNrTddSlotType> GetTddPattern () const override;
+  virtual void NotifyHarqPreemption (uint16_t rnti, uint8_t harqProcessId, bool isDl) override;
   // Configured Grant
   virtual Time GetTbUlEncodeLatency () const override;
 private:
@@ -330,6 +334,18 @@ NrMacMemberMacSchedSapUser::GetSlotPeriod() const
   return m_mac->m_phySapProvider->GetSlotPeriod ();
 }
 
+std::vector<LteNrTddSlotType>
+NrMacMemberMacSchedSapUser::GetTddPattern () const
+{
+  return m_mac->m_phySapProvider->GetTddPattern ();
+}
+
+void
+NrMacMemberMacSchedSapUser::NotifyHarqPreemption (uint16_t rnti, uint8_t harqProcessId, bool isDl)
+{
+  m_mac->DoNotifyHarqPreemption (rnti, harqProcessId, isDl);
+}
+
 // Configured Grant
 Time
 NrMacMemberMacSchedSapUser::GetTbUlEncodeLatency() const
@@ -444,6 +460,11 @@ NrGnbMac::GetTypeId (void)
                      "Harq feedback.",
                       MakeTraceSourceAccessor (&NrGnbMac::m_dlHarqFeedback),
                      "ns3::NrGnbMac::DlHarqFeedbackTracedCallback")
+    .AddTraceSource ("AoiSample",
+                     "Creation time of each AoI-tagged UL data packet received, "
+                     "once per packet (at its first subPDU).",
+                     MakeTraceSourceAccessor (&NrGnbMac::m_aoiSampleTrace),
+                     "ns3::NrGnbMac::AoiSampleTracedCallback")
      // Configured Grant
     .AddAttribute ("CG",
                   "Activate configured grant scheduling for UL periodic transmissions",
@@ -585,6 +606,7 @@ void
 NrGnbMac::DoSlotDlIndication (const SfnSf &sfnSf, LteNrTddSlotType type)
 {
   NS_LOG_FUNCTION (this);
+  NrProfilerScope profilerScope (NrProfiler::GNB_MAC_DL_SLOT_INDICATION);
   //NS_LOG_INFO ("Perform things on DL, slot on the air: " << sfnSf);
 
   // --- DOWNLINK ---
@@ -667,6 +689,7 @@ NrGnbMac::DoSlotDlIndication (const SfnSf &sfnSf, LteNrTddSlotType type)
 void NrGnbMac::DoSlotUlIndication (const SfnSf &sfnSf, LteNrTddSlotType type) /**************************< 스케줄러에게 전달하는 파라미터들>*****************************/
 {
   NS_LOG_FUNCTION (this);
+  NrProfilerScope profilerScope (NrProfiler::GNB_MAC_UL_SLOT_INDICATION);
   /////////////////////////////////////////////////////////NS_LOG_INFO ("Perform things on UL, slot on the air: " << sfnSf);
 
   // --- UPLINK ---
@@ -958,27 +981,53 @@ void NrGnbMac::DoReceivePhyPdu (Ptr<Packet> p) /********************************
   p->RemovePacketTag (tag);
 
   uint16_t rnti = tag.GetRnti ();
+
+  NS_ASSERT_MSG (m_rlcAttached.find (rnti) != m_rlcAttached.end (), "could not find RNTI" << rnti);
+
+  // A TB built by the UE MAC (UlTbBatching): split it in its subPDUs, in
+  // a single pass over the metadata of the TB
+  NrUlTbTag tbTag;
+  if (p->FindFirstMatchingByteTag (tbTag))
+    {
+      uint32_t offset = 0;
+      for (const auto & subPdu : tbTag.GetSubPdus ())
+        {
+          ReceiveUlSubPdu (rnti, p->CreateFragment (offset, subPdu.m_size), subPdu);
+          offset += subPdu.m_size;
+        }
+      NS_ASSERT (offset == p->GetSize ());
+      return;
+    }
+
+  // Otherwise, the packet is a single subPDU, with its own packet tags
+  ReceiveUlSubPdu (rnti, p, NrUlTbTag::ExtractSubPdu (p, 0));
+}
+
+void
+NrGnbMac::ReceiveUlSubPdu (uint16_t rnti, const Ptr<Packet> &p, const NrUlTbTag::SubPdu &subPdu)
+{
+  NS_LOG_FUNCTION (this << rnti << p->GetSize ());
+
   auto rntiIt = m_rlcAttached.find (rnti);
 
   NS_ASSERT_MSG (rntiIt != m_rlcAttached.end (), "could not find RNTI" << rnti);
 
   // 패킷 생성 시간 태그 확인
-  PacketCreationTimeTag creationTimeTag;
-  if (p->RemovePacketTag(creationTimeTag))
+  if (subPdu.m_hasMetadata)
   {
-    uint64_t creationTime = creationTimeTag.GetCreationTime();    // 패킷에서 패킷을 생성한 시간을 저장
+    const NrAoiMetadataTag &metadata = subPdu.m_metadata;
+    uint64_t creationTime = metadata.GetCreationTime();           // 패킷에서 패킷을 생성한 시간을 저장
     uint64_t receiveTime = Simulator::Now().GetMilliSeconds();    // 패킷을 gNB가 받은 시간을 저장
     uint64_t age = receiveTime - creationTime;                    // age는 gNB가 받은 시간에서 패킷 생성 시간의 차로 계산
 
     m_packetReceiveTimeMap[rnti] = receiveTime;                   // 각 패킷을 받은 시간을 rnti(UE)에 매핑하여 저장
 
-    // 긴급 패킷 여부 확인
-    PacketUrgencyTag urgencyTag;
-    if (p->RemovePacketTag(urgencyTag))
+    // 긴급 패킷 여부 확인 (0: 긴급도 없음)
+    if (metadata.GetUrgency() != 0)
     {
-      uint32_t Urgent = urgencyTag.GetUrgency();
+      uint32_t Urgent = metadata.GetUrgency();
       m_packetUrgencyMap[rnti] = Urgent;                          // 긴급도를 m_packetUrgencyMap에 저장
-      if (urgencyTag.GetUrgency()!=1)
+      if (Urgent!=1)
       {
         age *=(Urgent*10);  // 긴급 패킷인 경우 Age에 n을 곱함
       }
@@ -1014,6 +1063,23 @@ void NrGnbMac::DoReceivePhyPdu (Ptr<Packet> p) /********************************
       ReceiveBsrMessage (bsr); // Here it will be converted again, but our job is done.
       return;
     }
+  else if (header.GetLcId () == NrMacHeaderFsUl::LONG_BSR)
+    {
+      NrMacLongBsrCe bsrHeader;
+      p->RemoveHeader (bsrHeader);
+
+      // Same as above: the scheduler recognizes the long BSR from the
+      // number of LCGs reported
+      MacCeElement bsr;
+
+      bsr.m_macCeType = MacCeElement::BSR;
+      bsr.m_rnti = rnti;
+      bsr.m_macCeValue.m_bufferStatus.assign (bsrHeader.m_bufferSizeLevel.begin (),
+                                              bsrHeader.m_bufferSizeLevel.end ());
+
+      ReceiveBsrMessage (bsr);
+      return;
+    }
 
   // Ok, we know it is data, so let's extract and pass to RLC.
 
@@ -1031,6 +1097,18 @@ void NrGnbMac::DoReceivePhyPdu (Ptr<Packet> p) /********************************
   rxParams.lcid = macHeader.GetLcId ();
   rxParams.rnti = rnti;
 
+  // One AoI sample per packet: its other segments and its RLC
+  // retransmissions do not refresh the information at the receiver. The
+  // packets without a sequence number (old tags) cannot be told apart, and
+  // give a sample each
+  if (subPdu.m_hasMetadata
+      && (!subPdu.m_hasSeqNum
+          || UpdateAoiSequence (rnti, rxParams.lcid, subPdu.m_metadata.GetSequenceNumber ())))
+    {
+      m_aoiSampleTrace (GetCellId (), rnti, rxParams.lcid,
+                        subPdu.m_metadata.GetCreationTimeValue ());
+    }
+
   if (rxParams.p->GetSize ())
     {
       (*lcidIt).second->ReceivePdu (rxParams);
@@ -1049,6 +1127,62 @@ NrGnbMac::PrintAverageThroughput ()
     }
 }
 
+bool
+NrGnbMac::UpdateAoiSequence (uint16_t rnti, uint8_t lcid, uint32_t seqNum)
+{
+  // The flows are numbered from 0: a missing first packet is a loss too
+  AoiSequenceInfo &info = m_aoiSequence[std::make_pair (rnti, lcid)];
+
+  if (seqNum >= info.m_nextSeqNum)
+    {
+      // Store at most the last MAX_MISSING numbers of the gap, and drop the
+      // oldest ones stored, counting them as lost
+      uint32_t firstMissing = info.m_nextSeqNum;
+      if (seqNum - firstMissing > AoiSequenceInfo::MAX_MISSING)
+        {
+          info.m_lostUntracked += seqNum - firstMissing - AoiSequenceInfo::MAX_MISSING;
+          firstMissing = seqNum - AoiSequenceInfo::MAX_MISSING;
+        }
+      for (uint32_t missing = firstMissing; missing < seqNum; ++missing)
+        {
+          info.m_missing.insert (info.m_missing.end (), missing);
+        }
+      while (info.m_missing.size () > AoiSequenceInfo::MAX_MISSING)
+        {
+          info.m_missing.erase (info.m_missing.begin ());
+          ++info.m_lostUntracked;
+        }
+      info.m_nextSeqNum = seqNum + 1;
+      return true;
+    }
+
+  if (info.m_missing.erase (seqNum) > 0)
+    {
+      // It was counted as lost, but it is only late
+      NS_LOG_INFO ("UE " << rnti << " LC " << +lcid << " packet " << seqNum <<
+                   " received after " << info.m_nextSeqNum - 1);
+      ++info.m_reordered;
+      return true;
+    }
+
+  // Another segment, or an RLC retransmission, of a packet already received
+  return false;
+}
+
+uint64_t
+NrGnbMac::GetAoiLostPackets (uint16_t rnti, uint8_t lcid) const
+{
+  auto it = m_aoiSequence.find (std::make_pair (rnti, lcid));
+  return it != m_aoiSequence.end () ? it->second.m_missing.size () + it->second.m_lostUntracked : 0;
+}
+
+uint64_t
+NrGnbMac::GetAoiReorderedPackets (uint16_t rnti, uint8_t lcid) const
+{
+  auto it = m_aoiSequence.find (std::make_pair (rnti, lcid));
+  return it != m_aoiSequence.end () ? it->second.m_reordered : 0;
+}
+
 NrGnbPhySapUser*
 NrGnbMac::GetPhySapUser ()
 {
@@ -1116,7 +1250,29 @@ NrGnbMac::DoReceiveControlMessage  (Ptr<NrControlMessage> msg)
         componentCarrierId_configuredGrant = GetBwpId();
         lcid_configuredGrant = cgr->GetLCID();
         Time trafficInAndEncode = cgr->GetTrafficTimeInit() + m_phySapProvider->GetTbUlEncodeLatency();
-        m_ccmMacSapUser-> UlReceiveCgr (cgr->GetRNTI (), GetBwpId (), cgr->GetBufSize(), cgr->GetLCID(), cgr->GetTrafficP(), cgr->GetTrafficTimeInit(), cgr->GetTrafficDeadline());
+
+        uint32_t bufSize = cgr->GetBufSize ();
+        Time deadline = cgr->GetTrafficDeadline ();
+        Time timeInit = cgr->GetTrafficTimeInit ();
+        if (cgr->HasTrafficProfile ())
+          {
+            // Size the occasions for the payloads of the profile, not for the
+            // buffer of the UE at the time of the CGR
+            const auto & profile = cgr->GetTrafficProfile ();
+            bufSize = profile.GetGrantSize (bufSize);
+            deadline = profile.GetSchedulingDeadline ();
+            if (! profile.m_offset.IsZero ())
+              {
+                // The payloads are generated at the offset of the profile from
+                // the start of their slot, not at the measured time
+                int64_t slotNs = m_phySapProvider->GetSlotPeriod ().GetNanoSeconds ();
+                timeInit = NanoSeconds (timeInit.GetNanoSeconds () / slotNs * slotNs) + profile.m_offset;
+              }
+            NS_LOG_INFO ("CGR of UE " << cgr->GetRNTI () << " with traffic profile: " <<
+                         bufSize << " B every " << +cgr->GetTrafficP () << " ms, deadline " <<
+                         deadline);
+          }
+        m_ccmMacSapUser-> UlReceiveCgr (cgr->GetRNTI (), GetBwpId (), bufSize, cgr->GetLCID(), cgr->GetTrafficP(), timeInit, deadline);
         break;
       }
     case (NrControlMessage::SR):
@@ -1153,6 +1309,27 @@ NrGnbMac::DoUlHarqFeedback (const UlHarqInfo &params)
   m_ulHarqInfoReceived.push_back (params);
 }
 
+void
+NrGnbMac::DoNotifyHarqPreemption (uint16_t rnti, uint8_t harqProcessId, bool isDl)
+{
+  NS_LOG_FUNCTION (this << rnti << +harqProcessId << isDl);
+  if (isDl)
+    {
+      // The buffer of the process is refreshed by the new TB; its old
+      // content will not be retransmitted anymore
+      auto it = m_miDlHarqProcessesPackets.find (rnti);
+      NS_ASSERT (it != m_miDlHarqProcessesPackets.end ());
+      NrDlHarqProcessInfo &process = it->second.at (harqProcessId);
+      if (process.m_staleFeedback < UINT8_MAX)
+        {
+          ++process.m_staleFeedback;
+        }
+    }
+  // UL: the feedback is only forwarded to the scheduler, that discards the
+  // stale one, and the PHY resets the HARQ history when the new TB arrives
+  // with a new data indicator
+}
+
 void
 NrGnbMac::DoDlHarqFeedback (const DlHarqInfo &params)
 {
@@ -1161,6 +1338,18 @@ NrGnbMac::DoDlHarqFeedback (const DlHarqInfo &params)
   std::unordered_map <uint16_t, NrDlHarqProcessesBuffer_t>::iterator it =  m_miDlHarqProcessesPackets.find (params.m_rnti);
   NS_ASSERT (it != m_miDlHarqProcessesPackets.end ());
 
+  NrDlHarqProcessInfo &process = (*it).second.at (params.m_harqProcessId);
+  if (process.m_staleFeedback > 0)
+    {
+      // Feedback of a preempted TB: the buffer belongs to the new TB. The
+      // scheduler discards this feedback too
+      --process.m_staleFeedback;
+      NS_LOG_DEBUG (this << " HARQ feedback of a preempted TB, UE " << params.m_rnti << " harqId " << (uint16_t)params.m_harqProcessId);
+      m_dlHarqFeedback (params);
+      m_dlHarqInfoReceived.push_back (params);
+      return;
+    }
+
   for (uint8_t stream = 0; stream < params.m_harqStatus.size (); stream++)
     {
       if (params.m_harqStatus.at (stream) == DlHarqInfo::ACK)
@@ -25,6 +25,7 @@
 #include "nr-phy-sap.h"
 #include "nr-mac-scheduler.h"
 #include "nr-mac-pdu-info.h"
+#include "nr-ul-tb-tag.h"
 
 #include <ns3/lte-enb-cmac-sap.h>
 #include <ns3/lte-mac-sap.h>
@@ -33,6 +34,9 @@
 #include <ns3/lte-enb-cmac-sap.h>
 #include <ns3/traced-callback.h>
 
+#include <map>
+#include <set>
+
 namespace ns3 {
 
 class NrControlMessage;
@@ -172,6 +176,23 @@ public:
 
   void PrintAverageThroughput ();
 
+  /**
+   * \brief Get the packets of an AoI flow never received, from the NrAoiMetadataTag sequence numbers
+   * \param rnti RNTI of the UE
+   * \param lcid LC ID of the flow
+   * \return the number of packets missing, so far
+   *
+   * Each LC of a UE is an AoI flow, numbered from 0.
+   */
+  uint64_t GetAoiLostPackets (uint16_t rnti, uint8_t lcid) const;
+  /**
+   * \brief Get the packets of an AoI flow received after a more recent one
+   * \param rnti RNTI of the UE
+   * \param lcid LC ID of the flow
+   * \return the number of packets received out of order
+   */
+  uint64_t GetAoiReorderedPackets (uint16_t rnti, uint8_t lcid) const;
+
 
   /**
   * \brief Get the gNB-ComponentCarrierManager SAP User
@@ -253,6 +274,18 @@ public:
       (const SfnSf sfn, const uint16_t nodeId, const uint16_t rnti,
        const uint8_t bwpId, Ptr<NrControlMessage>);
 
+  /**
+   *  TracedCallback signature for the reception of an AoI-tagged UL data packet.
+   *
+   * \param [in] cellId Cell id of the gNB
+   * \param [in] rnti RNTI of the UE
+   * \param [in] lcid LC ID of the packet
+   * \param [in] creationTime creation time in the NrAoiMetadataTag of the packet
+   */
+  typedef void (* AoiSampleTracedCallback)
+      (const uint16_t cellId, const uint16_t rnti, const uint8_t lcid,
+       const Time creationTime);
+
   // Configured Grant
   void SetCG (bool CGSch);
   bool GetCG () const;
@@ -299,6 +332,13 @@ private:
    */
   void DoReportSrToScheduler (uint16_t rnti);
   void DoReceivePhyPdu (Ptr<Packet> p);
+  /**
+   * \brief Process an UL subPDU (a CE or data for the RLC)
+   * \param rnti RNTI of the UE
+   * \param p the subPDU, starting with its MAC subheader
+   * \param subPdu the metadata of the subPDU
+   */
+  void ReceiveUlSubPdu (uint16_t rnti, const Ptr<Packet> &p, const NrUlTbTag::SubPdu &subPdu);
   void DoReceiveControlMessage  (Ptr<NrControlMessage> msg);
   virtual void DoSchedConfigIndication (NrMacSchedSapUser::SchedConfigIndParameters ind);
   // forwarded from LteMacSapProvider
@@ -334,6 +374,13 @@ private:
    * \param params the UL HARQ feedback
    */
   void DoUlHarqFeedback (const UlHarqInfo &params);
+  /**
+   * \brief The scheduler preempted a HARQ process
+   * \param rnti RNTI of the UE
+   * \param harqProcessId ID of the process
+   * \param isDl true for a DL process, false for UL
+   */
+  void DoNotifyHarqPreemption (uint16_t rnti, uint8_t harqProcessId, bool isDl);
 
   /**
    * \brief Send to PHY the RAR messages
@@ -359,6 +406,9 @@ private:
   struct NrDlHarqProcessInfo
   {
     std::vector<HarqProcessInfoSingleStream> m_infoPerStream;
+    // feedbacks still expected for the TBs preempted from this process:
+    // they must not touch the buffer of the current TB
+    uint8_t m_staleFeedback {0};
   };
 
   typedef std::vector < NrDlHarqProcessInfo> NrDlHarqProcessesBuffer_t;
@@ -431,6 +481,13 @@ private:
    */
   TracedCallback<const DlHarqInfo&> m_dlHarqFeedback;
 
+  /**
+   * Trace the creation time of each AoI-tagged UL data packet received, once
+   * per packet (segments and duplicates are not sampled):
+   * cell id, rnti, lcid, creation time
+   */
+  TracedCallback<uint16_t, uint16_t, uint8_t, Time> m_aoiSampleTrace;
+
   //Configured Grant
 
   uint8_t componentCarrierId_configuredGrant; //!< Stored BWP Id to create CGR in the transmission phase
@@ -446,6 +503,36 @@ private:
   SfnSf m_cgrNextTxSlot;
   uint8_t countCG_slots = 0 ;
   uint64_t CalculateAgeForRnti(uint16_t rnti);  // Age 계산 함수 선언
+
+  /**
+   * \brief Loss and reordering of an AoI flow
+   *
+   * Only the last MAX_MISSING sequence numbers not received are stored, to
+   * recognize them if they arrive late; the older ones are only counted as
+   * lost, in m_lostUntracked.
+   */
+  struct AoiSequenceInfo
+  {
+    static const uint32_t MAX_MISSING = 1024; //!< Maximum size of m_missing
+
+    uint32_t m_nextSeqNum {0};     //!< Sequence number after the highest one received
+    std::set<uint32_t> m_missing;  //!< Sequence numbers below m_nextSeqNum not received yet
+    uint64_t m_lostUntracked {0};  //!< Packets lost, not in m_missing
+    uint64_t m_reordered {0};      //!< Packets received out of order
+  };
+
+  /**
+   * \brief Account the sequence number of a packet received from a UE
+   * \param rnti RNTI of the UE
+   * \param lcid LC ID of the packet
+   * \param seqNum sequence number in the NrAoiMetadataTag of the packet
+   * \return true for the first subPDU received of the packet, false for the
+   * other segments and for the RLC retransmissions (and for the packets
+   * older than the missing sequence numbers still tracked)
+   */
+  bool UpdateAoiSequence (uint16_t rnti, uint8_t lcid, uint32_t seqNum);
+
+  std::map<std::pair<uint16_t, uint8_t>, AoiSequenceInfo> m_aoiSequence; //!< AoI flow sequence, per (RNTI, LC ID)
 };
 
 }
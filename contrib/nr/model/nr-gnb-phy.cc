@@ -33,6 +33,7 @@
 #include <unordered_set>
 
 #include "nr-gnb-phy.h"
+#include "nr-profiler.h"
 #include "nr-ue-phy.h"
 #include "nr-net-device.h"
 #include "nr-ue-net-device.h"
@@ -129,6 +130,10 @@ NrGnbPhy::GetTypeId (void)
                      "Enb PHY Txed Control Messages Traces.",
                      MakeTraceSourceAccessor (&NrGnbPhy::m_phyTxedCtrlMsgsTrace),
                      "ns3::NrPhyRxTrace::TxedGnbPhyCtrlMsgsTracedCallback")
+    .AddTraceSource ("UlDtx",
+                     "An expected UL TB was not transmitted by the UE (e.g., skipped CG occasion)",
+                     MakeTraceSourceAccessor (&NrGnbPhy::m_ulDtxTrace),
+                     "ns3::NrGnbPhy::UlDtxTracedCallback")
     .AddAttribute ("N0Delay",
                    "Minimum processing delay needed to decode DL DCI and decode DL data",
                     UintegerValue (0),
@@ -708,6 +713,7 @@ void
 NrGnbPhy::StartSlot (const SfnSf &startSlot)
 {
   NS_LOG_FUNCTION (this);
+  NrProfilerScope profilerScope (NrProfiler::GNB_PHY_START_SLOT);
   NS_ASSERT (m_channelStatus != TO_LOSE);
 
   m_currentSlot = startSlot;
@@ -1259,6 +1265,10 @@ NrGnbPhy::DlCtrl (const std::shared_ptr<DciInfoElementTdma> &dci)
                         if (ulSfnConfigurateGrant<m_currentSlot || ulSfnConfigurateGrant==m_currentSlot){
                            // Do not send CG information if we are not in configuration phase (TO_RECEIVE_CG state in the UE state machine).
                            NS_LOG_INFO ("No messages to send, skipping");
+                           SfnSf ulSlot = m_currentSlot;
+                           ulSlot.Add (dciMsg->GetKDelay ());
+                           m_suppressedCgDci.emplace (ulSlot.Normalize (), dciInfoElem->m_rnti,
+                                                      dciInfoElem->m_symStart);
                        }else{
                            // The rest of DL CTRL signal are transmitted regardless
                            // of which state of configured grant scheduling we are in.
@@ -1381,6 +1391,17 @@ NrGnbPhy::UlData(const std::shared_ptr<DciInfoElementTdma> &dci)
                                                         FromRBGBitmaskToRBAssignment (dci->m_rbgBitmask),
                                                         dci->m_harqProcess, dci->m_rv.at (streamIndex), false,
                                                         dci->m_symStart, dci->m_numSym, m_currentSlot);
+      // The UE may skip a configured grant occasion: if nothing started by
+      // the end of the var TTI, it is a DTX and not a TB to NACK. The
+      // dynamic grants and the retransmissions had their DCI sent
+      const uint64_t slot = m_currentSlot.Normalize ();
+      m_suppressedCgDci.erase (m_suppressedCgDci.begin (),
+                               m_suppressedCgDci.lower_bound (std::make_tuple (slot, uint16_t (0), uint8_t (0))));
+      if (m_suppressedCgDci.erase (std::make_tuple (slot, dci->m_rnti, dci->m_symStart)) > 0)
+        {
+          Simulator::Schedule (varTtiPeriod, &NrGnbPhy::CheckUlDtx, this,
+                               dci->m_rnti, m_currentSlot, dci->m_symStart);
+        }
      }
 
   bool found = false;
@@ -1408,6 +1429,34 @@ NrGnbPhy::UlData(const std::shared_ptr<DciInfoElementTdma> &dci)
   return varTtiPeriod;
 }
 
+void
+NrGnbPhy::CheckUlDtx (uint16_t rnti, SfnSf sfn, uint8_t symStart)
+{
+  NS_LOG_FUNCTION (this << rnti);
+  uint8_t streamIndex = 0;
+  uint8_t harqProcessId = 0;
+  uint8_t rv = 0;
+  if (m_spectrumPhys.at (streamIndex)->CheckExpectedTbDtx (rnti, sfn, symStart, &harqProcessId, &rv))
+    {
+      ++m_ulDtxCount;
+      m_ulDtxTrace (sfn, rnti, symStart, GetBwpId (), GetCellId ());
+
+      // Release the HARQ process in the scheduler, instead of waiting for it to expire
+      UlHarqInfo harqUlInfo;
+      harqUlInfo.m_rnti = rnti;
+      harqUlInfo.m_tpc = 0;
+      harqUlInfo.m_harqProcessId = harqProcessId;
+      harqUlInfo.m_numRetx = rv;
+      harqUlInfo.m_receptionStatus = UlHarqInfo::Dtx;
+      ReportUlHarqFeedback (harqUlInfo);
+    }
+}
+
+uint64_t
+NrGnbPhy::GetUlDtxCount () const
+{
+  return m_ulDtxCount;
+}
 
 void
 NrGnbPhy::ChangeBeamformingVector (Ptr<NetDevice> dev)
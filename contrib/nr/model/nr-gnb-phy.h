@@ -24,6 +24,8 @@
 #include <ns3/lte-enb-cphy-sap.h>
 #include <ns3/nr-harq-phy.h>
 #include <functional>
+#include <set>
+#include <tuple>
 #include "ns3/ideal-beamforming-algorithm.h"
 #include "beam-conf-id.h"
 
@@ -387,6 +389,19 @@ public:
                                          const std::vector<int> &rbMap,
                                          uint16_t bwpId, uint16_t cellId);
 
+  /**
+   * \brief Check, at the end of an UL data var TTI, if the UE transmitted the TB
+   *
+   * Armed only for the configured-grant occasions, whose UL DCI was not sent
+   * (see m_suppressedCgDci). In case of DTX, the HARQ process is released
+   * with a UlHarqInfo::Dtx feedback.
+   *
+   * \param rnti RNTI of the UE
+   * \param sfn Slot of the expected TB
+   * \param symStart Sym start of the expected TB
+   */
+  void CheckUlDtx (uint16_t rnti, SfnSf sfn, uint8_t symStart);
+
   /**
    * \brief Retrieve the number of RB per RBG
    * \return the number of RB per RBG
@@ -416,6 +431,27 @@ public:
   void SetNUEcg (uint8_t CGPeriod);
   uint8_t GetNUEcg () const;
 
+  /**
+   * \brief Get the number of UL TBs that were expected but not transmitted
+   * \return the number of UL DTX detected since the start of the simulation
+   *
+   * A UE that skips an unused configured grant occasion shows up here,
+   * instead of as a corrupted TB.
+   */
+  uint64_t GetUlDtxCount () const;
+
+  /**
+   * \brief TracedCallback signature for UL DTX
+   *
+   * \param [in] sfnSf Slot of the expected TB
+   * \param [in] rnti RNTI of the UE that did not transmit
+   * \param [in] symStart Sym start of the expected TB
+   * \param [in] bwpId BWP ID
+   * \param [in] cellId Cell ID
+   */
+  typedef void (* UlDtxTracedCallback)(const SfnSf &sfnSf, uint16_t rnti, uint8_t symStart,
+                                       uint16_t bwpId, uint16_t cellId);
+
 protected:
   /**
    * \brief DoDispose method inherited from Object
@@ -758,6 +794,9 @@ private:
 
   TracedCallback<const SfnSf &, uint8_t, const std::vector<int>&, uint16_t, uint16_t> m_rbStatistics;
 
+  TracedCallback<const SfnSf &, uint16_t, uint8_t, uint16_t, uint16_t> m_ulDtxTrace; //!< UL DTX trace
+  uint64_t m_ulDtxCount {0}; //!< Number of UL DTX detected
+
   std::map<uint32_t, std::vector<uint32_t>> m_toSendDl; //!< Map that indicates, for each slot, what DL DCI we have to send
   std::map<uint32_t, std::vector<uint32_t>> m_toSendUl; //!< Map that indicates, for each slot, what UL DCI we have to send
   std::map<uint32_t, std::vector<uint32_t>> m_generateUl; //!< Map that indicates, for each slot, what UL DCI we have to generate
@@ -792,6 +831,11 @@ private:
 
   //Configured Grant
   bool m_firstPacket_configuredGrant {true}; //! SR from configuration period (CG)
+  /**
+   * \brief UL data DCIs not sent because the UE transmits with its configured grant:
+   * (absolute UL slot, RNTI, symbol start) of each occasion, to check it for DTX
+   */
+  std::set<std::tuple<uint64_t, uint16_t, uint8_t> > m_suppressedCgDci;
 
 
   bool m_cgScheduling = true;
@@ -20,6 +20,7 @@
 #include "nr-harq-phy.h"
 #include <ns3/log.h>
 #include <ns3/assert.h>
+#include <ns3/abort.h>
 
 NS_LOG_COMPONENT_DEFINE ("NrHarqPhy");
 
@@ -28,8 +29,10 @@ namespace ns3 {
 NrHarqPhy::~NrHarqPhy ()
 {
   NS_LOG_FUNCTION (this);
-  m_dlHistory.clear ();
-  m_ulHistory.clear ();
+  m_dlHistory.m_ueIndex.clear ();
+  m_dlHistory.m_history.clear ();
+  m_ulHistory.m_ueIndex.clear ();
+  m_ulHistory.m_history.clear ();
 }
 
 const NrErrorModel::NrErrorModelHistory &
@@ -77,38 +80,26 @@ NrHarqPhy::ResetUlHarqProcessStatus (uint16_t rnti, uint8_t id)
   ResetHarqProcessStatus (&m_ulHistory, rnti, id);
 }
 
-NrHarqPhy::HistoryMap::iterator
-NrHarqPhy::GetHistoryMapOf (NrHarqPhy::HistoryMap *map, uint16_t rnti) const
+NrErrorModel::NrErrorModelHistory &
+NrHarqPhy::GetHistoryOf (NrHarqPhy::HistoryMap *map, uint16_t rnti, uint8_t harqProcId) const
 {
   NS_LOG_FUNCTION (this);
+  NS_ABORT_MSG_IF (harqProcId >= MAX_HARQ_PROCESSES,
+                   "HARQ process id " << +harqProcId << " exceeds the supported " <<
+                   +MAX_HARQ_PROCESSES << " processes");
 
-  NrHarqPhy::HistoryMap::iterator it = map->find (rnti);
-  if (it == map->end ())
+  auto it = map->m_ueIndex.find (rnti);
+  if (it == map->m_ueIndex.end ())
     {
-      auto ret = map->insert (std::make_pair (rnti, ProcIdHistoryMap ()));
+      uint32_t ueIndex = static_cast<uint32_t> (map->m_ueIndex.size ());
+      auto ret = map->m_ueIndex.insert (std::make_pair (rnti, ueIndex));
       NS_ASSERT (ret.second);
+      map->m_history.resize (map->m_history.size () + MAX_HARQ_PROCESSES);
 
       it = ret.first;
     }
 
-  return it;
-}
-
-NrHarqPhy::ProcIdHistoryMap::iterator
-NrHarqPhy::GetProcIdHistoryMapOf (NrHarqPhy::ProcIdHistoryMap *map, uint16_t procId) const
-{
-  NS_LOG_FUNCTION (this);
-
-  NrHarqPhy::ProcIdHistoryMap::iterator it = map->find (procId);
-  if (it == map->end())
-    {
-      auto ret = map->insert (std::make_pair (procId, NrErrorModel::NrErrorModelHistory ()));
-      NS_ASSERT (ret.second);
-
-      it = ret.first;
-    }
-
-  return it;
+  return map->m_history.at (it->second * MAX_HARQ_PROCESSES + harqProcId);
 }
 
 void
@@ -117,11 +108,7 @@ NrHarqPhy::ResetHarqProcessStatus (NrHarqPhy::HistoryMap *map, uint16_t rnti,
 {
   NS_LOG_FUNCTION (this);
 
-  NrHarqPhy::HistoryMap::iterator historyMap = GetHistoryMapOf (map, rnti);
-
-  ProcIdHistoryMap * procIdMap = &(historyMap->second);
-
-  GetProcIdHistoryMapOf (procIdMap, harqProcId)->second.clear ();
+  GetHistoryOf (map, rnti, harqProcId).Reset ();
 }
 
 void
@@ -130,11 +117,7 @@ NrHarqPhy::UpdateHarqProcessStatus (NrHarqPhy::HistoryMap *map, uint16_t rnti,
 {
   NS_LOG_FUNCTION (this);
 
-  NrHarqPhy::HistoryMap::iterator historyMap = GetHistoryMapOf (map, rnti);
-
-  ProcIdHistoryMap * procIdMap = &(historyMap->second);
-
-  GetProcIdHistoryMapOf (procIdMap, harqProcId)->second.emplace_back (output);
+  output->AddToHistory (&GetHistoryOf (map, rnti, harqProcId));
 }
 
 const NrErrorModel::NrErrorModelHistory &
@@ -143,11 +126,7 @@ NrHarqPhy::GetHarqProcessInfo (NrHarqPhy::HistoryMap *map, uint16_t rnti,
 {
   NS_LOG_FUNCTION (this);
 
-  NrHarqPhy::HistoryMap::iterator historyMap = GetHistoryMapOf (map, rnti);
-
-  ProcIdHistoryMap * procIdMap = &(historyMap->second);
-
-  return GetProcIdHistoryMapOf (procIdMap, harqProcId)->second;
+  return GetHistoryOf (map, rnti, harqProcId);
 }
 
 
@@ -48,7 +48,8 @@ public:
   * for DL (asynchronous)
   * \param rnti the RNTI
   * \param harqProcId the HARQ proc id
-  * \return the vector of the info related to HARQ proc Id
+  * \return the history related to HARQ proc Id; the reference is valid
+  * until a new RNTI is added
   */
   const NrErrorModel::NrErrorModelHistory & GetHarqProcessInfoDl (uint16_t rnti, uint8_t harqProcId);
 
@@ -57,7 +58,8 @@ public:
   * for UL (asynchronous)
   * \param rnti the RNTI
   * \param harqProcId the HARQ process id
-  * \return the vector of the info related to HARQ proc Id
+  * \return the history related to HARQ proc Id; the reference is valid
+  * until a new RNTI is added
   */
   const NrErrorModel::NrErrorModelHistory & GetHarqProcessInfoUl (uint16_t rnti, uint8_t harqProcId);
 
@@ -97,33 +99,36 @@ public:
   */
   void ResetUlHarqProcessStatus (uint16_t rnti, uint8_t id);
 
+  /**
+   * \brief Maximum number of HARQ processes per UE
+   */
+  static const uint8_t MAX_HARQ_PROCESSES = 32;
+
 private:
 
   /**
-   * \brief Map between a process id and its HARQ history (a vector of pointers)
+   * \brief HARQ histories of all the processes of all the UEs
    *
    * The HARQ history depends on the error model (LTE error model stores MI (MIESM-based), while NR
-   * error model stores SINR (EESM-based)) as well as on the HARQ combining method.
+   * error model stores SINR (EESM-based)) as well as on the HARQ combining method, but
+   * it is always a fixed set of accumulated terms (see NrErrorModelHarqHistory).
+   * The histories are stored in a flat vector: the RNTI is translated into a dense
+   * UE index, and the history of the process p of the UE i is at i * MAX_HARQ_PROCESSES + p.
    */
-  typedef std::unordered_map <uint8_t, NrErrorModel::NrErrorModelHistory> ProcIdHistoryMap;
-  /**
-   * \brief Map between an RNTI and its ProcIdHistoryMap
-   */
-  typedef std::unordered_map <uint16_t, ProcIdHistoryMap> HistoryMap;
+  struct HistoryMap
+  {
+    std::unordered_map<uint16_t, uint32_t> m_ueIndex;           //!< Dense index of each RNTI
+    std::vector<NrErrorModel::NrErrorModelHistory> m_history;  //!< Histories, indexed by UE index and process id
+  };
+
   /**
-  * \brief Return the HARQ history map of the retransmissions of all process ids of a particular RNTI
+  * \brief Return the HARQ history of a particular process id, creating the UE entry if needed
+  * \param map the HistoryMap
   * \param rnti the RNTI
-  * \param map the Map between RNTIs and their history
-  * \return the HistoryMap of such RNTI
-  */
-  HistoryMap::iterator GetHistoryMapOf (HistoryMap *map, uint16_t rnti) const;
-  /**
-  * \brief Return the HARQ history of a particular process id
-  * \param procId the process id
-  * \param map the Map between processes ids and their history
-  * \return the ProcIdHistoryMap of such process id
+  * \param harqProcId the HARQ process id
+  * \return the HARQ history of such process id
   */
-  ProcIdHistoryMap::iterator GetProcIdHistoryMapOf (ProcIdHistoryMap *map, uint16_t procId) const;
+  NrErrorModel::NrErrorModelHistory & GetHistoryOf (HistoryMap *map, uint16_t rnti, uint8_t harqProcId) const;
 
   /**
   * \brief Reset the HARQ history of a particular process id
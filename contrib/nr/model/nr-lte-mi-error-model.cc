@@ -494,23 +494,17 @@ NrLteMiErrorModel::GetTbBitDecodificationStats (const SpectrumValue& sinr,
   double MI = tbMi;
   double Reff = 0.0;
 
-  if (history.size () > 0)
+  if (history.m_numTx > 0)
     {
       uint32_t codeBitsSum = 0;
       double miSum = 0.0;
-      uint32_t infoBits = DynamicCast<NrLteMiErrorModelOutput> (history.front ())->m_infoBits; // information bits of the first TB
+      uint32_t infoBits = history.m_infoBits; // information bits of the first TB
 
-      for (const Ptr<NrErrorModelOutput> & output : history)
-        {
-          Ptr<NrLteMiErrorModelOutput> miHistory = DynamicCast<NrLteMiErrorModelOutput> (output);
-          NS_ASSERT (miHistory != nullptr);
-
-          NS_LOG_DEBUG (" Sum MI " << miHistory->m_mi << " Ci " << miHistory->m_codeBits <<
-                        " infoBits: " << miHistory->m_infoBits);
+      NS_LOG_DEBUG (" Sum MI*Ci " << history.m_miCodeBits << " Sum Ci " << history.m_codeBits <<
+                    " infoBits: " << infoBits);
 
-          codeBitsSum += miHistory->m_codeBits;
-          miSum += (miHistory->m_mi * miHistory->m_codeBits);
-        }
+      codeBitsSum += history.m_codeBits;
+      miSum += history.m_miCodeBits;
 
       codeBitsSum += size / McsEcrTable [mcs];
       miSum += tbMi * (size / McsEcrTable [mcs]);
@@ -518,7 +512,7 @@ NrLteMiErrorModel::GetTbBitDecodificationStats (const SpectrumValue& sinr,
       MI = miSum / static_cast<double> (codeBitsSum);
     }
 
-  NS_LOG_INFO (" MI " << MI << " Reff " << Reff << " HARQ " << history.size ());
+  NS_LOG_INFO (" MI " << MI << " Reff " << Reff << " HARQ " << history.m_numTx);
 
   // estimate CB size (according to sec 5.1.2 of TS 36.212)
   uint16_t Z = 6144; // max size of a codeblock (including CRC)
@@ -578,7 +572,7 @@ NrLteMiErrorModel::GetTbBitDecodificationStats (const SpectrumValue& sinr,
 
   double errorRate = 1.0;
   uint8_t ecrId = 0;
-  if (history.size () == 0)
+  if (history.m_numTx == 0)
     {
       // first tx -> get ECR from MCS
       ecrId = McsEcrBlerTableMapping[mcs];
@@ -587,7 +581,7 @@ NrLteMiErrorModel::GetTbBitDecodificationStats (const SpectrumValue& sinr,
     }
   else
     {
-      NS_LOG_INFO ("HARQ block no. " << history.size ());
+      NS_LOG_INFO ("HARQ block no. " << history.m_numTx);
       // harq retx -> get closest ECR to Reff from available ones
       if (mcs <= MI_QPSK_MAX_ID)
         {
@@ -50,6 +50,17 @@ struct NrLteMiErrorModelOutput : public NrErrorModelOutput
   {
   }
 
+  void AddToHistory (NrErrorModelHarqHistory *history) const override
+  {
+    if (history->m_numTx == 0)
+      {
+        history->m_infoBits = m_infoBits;
+      }
+    history->m_codeBits += m_codeBits;
+    history->m_miCodeBits += m_mi * m_codeBits;
+    NrErrorModelOutput::AddToHistory (history);
+  }
+
   double m_mi       {0.0};    //!< Mutual Information
   double m_miTotal  {0.0};    //!< Acumulated Mutual Information
   uint32_t m_infoBits {0};    //!< number of info bits
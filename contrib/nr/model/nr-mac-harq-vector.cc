@@ -23,54 +23,93 @@ namespace ns3 {
 bool
 NrMacHarqVector::Erase (uint8_t id)
 {
-  at (id).Erase ();
-  --m_usedSize;
-
-  uint32_t count = 0;
-  for (const auto & v : *this)
+  NS_ASSERT (Exist (id));
+  if (m_processes[id].second.m_active)
     {
-      if (v.second.m_active)
-        {
-          ++count;
-        }
+      --m_usedSize;
     }
-  NS_ASSERT (count == m_usedSize);
+  m_processes[id].second.Erase ();
+  m_freeMask |= (1U << id);
+
+  NS_ASSERT (static_cast<uint32_t> (__builtin_popcount (m_freeMask)) == static_cast<uint32_t> (m_maxSize - m_usedSize));
   return true;
 }
 
 bool
 NrMacHarqVector::Insert (uint8_t *id, const HarqProcess& element)
 {
-  if (m_usedSize >= m_maxSize)
-    {
-      return false;
-    }
-
   NS_ABORT_IF (element.m_active == false);
 
   *id = FirstAvailableId ();
   if (*id == 255)
     {
-      return false;
+      if (m_overflowPolicy != PREEMPT_OLDEST)
+        {
+          return false;
+        }
+      *id = OldestPreemptableId ();
+      if (*id == 255)
+        {
+          return false;
+        }
+      if (m_preemptionCb)
+        {
+          m_preemptionCb (*id, m_processes[*id].second);
+        }
+      Erase (*id);
+      ++m_preempted;
+      if (m_staleFeedback[*id] < UINT8_MAX)
+        {
+          ++m_staleFeedback[*id];
+        }
     }
 
-  NS_ABORT_IF (at (*id).m_active == true);
-  at (*id) = element;
+  NS_ABORT_IF (m_processes[*id].second.m_active == true);
+  m_processes[*id].second = element;
+  m_freeMask &= ~(1U << *id);
 
-  NS_ABORT_IF (at (*id).m_active == false);
+  NS_ABORT_IF (m_processes[*id].second.m_active == false);
   NS_ABORT_IF (this->FirstAvailableId () == *id);
 
   ++m_usedSize;
   return true;
 }
 
+bool
+NrMacHarqVector::ConsumeStaleFeedback (uint8_t id)
+{
+  NS_ASSERT (Exist (id));
+  if (m_staleFeedback[id] == 0)
+    {
+      return false;
+    }
+  --m_staleFeedback[id];
+  return true;
+}
+
+uint8_t
+NrMacHarqVector::OldestPreemptableId () const
+{
+  uint8_t oldest = 255;
+  for (uint8_t i = 0; i < m_maxSize; ++i)
+    {
+      const HarqProcess & p = m_processes[i].second;
+      if (p.m_active && p.m_status == HarqProcess::WAITING_FEEDBACK
+          && (oldest == 255 || p.m_timer > m_processes[oldest].second.m_timer))
+        {
+          oldest = i;
+        }
+    }
+  return oldest;
+}
+
 std::ostream &
 operator<< (std::ostream & os, NrMacHarqVector const & item)
 {
-  for (const auto & p : item)
+  for (auto it = item.CBegin (); it != item.CEnd (); ++it)
     {
-      os << "Process ID " << static_cast<uint32_t> (p.first)
-         << ": " << p.second << std::endl;
+      os << "Process ID " << static_cast<uint32_t> (it->first)
+         << ": " << it->second << std::endl;
     }
   return os;
 }
@@ -18,7 +18,10 @@
  */
 #pragma once
 
-#include <unordered_map>
+#include <array>
+#include <functional>
+#include <utility>
+#include <ns3/abort.h>
 #include "nr-mac-harq-process.h"
 
 namespace ns3 {
@@ -27,49 +30,126 @@ namespace ns3 {
  * \ingroup scheduler
  * \brief Data structure to save all the HARQ process of an UE
  *
- * The data is stored as an unordered_map between the process ID and the
- * real data, saved in the structure HarqProcess. The vector (yes, it is an
- * improper name) is always full (i.e., it always contains almost 20 HARQ processes)
- * but they can be inactive (i.e., no data is stored there). The duty of finding
- * an empty spot is split between Insert and FirstAvailableId.
+ * The data is stored in a fixed-capacity array, indexed by the process ID;
+ * each element is a pair between the process ID and the real data, saved in
+ * the structure HarqProcess, so the iterators behave as the ones of a map.
+ * The vector is always full (i.e., it always contains the configured number
+ * of HARQ processes, 16 in NR, 20 by default in this module) but they can be
+ * inactive (i.e., no data is stored there). Iteration follows the process ID
+ * order.
  *
- * The class does not support going "out of space", or in other words, if all
- * the spots are filled with active processes, the next insert will fail.
+ * A bitmap of the inactive processes makes Insert and FirstAvailableId O(1),
+ * without any allocation.
+ *
+ * By default, the class does not support going "out of space", or in other
+ * words, if all the spots are filled with active processes, the next insert
+ * will fail. With the PREEMPT_OLDEST overflow policy, the process waiting for
+ * feedback since the longest time is dropped to make room for the new one.
+ * The owner is told through the preemption callback, and the feedback of the
+ * dropped TB, that will still arrive for the same process ID, is recognized
+ * by ConsumeStaleFeedback: feedbacks of a process arrive in the order of
+ * the transmissions, so the first ones after a preemption belong to the
+ * dropped TBs.
  *
  * \see HarqProcess
  */
-class NrMacHarqVector : private std::unordered_map<uint8_t, HarqProcess>
+class NrMacHarqVector
 {
 public:
   friend std::ostream &  operator<< (std::ostream & os, NrMacHarqVector const & item);
+
+  /**
+   * \brief Maximum number of processes that can be stored
+   */
+  static const uint8_t MAX_PROCESSES = 32;
+
+  /**
+   * \brief What to do when a process has to be inserted and all of them are active
+   */
+  enum OverflowPolicy : uint8_t
+  {
+    FAIL = 0,          //!< Insert fails (and the scheduler aborts)
+    PREEMPT_OLDEST = 1 //!< Drop the oldest process that is waiting for feedback
+  };
+
+  /**
+   * \brief Callback invoked when a process is preempted, before it is
+   * erased: the ID of the process and the process
+   */
+  typedef std::function<void (uint8_t, const HarqProcess &)> PreemptionCallback;
+
+  /**
+   * \brief element of the vector: the process ID and the process
+   */
+  typedef std::pair<uint8_t, HarqProcess> value_type;
   /**
-   * \brief iterator of the map
+   * \brief iterator of the vector
    */
-  typedef typename std::unordered_map<uint8_t, HarqProcess>::iterator iterator;
+  typedef value_type * iterator;
   /**
-   * \brief const_iterator of the map
+   * \brief const_iterator of the vector
    */
-  typedef typename std::unordered_map<uint8_t, HarqProcess>::const_iterator const_iterator;
+  typedef const value_type * const_iterator;
 
   /**
     * \brief Default constructor
     */
   NrMacHarqVector () = default;
 
+  /**
+   * \brief Constructor with the number of processes
+   * \param size the vector size
+   */
+  explicit NrMacHarqVector (uint8_t size)
+  {
+    SetMaxSize (size);
+  }
+
   /**
    * \brief Set and reserve the size of the vector
    * \param size the vector size
    *
-   * The method will reserve and create the necessary processes.
+   * The method will create the necessary (inactive) processes.
    */
   void SetMaxSize (uint8_t size)
   {
+    NS_ABORT_MSG_IF (size > MAX_PROCESSES, "At most " << +MAX_PROCESSES << " HARQ processes are supported");
     m_maxSize = size;
-    reserve (size);
-    for (auto i = 0; i < size; ++i)
+    m_usedSize = 0;
+    for (uint8_t i = 0; i < size; ++i)
       {
-        emplace (i, HarqProcess ());
+        m_processes[i].first = i;
+        m_processes[i].second = HarqProcess ();
       }
+    m_freeMask = size == 32 ? UINT32_MAX : ((1U << size) - 1);
+    m_staleFeedback.fill (0);
+  }
+
+  /**
+   * \brief Set the overflow policy
+   * \param policy the policy to apply when all the processes are active
+   */
+  void SetOverflowPolicy (OverflowPolicy policy)
+  {
+    m_overflowPolicy = policy;
+  }
+
+  /**
+   * \brief Set the callback invoked when a process is preempted
+   * \param cb the callback
+   */
+  void SetPreemptionCallback (const PreemptionCallback &cb)
+  {
+    m_preemptionCb = cb;
+  }
+
+  /**
+   * \brief Get the number of processes preempted by the PREEMPT_OLDEST policy
+   * \return the number of preempted processes
+   */
+  uint32_t GetPreemptedCount () const
+  {
+    return m_preempted;
   }
 
   /**
@@ -87,6 +167,34 @@ public:
    */
   bool Insert (uint8_t *id, const HarqProcess& element);
 
+  /**
+   * \brief Check a newly received feedback against the preempted TBs
+   *
+   * To be called once for each feedback, when it is received. If the
+   * feedback belongs to a TB dropped by a preemption, it is accounted and
+   * it has to be discarded: it does not refer to the TB now stored in the
+   * process.
+   *
+   * \param id ID of the process of the feedback
+   * \return true if the feedback is stale and has to be discarded
+   */
+  bool ConsumeStaleFeedback (uint8_t id);
+
+  /**
+   * \brief Forget the feedbacks still expected for the TBs preempted from
+   * a process
+   *
+   * To be called when the process expires: the feedback of the TBs sent
+   * before the expired one will not arrive anymore.
+   *
+   * \param id ID of the process
+   */
+  void ClearStaleFeedback (uint8_t id)
+  {
+    NS_ASSERT (Exist (id));
+    m_staleFeedback[id] = 0;
+  }
+
   /**
    * \brief Find a process
    * \param key ID of the process to find
@@ -95,7 +203,7 @@ public:
   const iterator
   Find (uint8_t key)
   {
-    return this->find (key);
+    return key < m_maxSize ? &m_processes[key] : End ();
   }
   /**
    * \brief Begin of the vector
@@ -104,7 +212,7 @@ public:
   const iterator
   Begin ()
   {
-    return this->begin ();
+    return m_processes.data ();
   }
   /**
    * \brief End of the vector
@@ -113,36 +221,35 @@ public:
   const iterator
   End ()
   {
-    return this->end ();
+    return m_processes.data () + m_maxSize;
   }
   /**
    * \brief Const begin of the vector
    * \return a const iterator to the first element
    */
   const_iterator
-  CBegin ()
+  CBegin () const
   {
-    return this->cbegin ();
+    return m_processes.data ();
   }
   /**
    * \brief Const end of the vector
    * \return a const iterator to the end() element
    */
   const_iterator
-  CEnd ()
+  CEnd () const
   {
-    return this->cend ();
+    return m_processes.data () + m_maxSize;
   }
   /**
-   * \brief Check if the ID exists in the map
+   * \brief Check if the ID exists in the vector
    * \param id ID to check
    * \return true if the ID exists, false if the ID is outside the maximum number
    * of stored elements
    */
   bool Exist (uint8_t id) const
   {
-    // could be id > max_size?
-    return find (id) != end ();
+    return id < m_maxSize;
   }
   /**
    * \brief Get a reference to a process
@@ -152,7 +259,7 @@ public:
   HarqProcess & Get (uint8_t id)
   {
     NS_ASSERT (Exist (id));
-    return find (id)->second;
+    return m_processes[id].second;
   }
   /**
    * \brief Get a const reference to a process
@@ -162,7 +269,7 @@ public:
   const HarqProcess & Get (uint8_t id) const
   {
     NS_ASSERT (Exist (id));
-    return find (id)->second;
+    return m_processes[id].second;
   }
   /**
    * \brief Find the first (INACTIVE) ID
@@ -170,22 +277,21 @@ public:
    */
   uint8_t FirstAvailableId () const
   {
-    for (const auto & it : *this)
+    if (m_freeMask == 0)
       {
-        if (!it.second.m_active)
-          {
-            return it.first;
-          }
+        return 255;
       }
-    return 255;
+    return static_cast<uint8_t> (__builtin_ctz (m_freeMask));
   }
   /**
    * \brief Can an ID be inserted?
-   * \return true if there is space to insert a new process, false otherwise
+   * \return true if there is space to insert a new process (possibly
+   * preempting an old one, depending on the overflow policy), false otherwise
    */
   bool CanInsert () const
   {
-    return Size () < m_maxSize;
+    return Size () < m_maxSize
+      || (m_overflowPolicy == PREEMPT_OLDEST && OldestPreemptableId () != 255);
   }
   /**
    * \brief Get the used size of the vector
@@ -197,8 +303,22 @@ public:
   }
 
 private:
-  uint8_t m_maxSize  {0}; //!< Maximum size (or the number of processes stored)
-  uint8_t m_usedSize {0}; //!< Number of ACTIVE processes
+  /**
+   * \brief Find the process that can be preempted: the one waiting for
+   * feedback since the longest time. Processes that received a NACK are
+   * never preempted, as they can be already listed for retransmission.
+   * \return the ID of the process, or 255 if no process can be preempted
+   */
+  uint8_t OldestPreemptableId () const;
+
+  std::array<value_type, MAX_PROCESSES> m_processes; //!< The processes, indexed by ID
+  uint32_t m_freeMask {0};   //!< Bit i is set if the process i is inactive
+  uint8_t m_maxSize  {0};    //!< Maximum size (or the number of processes stored)
+  uint8_t m_usedSize {0};    //!< Number of ACTIVE processes
+  OverflowPolicy m_overflowPolicy {FAIL}; //!< Policy when all the processes are active
+  uint32_t m_preempted {0};  //!< Number of preempted processes
+  std::array<uint8_t, MAX_PROCESSES> m_staleFeedback {}; //!< Feedbacks still expected for the preempted TBs, per process
+  PreemptionCallback m_preemptionCb; //!< Invoked when a process is preempted
 };
 
 /**
@@ -66,6 +66,7 @@ NrMacHeaderFsUl::IsFixedSizeHeader () const
   if (m_lcid == C_RNTI) return true;
   if (m_lcid == SHORT_TRUNCATED_BSR) return true;
   if (m_lcid == SHORT_BSR) return true;
+  if (m_lcid == LONG_BSR) return true;
   if (m_lcid == PADDING) return true;
 
   return false;
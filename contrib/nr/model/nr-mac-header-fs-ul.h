@@ -40,7 +40,8 @@ namespace ns3 {
  * \internal
  *
  * This header must be used to report some fixed-sized CE to the UE. An
- * example is NrMacShortBsrCe.
+ * example is NrMacShortBsrCe (or NrMacLongBsrCe, which in this
+ * implementation has a fixed size).
  */
 class NrMacHeaderFsUl : public NrMacHeaderFs
 {
@@ -75,6 +76,7 @@ public:
   static const uint8_t C_RNTI = 58;                          //!< C-RNTI
   static const uint8_t SHORT_TRUNCATED_BSR = 59;             //!< Short Truncated BSR
   static const uint8_t SHORT_BSR = 61;                       //!< Short BSR
+  static const uint8_t LONG_BSR = 62;                        //!< Long BSR
 
   /**
    * \brief Set the LC ID
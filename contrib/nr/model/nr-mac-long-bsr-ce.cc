@@ -0,0 +1,177 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "nr-mac-long-bsr-ce.h"
+#include <ns3/log.h>
+
+#include <algorithm>
+#include <vector>
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (NrMacLongBsrCe);
+NS_LOG_COMPONENT_DEFINE ("NrMacLongBsrCe");
+
+/**
+ * \brief Upper bound of each of the 8-bit buffer levels
+ *
+ * Table 6.1.3-2 TS 38.321 V15.3.0: level 0 is an empty buffer, level 254 is
+ * anything above the last bound, and level 255 is reserved.
+ */
+static const std::vector<uint64_t> &
+GetLongBsrLookupVector ()
+{
+  static const std::vector<uint64_t> lookupVector =
+  {
+    0, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20,
+    22, 23, 25, 26, 28, 30, 32, 34, 36, 38, 40, 43,
+    46, 49, 52, 55, 59, 62, 66, 71, 75, 80, 85, 91,
+    97, 103, 110, 117, 124, 132, 141, 150, 160, 170, 181, 193,
+    205, 218, 233, 248, 264, 281, 299, 318, 339, 361, 384, 409,
+    436, 464, 494, 526, 560, 597, 635, 677, 720, 767, 817, 870,
+    926, 987, 1051, 1119, 1191, 1269, 1351, 1439, 1532, 1631, 1737, 1850,
+    1970, 2098, 2234, 2379, 2533, 2698, 2873, 3059, 3258, 3469, 3694, 3934,
+    4189, 4461, 4751, 5059, 5387, 5737, 6109, 6506, 6928, 7378, 7857, 8367,
+    8910, 9488, 10104, 10760, 11458, 12202, 12994, 13838, 14736, 15692, 16711, 17795,
+    18951, 20181, 21491, 22885, 24371, 25953, 27638, 29431, 31342, 33376, 35543, 37850,
+    40307, 42923, 45709, 48676, 51836, 55200, 58784, 62599, 66663, 70990, 75598, 80505,
+    85730, 91295, 97221, 103532, 110252, 117409, 125030, 133146, 141789, 150992, 160793, 171231,
+    182345, 194182, 206786, 220209, 234503, 249725, 265935, 283197, 301579, 321155, 342002, 364202,
+    387842, 413018, 439827, 468377, 498780, 531156, 565634, 602350, 641449, 683087, 727427, 774645,
+    824928, 878475, 935498, 996222, 1060888, 1129752, 1203086, 1281179, 1364342, 1452903, 1547213, 1647644,
+    1754595, 1868488, 1989774, 2118933, 2256475, 2402946, 2558924, 2725027, 2901912, 3090279, 3290873, 3504487,
+    3731968, 3974215, 4232186, 4506902, 4799451, 5110989, 5442750, 5796046, 6172275, 6572925, 6999582, 7453933,
+    7937777, 8453028, 9001725, 9586039, 10208280, 10870913, 11576557, 12328006, 13128233, 13980403, 14887889, 15854280,
+    16883401, 17979324, 19146385, 20389201, 21712690, 23122088, 24622972, 26221280, 27923336, 29735875, 31666069, 33721553,
+    35910462, 38241455, 40723756, 43367187, 46182206, 49179951, 52372284, 55771835, 59392055, 63247269, 67352729, 71724679,
+    76380419, 81338368
+  };
+
+  return lookupVector;
+}
+
+TypeId
+NrMacLongBsrCe::GetTypeId ()
+{
+  static TypeId tid = TypeId ("ns3::NrMacLongBsrCe")
+    .SetParent<Header> ()
+    .AddConstructor<NrMacLongBsrCe> ();
+  return tid;
+}
+
+TypeId NrMacLongBsrCe::GetInstanceTypeId () const
+{
+  return GetTypeId ();
+}
+
+NrMacLongBsrCe::NrMacLongBsrCe ()
+{
+  NS_LOG_FUNCTION (this);
+  m_header.SetLcId (NrMacHeaderFsUl::LONG_BSR);
+}
+
+void
+NrMacLongBsrCe::Serialize (Buffer::Iterator start) const
+{
+  NS_LOG_FUNCTION (this);
+
+  m_header.Serialize (start);
+  start.Next (m_header.GetSerializedSize ());
+
+  for (const auto & level : m_bufferSizeLevel)
+    {
+      start.WriteU8 (level);
+    }
+}
+
+uint32_t
+NrMacLongBsrCe::Deserialize (Buffer::Iterator start)
+{
+  NS_LOG_FUNCTION (this);
+
+  auto readBytes = m_header.Deserialize (start);
+  start.Next (readBytes);
+  NS_ASSERT (m_header.GetLcId () == NrMacHeaderFsUl::LONG_BSR);
+
+  for (auto & level : m_bufferSizeLevel)
+    {
+      level = start.ReadU8 ();
+    }
+
+  return GetSerializedSize ();
+}
+
+uint32_t
+NrMacLongBsrCe::GetSerializedSize () const
+{
+  NS_LOG_FUNCTION (this);
+  return m_header.GetSerializedSize () + NUM_LCG;
+}
+
+void
+NrMacLongBsrCe::Print (std::ostream &os) const
+{
+  NS_LOG_FUNCTION (this);
+  for (uint32_t lcg = 0; lcg < NUM_LCG; ++lcg)
+    {
+      os << "LCG" << lcg << ": " << static_cast<uint32_t> (m_bufferSizeLevel[lcg]);
+    }
+}
+
+bool
+NrMacLongBsrCe::operator == (const NrMacLongBsrCe &o) const
+{
+  return m_bufferSizeLevel == o.m_bufferSizeLevel;
+}
+
+uint8_t
+NrMacLongBsrCe::FromBytesToLevel (uint64_t bufferSize)
+{
+  const auto & lookupVector = GetLongBsrLookupVector ();
+
+  NS_ASSERT (lookupVector.size () == 254 && lookupVector.back () == 81338368);
+  if (bufferSize > lookupVector.back ())
+    {
+      return 254;
+    }
+
+  // First level whose upper bound is not below the buffer size
+  auto it = std::lower_bound (lookupVector.begin (), lookupVector.end (), bufferSize);
+  uint32_t index = static_cast<uint32_t> (std::distance (lookupVector.begin (), it));
+
+  NS_ASSERT (index <= 253);
+
+  return static_cast<uint8_t> (index);
+}
+
+uint64_t
+NrMacLongBsrCe::FromLevelToBytes (uint8_t bufferLevel)
+{
+  const auto & lookupVector = GetLongBsrLookupVector ();
+
+  if (bufferLevel > lookupVector.size () - 1)
+    {
+      // The value is > 81338368 (255 is reserved). As for the short BSR,
+      // return something big
+      return lookupVector.back () * 8;
+    }
+
+  return lookupVector[bufferLevel];
+}
+
+} // namespace ns3
@@ -0,0 +1,138 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#ifndef NR_MAC_LONG_BSR_CE_H
+#define NR_MAC_LONG_BSR_CE_H
+
+#include "ns3/packet.h"
+#include "nr-mac-header-fs-ul.h"
+
+#include <array>
+
+namespace ns3 {
+
+/**
+ * \ingroup ue-mac
+ * \ingroup gnb-mac
+ * \brief Long BSR control element
+ *
+ * This is the long BSR control element, meant to be written after a subHeader,
+ * within a NR subPDU. It always be fixed size of 8 byte, one for each LCG,
+ * and each byte is an 8-bit buffer level. Please use the conversion function
+ * to write or read the buffer level.
+ *
+ * The serialization looks like the following:
+ *
+ * \verbatim
+ +-----------------------------------------------------------+
+ |                                                           |
+ |                  Buffer Level (LCG 0)                     |   Oct 1
+ |                                                           |
+ +-----------------------------------------------------------+
+ |                          ...                              |
+ +-----------------------------------------------------------+
+ |                                                           |
+ |                  Buffer Level (LCG 7)                     |   Oct 8
+ |                                                           |
+ +-----------------------------------------------------------+
+\endverbatim
+ *
+ * As for NrMacShortBsrCe, this is a mix of what LENA uses and what the
+ * standard says: the standard long BSR starts with a bitmap of the LCGs
+ * present, and has a variable size. Here, all the 8 LCGs are always written,
+ * and the position tells us to what LCG it pertains.
+ *
+ * With 256 levels instead of 32, the buffer reported to the gNB is much
+ * closer to the real one (the step between two levels is ~6.5%, instead of
+ * ~40%), and the scheduler wastes less resources.
+ *
+ * Please refer to TS 38.321 section 6.1.3.1 for more information.
+ */
+class NrMacLongBsrCe : public Header
+{
+public:
+  /**
+   * \brief GetTypeId
+   * \return the type id of the object
+   */
+  static TypeId  GetTypeId (void);
+  /**
+   * \brief GetInstanceTypeId
+   * \return the instance type id
+   */
+  virtual TypeId  GetInstanceTypeId (void) const;
+
+  /**
+   * \brief NrMacLongBsrCe constructor
+   */
+  NrMacLongBsrCe ();
+
+  /**
+   * \brief Serialize on a buffer
+   * \param start start position
+   */
+  void Serialize (Buffer::Iterator start) const;
+  /**
+   * \brief Deserialize from a buffer
+   * \param start start position
+   * \return the number of bytes read from the buffer
+   */
+  uint32_t Deserialize (Buffer::Iterator start);
+  /**
+   * \brief Get the serialized size
+   * \return the size of the subheader plus 8
+   */
+  uint32_t GetSerializedSize () const;
+  /**
+   * \brief Print the struct on a ostream
+   * \param os ostream
+   */
+  void Print (std::ostream &os) const;
+
+  /**
+   * \brief IsEqual
+   * \param o another instance
+   * \return true if this and o are equal, false otherwise
+   */
+  bool operator == (const NrMacLongBsrCe &o) const;
+
+  /**
+   * \brief Convert a bytes value into the level to write in the BSR
+   * \param bufferSize The buffer size
+   * \return a number between 0 and 254 that represents the buffer level (255 is reserved)
+   */
+  static uint8_t FromBytesToLevel (uint64_t bufferSize);
+
+  /**
+   * \brief Convert a buffer level into a buffer size
+   * \param bufferLevel The buffer level
+   * \return the buffer size
+   */
+  static uint64_t FromLevelToBytes (uint8_t bufferLevel);
+
+  static const uint8_t NUM_LCG = 8; //!< Number of LCG reported
+
+  std::array<uint8_t, NUM_LCG> m_bufferSizeLevel {}; //!< Buffer size level for each LCG
+
+private:
+  NrMacHeaderFsUl m_header; //!< Fixed-size header to prepend to the BSR
+};
+
+} //namespace ns3
+
+#endif /* NR_MAC_LONG_BSR_CE_H */
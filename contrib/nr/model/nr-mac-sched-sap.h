@@ -278,6 +278,24 @@ public:
    */
   virtual Time GetSlotPeriod () const = 0;
 
+  /**
+   * \brief Get the TDD pattern of the PHY
+   * \return the type of each slot of the pattern
+   */
+  virtual std::vector<LteNrTddSlotType> GetTddPattern () const = 0;
+
+  /**
+   * \brief A HARQ process has been preempted to make room for a new TB
+   *
+   * The feedback of the dropped TB will still arrive with the same process
+   * ID, and it does not refer to the new TB.
+   *
+   * \param rnti RNTI of the UE
+   * \param harqProcessId ID of the process
+   * \param isDl true for a DL process, false for UL
+   */
+  virtual void NotifyHarqPreemption (uint16_t rnti, uint8_t harqProcessId, bool isDl) = 0;
+
   // Configured Grant
   virtual Time GetTbUlEncodeLatency () const = 0;
 };
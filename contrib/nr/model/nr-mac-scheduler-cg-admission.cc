@@ -0,0 +1,174 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "nr-mac-scheduler-cg-admission.h"
+
+#include <ns3/log.h>
+#include <ns3/abort.h>
+#include <algorithm>
+#include <cmath>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NrMacSchedulerCgAdmission");
+
+void
+NrMacSchedulerCgAdmission::Configure (const Ptr<const NrAmc> &amc, uint32_t numRbg,
+                                      uint32_t rbPerRbg, uint32_t dataSymPerSlot,
+                                      double ulSymPerSlot)
+{
+  NS_LOG_FUNCTION (this << numRbg << rbPerRbg << dataSymPerSlot << ulSymPerSlot);
+  NS_ASSERT (amc != nullptr);
+  NS_ASSERT (ulSymPerSlot <= dataSymPerSlot);
+  m_amc = amc;
+  m_numRbg = numRbg;
+  m_rbPerRbg = rbPerRbg;
+  m_dataSymPerSlot = dataSymPerSlot;
+  m_ulSymPerSlot = ulSymPerSlot;
+  m_bytesPerUnit.fill (0.0);
+}
+
+bool
+NrMacSchedulerCgAdmission::IsConfigured () const
+{
+  return m_amc != nullptr;
+}
+
+void
+NrMacSchedulerCgAdmission::SetMaxUtilization (double v)
+{
+  NS_ABORT_MSG_IF (v <= 0.0 || v > 1.0, "The CG utilization must be in (0, 1]");
+  m_maxUtilization = v;
+}
+
+double
+NrMacSchedulerCgAdmission::GetMaxUtilization () const
+{
+  return m_maxUtilization;
+}
+
+bool
+NrMacSchedulerCgAdmission::Admit (uint16_t rnti, uint32_t period, uint32_t bytes, uint8_t mcs)
+{
+  NS_LOG_FUNCTION (this << rnti << period << bytes << static_cast<uint32_t> (mcs));
+  NS_ASSERT (IsConfigured ());
+  NS_ASSERT (period > 0);
+
+  double previous = 0.0;
+  auto it = m_flows.find (rnti);
+  if (it != m_flows.end ())
+    {
+      previous = it->second.m_demand;
+    }
+
+  double demand = ComputeDemand (period, bytes, mcs);
+  if (demand * period > m_numRbg * m_dataSymPerSlot
+      || m_demand - previous + demand > GetCapacity ())
+    {
+      NS_LOG_INFO ("CG flow of UE " << rnti << " needs " << demand << " units per slot, " <<
+                   GetCapacity () - m_demand + previous << " available");
+      return false;
+    }
+
+  m_demand += demand - previous;
+  m_flows[rnti] = Flow {period, demand};
+  return true;
+}
+
+void
+NrMacSchedulerCgAdmission::RemoveFlow (uint16_t rnti)
+{
+  auto it = m_flows.find (rnti);
+  if (it != m_flows.end ())
+    {
+      m_demand = std::max (0.0, m_demand - it->second.m_demand);
+      m_flows.erase (it);
+    }
+}
+
+bool
+NrMacSchedulerCgAdmission::HasFlow (uint16_t rnti) const
+{
+  return m_flows.find (rnti) != m_flows.end ();
+}
+
+uint32_t
+NrMacSchedulerCgAdmission::GetFlowPeriod (uint16_t rnti) const
+{
+  auto it = m_flows.find (rnti);
+  return it != m_flows.end () ? it->second.m_period : 0;
+}
+
+double
+NrMacSchedulerCgAdmission::GetCapacity () const
+{
+  return m_numRbg * m_ulSymPerSlot * m_maxUtilization;
+}
+
+double
+NrMacSchedulerCgAdmission::GetDemand () const
+{
+  return m_demand;
+}
+
+double
+NrMacSchedulerCgAdmission::GetUtilization () const
+{
+  double capacity = GetCapacity ();
+  return capacity > 0.0 ? m_demand / capacity : 0.0;
+}
+
+uint32_t
+NrMacSchedulerCgAdmission::GetAdmissibleBytes (uint32_t period, uint8_t mcs) const
+{
+  NS_ASSERT (IsConfigured ());
+  NS_ASSERT (period > 0);
+
+  double remaining = GetCapacity () - m_demand;
+  if (remaining <= 0.0)
+    {
+      return 0;
+    }
+  // an occasion can not be larger than a slot
+  double units = std::min (std::floor (remaining * period),
+                           static_cast<double> (m_numRbg * m_dataSymPerSlot));
+  return static_cast<uint32_t> (units * GetBytesPerUnit (mcs));
+}
+
+double
+NrMacSchedulerCgAdmission::GetBytesPerUnit (uint8_t mcs) const
+{
+  NS_ASSERT (mcs < m_bytesPerUnit.size ());
+  if (m_bytesPerUnit[mcs] == 0.0)
+    {
+      uint32_t units = m_numRbg * m_dataSymPerSlot;
+      uint32_t tbs = m_amc->CalculateTbSize (mcs, units * m_rbPerRbg);
+      m_bytesPerUnit[mcs] = std::max (1.0, static_cast<double> (tbs)) / units;
+      NS_LOG_DEBUG ("MCS " << static_cast<uint32_t> (mcs) << ": " <<
+                    m_bytesPerUnit[mcs] << " bytes per RBG-symbol");
+    }
+  return m_bytesPerUnit[mcs];
+}
+
+double
+NrMacSchedulerCgAdmission::ComputeDemand (uint32_t period, uint32_t bytes, uint8_t mcs) const
+{
+  return std::ceil (bytes / GetBytesPerUnit (mcs)) / period;
+}
+
+} // namespace ns3
@@ -0,0 +1,155 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include "nr-amc.h"
+#include <array>
+#include <cstdint>
+#include <unordered_map>
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief Utilization model of the UL resources used by configured grants
+ *
+ * The UL resources of a BWP are counted in units of one RBG for one symbol.
+ * The capacity, in units per slot, is the number of RBG times the average
+ * number of UL data symbols per slot of the TDD pattern, scaled by the
+ * maximum utilization that can be reserved for CG. Each CG flow demands, in units per slot, the units
+ * needed by one occasion at the MCS of the UE, divided by its period.
+ *
+ * The bytes that a unit carries at each MCS are computed with NrAmc the first
+ * time the MCS is used, so that admitting or removing a flow is O(1).
+ */
+class NrMacSchedulerCgAdmission
+{
+public:
+  /**
+   * \brief NrMacSchedulerCgAdmission default constructor
+   */
+  NrMacSchedulerCgAdmission () = default;
+
+  /**
+   * \brief Set the resources of the BWP
+   * \param amc the UL AMC
+   * \param numRbg number of RBG of the BWP
+   * \param rbPerRbg number of RB in a RBG
+   * \param dataSymPerSlot maximum number of UL data symbols in a slot
+   * \param ulSymPerSlot average number of UL data symbols per slot of the TDD pattern
+   */
+  void Configure (const Ptr<const NrAmc> &amc, uint32_t numRbg, uint32_t rbPerRbg,
+                  uint32_t dataSymPerSlot, double ulSymPerSlot);
+  /**
+   * \return true if Configure has been called
+   */
+  bool IsConfigured () const;
+
+  /**
+   * \brief Set the fraction of the UL resources that CG flows can reserve
+   * \param v the fraction, in (0, 1]
+   */
+  void SetMaxUtilization (double v);
+  /**
+   * \return the fraction of the UL resources that CG flows can reserve
+   */
+  double GetMaxUtilization () const;
+
+  /**
+   * \brief Admit (or update) the CG flow of an UE, if it fits
+   * \param rnti RNTI of the UE
+   * \param period period, in slots (greater than 0)
+   * \param bytes bytes of each occasion
+   * \param mcs UL MCS of the UE
+   * \return true if the flow has been admitted; if not, the previous flow of
+   * the UE (if any) is kept
+   */
+  bool Admit (uint16_t rnti, uint32_t period, uint32_t bytes, uint8_t mcs);
+  /**
+   * \brief Remove the CG flow of an UE (if any)
+   * \param rnti RNTI of the UE
+   */
+  void RemoveFlow (uint16_t rnti);
+  /**
+   * \param rnti RNTI of the UE
+   * \return true if the UE has an admitted CG flow
+   */
+  bool HasFlow (uint16_t rnti) const;
+  /**
+   * \param rnti RNTI of the UE
+   * \return the period of the admitted flow of the UE (0 if none)
+   */
+  uint32_t GetFlowPeriod (uint16_t rnti) const;
+
+  /**
+   * \return the capacity for CG, in units (RBG x symbol) per slot
+   */
+  double GetCapacity () const;
+  /**
+   * \return the units (RBG x symbol) per slot demanded by the admitted flows
+   */
+  double GetDemand () const;
+  /**
+   * \return the fraction of the capacity demanded by the admitted flows
+   */
+  double GetUtilization () const;
+  /**
+   * \brief Get the largest occasion that a new flow could have
+   * \param period period, in slots (greater than 0)
+   * \param mcs UL MCS of the UE
+   * \return the bytes of the largest occasion that fits in the remaining capacity
+   */
+  uint32_t GetAdmissibleBytes (uint32_t period, uint8_t mcs) const;
+
+private:
+  /**
+   * \brief An admitted CG flow
+   */
+  struct Flow
+  {
+    uint32_t m_period {0}; //!< Period, in slots
+    double m_demand {0.0}; //!< Units per slot
+  };
+
+  /**
+   * \param mcs the MCS
+   * \return the bytes carried by a unit at the MCS
+   */
+  double GetBytesPerUnit (uint8_t mcs) const;
+  /**
+   * \param period period, in slots
+   * \param bytes bytes of each occasion
+   * \param mcs the MCS
+   * \return the units per slot demanded by the flow
+   */
+  double ComputeDemand (uint32_t period, uint32_t bytes, uint8_t mcs) const;
+
+  Ptr<const NrAmc> m_amc;          //!< UL AMC
+  uint32_t m_numRbg {0};           //!< RBG of the BWP
+  uint32_t m_rbPerRbg {0};         //!< RB in a RBG
+  uint32_t m_dataSymPerSlot {0};   //!< Maximum UL data symbols in a slot
+  double m_ulSymPerSlot {0.0};     //!< Average UL data symbols per slot of the TDD pattern
+  double m_maxUtilization {1.0};   //!< Fraction of the UL resources for CG
+
+  double m_demand {0.0};           //!< Units per slot demanded by the admitted flows
+  std::unordered_map<uint16_t, Flow> m_flows; //!< Admitted flows, by RNTI
+
+  mutable std::array<double, 32> m_bytesPerUnit {}; //!< Bytes per unit, by MCS (0: not computed yet)
+};
+
+} // namespace ns3
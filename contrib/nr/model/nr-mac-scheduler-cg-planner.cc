@@ -0,0 +1,316 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "nr-mac-scheduler-cg-planner.h"
+
+#include <ns3/log.h>
+#include <ns3/abort.h>
+#include <algorithm>
+#include <numeric>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NrMacSchedulerCgPlanner");
+
+void
+NrMacSchedulerCgPlanner::SetSlotCapacity (uint32_t bytes)
+{
+  m_slotCapacity = bytes;
+}
+
+uint32_t
+NrMacSchedulerCgPlanner::GetSlotCapacity () const
+{
+  return m_slotCapacity;
+}
+
+void
+NrMacSchedulerCgPlanner::SetMaxOccasionsPerSlot (uint32_t n)
+{
+  m_maxOccasions = n;
+}
+
+uint32_t
+NrMacSchedulerCgPlanner::GetMaxOccasionsPerSlot () const
+{
+  return m_maxOccasions;
+}
+
+void
+NrMacSchedulerCgPlanner::SetUlSlotMask (const std::vector<bool> &ulSlots)
+{
+  NS_LOG_FUNCTION (this << ulSlots.size ());
+  NS_ABORT_MSG_IF (! m_flows.empty (), "The UL slot mask must be set before adding any flow");
+  NS_ABORT_MSG_IF (ulSlots.size () > MAX_HYPERPERIOD, "UL slot mask longer than the maximum hyperperiod");
+
+  m_ulSlots = ulSlots;
+  m_hyperperiod = GetBaseHyperperiod ();
+  m_load.assign (m_hyperperiod, 0);
+  m_count.assign (m_hyperperiod, 0);
+  RebuildTable ();
+}
+
+uint32_t
+NrMacSchedulerCgPlanner::GetBaseHyperperiod () const
+{
+  return m_ulSlots.empty () ? 1 : static_cast<uint32_t> (m_ulSlots.size ());
+}
+
+bool
+NrMacSchedulerCgPlanner::HasFlow (uint16_t rnti) const
+{
+  return std::any_of (m_flows.begin (), m_flows.end (),
+                      [rnti] (const Flow &f) { return f.m_rnti == rnti; });
+}
+
+size_t
+NrMacSchedulerCgPlanner::GetNumFlows () const
+{
+  return m_flows.size ();
+}
+
+uint32_t
+NrMacSchedulerCgPlanner::GetHyperperiod () const
+{
+  return m_hyperperiod;
+}
+
+NrMacSchedulerCgPlanner::OccasionRange
+NrMacSchedulerCgPlanner::GetOccasions (uint64_t slot) const
+{
+  OccasionRange range;
+  if (m_occasions.empty ())
+    {
+      return range;
+    }
+  uint32_t s = static_cast<uint32_t> (slot % m_hyperperiod);
+  range.m_begin = m_occasions.data () + m_slotStart[s];
+  range.m_end = m_occasions.data () + m_slotStart[s + 1];
+  return range;
+}
+
+bool
+NrMacSchedulerCgPlanner::AddFlow (uint16_t rnti, uint32_t period, uint32_t offset,
+                                  uint32_t size, uint32_t maxDelay)
+{
+  NS_LOG_FUNCTION (this << rnti << period << offset << size << maxDelay);
+  NS_ASSERT (period > 0);
+
+  auto it = std::find_if (m_flows.begin (), m_flows.end (),
+                          [rnti] (const Flow &f) { return f.m_rnti == rnti; });
+  if (it == m_flows.end ())
+    {
+      bool placed = Place (rnti, period, offset, size, maxDelay);
+      RebuildTable ();
+      return placed;
+    }
+
+  // Update: free the old occasions, and put them back if the new flow does not fit
+  Flow old = *it;
+  RemoveFlow (rnti);
+  if (! Place (rnti, period, offset, size, maxDelay))
+    {
+      Resize (static_cast<uint32_t> (std::lcm (m_hyperperiod, old.m_period)));
+      Account (old, +1);
+      m_flows.push_back (old);
+      RebuildTable ();
+      return false;
+    }
+  RebuildTable ();
+  return true;
+}
+
+void
+NrMacSchedulerCgPlanner::RemoveFlow (uint16_t rnti)
+{
+  NS_LOG_FUNCTION (this << rnti);
+
+  auto it = std::find_if (m_flows.begin (), m_flows.end (),
+                          [rnti] (const Flow &f) { return f.m_rnti == rnti; });
+  if (it == m_flows.end ())
+    {
+      return;
+    }
+  Account (*it, -1);
+  m_flows.erase (it);
+
+  uint32_t hyperperiod = GetBaseHyperperiod ();
+  for (const auto & f : m_flows)
+    {
+      hyperperiod = std::lcm (hyperperiod, f.m_period);
+    }
+  Resize (hyperperiod);
+  RebuildTable ();
+}
+
+bool
+NrMacSchedulerCgPlanner::Place (uint16_t rnti, uint32_t period, uint32_t offset,
+                                uint32_t size, uint32_t maxDelay)
+{
+  uint64_t hyperperiod = std::lcm (static_cast<uint64_t> (m_hyperperiod), static_cast<uint64_t> (period));
+  if (hyperperiod > MAX_HYPERPERIOD)
+    {
+      NS_LOG_INFO ("Flow of UE " << rnti << " rejected: hyperperiod " << hyperperiod <<
+                   " longer than " << MAX_HYPERPERIOD << " slots");
+      return false;
+    }
+  uint32_t oldHyperperiod = m_hyperperiod;
+  Resize (static_cast<uint32_t> (hyperperiod));
+
+  // Choose the shift with the lowest peak (bytes, then occasions); the
+  // earliest one among the equivalent
+  uint32_t maxShift = std::min (maxDelay, period - 1);
+  bool found = false;
+  uint32_t bestSlot = 0;
+  uint64_t bestLoad = 0;
+  uint32_t bestCount = 0;
+  for (uint32_t shift = 0; shift <= maxShift; ++shift)
+    {
+      uint32_t slot = (offset + shift) % period;
+      uint64_t peakLoad = 0;
+      uint32_t peakCount = 0;
+      bool ulOnly = true;
+      for (uint32_t s = slot; s < m_hyperperiod; s += period)
+        {
+          // The hyperperiod is a multiple of the mask length
+          if (! m_ulSlots.empty () && ! m_ulSlots[s % m_ulSlots.size ()])
+            {
+              ulOnly = false;
+              break;
+            }
+          peakLoad = std::max<uint64_t> (peakLoad, static_cast<uint64_t> (m_load[s]) + size);
+          peakCount = std::max<uint32_t> (peakCount, m_count[s] + 1U);
+        }
+      if (! ulOnly
+          || (m_slotCapacity > 0 && peakLoad > m_slotCapacity)
+          || (m_maxOccasions > 0 && peakCount > m_maxOccasions))
+        {
+          continue;
+        }
+      if (! found || peakLoad < bestLoad || (peakLoad == bestLoad && peakCount < bestCount))
+        {
+          found = true;
+          bestSlot = slot;
+          bestLoad = peakLoad;
+          bestCount = peakCount;
+        }
+    }
+
+  if (! found)
+    {
+      NS_LOG_INFO ("Flow of UE " << rnti << " rejected: no room in the UL slots among " <<
+                   maxShift + 1 << " candidate slots");
+      Resize (oldHyperperiod);
+      return false;
+    }
+
+  Flow flow;
+  flow.m_rnti = rnti;
+  flow.m_period = period;
+  flow.m_slot = bestSlot;
+  flow.m_size = size;
+  Account (flow, +1);
+  m_flows.push_back (flow);
+
+  NS_LOG_INFO ("Flow of UE " << rnti << " placed at slot " << bestSlot << " of period " <<
+               period << " (nominal " << offset % period << "), peak load " << bestLoad <<
+               " B, hyperperiod " << m_hyperperiod);
+  return true;
+}
+
+void
+NrMacSchedulerCgPlanner::Resize (uint32_t hyperperiod)
+{
+  if (hyperperiod == m_hyperperiod)
+    {
+      return;
+    }
+  // The load is periodic with the LCM of the periods of the flows, which
+  // divides both the old and the new hyperperiod
+  uint32_t old = m_hyperperiod;
+  m_load.resize (old, 0);
+  m_count.resize (old, 0);
+  if (hyperperiod > old)
+    {
+      NS_ASSERT (hyperperiod % old == 0);
+      m_load.resize (hyperperiod);
+      m_count.resize (hyperperiod);
+      for (uint32_t s = old; s < hyperperiod; ++s)
+        {
+          m_load[s] = m_load[s - old];
+          m_count[s] = m_count[s - old];
+        }
+    }
+  else
+    {
+      m_load.resize (hyperperiod);
+      m_count.resize (hyperperiod);
+    }
+  m_hyperperiod = hyperperiod;
+}
+
+void
+NrMacSchedulerCgPlanner::Account (const Flow &flow, int sign)
+{
+  m_load.resize (m_hyperperiod, 0);
+  m_count.resize (m_hyperperiod, 0);
+  for (uint32_t s = flow.m_slot; s < m_hyperperiod; s += flow.m_period)
+    {
+      if (sign > 0)
+        {
+          m_load[s] += flow.m_size;
+          m_count[s] += 1;
+        }
+      else
+        {
+          NS_ASSERT (m_load[s] >= flow.m_size && m_count[s] > 0);
+          m_load[s] -= flow.m_size;
+          m_count[s] -= 1;
+        }
+    }
+}
+
+void
+NrMacSchedulerCgPlanner::RebuildTable ()
+{
+  m_slotStart.assign (m_hyperperiod + 1, 0);
+  m_occasions.clear ();
+  if (m_flows.empty ())
+    {
+      return;
+    }
+
+  // Counting sort of the occasions by slot
+  for (uint32_t s = 0; s < m_hyperperiod; ++s)
+    {
+      m_slotStart[s + 1] = m_slotStart[s] + m_count[s];
+    }
+  m_occasions.resize (m_slotStart[m_hyperperiod]);
+  std::vector<uint32_t> next (m_slotStart.begin (), m_slotStart.end () - 1);
+  for (const auto & f : m_flows)
+    {
+      for (uint32_t s = f.m_slot; s < m_hyperperiod; s += f.m_period)
+        {
+          Occasion & o = m_occasions[next[s]++];
+          o.m_rnti = f.m_rnti;
+          o.m_size = f.m_size;
+        }
+    }
+}
+
+} // namespace ns3
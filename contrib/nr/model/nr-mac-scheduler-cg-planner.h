@@ -0,0 +1,229 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup scheduler
+ * \brief Collision-free layout of the configured-grant occasions
+ *
+ * Each configured-grant (CG) flow is described by its period, its nominal
+ * offset and its size, all in slots and bytes, and by the maximum delay (in
+ * slots) that its occasions can tolerate with respect to the nominal offset.
+ * The planner places every flow, once, at the shift (between 0 and the
+ * maximum delay) that keeps the peak load of the slots lowest, over the
+ * hyperperiod (the LCM of the periods). A flow is rejected when no shift
+ * keeps every slot within the capacity (bytes and number of occasions per
+ * slot; 0 means unlimited), or when the hyperperiod would become longer than
+ * MAX_HYPERPERIOD. When a UL slot mask is set (the TDD pattern), the
+ * occasions are placed only in the slots that can carry UL data, and the
+ * length of the mask is part of the hyperperiod.
+ *
+ * The result is stored as a compact table (slot -> occasions of that slot,
+ * in a single array indexed by an offset array), rebuilt when a flow joins or
+ * leaves, so that the per-slot scheduling is a lookup:
+ *
+ * \code{.cpp}
+ * for (const auto & occasion : planner.GetOccasions (sfn.Normalize ()))
+ *   {
+ *     // occasion.m_rnti, occasion.m_size
+ *   }
+ * \endcode
+ */
+class NrMacSchedulerCgPlanner
+{
+public:
+  /**
+   * \brief Maximum hyperperiod, in slots (a SFN cycle with numerology 2)
+   */
+  static const uint32_t MAX_HYPERPERIOD = 40960;
+
+  /**
+   * \brief A CG occasion: the UE that transmits, and the bytes reserved
+   */
+  struct Occasion
+  {
+    uint16_t m_rnti {0}; //!< RNTI of the UE
+    uint32_t m_size {0}; //!< Bytes reserved for the UE
+  };
+
+  /**
+   * \brief The occasions of a slot (usable in a range-based for)
+   */
+  struct OccasionRange
+  {
+    const Occasion *m_begin {nullptr}; //!< First occasion
+    const Occasion *m_end {nullptr};   //!< Past the last occasion
+
+    /**
+     * \return the first occasion
+     */
+    const Occasion * begin () const
+    {
+      return m_begin;
+    }
+    /**
+     * \return past the last occasion
+     */
+    const Occasion * end () const
+    {
+      return m_end;
+    }
+    /**
+     * \return the number of occasions
+     */
+    size_t size () const
+    {
+      return static_cast<size_t> (m_end - m_begin);
+    }
+  };
+
+  /**
+   * \brief NrMacSchedulerCgPlanner default constructor
+   */
+  NrMacSchedulerCgPlanner () = default;
+
+  /**
+   * \brief Set the bytes available for CG in each slot (0: unlimited)
+   * \param bytes the capacity
+   *
+   * It applies to the flows added after the call.
+   */
+  void SetSlotCapacity (uint32_t bytes);
+  /**
+   * \return the bytes available for CG in each slot (0: unlimited)
+   */
+  uint32_t GetSlotCapacity () const;
+  /**
+   * \brief Set the maximum number of occasions in each slot (0: unlimited)
+   * \param n the maximum
+   *
+   * It applies to the flows added after the call.
+   */
+  void SetMaxOccasionsPerSlot (uint32_t n);
+  /**
+   * \return the maximum number of occasions in each slot (0: unlimited)
+   */
+  uint32_t GetMaxOccasionsPerSlot () const;
+  /**
+   * \brief Set the slots that can carry UL data
+   * \param ulSlots one entry per slot of the TDD pattern, true if the slot can
+   * carry UL data (empty: every slot)
+   *
+   * It must be called before adding any flow.
+   */
+  void SetUlSlotMask (const std::vector<bool> &ulSlots);
+
+  /**
+   * \brief Add (or update) the CG flow of an UE
+   * \param rnti RNTI of the UE
+   * \param period period, in slots (greater than 0)
+   * \param offset nominal offset of the occasions, in slots (modulo period)
+   * \param size bytes of each occasion
+   * \param maxDelay maximum delay of the occasions with respect to the nominal offset, in slots
+   * \return true if the flow has been placed, false if it does not fit or
+   * no candidate slot can carry UL data (if the UE already had a flow, it is
+   * kept unchanged)
+   */
+  bool AddFlow (uint16_t rnti, uint32_t period, uint32_t offset, uint32_t size, uint32_t maxDelay);
+  /**
+   * \brief Remove the CG flow of an UE (if any)
+   * \param rnti RNTI of the UE
+   */
+  void RemoveFlow (uint16_t rnti);
+  /**
+   * \param rnti RNTI of the UE
+   * \return true if the UE has a CG flow in the layout
+   */
+  bool HasFlow (uint16_t rnti) const;
+  /**
+   * \return the number of CG flows in the layout
+   */
+  size_t GetNumFlows () const;
+  /**
+   * \return the current hyperperiod, in slots
+   */
+  uint32_t GetHyperperiod () const;
+
+  /**
+   * \brief Get the occasions of a slot
+   * \param slot absolute slot number (e.g., SfnSf::Normalize)
+   * \return the occasions of the slot
+   */
+  OccasionRange GetOccasions (uint64_t slot) const;
+
+private:
+  /**
+   * \brief A placed CG flow
+   */
+  struct Flow
+  {
+    uint16_t m_rnti {0};   //!< RNTI of the UE
+    uint32_t m_period {0}; //!< Period, in slots
+    uint32_t m_slot {0};   //!< Slot (modulo period) of the occasions, after the shift
+    uint32_t m_size {0};   //!< Bytes of each occasion
+  };
+
+  /**
+   * \brief Change the hyperperiod, tiling or truncating the per-slot load
+   * \param hyperperiod the new hyperperiod (multiple or divisor of the current one)
+   */
+  void Resize (uint32_t hyperperiod);
+  /**
+   * \brief Add (or subtract) the occasions of a flow to the per-slot load
+   * \param flow the flow
+   * \param sign +1 to add, -1 to subtract
+   */
+  void Account (const Flow &flow, int sign);
+  /**
+   * \brief Rebuild the slot -> occasions table
+   */
+  void RebuildTable ();
+  /**
+   * \return the hyperperiod without flows (the length of the UL slot mask, or 1)
+   */
+  uint32_t GetBaseHyperperiod () const;
+  /**
+   * \brief Place a flow, if possible
+   * \param rnti RNTI of the UE
+   * \param period period, in slots
+   * \param offset nominal offset
+   * \param size bytes of each occasion
+   * \param maxDelay maximum delay, in slots
+   * \return true if the flow has been placed
+   */
+  bool Place (uint16_t rnti, uint32_t period, uint32_t offset, uint32_t size, uint32_t maxDelay);
+
+  uint32_t m_slotCapacity {0};   //!< Bytes available for CG in each slot (0: unlimited)
+  uint32_t m_maxOccasions {0};   //!< Maximum occasions in each slot (0: unlimited)
+  uint32_t m_hyperperiod {1};    //!< LCM of the periods of the flows and of the length of the UL slot mask
+
+  std::vector<bool> m_ulSlots;        //!< Slots of the TDD pattern that can carry UL data (empty: every slot)
+
+  std::vector<Flow> m_flows;          //!< Placed flows
+  std::vector<uint32_t> m_load;       //!< Bytes reserved in each slot of the hyperperiod
+  std::vector<uint32_t> m_count;      //!< Occasions in each slot of the hyperperiod
+  std::vector<uint32_t> m_slotStart;  //!< Index in m_occasions of the first occasion of each slot (hyperperiod + 1 entries)
+  std::vector<Occasion> m_occasions;  //!< Occasions, grouped by slot
+};
+
+} // namespace ns3
@@ -29,6 +29,7 @@
 #include "nr-amc.h"
 
 #include <ns3/log.h>
+#include <algorithm>
 
 namespace ns3 {
 
@@ -58,47 +59,109 @@ NrMacSchedulerCQIManagement::UlSBCQIReported (uint32_t expirationTime, [[maybe_u
   ueInfo->m_ulCqi.m_sinr = params.m_ulCqi.m_sinr;
   ueInfo->m_ulCqi.m_cqiType = NrMacSchedulerUeInfo::CqiInfo::SB;
   ueInfo->m_ulCqi.m_timer = expirationTime;
+  ueInfo->m_ulCqi.m_expiry = m_ulExpirations.Schedule (ueInfo, expirationTime);
 
-  std::vector<int> rbAssignment (params.m_ulCqi.m_sinr.size (), 0);
+  // The SpectrumValue starts at 0.0: copy the SINR of the allocated RBGs,
+  // block by block
+  SpectrumValue specVals (model);
+  const uint32_t numRb = model->GetNumBands ();
+  const std::vector<double> &sinr = ueInfo->m_ulCqi.m_sinr;
+  NS_ASSERT (sinr.size () >= numRb);
+  double *values = &(*specVals.ValuesBegin ());
 
-  for (uint32_t i = 0; i < rbgMask.size (); ++i)
+  for (uint32_t rbg = 0; rbg < rbgMask.size (); ++rbg)
     {
-      if (rbgMask.at (i) == 1)
+      uint32_t first = rbg * numRbPerRbg;
+      if (rbgMask[rbg] == 1 && first < numRb)
         {
-          for (uint32_t k = 0; k < numRbPerRbg; ++k)
-            {
-              rbAssignment[i * numRbPerRbg + k] = 1;
-            }
+          uint32_t last = std::min (first + numRbPerRbg, numRb);
+          std::copy (sinr.begin () + first, sinr.begin () + last, values + first);
         }
     }
 
-  SpectrumValue specVals (model);
-  Values::iterator specIt = specVals.ValuesBegin ();
+  NS_LOG_INFO ("Values of SINR to pass to the AMC: " << specVals);
 
-  std::stringstream out;
+  UpdateUlSubbandCqi (specVals, rbgMask, numRbPerRbg, ueInfo);
 
-  for (uint32_t ichunk = 0; ichunk < model->GetNumBands (); ichunk++)
+  // MCS updated inside the function; crappy API... but we can't fix everything
+  ueInfo->m_ulCqi.m_cqi = GetAmcUl ()->CreateCqiFeedbackWbTdma (specVals, ueInfo->m_ulMcs);
+  NS_LOG_DEBUG ("Calculated MCS for RNTI " << ueInfo->m_rnti << " is " << ueInfo->m_ulMcs);
+}
+
+void
+NrMacSchedulerCQIManagement::UpdateUlSubbandCqi (const SpectrumValue &sinr,
+                                                 const std::vector<uint8_t> &rbgMask,
+                                                 uint32_t numRbPerRbg,
+                                                 const std::shared_ptr<NrMacSchedulerUeInfo> &ueInfo) const
+{
+  NS_LOG_FUNCTION (this);
+  auto & ulCqi = ueInfo->m_ulCqi;
+  uint16_t numSb = static_cast<uint16_t> (std::min<size_t> (rbgMask.size (), ulCqi.m_sbCqi.size ()));
+  NS_ASSERT_MSG (numSb == rbgMask.size (), "More RBG than sub-band CQI entries");
+
+  const uint32_t numRb = sinr.GetSpectrumModel ()->GetNumBands ();
+  const double *values = &(*sinr.ConstValuesBegin ());
+  Ptr<const NrAmc> amc = GetAmcUl ();
+  bool shannon = amc->GetAmcModel () == NrAmc::ShannonModel;
+
+  if (shannon)
+    {
+      m_sbSe.resize (numRb);
+      amc->GetSpectralEfficiencies (values, numRb, m_sbSe.data ());
+    }
+
+  SpectrumValue sbSinr (sinr.GetSpectrumModel ());
+  double *sbValues = &(*sbSinr.ValuesBegin ());
+  for (uint16_t rbg = 0; rbg < numSb; ++rbg)
     {
-      NS_ASSERT (specIt != specVals.ValuesEnd ());
-      if (rbAssignment[ichunk] == 1)
+      uint32_t first = rbg * numRbPerRbg;
+      if (rbgMask[rbg] != 1 || first >= numRb)
         {
-          *specIt = ueInfo->m_ulCqi.m_sinr.at (ichunk);
-          out << ueInfo->m_ulCqi.m_sinr.at (ichunk) << " ";
+          continue;
         }
-      else
+      uint32_t last = std::min (first + numRbPerRbg, numRb);
+      if (std::all_of (values + first, values + last, [] (double v) { return v == 0.0; }))
         {
-          out << "0.0 ";
-          *specIt = 0.0;
+          continue; // no signal measured in the RBG
         }
 
-      specIt++;
+      if (shannon)
+        {
+          // As the wideband value: average of the RBs with signal
+          double seSum = 0.0;
+          uint32_t rbNum = 0;
+          for (uint32_t rb = first; rb < last; ++rb)
+            {
+              if (values[rb] != 0.0)
+                {
+                  seSum += m_sbSe[rb];
+                  ++rbNum;
+                }
+            }
+          ulCqi.m_sbCqi[rbg] = amc->GetCqiFromSpectralEfficiency (seSum / rbNum);
+          ulCqi.m_sbMcs[rbg] = amc->GetMcsFromSpectralEfficiency (seSum / rbNum);
+        }
+      else
+        {
+          std::fill (sbValues, sbValues + numRb, 0.0);
+          std::copy (values + first, values + last, sbValues + first);
+          ulCqi.m_sbCqi[rbg] = amc->CreateCqiFeedbackWbTdma (sbSinr, ulCqi.m_sbMcs[rbg]);
+        }
+      ulCqi.m_sbReported[rbg] = true;
     }
+  ulCqi.m_numSb = numSb;
+}
 
-  NS_LOG_INFO ("Values of SINR to pass to the AMC: " << out.str ());
-
-  // MCS updated inside the function; crappy API... but we can't fix everything
-  ueInfo->m_ulCqi.m_cqi = GetAmcUl ()->CreateCqiFeedbackWbTdma (specVals, ueInfo->m_ulMcs);
-  NS_LOG_DEBUG ("Calculated MCS for RNTI " << ueInfo->m_rnti << " is " << ueInfo->m_ulMcs);
+uint64_t
+NrMacSchedulerCQIManagement::ExpirationWheel::Schedule (const std::shared_ptr<NrMacSchedulerUeInfo> &ue,
+                                                        uint32_t validity)
+{
+  uint64_t expiry = m_now + validity + 1;
+  Entry entry;
+  entry.m_ue = ue;
+  entry.m_expiry = expiry;
+  m_buckets[expiry & (SIZE - 1)].emplace_back (std::move (entry));
+  return expiry;
 }
 
 void
@@ -152,6 +215,7 @@ NrMacSchedulerCQIManagement::DlWBCQIReported (const DlCqiInfo &info,
 
   ueInfo->m_dlCqi.m_cqiType = NrMacSchedulerUeInfo::DlCqiInfo::WB;
   ueInfo->m_dlCqi.m_timer = expirationTime;
+  ueInfo->m_dlCqi.m_expiry = m_dlExpirations.Schedule (ueInfo, expirationTime);
   ueInfo->m_dlCqi.m_ri = info.m_ri;
   ueInfo->m_dlCqi.m_wbCqi.resize (info.m_wbCqi.size ());
   ueInfo->m_dlMcs.resize (info.m_wbCqi.size ());
@@ -202,50 +266,43 @@ NrMacSchedulerCQIManagement::DlWBCQIReported (const DlCqiInfo &info,
 }
 
 void
-NrMacSchedulerCQIManagement::RefreshDlCqiMaps (const std::unordered_map<uint16_t, std::shared_ptr<NrMacSchedulerUeInfo> > &ueMap) const
+NrMacSchedulerCQIManagement::RefreshDlCqiMaps () const
 {
   NS_LOG_FUNCTION (this);
 
-  for (const auto &itUe : ueMap)
+  m_dlExpirations.Advance ([this] (const std::shared_ptr<NrMacSchedulerUeInfo> &ue, uint64_t now)
     {
-      const std::shared_ptr<NrMacSchedulerUeInfo>&ue = itUe.second;
-
-      if (ue->m_dlCqi.m_timer == 0)
+      if (ue->m_dlCqi.m_expiry != now)
         {
-          ue->m_dlCqi.m_cqiType = NrMacSchedulerUeInfo::DlCqiInfo::WB;
-          for (uint8_t stream = 0; stream < ue->m_dlCqi.m_wbCqi.size (); stream++)
-            {
-              ue->m_dlCqi.m_wbCqi.at (stream) = 1; // lowest value for trying a transmission
-              ue->m_dlMcs.at (stream) = GetStartMcsDl ();
-            }
+          return; // a newer report arrived
         }
-      else
+      NS_LOG_INFO ("DL CQI of UE " << ue->m_rnti << " expired");
+      ue->m_dlCqi.m_cqiType = NrMacSchedulerUeInfo::DlCqiInfo::WB;
+      for (uint8_t stream = 0; stream < ue->m_dlCqi.m_wbCqi.size (); stream++)
         {
-          ue->m_dlCqi.m_timer -= 1;
+          ue->m_dlCqi.m_wbCqi.at (stream) = 1; // lowest value for trying a transmission
+          ue->m_dlMcs.at (stream) = GetStartMcsDl ();
         }
-    }
+    });
 }
 
 void
-NrMacSchedulerCQIManagement::RefreshUlCqiMaps (const std::unordered_map<uint16_t, std::shared_ptr<NrMacSchedulerUeInfo> > &ueMap) const
+NrMacSchedulerCQIManagement::RefreshUlCqiMaps () const
 {
   NS_LOG_FUNCTION (this);
 
-  for (const auto &itUe : ueMap)
+  m_ulExpirations.Advance ([this] (const std::shared_ptr<NrMacSchedulerUeInfo> &ue, uint64_t now)
     {
-      const std::shared_ptr<NrMacSchedulerUeInfo>&ue = itUe.second;
-
-      if (ue->m_ulCqi.m_timer == 0)
+      if (ue->m_ulCqi.m_expiry != now)
         {
-          ue->m_ulCqi.m_cqi = 1; // lowest value for trying a transmission
-          ue->m_ulCqi.m_cqiType = NrMacSchedulerUeInfo::CqiInfo::WB;
-          ue->m_ulMcs = GetStartMcsUl ();
+          return; // a newer report arrived
         }
-      else
-        {
-          ue->m_ulCqi.m_timer -= 1;
-        }
-    }
+      NS_LOG_INFO ("UL CQI of UE " << ue->m_rnti << " expired");
+      ue->m_ulCqi.m_cqi = 1; // lowest value for trying a transmission
+      ue->m_ulCqi.m_cqiType = NrMacSchedulerUeInfo::CqiInfo::WB;
+      ue->m_ulCqi.m_numSb = 0;
+      ue->m_ulMcs = GetStartMcsUl ();
+    });
 }
 
 uint16_t
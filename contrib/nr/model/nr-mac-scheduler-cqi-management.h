@@ -20,6 +20,7 @@
 
 #include "nr-phy-mac-common.h"
 #include "nr-mac-scheduler-ue-info.h"
+#include <array>
 #include <memory>
 
 namespace ns3 {
@@ -35,6 +36,11 @@ class NrAmc;
  * and it is a bit more complicated. For any detail, check the respective
  * documentation.
  *
+ * The expiration of the reported values does not scan all the UEs at every
+ * slot: each report is inserted in a timing wheel (one for DL, one for UL),
+ * in the bucket of the refresh at which it expires, and each refresh
+ * processes only its bucket.
+ *
  * \see UlSBCQIReported
  * \see DlWBCQIReported
  */
@@ -118,6 +124,11 @@ public:
    * and then passed as input to NrAmc::CreateCqiFeedbackWbTdma. From this
    * function, we have as a result an updated value of CQI, as well as an updated
    * version of MCS for the UL.
+   *
+   * The CQI and the MCS of each allocated RBG are stored as well, in the
+   * sub-band arrays of the UE; the RBGs not allocated keep their previous
+   * value. They are computed with the AMC model of the wideband MCS, so
+   * that the sub-band and the wideband MCS can be compared.
    */
   void UlSBCQIReported (uint32_t expirationTime, uint32_t tbs,
                         const NrMacSchedSapProvider::SchedUlCqiInfoReqParameters& params,
@@ -126,28 +137,108 @@ public:
                         const Ptr<const SpectrumModel> &model) const;
 
   /**
-   * \brief Refresh the DL CQI for all the UE
+   * \brief Refresh the DL CQI of the UEs
    *
    * This method should be called every slot.
-   * Decrement the validity counter DL CQI, and if a CQI expires, reset its
-   * value to the default (MCS 0)
-   *
-   * \param m_ueMap UE map
+   * Advance the DL timing wheel, and if a CQI expires, reset its
+   * value to the default (the starting MCS)
    */
-  void RefreshDlCqiMaps (const std::unordered_map<uint16_t, std::shared_ptr<NrMacSchedulerUeInfo> > &m_ueMap) const;
+  void RefreshDlCqiMaps () const;
 
   /**
-   * \brief Refresh the UL CQI for all the UE
+   * \brief Refresh the UL CQI of the UEs
    *
    * This method should be called every slot.
-   * Decrement the validity counter UL CQI, and if a CQI expires, reset its
-   * value to the default (MCS 0)
-   *
-   * \param m_ueMap UE map
+   * Advance the UL timing wheel, and if a CQI expires, reset its
+   * value to the default (the starting MCS)
    */
-  void RefreshUlCqiMaps (const std::unordered_map<uint16_t, std::shared_ptr<NrMacSchedulerUeInfo> > &m_ueMap) const;
+  void RefreshUlCqiMaps () const;
 
 private:
+  /**
+   * \brief Timing wheel of the CQI expirations
+   *
+   * Time is counted in refreshes. A value reported when the count is t, with
+   * a validity of T slots, expires at the refresh t + T + 1 (as the previous
+   * per-UE countdown did). The entries are not removed when a newer report
+   * arrives: at expiration, the UE is reset only if its current expiration is
+   * the one of the entry. Entries farther than the wheel size stay in their
+   * bucket for more rounds.
+   */
+  class ExpirationWheel
+  {
+  public:
+    /**
+     * \brief Number of buckets (a power of 2; CQI validity is usually shorter)
+     */
+    static const uint32_t SIZE = 1024;
+
+    /**
+     * \brief Insert an expiration
+     * \param ue the UE
+     * \param validity validity of the value, in slots
+     * \return the refresh count at which the value expires
+     */
+    uint64_t Schedule (const std::shared_ptr<NrMacSchedulerUeInfo> &ue, uint32_t validity);
+
+    /**
+     * \brief Advance by one refresh, calling expire for the UE expiring now
+     * \param expire function called with the UE and the current count; it
+     * has to check whether the expiration is still current
+     */
+    template <class F>
+    void Advance (F expire)
+    {
+      ++m_now;
+      std::vector<Entry> & bucket = m_buckets[m_now & (SIZE - 1)];
+      size_t i = 0;
+      while (i < bucket.size ())
+        {
+          if (bucket[i].m_expiry != m_now)
+            {
+              ++i;
+              continue;
+            }
+          std::shared_ptr<NrMacSchedulerUeInfo> ue = bucket[i].m_ue.lock ();
+          if (ue)
+            {
+              expire (ue, m_now);
+            }
+          bucket[i] = std::move (bucket.back ());
+          bucket.pop_back ();
+        }
+    }
+
+  private:
+    /**
+     * \brief An expiration
+     */
+    struct Entry
+    {
+      std::weak_ptr<NrMacSchedulerUeInfo> m_ue; //!< The UE (it may be removed in the meantime)
+      uint64_t m_expiry {0};                    //!< Refresh count of the expiration
+    };
+
+    std::array<std::vector<Entry>, SIZE> m_buckets; //!< Buckets, indexed by expiration modulo SIZE
+    uint64_t m_now {0};                             //!< Number of refreshes done
+  };
+
+  /**
+   * \brief Compute the CQI and the MCS of the allocated RBGs and store them as sub-band values
+   * \param sinr SINR of each RB (0 for the non-allocated ones)
+   * \param rbgMask RBG mask of the allocation
+   * \param numRbPerRbg number of RB per RBG
+   * \param ueInfo UE info
+   *
+   * With the Shannon model, the spectral efficiency of the RBs is computed in
+   * a batch and averaged per RBG, as NrAmc::CreateCqiFeedbackWbTdma averages
+   * it over the band. With the error model, NrAmc::CreateCqiFeedbackWbTdma
+   * is evaluated on the RBs of each RBG.
+   */
+  void UpdateUlSubbandCqi (const SpectrumValue &sinr,
+                           const std::vector<uint8_t> &rbgMask, uint32_t numRbPerRbg,
+                           const std::shared_ptr<NrMacSchedulerUeInfo> &ueInfo) const;
+
   /**
    * \brief Get the bwp id of this MAC
    * \return the bwp id
@@ -186,6 +277,10 @@ private:
   std::function<uint8_t ()> m_getStartMcsUl; //!< Function to retrieve the starting MCS for UL
   std::function<Ptr<const NrAmc> ()> m_getAmcDl; //!< Function to retrieve the AMC for DL
   std::function<Ptr<const NrAmc> ()> m_getAmcUl; //!< Function to retrieve the AMC for UL
+
+  mutable ExpirationWheel m_dlExpirations;  //!< Expirations of the DL CQI
+  mutable ExpirationWheel m_ulExpirations;  //!< Expirations of the UL CQI
+  mutable std::vector<double> m_sbSe;       //!< Scratch: spectral efficiency of each RB (Shannon model)
 };
 
 } // namespace ns3
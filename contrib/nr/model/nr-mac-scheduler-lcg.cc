@@ -34,6 +34,7 @@ NrMacSchedulerLC::NrMacSchedulerLC (const LogicalChannelConfigListElement_s &con
   m_delayBudget = MilliSeconds (bearer.GetPacketDelayBudgetMs ());
   m_isGbr = bearer.IsGbr ();
   m_PER = bearer.GetPacketErrorLossRate ();
+  m_priority = bearer.GetPriority ();
 }
 
 void
@@ -87,6 +88,14 @@ NrMacSchedulerLCG::AssignedData (uint8_t lcId, uint32_t size, std::string type)
           rlcOverhead = 2;
         }
 
+      // SHORT_BSR, which is 5 bytes.
+      // We have 3 bytes of overhead for each subPDU (3*LCG)
+      uint32_t overhead = rlcOverhead + 5 + 3;
+      // A grant that does not cover the overheads carries no data of the LC
+      uint32_t sent = size > overhead ? std::min (m_lcMap.at (lcId)->m_rlcTransmissionQueueSize,
+                                                  size - overhead)
+                                      : 0;
+
       if (m_totalSize < m_lcMap.at (lcId)->m_rlcTransmissionQueueSize)
         {
           NS_LOG_WARN ("Total Tx queue size lower than it should be at this point. Reseting it.");
@@ -94,29 +103,10 @@ NrMacSchedulerLCG::AssignedData (uint8_t lcId, uint32_t size, std::string type)
         }
       else
         {
-          if (m_lcMap.at (lcId)->m_rlcTransmissionQueueSize <= size)
-            {
-              m_totalSize -= m_lcMap.at (lcId)->m_rlcTransmissionQueueSize;
-            }
-          else
-            {
-              m_totalSize -= std::min (m_lcMap.at (lcId)->m_rlcTransmissionQueueSize, size - rlcOverhead - 5 - 3 );
-            }
-        }
-      //if (size - rlcOverhead >= m_lcMap.at (lcId)->m_rlcTransmissionQueueSize)
-      if (size - rlcOverhead - 3 - 5  >= m_lcMap.at (lcId)->m_rlcTransmissionQueueSize)
-        {
-          // we can transmit everything from the queue, reset it
-          m_lcMap.at (lcId)->m_rlcTransmissionQueueSize = 0;
-        }
-      else
-        {
-          // not enough to empty all queue, but send what you can, this is normal situation to happen
-          //m_lcMap.at (lcId)->m_rlcTransmissionQueueSize -= size - rlcOverhead;
-          // SHORT_BSR, which is 5 bytes.
-          // We have 3 bytes of overhead for each subPDU (3*LCG)
-          m_lcMap.at (lcId)->m_rlcTransmissionQueueSize -= size - rlcOverhead - 5 - 3 ;
+          m_totalSize -= sent;
         }
+      // if not enough to empty all queue, send what you can, this is normal situation to happen
+      m_lcMap.at (lcId)->m_rlcTransmissionQueueSize -= sent;
     }
   else
     {
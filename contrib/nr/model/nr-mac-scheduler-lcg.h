@@ -18,13 +18,203 @@
  */
 #pragma once
 
+#include <array>
 #include <memory>
 #include <ns3/ff-mac-common.h>
 #include <ns3/nstime.h>
+#include <ns3/abort.h>
 #include "nr-mac-sched-sap.h"
 
 namespace ns3 {
 
+/**
+ * \ingroup scheduler
+ * \brief Fixed-capacity map between a small ID (LC or LCG) and a value
+ *
+ * The values are stored inline, in an array indexed by the ID, and a bitmask
+ * tells which IDs are present. Lookups do not hash, iterations follow the
+ * ID order and do not allocate. The interface is the subset of the
+ * std::unordered_map one used by the scheduler; the elements are pairs
+ * (ID, value), so the iterators can be used in the same way.
+ */
+template <class T, uint8_t N>
+class NrMacSchedulerIdMap
+{
+  static_assert (N <= 64, "The occupancy mask has 64 bits");
+
+public:
+  typedef std::pair<uint8_t, T> value_type; //!< Element of the map
+
+  /**
+   * \brief Iterator over the present IDs
+   */
+  template <class V, class C>
+  class Iterator
+  {
+  public:
+    /**
+     * \brief Constructor
+     * \param c the container
+     * \param mask the IDs that remain to visit
+     */
+    Iterator (C *c, uint64_t mask) : m_c (c), m_mask (mask)
+    {
+    }
+    /**
+     * \return the current element
+     */
+    V & operator* () const
+    {
+      return m_c->m_slots[__builtin_ctzll (m_mask)];
+    }
+    /**
+     * \return a pointer to the current element
+     */
+    V * operator-> () const
+    {
+      return &(**this);
+    }
+    /**
+     * \brief Move to the next present ID
+     * \return the iterator
+     */
+    Iterator & operator++ ()
+    {
+      m_mask &= m_mask - 1;
+      return *this;
+    }
+    /**
+     * \param o other iterator
+     * \return true if the iterators point to the same element
+     */
+    bool operator== (const Iterator &o) const
+    {
+      return m_mask == o.m_mask;
+    }
+    /**
+     * \param o other iterator
+     * \return true if the iterators do not point to the same element
+     */
+    bool operator!= (const Iterator &o) const
+    {
+      return m_mask != o.m_mask;
+    }
+
+  private:
+    C *m_c;          //!< The container
+    uint64_t m_mask; //!< The IDs that remain to visit
+  };
+
+  typedef Iterator<value_type, NrMacSchedulerIdMap> iterator;                   //!< iterator
+  typedef Iterator<const value_type, const NrMacSchedulerIdMap> const_iterator; //!< const iterator
+
+  /**
+   * \brief Constructor
+   */
+  NrMacSchedulerIdMap ()
+  {
+    for (uint8_t i = 0; i < N; ++i)
+      {
+        m_slots[i].first = i;
+      }
+  }
+
+  /**
+   * \param id the ID
+   * \return true if the ID is present
+   */
+  bool Contains (uint8_t id) const
+  {
+    return id < N && (m_mask & (1ULL << id)) != 0;
+  }
+  /**
+   * \param id the ID
+   * \return an iterator to the element, or end () if the ID is not present
+   */
+  iterator find (uint8_t id)
+  {
+    return Contains (id) ? iterator (this, m_mask & ~((1ULL << id) - 1)) : end ();
+  }
+  /**
+   * \param id the ID
+   * \return an iterator to the element, or end () if the ID is not present
+   */
+  const_iterator find (uint8_t id) const
+  {
+    return Contains (id) ? const_iterator (this, m_mask & ~((1ULL << id) - 1)) : end ();
+  }
+  /**
+   * \param id the ID
+   * \return the value associated to the ID, that must be present
+   */
+  T & at (uint8_t id)
+  {
+    NS_ABORT_MSG_UNLESS (Contains (id), "ID " << +id << " not present");
+    return m_slots[id].second;
+  }
+  /**
+   * \param id the ID
+   * \return the value associated to the ID, that must be present
+   */
+  const T & at (uint8_t id) const
+  {
+    NS_ABORT_MSG_UNLESS (Contains (id), "ID " << +id << " not present");
+    return m_slots[id].second;
+  }
+  /**
+   * \brief Insert an element, if its ID is not present
+   * \param element the pair (ID, value)
+   * \return the iterator to the element with such ID, and true if the insertion took place
+   */
+  std::pair<iterator, bool> emplace (value_type && element)
+  {
+    uint8_t id = element.first;
+    NS_ABORT_MSG_IF (id >= N, "ID " << +id << " exceeds the capacity " << +N);
+    if (Contains (id))
+      {
+        return std::make_pair (find (id), false);
+      }
+    m_slots[id].second = std::move (element.second);
+    m_mask |= (1ULL << id);
+    return std::make_pair (find (id), true);
+  }
+  /**
+   * \return the number of present IDs
+   */
+  size_t size () const
+  {
+    return static_cast<size_t> (__builtin_popcountll (m_mask));
+  }
+  /**
+   * \return the bitmask of the present IDs (bit i set if the ID i is present)
+   */
+  uint64_t GetMask () const
+  {
+    return m_mask;
+  }
+
+  iterator begin ()
+  {
+    return iterator (this, m_mask);
+  }
+  iterator end ()
+  {
+    return iterator (this, 0);
+  }
+  const_iterator begin () const
+  {
+    return const_iterator (this, m_mask);
+  }
+  const_iterator end () const
+  {
+    return const_iterator (this, 0);
+  }
+
+private:
+  std::array<value_type, N> m_slots; //!< Elements, indexed by ID
+  uint64_t m_mask {0};               //!< Bit i is set if the ID i is present
+};
+
 /**
  * \ingroup scheduler
  * \brief Represent a DL Logical Channel of an UE
@@ -119,6 +309,7 @@ public:
   Time m_delayBudget    {Time::Min ()}; //!< Delay budget of the flow
   double m_PER          {0.0};         //!< PER of the flow
   bool m_isGbr          {false};       //!< Is GBR?
+  uint8_t m_priority    {0};           //!< QoS priority level of the flow (lower is more important)
 };
 
 /**
@@ -132,8 +323,8 @@ typedef std::unique_ptr<NrMacSchedulerLC> LCPtr;
  * \brief Represent an UE LCG (can be DL or UL)
  *
  * A Logical Channel Group has an id (represented by m_id) and can contain
- * logical channels. The LC are stored inside an unordered map, indexed
- * by their ID.
+ * logical channels. The LC are stored inside a NrMacSchedulerIdMap, indexed
+ * by their ID (at most MAX_LCID).
  *
  * The LCs are inserted through the method Insert, and they can be updated with
  * a call to UpdateInfo. The update is different in DL and UL: in UL only the
@@ -155,6 +346,11 @@ typedef std::unique_ptr<NrMacSchedulerLC> LCPtr;
 class NrMacSchedulerLCG
 {
 public:
+  /**
+   * \brief Maximum LC ID (NR data LCIDs go from 1 to 32)
+   */
+  static const uint8_t MAX_LCID = 32;
+
   /**
    * \brief NrMacSchedulerLCG constructor
    * \param id The id of the LCG
@@ -177,7 +373,7 @@ public:
   bool
   Contains (uint8_t lcId) const
   {
-    return m_lcMap.find (lcId) != m_lcMap.end ();
+    return m_lcMap.Contains (lcId);
   }
 
   /**
@@ -199,7 +395,7 @@ public:
   Insert (LCPtr && lc)
   {
     NS_ASSERT (!Contains (lc->m_id));
-    return m_lcMap.emplace (std::make_pair (lc->m_id, std::move (lc))).second;
+    return m_lcMap.emplace (std::make_pair (static_cast<uint8_t> (lc->m_id), std::move (lc))).second;
   }
 
   /**
@@ -295,6 +491,9 @@ public:
   /**
    * \brief Get a vector of LC ID
    * \return a vector with all the LC id present in this LCG
+   *
+   * In the scheduling loops, prefer GetLCIdMask or GetActiveLCIdMask, which
+   * do not allocate.
    */
   std::vector<uint8_t>
   GetLCId () const
@@ -307,6 +506,48 @@ public:
     return ret;
   }
 
+  /**
+   * \brief Get a LC of this LCG
+   * \param lcId LC ID, that must be present
+   * \return the LC
+   */
+  const NrMacSchedulerLC &
+  GetLC (uint8_t lcId) const
+  {
+    return *m_lcMap.at (lcId);
+  }
+
+  /**
+   * \brief Get the LC IDs present in this LCG
+   * \return a bitmask, with the bit i set if the LC i is in this LCG
+   */
+  uint64_t
+  GetLCIdMask () const
+  {
+    return m_lcMap.GetMask ();
+  }
+
+  /**
+   * \brief Get the LC IDs that have data to transmit
+   * \return a bitmask, with the bit i set if the LC i has a total size greater than 0
+   *
+   * To visit the IDs: for (uint64_t m = mask; m != 0; m &= m - 1), the ID
+   * being __builtin_ctzll (m).
+   */
+  uint64_t
+  GetActiveLCIdMask () const
+  {
+    uint64_t mask = 0;
+    for (const auto & lc : m_lcMap)
+      {
+        if (lc.second->GetTotalSize () > 0)
+          {
+            mask |= (1ULL << lc.first);
+          }
+      }
+    return mask;
+  }
+
   /**
    * \brief Inform the LCG of the assigned data to a LC id
    * \param lcId the LC id to which the data was assigned
@@ -318,7 +559,7 @@ public:
 private:
   uint32_t m_totalSize {0};                  //!< Total size
   uint8_t m_id {0};                          //!< ID of the LCG
-  std::unordered_map<uint8_t, LCPtr> m_lcMap; //!< Map between LC id and their pointer
+  NrMacSchedulerIdMap<LCPtr, MAX_LCID + 1> m_lcMap; //!< Map between LC id and their pointer
 };
 
 /**
@@ -327,4 +568,10 @@ private:
  */
 typedef std::unique_ptr<NrMacSchedulerLCG> LCGPtr;
 
+/**
+ * \brief Map between the LCG id (at most 8 LCG, as in NR) and the LCG of an UE
+ * \ingroup scheduler
+ */
+typedef NrMacSchedulerIdMap<LCGPtr, 8> LCGMap;
+
 } // namespace ns3
@@ -26,12 +26,15 @@
   while (false);
 
 #include "nr-mac-scheduler-ns3.h"
+#include "nr-profiler.h"
 #include "nr-mac-scheduler-harq-rr.h"
 #include "nr-mac-short-bsr-ce.h"
+#include "nr-mac-long-bsr-ce.h"
 #include "nr-mac-scheduler-srs-default.h"
 
 #include <ns3/boolean.h>
 #include <ns3/uinteger.h>
+#include <ns3/double.h>
 #include <ns3/log.h>
 #include <ns3/eps-bearer.h>
 #include <ns3/pointer.h>
@@ -40,6 +43,7 @@
 #include <unordered_set>
 
 #include <queue>
+#include <limits>
 
 namespace ns3 {
 
@@ -73,6 +77,10 @@ NrMacSchedulerNs3::NrMacSchedulerNs3 () : NrMacScheduler ()
 NrMacSchedulerNs3::~NrMacSchedulerNs3 ()
 {
   m_ueMap.clear ();
+  m_ueVector.clear ();
+  m_rntiToUeIndex.clear ();
+  m_dlActive = ActiveSet ();
+  m_ulActive = ActiveSet ();
 }
 
 void
@@ -217,6 +225,70 @@ NrMacSchedulerNs3::GetTypeId (void)
                    MakeBooleanAccessor (&NrMacSchedulerNs3::SetCG,
                                         &NrMacSchedulerNs3::GetCG),
                    MakeBooleanChecker ())
+    .AddAttribute ("PreemptOldestHarq",
+                   "When all the HARQ processes of a UE are active, drop the oldest one "
+                   "waiting for feedback instead of aborting the simulation",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NrMacSchedulerNs3::m_preemptOldestHarq),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CgPlanner",
+                   "Plan the configured-grant occasions over the hyperperiod of the CG "
+                   "periods when a UE sends its first CGR, rejecting the UEs that do not "
+                   "fit, and schedule them with a per-slot table lookup",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NrMacSchedulerNs3::m_cgPlannerEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CgPlannerSlotCapacity",
+                   "Bytes available for configured-grant occasions in each slot (0: unlimited)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&NrMacSchedulerNs3::SetCgPlannerSlotCapacity,
+                                         &NrMacSchedulerNs3::GetCgPlannerSlotCapacity),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("CgPlannerMaxUesPerSlot",
+                   "Maximum number of configured-grant occasions in each slot (0: unlimited)",
+                   UintegerValue (0),
+                   MakeUintegerAccessor (&NrMacSchedulerNs3::SetCgPlannerMaxUesPerSlot,
+                                         &NrMacSchedulerNs3::GetCgPlannerMaxUesPerSlot),
+                   MakeUintegerChecker<uint32_t> ())
+    .AddAttribute ("CgAdmissionControl",
+                   "Admit the configured-grant flows only if their periodic demand fits "
+                   "in the UL resources of the BWP (see CgAdmissionMaxUtilization)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NrMacSchedulerNs3::m_cgAdmissionEnabled),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CgAdmissionMaxUtilization",
+                   "Fraction of the UL resources (RBG x UL symbols of the TDD pattern) "
+                   "that the configured-grant flows can reserve, in (0, 1]",
+                   DoubleValue (1.0),
+                   MakeDoubleAccessor (&NrMacSchedulerNs3::SetCgAdmissionMaxUtilization,
+                                       &NrMacSchedulerNs3::GetCgAdmissionMaxUtilization),
+                   MakeDoubleChecker<double> (std::numeric_limits<double>::min (), 1.0))
+    .AddAttribute ("CgAdmissionMinDowngrade",
+                   "Minimum fraction of the requested bytes that a configured-grant flow "
+                   "that does not fit can be admitted with; below it, the flow is rejected "
+                   "(1.0 disables the downgrade)",
+                   DoubleValue (0.5),
+                   MakeDoubleAccessor (&NrMacSchedulerNs3::m_cgMinDowngrade),
+                   MakeDoubleChecker<double> (0.0, 1.0))
+    .AddAttribute ("CgLongBsrLevels",
+                   "Round the configured-grant allocations up to a long BSR level "
+                   "(256 levels) instead of a short BSR one (32 levels). Use it "
+                   "together with the NrUeMac LongBsr attribute",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NrMacSchedulerNs3::m_cgLongBsrLevels),
+                   MakeBooleanChecker ())
+    .AddTraceSource ("CgAdmission",
+                     "Decision of the admission control on a new configured-grant flow",
+                     MakeTraceSourceAccessor (&NrMacSchedulerNs3::m_cgAdmissionTrace),
+                     "ns3::NrMacSchedulerNs3::CgAdmissionTracedCallback")
+    .AddAttribute ("QosLcAssignment",
+                   "Distribute the bytes of a TB between the LCs of the UE by QoS "
+                   "(configured-grant LC and GBR LCs first, by priority, and then the "
+                   "other LCs in proportion to their buffer) instead of evenly",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NrMacSchedulerNs3::SetQosLcAssignment,
+                                        &NrMacSchedulerNs3::IsQosLcAssignment),
+                   MakeBooleanChecker ())
   ;
 
   return tid;
@@ -526,13 +598,28 @@ NrMacSchedulerNs3::DoCschedUeConfigReq (const NrMacCschedSapProvider::CschedUeCo
   if (itUe == m_ueMap.end ())
     {
       itUe = m_ueMap.insert (std::make_pair (params.m_rnti, CreateUeRepresentation (params))).first;
+      RegisterUe (UeInfoOf (*itUe));
 
       UeInfoOf (*itUe)->m_dlHarq.SetMaxSize (static_cast<uint8_t> (m_macSchedSapUser->GetNumHarqProcess ()));
       UeInfoOf (*itUe)->m_ulHarq.SetMaxSize (static_cast<uint8_t> (m_macSchedSapUser->GetNumHarqProcess ()));
+      if (m_preemptOldestHarq)
+        {
+          UeInfoOf (*itUe)->m_dlHarq.SetOverflowPolicy (NrMacHarqVector::PREEMPT_OLDEST);
+          UeInfoOf (*itUe)->m_ulHarq.SetOverflowPolicy (NrMacHarqVector::PREEMPT_OLDEST);
+          UeInfoOf (*itUe)->m_dlHarq.SetPreemptionCallback (std::bind (&NrMacSchedulerNs3::NotifyHarqPreemption,
+                                                                       this, params.m_rnti, true,
+                                                                       std::placeholders::_1,
+                                                                       std::placeholders::_2));
+          UeInfoOf (*itUe)->m_ulHarq.SetPreemptionCallback (std::bind (&NrMacSchedulerNs3::NotifyHarqPreemption,
+                                                                       this, params.m_rnti, false,
+                                                                       std::placeholders::_1,
+                                                                       std::placeholders::_2));
+        }
       UeInfoOf (*itUe)->m_dlMcs.push_back (m_startMcsDl);
       UeInfoOf (*itUe)->m_startMcsDlUe = m_startMcsDl;
       UeInfoOf (*itUe)->m_dlCqi.m_ri = 1;
       UeInfoOf (*itUe)->m_ulMcs = m_startMcsUl;
+      UeInfoOf (*itUe)->m_ulCqi.m_cqi = 1; // no report yet: lowest value for trying a transmission
 
       NrMacSchedulerSrs::SrsPeriodicityAndOffset srs = m_schedulerSrs->AddUe ();
 
@@ -574,6 +661,10 @@ NrMacSchedulerNs3::DoCschedUeReleaseReq (const NrMacCschedSapProvider::CschedUeR
   NS_ABORT_IF (itUe == m_ueMap.end ());
 
   m_schedulerSrs->RemoveUe (itUe->second->m_srsOffset);
+  m_cgPlanner.RemoveFlow (params.m_rnti);
+  m_cgAdmission.RemoveFlow (params.m_rnti);
+  m_cgGranted.erase (params.m_rnti);
+  UnregisterUe (params.m_rnti);
   m_ueMap.erase (itUe);
 
   // When it will be the case of reducing the periodicity? Question for the
@@ -725,17 +816,16 @@ NrMacSchedulerNs3::DoSchedDlRlcBufferReq (const NrMacSchedSapProvider::SchedDlRl
   NS_LOG_FUNCTION (this << params.m_rnti <<
                    static_cast<uint32_t> (params.m_logicalChannelIdentity));
 
-  GetSecond UeInfoOf;
-  auto itUe = m_ueMap.find (params.m_rnti);
-  NS_ABORT_IF (itUe == m_ueMap.end ());
+  const auto & ue = GetUe (params.m_rnti);
 
-  for (const auto &lcg : UeInfoOf (*itUe)->m_dlLCG)
+  for (const auto &lcg : ue->m_dlLCG)
     {
       if (lcg.second->Contains (params.m_logicalChannelIdentity))
         {
           NS_LOG_INFO ("Updating DL LC Info: " << params <<
                        " in LCG: " << static_cast<uint32_t> (lcg.first));
           lcg.second->UpdateInfo (params);
+          UpdateDlActiveSet (ue);
           return;
         }
     }
@@ -748,7 +838,7 @@ NrMacSchedulerNs3::DoSchedDlRlcBufferReq (const NrMacSchedSapProvider::SchedDlRl
  * \param bsr BSR received
  *
  * The UE notifies the buffer size as a sum of all the components. The BSR
- * is a vector of 4 uint8_t that represents the amount of data in each
+ * is a vector of 4 (short BSR) or 8 (long BSR) uint8_t that represents the amount of data in each
  * LCG. A call to NrMacSchedulerLCG::UpdateInfo is then issued with
  * the amount of data as parameter.
  */
@@ -757,37 +847,43 @@ NrMacSchedulerNs3::BSRReceivedFromUe (const MacCeElement &bsr)
 {
   NS_LOG_FUNCTION (this);
   NS_ASSERT (bsr.m_macCeType == MacCeElement::BSR);
-  GetSecond UeInfoOf;
-  auto itUe = m_ueMap.find (bsr.m_rnti);
-  NS_ABORT_IF (itUe == m_ueMap.end ());
+  const auto & ue = GetUe (bsr.m_rnti);
 
   // The UE only notifies the buf size as sum of all components.
   // see nr-ue-mac.cc:395
-  for (uint8_t lcg = 0; lcg < 4; ++lcg)
+  // A long BSR reports 8 LCGs, with 8-bit levels; a short one 4 LCGs, with 5-bit levels.
+  const auto & bufferStatus = bsr.m_macCeValue.m_bufferStatus;
+  const bool longBsr = bufferStatus.size () == NrMacLongBsrCe::NUM_LCG;
+  NS_ASSERT (longBsr || bufferStatus.size () == 4);
+  const uint32_t bsrSize = longBsr ? NrMacLongBsrCe ().GetSerializedSize ()
+                                   : NrMacShortBsrCe ().GetSerializedSize ();
+
+  for (uint8_t lcg = 0; lcg < bufferStatus.size (); ++lcg)
     {
-      uint8_t bsrId = bsr.m_macCeValue.m_bufferStatus.at (lcg);
-      uint32_t bufSize = NrMacShortBsrCe::FromLevelToBytes (bsrId);
+      uint8_t bsrId = bufferStatus.at (lcg);
+      uint32_t bufSize = FromBsrLevelToBytes (bsrId, longBsr);
 
-      auto itLcg = UeInfoOf (*itUe)->m_ulLCG.find (lcg);
-      if (itLcg == UeInfoOf (*itUe)->m_ulLCG.end ())
+      auto itLcg = ue->m_ulLCG.find (lcg);
+      if (itLcg == ue->m_ulLCG.end ())
         {
           NS_ABORT_MSG_IF (bufSize > 0, "LCG " << static_cast<uint32_t> (lcg) <<
-                           " not found for UE " << itUe->second->m_rnti);
+                           " not found for UE " << ue->m_rnti);
           continue;
         }
 
       if (itLcg->second->GetTotalSize () > 0 || bufSize > 0)
         {
-          // SHORT_BSR, which is 5 bytes.
+          // BSR, which is 5 bytes (SHORT_BSR) or 9 bytes (LONG_BSR).
           // We have 3 bytes of overhead for each subPDU (3*LCG)
           // RLC overhad = 2 bytes
-          bufSize = 5+3+2+bufSize;
+          bufSize = bsrSize+3+2+bufSize;
           NS_LOG_INFO ("Updating UL LCG " << static_cast<uint32_t> (lcg) <<
                        " for UE " << bsr.m_rnti << " size " << bufSize);
         }
 
       itLcg->second->UpdateInfo (bufSize);
     }
+  UpdateUlActiveSet (ue);
 }
 
 /**
@@ -842,8 +938,7 @@ NrMacSchedulerNs3::DoSchedDlCqiInfoReq (const NrMacSchedSapProvider::SchedDlCqiI
 
   for (const auto &cqi : params.m_cqiList)
     {
-      NS_ASSERT (m_ueMap.find (cqi.m_rnti) != m_ueMap.end ());
-      const std::shared_ptr<NrMacSchedulerUeInfo> & ue = m_ueMap.find (cqi.m_rnti)->second;
+      const std::shared_ptr<NrMacSchedulerUeInfo> & ue = GetUe (cqi.m_rnti);
 
       if (cqi.m_cqiType == DlCqiInfo::WB)
         {
@@ -907,13 +1002,12 @@ NrMacSchedulerNs3::DoSchedUlCqiInfoReq (const NrMacSchedSapProvider::SchedUlCqiI
             const AllocElem & allocation = *(it);
             if (allocation.m_symStart == symStart)
               {
-                auto itUe = m_ueMap.find (allocation.m_rnti);
-                NS_ASSERT (itUe != m_ueMap.end ());
+                const auto & ue = GetUe (allocation.m_rnti);
                 NS_ASSERT (allocation.m_numSym > 0);
                 NS_ASSERT (allocation.m_tbs > 0);
 
                 m_cqiManagement.UlSBCQIReported (expirationTime, allocation.m_tbs,
-                                                 params, UeInfoOf (*itUe),
+                                                 params, ue,
                                                  allocation.m_rbgMask,
                                                  m_macSchedSapUser->GetNumRbPerRbg (),
                                                  m_macSchedSapUser->GetSpectrumModel ());
@@ -1007,7 +1101,7 @@ NrMacSchedulerNs3::ProcessHARQFeedbacks (std::vector<T> *harqInfo,
     {
       uint8_t harqId = harqFeedbackIt->m_harqProcessId;
       uint16_t rnti = harqFeedbackIt->m_rnti;
-      NrMacHarqVector & ueHarqVector = GetHarqVectorFn (m_ueMap.find (rnti)->second);
+      NrMacHarqVector & ueHarqVector = GetHarqVectorFn (GetUe (rnti));
       HarqProcess & ueProcess = ueHarqVector.Get (harqId);
 
       NS_LOG_INFO ("Evaluating feedback: " << *harqFeedbackIt);
@@ -1047,6 +1141,55 @@ NrMacSchedulerNs3::ProcessHARQFeedbacks (std::vector<T> *harqInfo,
   NS_ASSERT (harqInfo->size () == nackReceived);
 }
 
+/**
+ * \brief Remove the feedbacks of the TBs dropped by a HARQ preemption
+ * \param harqInfo all the known HARQ feedbacks (can be UL or DL)
+ * \param firstReceived index of the first feedback received in this slot;
+ * the ones before it have already been checked
+ * \param GetHarqVectorFn Function to retrieve the correct Harq Vector
+ * \param direction "UL" or "DL" for debug messages
+ *
+ * When a process is preempted (PreemptOldestHarq), its ID is given to a new
+ * TB while the feedback of the dropped TB is still on its way: that
+ * feedback must not ACK or NACK the new TB.
+ *
+ * \see NrMacHarqVector::ConsumeStaleFeedback
+ */
+template<typename T>
+void
+NrMacSchedulerNs3::RemoveStaleHARQFeedbacks (std::vector<T> *harqInfo, uint64_t firstReceived,
+                                             const NrMacSchedulerUeInfo::GetHarqVectorFn &GetHarqVectorFn,
+                                             const std::string &direction) const
+{
+  NS_LOG_FUNCTION (this);
+  for (auto it = harqInfo->begin () + firstReceived; it != harqInfo->end (); /* no inc */)
+    {
+      NrMacHarqVector & ueHarqVector = GetHarqVectorFn (GetUe (it->m_rnti));
+      if (ueHarqVector.ConsumeStaleFeedback (it->m_harqProcessId))
+        {
+          NS_LOG_INFO ("Feedback for UE " << it->m_rnti << " process " <<
+                       static_cast<uint32_t> (it->m_harqProcessId) <<
+                       " direction " << direction <<
+                       " ignored because its TB has been preempted");
+          it = harqInfo->erase (it);
+        }
+      else
+        {
+          ++it;
+        }
+    }
+}
+
+void
+NrMacSchedulerNs3::NotifyHarqPreemption (uint16_t rnti, bool isDl, uint8_t id,
+                                         [[maybe_unused]] const HarqProcess &process)
+{
+  NS_LOG_FUNCTION (this << rnti << isDl << +id);
+  NS_LOG_INFO ("Preempted " << (isDl ? "DL" : "UL") << " HARQ process " << +id <<
+               " of UE " << rnti << ": " << process);
+  m_macSchedSapUser->NotifyHarqPreemption (rnti, id, isDl);
+}
+
 /**
  * \brief Reset expired HARQ
  * \param rnti RNTI of the user
@@ -1083,12 +1226,115 @@ NrMacSchedulerNs3::ResetExpiredHARQ (uint16_t rnti, NrMacHarqVector *harq)
       else
         {
           harq->Erase (processId);
+          harq->ClearStaleFeedback (processId);
           NS_LOG_INFO ("Erased process for UE " << rnti << " number " <<
                        static_cast<uint32_t> (processId) << " for time limits");
         }
     }
 }
 
+void
+NrMacSchedulerNs3::RegisterUe (const UePtr &ue)
+{
+  NS_LOG_FUNCTION (this << ue->m_rnti);
+  if (ue->m_rnti >= m_rntiToUeIndex.size ())
+    {
+      m_rntiToUeIndex.resize (ue->m_rnti + 1, UINT32_MAX);
+    }
+  NS_ASSERT (m_rntiToUeIndex[ue->m_rnti] == UINT32_MAX);
+
+  m_rntiToUeIndex[ue->m_rnti] = static_cast<uint32_t> (m_ueVector.size ());
+  m_ueVector.push_back (ue);
+
+  for (auto set : {&m_dlActive, &m_ulActive})
+    {
+      set->m_pos.push_back (UINT32_MAX);
+      set->m_buffer.push_back (0);
+    }
+}
+
+void
+NrMacSchedulerNs3::UnregisterUe (uint16_t rnti)
+{
+  NS_LOG_FUNCTION (this << rnti);
+  uint32_t index = GetUeIndex (rnti);
+  NS_ABORT_MSG_IF (index == UINT32_MAX, "UE " << rnti << " is not registered");
+  uint32_t last = static_cast<uint32_t> (m_ueVector.size () - 1);
+
+  for (auto set : {&m_dlActive, &m_ulActive})
+    {
+      RemoveFromActiveSet (set, index);
+      if (index != last)
+        {
+          set->m_buffer[index] = set->m_buffer[last];
+          set->m_pos[index] = set->m_pos[last];
+          if (set->m_pos[index] != UINT32_MAX)
+            {
+              set->m_ues[set->m_pos[index]] = index;
+            }
+        }
+      set->m_pos.pop_back ();
+      set->m_buffer.pop_back ();
+    }
+
+  // move the last UE in the hole left by the removed one
+  if (index != last)
+    {
+      m_ueVector[index] = m_ueVector.back ();
+      m_rntiToUeIndex[m_ueVector[index]->m_rnti] = index;
+    }
+  m_ueVector.pop_back ();
+  m_rntiToUeIndex[rnti] = UINT32_MAX;
+}
+
+void
+NrMacSchedulerNs3::UpdateActiveSet (ActiveSet *set, const UePtr &ue,
+                                    const NrMacSchedulerUeInfo::GetLCGFn &GetLCGFn) const
+{
+  NS_LOG_FUNCTION (this << ue->m_rnti);
+  uint32_t index = GetUeIndex (ue->m_rnti);
+  NS_ASSERT (index != UINT32_MAX);
+
+  uint32_t totBuffer = 0;
+  for (const auto & lcgInfo : GetLCGFn (ue))
+    {
+      totBuffer += lcgInfo.second->GetTotalSize ();
+    }
+  set->m_buffer[index] = totBuffer;
+
+  if (totBuffer > 0 && set->m_pos[index] == UINT32_MAX)
+    {
+      set->m_pos[index] = static_cast<uint32_t> (set->m_ues.size ());
+      set->m_ues.push_back (index);
+    }
+  else if (totBuffer == 0)
+    {
+      RemoveFromActiveSet (set, index);
+    }
+}
+
+void
+NrMacSchedulerNs3::RemoveFromActiveSet (ActiveSet *set, uint32_t ueIndex)
+{
+  uint32_t pos = set->m_pos[ueIndex];
+  if (pos == UINT32_MAX)
+    {
+      return;
+    }
+  set->m_ues[pos] = set->m_ues.back ();
+  set->m_pos[set->m_ues[pos]] = pos;
+  set->m_ues.pop_back ();
+  set->m_pos[ueIndex] = UINT32_MAX;
+}
+
+const UePtr &
+NrMacSchedulerNs3::GetUe (uint16_t rnti) const
+{
+  uint32_t index = GetUeIndex (rnti);
+  NS_ABORT_MSG_IF (index == UINT32_MAX, "UE " << rnti << " is not registered");
+  return m_ueVector[index];
+}
+
 /**
  * \brief Prepend a CTRL symbol to the allocation list
  * \param symStart starting symbol
@@ -1177,7 +1423,7 @@ NrMacSchedulerNs3::ComputeActiveHarq (ActiveHarqMap *activeDlHarq,
   for (const auto &feedback : dlHarqFeedback)
     {
       uint16_t rnti = feedback.m_rnti;
-      auto &schedInfo = m_ueMap.find (rnti)->second;
+      const auto &schedInfo = GetUe (rnti);
       auto beamIterator = activeDlHarq->find (schedInfo->m_beamConfId);
 
       if (beamIterator == activeDlHarq->end ())
@@ -1221,7 +1467,7 @@ NrMacSchedulerNs3::ComputeActiveHarq (ActiveHarqMap *activeUlHarq,
   for (const auto &feedback : ulHarqFeedback)
     {
       uint16_t rnti = feedback.m_rnti;
-      auto &schedInfo = m_ueMap.find (rnti)->second;
+      const auto &schedInfo = GetUe (rnti);
       auto beamIterator = activeUlHarq->find (schedInfo->m_beamConfId);
 
       if (beamIterator == activeUlHarq->end ())
@@ -1243,28 +1489,29 @@ NrMacSchedulerNs3::ComputeActiveHarq (ActiveHarqMap *activeUlHarq,
 /**
  * \brief Compute the number of active DL and UL UE
  * \param activeDlUe map of active DL UE to be filled
+ * \param activeSet the UEs that have data buffered in the direction
  * \param GetLCGFn Function to retrieve the LCG of a UE
  * \param mode UL or DL (to be printed in debug messages)
  *
- * The function loops all available UEs and checks their LC. If one (or more)
- * LC contains bytes, they are marked active and inserted in one of the
- * list passed as input parameters. Every UE is marked as active if it has
- * data to transmit; it is a duty for someone else to not assign two DCI for
- * the same RNTI.
+ * The function loops the UEs that have data buffered (which are tracked
+ * each time a buffer changes, see UpdateActiveSet) and, if they have a free
+ * HARQ process, it inserts them, grouped by beam, in the list passed as input
+ * parameter. Every UE is marked as active if it has data to transmit; it is a
+ * duty for someone else to not assign two DCI for the same RNTI.
  */
 void
 NrMacSchedulerNs3::ComputeActiveUe (ActiveUeMap *activeUe,
+                                        const ActiveSet &activeSet,
                                         const NrMacSchedulerUeInfo::GetLCGFn &GetLCGFn,
                                         const NrMacSchedulerUeInfo::GetHarqVectorFn &GetHarqVector,
                                         const std::string &mode) const
 {
   NS_LOG_FUNCTION (this);
-  for (const auto &ueInfo : m_ueMap)
+  for (const auto &ueIndex : activeSet.m_ues)
     {
-      uint32_t totBuffer = 0;
-      const auto & ue = ueInfo.second;
+      const auto & ue = m_ueVector[ueIndex];
+      uint32_t totBuffer = activeSet.m_buffer[ueIndex];
 
-      // compute total DL and UL bytes buffered
       for (const auto & lcgInfo : GetLCGFn (ue))
         {
           const auto & lcg = lcgInfo.second;
@@ -1274,10 +1521,9 @@ NrMacSchedulerNs3::ComputeActiveUe (ActiveUeMap *activeUe,
                            static_cast<uint32_t> (lcgInfo.first) <<
                            " bytes " << lcg->GetTotalSize ());
             }
-          totBuffer += lcg->GetTotalSize ();
         }
 
-      auto harqV = GetHarqVector (ue);
+      const auto & harqV = GetHarqVector (ue);
 
       if (totBuffer > 0 && harqV.CanInsert ())
         {
@@ -1296,30 +1542,55 @@ NrMacSchedulerNs3::ComputeActiveUe (ActiveUeMap *activeUe,
     }
 }
 
+void
+NrMacSchedulerNs3::SetQosLcAssignment (bool v)
+{
+  NS_LOG_FUNCTION (this << v);
+  m_assignBytesToLC = v ? &NrMacSchedulerNs3::AssignBytesToLCByQos
+                        : &NrMacSchedulerNs3::AssignBytesToLCEvenly;
+}
+
+bool
+NrMacSchedulerNs3::IsQosLcAssignment () const
+{
+  return m_assignBytesToLC == &NrMacSchedulerNs3::AssignBytesToLCByQos;
+}
+
 /**
  * \brief Method to decide how to distribute the assigned bytes to the different LCs
  * \param ueLCG LCG of an UE
  * \param tbs TBS to divide between the LCG/LC
- * \return A vector of Assignation
+ * \param isDl true if ueLCG are the DL LCGs of the UE, false for UL
+ * \return A vector of Assignation, with an entry for each LC with data
  *
- * The method distribute bytes evenly between LCG. This is a default;
- * more advanced methods can be inserted. Please note that the correct way
- * is to move this implementation in a class, and then implementing
- * a different method in a different class. Then, the selection between
- * the implementation should be done with an Attribute.
+ * The method is selected with the attribute QosLcAssignment: by default,
+ * AssignBytesToLCEvenly, otherwise AssignBytesToLCByQos. For the same LCG
+ * state, the entries are always returned in the same order (the DL
+ * relies on it to match the LCs between the streams).
  *
  * Please don't try to insert if/switch statements here, NOR to make it virtual
  * and to change in the subclasses.
  */
+std::vector<NrMacSchedulerNs3::Assignation>
+NrMacSchedulerNs3::AssignBytesToLC (const LCGMap &ueLCG, uint32_t tbs, bool isDl) const
+{
+  return (this->*m_assignBytesToLC) (ueLCG, tbs, isDl);
+}
+
+/**
+ * \brief Distribute the assigned bytes evenly between the LCs with data
+ * \param ueLCG LCG of an UE
+ * \param tbs TBS to divide between the LCG/LC
+ * \param isDl unused
+ * \return A vector of Assignation
+ */
 // Assume LC are unique
 std::vector<NrMacSchedulerNs3::Assignation>
-NrMacSchedulerNs3::AssignBytesToLC (const std::unordered_map<uint8_t, LCGPtr> &ueLCG,
-                                        uint32_t tbs) const
+NrMacSchedulerNs3::AssignBytesToLCEvenly (const LCGMap &ueLCG,
+                                          uint32_t tbs,
+                                          [[maybe_unused]] bool isDl) const
 {
   NS_LOG_FUNCTION (this);
-  GetFirst GetLCGID;
-  GetSecond GetLCG;
-
   std::vector<Assignation> ret;
 
   NS_LOG_INFO ("To distribute: " << tbs << " bytes over " << ueLCG.size () << " LCG");
@@ -1327,14 +1598,7 @@ NrMacSchedulerNs3::AssignBytesToLC (const std::unordered_map<uint8_t, LCGPtr> &u
   uint32_t activeLc = 0;
   for (const auto & lcg : ueLCG)
     {
-      std::vector<uint8_t> lcs = GetLCG (lcg)->GetLCId ();
-      for (const auto & lcId : lcs)
-        {
-          if (GetLCG (lcg)->GetTotalSizeOfLC (lcId) > 0)
-            {
-              ++activeLc;
-            }
-        }
+      activeLc += static_cast<uint32_t> (__builtin_popcountll (lcg.second->GetActiveLCIdMask ()));
     }
 
   if (activeLc == 0)
@@ -1347,22 +1611,183 @@ NrMacSchedulerNs3::AssignBytesToLC (const std::unordered_map<uint8_t, LCGPtr> &u
 
   for (const auto & lcg : ueLCG)
     {
-      std::vector<uint8_t> lcs = GetLCG (lcg)->GetLCId ();
-      for (const auto & lcId : lcs)
+      for (uint64_t lcMask = lcg.second->GetActiveLCIdMask (); lcMask != 0; lcMask &= lcMask - 1)
+        {
+          uint8_t lcId = static_cast<uint8_t> (__builtin_ctzll (lcMask));
+          NS_LOG_INFO ("Assigned to LCID " << static_cast<uint32_t> (lcId) <<
+                       " inside LCG " << static_cast<uint32_t> (lcg.first) <<
+                       " an amount of " << amountPerLC << " B");
+          ret.emplace_back (Assignation (lcg.first, lcId, amountPerLC));
+        }
+    }
+
+  return ret;
+}
+
+/**
+ * \brief Distribute the assigned bytes between the LCs with data, by QoS
+ * \param ueLCG LCG of an UE
+ * \param tbs TBS to divide between the LCG/LC
+ * \param isDl true if ueLCG are the DL LCGs of the UE, false for UL
+ * \return A vector of Assignation
+ *
+ * The LCs are served in two classes. The UL configured-grant LC and the GBR
+ * LCs are served first, in strict priority (the configured-grant LC, then
+ * the GBR LCs by their QoS priority level), each one up to its buffer plus
+ * the MAC subheader. The bytes left are divided between the other LCs in
+ * proportion to their buffer.
+ *
+ * An LC is never given less than a MAC subheader plus one byte: a share
+ * too small for that goes to the next LC instead. The bytes left at the
+ * end (rounding remainders, or bytes not needed by the strict-priority LCs)
+ * go to the last proportional LC served or, if there is none, to the most
+ * important LC served, to cover the RLC/MAC headers instead of becoming
+ * padding.
+ *
+ * The returned vector is built in a single pass over the LCGs, keeping it
+ * ordered by insertion (there are at most a handful of LCs per UE).
+ */
+std::vector<NrMacSchedulerNs3::Assignation>
+NrMacSchedulerNs3::AssignBytesToLCByQos (const LCGMap &ueLCG,
+                                         uint32_t tbs, bool isDl) const
+{
+  NS_LOG_FUNCTION (this);
+  std::vector<Assignation> ret;
+
+  // MAC subheader of each LC served (see DoScheduleDlData)
+  static const uint32_t subheaderSize = 3;
+
+  // Strict-priority LCs have a rank below 256, sorted by importance;
+  // the others share the same rank, and are kept in the LCG/LC id order.
+  // Only the UL carries the configured-grant traffic
+  auto rankOf = [this, isDl] (const NrMacSchedulerLC &lc) -> uint32_t
+    {
+      if (!isDl && lc.m_id == m_lcid_configuredGrant)
+        {
+          return 0;
+        }
+      return lc.m_isGbr ? 1 + lc.m_priority : 256;
+    };
+
+  uint64_t proportionalBuffer = 0;
+  for (const auto & lcg : ueLCG)
+    {
+      for (uint64_t lcMask = lcg.second->GetActiveLCIdMask (); lcMask != 0; lcMask &= lcMask - 1)
+        {
+          uint8_t lcId = static_cast<uint8_t> (__builtin_ctzll (lcMask));
+          const NrMacSchedulerLC & lc = lcg.second->GetLC (lcId);
+          uint32_t rank = rankOf (lc);
+          if (rank >= 256)
+            {
+              proportionalBuffer += lc.GetTotalSize ();
+            }
+
+          ret.emplace_back (Assignation (lcg.first, lcId, 0));
+          for (size_t i = ret.size () - 1; i > 0; --i)
+            {
+              const Assignation & prev = ret[i - 1];
+              if (rankOf (ueLCG.at (prev.m_lcg)->GetLC (prev.m_lcId)) <= rank)
+                {
+                  break;
+                }
+              std::swap (ret[i - 1], ret[i]);
+            }
+        }
+    }
+
+  // The strict-priority LCs come first in ret, so the proportional share
+  // is computed on what they leave. left counts the bytes not assigned yet,
+  // including the shares too small to be assigned, that are carried to the
+  // next proportional LC
+  uint32_t left = tbs;
+  uint32_t shareable = tbs;
+  uint32_t carry = 0;
+  Assignation *firstStrict = nullptr;
+  Assignation *lastProportional = nullptr;
+  for (auto & assignation : ret)
+    {
+      const NrMacSchedulerLC & lc = ueLCG.at (assignation.m_lcg)->GetLC (assignation.m_lcId);
+      bool strict = rankOf (lc) < 256;
+      uint32_t share;
+      if (strict)
+        {
+          share = std::min (left, lc.GetTotalSize () + subheaderSize);
+        }
+      else
+        {
+          share = static_cast<uint32_t> (static_cast<uint64_t> (shareable) *
+                                         lc.GetTotalSize () / proportionalBuffer);
+          share = std::min (left, share + carry);
+        }
+
+      if (share <= subheaderSize)
         {
-          if (GetLCG (lcg)->GetTotalSizeOfLC (lcId) > 0)
+          carry = strict ? 0 : share;
+        }
+      else
+        {
+          assignation.m_bytes = share;
+          left -= share;
+          carry = 0;
+          if (strict)
             {
-              NS_LOG_INFO ("Assigned to LCID " << static_cast<uint32_t> (lcId) <<
-                           " inside LCG " << static_cast<uint32_t> (GetLCGID (lcg)) <<
-                           " an amount of " << amountPerLC << " B");
-              ret.emplace_back (Assignation (GetLCGID (lcg), lcId, amountPerLC));
+              firstStrict = firstStrict == nullptr ? &assignation : firstStrict;
             }
+          else
+            {
+              lastProportional = &assignation;
+            }
+        }
+
+      if (strict)
+        {
+          shareable = left;
         }
     }
 
+  // Rounding remainder of the proportional share, small shares, or bytes
+  // not needed by the strict-priority LCs
+  if (left > 0)
+    {
+      Assignation *target = lastProportional != nullptr ? lastProportional : firstStrict;
+      if (target != nullptr)
+        {
+          target->m_bytes += left;
+        }
+      else if (left > subheaderSize && ret.size () > 0)
+        {
+          ret.front ().m_bytes = left;
+        }
+    }
+
+  for (const auto & assignation : ret)
+    {
+      NS_LOG_INFO ("Assigned to LCID " << static_cast<uint32_t> (assignation.m_lcId) <<
+                   " inside LCG " << static_cast<uint32_t> (assignation.m_lcg) <<
+                   " an amount of " << assignation.m_bytes << " B");
+    }
+
   return ret;
 }
 
+void
+NrMacSchedulerNs3::UpdateUlLCG (const LCGMap &ulLCG, const std::vector<Assignation> &distributedBytes) const
+{
+  NS_LOG_FUNCTION (this);
+  for (const auto & byteDistribution : distributedBytes)
+    {
+      if (byteDistribution.m_bytes <= 3)
+        {
+          continue;
+        }
+      uint32_t bytes = byteDistribution.m_bytes - 3; // Consider the subPdu overhead
+      ulLCG.at (byteDistribution.m_lcg)->AssignedData (byteDistribution.m_lcId, bytes, "UL");
+      NS_LOG_DEBUG ("UL LCG " << static_cast<uint32_t> (byteDistribution.m_lcg) <<
+                    " assigned bytes " << bytes << " to LCID " <<
+                    static_cast<uint32_t> (byteDistribution.m_lcId));
+    }
+}
+
 
 /**
  * \brief Scheduling new DL data
@@ -1489,7 +1914,7 @@ NrMacSchedulerNs3::DoScheduleDlData (PointInFTPlane *spoint, uint32_t symAvail,
             {
               //distribute tbsize of each stream among the LCs of the UE
               //distributedBytes size is equal to the number of LCs
-              auto distributedBytes = AssignBytesToLC (ue.first->m_dlLCG, it);
+              auto distributedBytes = AssignBytesToLC (ue.first->m_dlLCG, it, true);
               if (bytesPerLcPerStream.size () == 0)
                 {
                   bytesPerLcPerStream.resize (distributedBytes.size ());
@@ -1555,6 +1980,7 @@ NrMacSchedulerNs3::DoScheduleDlData (PointInFTPlane *spoint, uint32_t symAvail,
               HarqProcess & process = ue.first->m_dlHarq.Get (dci->m_harqProcess);
               process.m_rlcPduInfo.push_back (rlcPdusInfoPerStream);
             }
+          UpdateDlActiveSet (ue.first);
 
 
 /*
@@ -1643,6 +2069,7 @@ NrMacSchedulerNs3::DoScheduleUlData (PointInFTPlane *spoint, uint32_t symAvail,
                                          const ActiveUeMap &activeUl, SlotAllocInfo *slotAlloc) const
 {
   NS_LOG_FUNCTION (this);
+  NrProfilerScope profilerScope (NrProfiler::SCHED_UL_DATA);
   NS_ASSERT (symAvail > 0 && activeUl.size () > 0);
   NS_ASSERT (spoint->m_rbg == 0);
 
@@ -1761,17 +2188,10 @@ NrMacSchedulerNs3::DoScheduleUlData (PointInFTPlane *spoint, uint32_t symAvail,
             }
 
 
-          auto distributedBytes = AssignBytesToLC (ue.first->m_ulLCG, dci->m_tbSize.at (0));
-          bool assignedToLC = false;
-          for (const auto & byteDistribution : distributedBytes)
-            {
-              assignedToLC = true;
-              ue.first->m_ulLCG.at (byteDistribution.m_lcg)->AssignedData (byteDistribution.m_lcId, byteDistribution.m_bytes, "UL");
-              NS_LOG_DEBUG ("UL LCG " << static_cast<uint32_t> (byteDistribution.m_lcg) <<
-                            " assigned bytes " << byteDistribution.m_bytes << " to LCID " <<
-                            static_cast<uint32_t> (byteDistribution.m_lcId));
-            }
-          NS_ASSERT (assignedToLC);
+          auto distributedBytes = AssignBytesToLC (ue.first->m_ulLCG, dci->m_tbSize.at (0), false);
+          NS_ASSERT (distributedBytes.size () > 0);
+          UpdateUlLCG (ue.first->m_ulLCG, distributedBytes);
+          UpdateUlActiveSet (ue.first);
           slotAlloc->m_varTtiAllocInfo.emplace_front (slotInfo);
         }
       if (assigned)
@@ -1814,11 +2234,12 @@ NrMacSchedulerNs3::DoScheduleUlSr (PointInFTPlane *spoint, const std::list<uint1
 
   for (const auto & v : rntiList)
     {
-      for (auto & ulLcg : NrMacSchedulerUeInfo::GetUlLCG (m_ueMap.at (v)))
+      for (auto & ulLcg : NrMacSchedulerUeInfo::GetUlLCG (GetUe (v)))
         {
           NS_LOG_DEBUG ("Assigning 12 bytes to UE " << v << " because of a SR");
           ulLcg.second->UpdateInfo (22); //(22 as it is the header of IPv4)
         }
+      UpdateUlActiveSet (GetUe (v));
     }
 }
 
@@ -1909,7 +2330,7 @@ NrMacSchedulerNs3::ScheduleDl (const NrMacSchedSapProvider::SchedDlTriggerReqPar
   ComputeActiveHarq (&activeDlHarq, dlHarqFeedback);
 
   ActiveUeMap activeDlUe;
-  ComputeActiveUe (&activeDlUe, &NrMacSchedulerUeInfo::GetDlLCG,
+  ComputeActiveUe (&activeDlUe, m_dlActive, &NrMacSchedulerUeInfo::GetDlLCG,
                    &NrMacSchedulerUeInfo::GetDlHarqVector, "DL");
 
   DoScheduleDl (dlHarqFeedback, activeDlHarq, &activeDlUe, params.m_snfSf,
@@ -2108,6 +2529,11 @@ NrMacSchedulerNs3::DoScheduleUl (const std::vector <UlHarqInfo> &ulHarqFeedback,
 
   NS_ASSERT (ulAssignationStartPoint.m_rbg == 0);
 
+ if (ulSymAvail > 0 && m_cgScheduling && m_cgPlannerEnabled)
+  {
+    DoScheduleUlCgOccasions (ulSfn);
+  }
+
  if (ulSymAvail > 0 && m_srList.size () > 0)
   {
    if (m_cgScheduling)
@@ -2124,7 +2550,7 @@ NrMacSchedulerNs3::DoScheduleUl (const std::vector <UlHarqInfo> &ulHarqFeedback,
      m_srList.clear ();
    }
   ActiveUeMap activeUlUe;
-  ComputeActiveUe (&activeUlUe, &NrMacSchedulerUeInfo::GetUlLCG,
+  ComputeActiveUe (&activeUlUe, m_ulActive, &NrMacSchedulerUeInfo::GetUlLCG,
                    &NrMacSchedulerUeInfo::GetUlHarqVector, "UL");
 
   GetSecond GetUeInfoList;
@@ -2219,7 +2645,7 @@ NrMacSchedulerNs3::DoScheduleSrs (PointInFTPlane *spoint, SlotAllocInfo *allocIn
   uint8_t used = 0;
 
   // Without UE, don't schedule any SRS
-  if (m_ueMap.size () == 0)
+  if (m_ueVector.size () == 0)
     {
       return used;
     }
@@ -2228,14 +2654,14 @@ NrMacSchedulerNs3::DoScheduleSrs (PointInFTPlane *spoint, SlotAllocInfo *allocIn
   // absolute_slot_number % periodicity = offset_UEx
   // Assuming that all UEs share the same periodicity.
 
-  uint32_t offset_UEx = m_srsSlotCounter % m_ueMap.begin()->second->m_srsPeriodicity;
+  uint32_t offset_UEx = m_srsSlotCounter % m_ueVector.front ()->m_srsPeriodicity;
   uint16_t rnti = 0;
 
-  for (const auto & ue : m_ueMap)
+  for (const auto & ue : m_ueVector)
     {
-      if (ue.second->m_srsOffset == offset_UEx)
+      if (ue->m_srsOffset == offset_UEx)
         {
-          rnti = ue.second->m_rnti;
+          rnti = ue->m_rnti;
         }
     }
 
@@ -2435,12 +2861,12 @@ NrMacSchedulerNs3::DoSchedDlTriggerReq (const NrMacSchedSapProvider::SchedDlTrig
   NS_LOG_FUNCTION (this);
 
   // process received CQIs
-  m_cqiManagement.RefreshDlCqiMaps (m_ueMap);
+  m_cqiManagement.RefreshDlCqiMaps ();
 
   // reset expired HARQ
-  for (const auto & itUe : m_ueMap)
+  for (const auto & ue : m_ueVector)
     {
-      ResetExpiredHARQ (itUe.second->m_rnti, &itUe.second->m_dlHarq);
+      ResetExpiredHARQ (ue->m_rnti, &ue->m_dlHarq);
     }
 
   // Merge not-retransmitted and received feedback
@@ -2459,6 +2885,9 @@ NrMacSchedulerNs3::DoSchedDlTriggerReq (const NrMacSchedSapProvider::SchedDlTrig
                      " existing: " << existingSize << " received: " << inSize <<
                      " calculated: " << dlHarqFeedback.size ());
 
+      RemoveStaleHARQFeedbacks (&dlHarqFeedback, existingSize,
+                                NrMacSchedulerUeInfo::GetDlHarqVector, "DL");
+
       std::unordered_map<uint16_t, std::set<uint32_t>> feedbacksDup;
 
       // Let's find out:
@@ -2468,7 +2897,7 @@ NrMacSchedulerNs3::DoSchedDlTriggerReq (const NrMacSchedSapProvider::SchedDlTrig
       //    these are generated.. but anyway..
       for (auto it = dlHarqFeedback.begin (); it != dlHarqFeedback.end (); /* no inc */)
         {
-          auto & ueInfo = m_ueMap.find (it->m_rnti)->second;
+          const auto & ueInfo = GetUe (it->m_rnti);
           auto & process = ueInfo->m_dlHarq.Find (it->m_harqProcessId)->second;
           NS_LOG_INFO ("Analyzing feedback for UE " << it->m_rnti << " process " <<
                        static_cast<uint32_t> (it->m_harqProcessId));
@@ -2527,14 +2956,15 @@ void
 NrMacSchedulerNs3::DoSchedUlTriggerReq (const NrMacSchedSapProvider::SchedUlTriggerReqParameters& params)
 {
   NS_LOG_FUNCTION (this);
+  NrProfilerScope profilerScope (NrProfiler::SCHED_UL_TRIGGER_REQ);
 
   // process received CQIs
-  m_cqiManagement.RefreshUlCqiMaps (m_ueMap);
+  m_cqiManagement.RefreshUlCqiMaps ();
 
   // reset expired HARQ
-  for (const auto & itUe : m_ueMap)
+  for (const auto & ue : m_ueVector)
     {
-      ResetExpiredHARQ (itUe.second->m_rnti, &itUe.second->m_ulHarq);
+      ResetExpiredHARQ (ue->m_rnti, &ue->m_ulHarq);
     }
   // Merge not-retransmitted and received feedback
   std::vector <UlHarqInfo> ulHarqFeedback;
@@ -2551,10 +2981,13 @@ NrMacSchedulerNs3::DoSchedUlTriggerReq (const NrMacSchedSapProvider::SchedUlTrig
                      " existing: " << existingSize << " received: " << inSize <<
                      " calculated: " << ulHarqFeedback.size ());
 
+      RemoveStaleHARQFeedbacks (&ulHarqFeedback, existingSize,
+                                NrMacSchedulerUeInfo::GetUlHarqVector, "UL");
+
       // if there are feedbacks for expired process, remove them
       for (auto it = ulHarqFeedback.begin (); it != ulHarqFeedback.end (); /* no inc */)
         {
-          auto & ueInfo = m_ueMap.find (it->m_rnti)->second;
+          const auto & ueInfo = GetUe (it->m_rnti);
           auto & process = ueInfo->m_ulHarq.Find (it->m_harqProcessId)->second;
           if (!process.m_active)
             {
@@ -2608,31 +3041,242 @@ NrMacSchedulerNs3::DoScheduleUlresources_configuredGrant (PointInFTPlane *spoint
   NS_LOG_FUNCTION (this);
   NS_ASSERT (spoint->m_rbg == 0);
 
-  auto bufSizeUeIt = m_bufCgr.begin ();
-  uint32_t bufSize ;
-  uint32_t bufWithOH;
-
+  // The list mixes the UEs of the CGRs and the ones of the SRs
   for (const auto & v : rntiList)
     {
-      for (auto & ulLcg : NrMacSchedulerUeInfo::GetUlLCG (m_ueMap.at (v)))
+      auto bufSizeUeIt = m_bufCgr.find (v);
+      if (bufSizeUeIt != m_bufCgr.end ())
+        {
+          LoadCgBuffer (v, GetCgBufferSize (bufSizeUeIt->second));
+        }
+      else
+        {
+          UpdateUlActiveSet (GetUe (v));
+        }
+    }
+}
+
+void
+NrMacSchedulerNs3::DoScheduleUlCgOccasions (const SfnSf &ulSfn) const
+{
+  NS_LOG_FUNCTION (this);
+
+  for (const auto & occasion : m_cgPlanner.GetOccasions (ulSfn.Normalize ()))
+    {
+      NS_LOG_DEBUG ("Planned CG occasion of UE " << occasion.m_rnti << " in " << ulSfn);
+      LoadCgBuffer (occasion.m_rnti, occasion.m_size);
+    }
+}
+
+void
+NrMacSchedulerNs3::LoadCgBuffer (uint16_t rnti, uint32_t bytes) const
+{
+  NS_LOG_FUNCTION (this << rnti << bytes);
+
+  for (auto & ulLcg : NrMacSchedulerUeInfo::GetUlLCG (GetUe (rnti)))
+    {
+      // only one LC per LCG in UL
+      if (ulLcg.second->Contains (m_lcid_configuredGrant))
+        {
+          NS_LOG_DEBUG ("Assigning " << bytes << " bytes to UE " << rnti << " because of a CGR");
+          ulLcg.second->UpdateInfo (bytes);
+        }
+    }
+  UpdateUlActiveSet (GetUe (rnti));
+}
+
+uint64_t
+NrMacSchedulerNs3::FromBsrLevelToBytes (uint8_t level, bool longBsr)
+{
+  return longBsr ? NrMacLongBsrCe::FromLevelToBytes (level)
+                 : NrMacShortBsrCe::FromLevelToBytes (level);
+}
+
+uint8_t
+NrMacSchedulerNs3::FromBytesToBsrLevel (uint64_t bytes, bool longBsr)
+{
+  return longBsr ? NrMacLongBsrCe::FromBytesToLevel (bytes)
+                 : NrMacShortBsrCe::FromBytesToLevel (bytes);
+}
+
+uint32_t
+NrMacSchedulerNs3::GetCgOverhead () const
+{
+  // 2 overheadRLC, 3 subheader and the BSR (5 for the short one, 9 for the long one)
+  return m_cgLongBsrLevels ? 2 + 3 + NrMacLongBsrCe ().GetSerializedSize () : 8 + 2;
+}
+
+uint32_t
+NrMacSchedulerNs3::GetCgBufferSize (uint32_t bufSize) const
+{
+  uint32_t bufWithOH = bufSize + GetCgOverhead ();
+  uint8_t bsrId = FromBytesToBsrLevel (bufWithOH, m_cgLongBsrLevels);
+  return FromBsrLevelToBytes (bsrId, m_cgLongBsrLevels);
+}
+
+void
+NrMacSchedulerNs3::PlanCgFlows (const NrMacSchedSapProvider::SchedUlCgrInfoReqParameters &params)
+{
+  NS_LOG_FUNCTION (this);
+
+  const Time slotPeriod = m_macSchedSapUser->GetSlotPeriod ();
+  const uint64_t now = params.m_snfSf.Normalize ();
+
+  if (m_cgPlanner.GetNumFlows () == 0)
+    {
+      // The occasions are scheduled by the UL path, that runs for the UL and F slots
+      std::vector<bool> ulSlots;
+      for (const auto & type : m_macSchedSapUser->GetTddPattern ())
+        {
+          ulSlots.push_back (type == LteNrTddSlotType::UL || type == LteNrTddSlotType::F);
+        }
+      m_cgPlanner.SetUlSlotMask (ulSlots);
+    }
+
+  for (size_t i = 0; i < params.m_srList.size (); ++i)
+    {
+      uint16_t rnti = params.m_srList[i];
+      if (m_cgPlanner.HasFlow (rnti) || i >= params.m_bufCgr.size () || i >= params.m_TraffPCgr.size ())
+        {
+          continue;
+        }
+
+      uint32_t period = GetCgPeriodInSlots (params.m_TraffPCgr[i]);
+      uint32_t maxDelay = 0;
+      if (i < params.m_TraffDeadlineCgr.size () && params.m_TraffDeadlineCgr[i].IsStrictlyPositive ())
+        {
+          maxDelay = static_cast<uint32_t> (params.m_TraffDeadlineCgr[i].GetNanoSeconds () /
+                                            slotPeriod.GetNanoSeconds ());
+        }
+
+      if (! m_cgPlanner.AddFlow (rnti, period, static_cast<uint32_t> (now % period),
+                                 GetCgBufferSize (params.m_bufCgr[i]), maxDelay))
+        {
+          NS_LOG_WARN ("CG of UE " << rnti << " (period " << period << " slots, " <<
+                       params.m_bufCgr[i] << " B) does not fit in the CG layout: rejected");
+          m_cgAdmission.RemoveFlow (rnti);
+          m_cgGranted.erase (rnti);
+        }
+    }
+}
+
+uint32_t
+NrMacSchedulerNs3::GetCgPeriodInSlots (uint32_t periodMs) const
+{
+  const Time slotPeriod = m_macSchedSapUser->GetSlotPeriod ();
+  const uint32_t slotsPerMs = static_cast<uint32_t> (MilliSeconds (1).GetNanoSeconds () /
+                                                     slotPeriod.GetNanoSeconds ());
+  return std::max (1U, periodMs * slotsPerMs);
+}
+
+NrMacSchedSapProvider::SchedUlCgrInfoReqParameters
+NrMacSchedulerNs3::AdmitCgFlows (const NrMacSchedSapProvider::SchedUlCgrInfoReqParameters &params)
+{
+  NS_LOG_FUNCTION (this);
+
+  if (! m_cgAdmission.IsConfigured ())
+    {
+      // UL data symbols of the slots of the TDD pattern, as in DoScheduleUl
+      const uint32_t ulSlotSym = m_macSchedSapUser->GetSymbolsPerSlot () - m_ulCtrlSymbols;
+      const uint32_t fSlotSym = ulSlotSym - m_dlCtrlSymbols - m_dlDataSymbolsF;
+      const auto pattern = m_macSchedSapUser->GetTddPattern ();
+      uint32_t ulSym = 0;
+      for (const auto & type : pattern)
+        {
+          ulSym += type == LteNrTddSlotType::UL ? ulSlotSym : type == LteNrTddSlotType::F ? fSlotSym : 0;
+        }
+      m_cgAdmission.Configure (m_ulAmc, GetBandwidthInRbg (), GetNumRbPerRbg (), ulSlotSym,
+                               pattern.empty () ? ulSlotSym : static_cast<double> (ulSym) / pattern.size ());
+    }
+
+  NrMacSchedSapProvider::SchedUlCgrInfoReqParameters admitted;
+  admitted.m_snfSf = params.m_snfSf;
+  admitted.lcid = params.lcid;
+
+  for (size_t i = 0; i < params.m_srList.size (); ++i)
+    {
+      uint16_t rnti = params.m_srList[i];
+      if (i >= params.m_bufCgr.size () || i >= params.m_TraffPCgr.size ())
+        {
+          continue;
+        }
+
+      uint32_t requested = params.m_bufCgr[i];
+      uint32_t period = GetCgPeriodInSlots (params.m_TraffPCgr[i]);
+      uint32_t granted = 0;
+
+      if (m_cgAdmission.GetFlowPeriod (rnti) == period)
+        {
+          granted = std::min (requested, m_cgGranted.at (rnti));
+        }
+      else
         {
-          std::vector<uint8_t> lcid = ulLcg.second -> GetLCId();
-          if (lcid[0] == m_lcid_configuredGrant)
+          uint8_t mcs = GetUe (rnti)->m_ulMcs;
+          uint8_t decision = CG_REJECTED;
+
+          m_cgAdmission.RemoveFlow (rnti);
+          m_cgGranted.erase (rnti);
+
+          if (m_cgAdmission.Admit (rnti, period, GetCgBufferSize (requested), mcs))
             {
-              while (bufSizeUeIt != m_bufCgr.end ())
+              granted = requested;
+              decision = CG_ACCEPTED;
+            }
+          else
+            {
+              // Largest BSR level that fits, minus the overhead added by GetCgBufferSize
+              uint32_t admissible = m_cgAdmission.GetAdmissibleBytes (period, mcs);
+              uint8_t level = FromBytesToBsrLevel (admissible, m_cgLongBsrLevels);
+              while (level > 0 && FromBsrLevelToBytes (level, m_cgLongBsrLevels) > admissible)
                 {
-                  bufWithOH = *bufSizeUeIt + uint32_t (8 + 2); // 2 overheadRLC and 8 BSR+Overhead
-                  uint8_t bsrId = NrMacShortBsrCe::FromBytesToLevel(bufWithOH);
-                  bufSize = NrMacShortBsrCe::FromLevelToBytes (bsrId);
+                  --level;
+                }
+              uint32_t bytes = FromBsrLevelToBytes (level, m_cgLongBsrLevels);
+              uint32_t downgraded = bytes > GetCgOverhead () ? bytes - GetCgOverhead () : 0;
 
-                  NS_LOG_DEBUG ("Assigning " << bufSize << " bytes to UE " << v << " because of a CGR");
-                  ulLcg.second->UpdateInfo(bufSize);
-                  break;
-               }
+              if (downgraded > 0 && downgraded >= m_cgMinDowngrade * requested
+                  && m_cgAdmission.Admit (rnti, period, GetCgBufferSize (downgraded), mcs))
+                {
+                  granted = downgraded;
+                  decision = CG_DOWNGRADED;
+                }
+            }
+
+          if (granted > 0)
+            {
+              m_cgGranted[rnti] = granted;
             }
+
+          NS_LOG_INFO ("CG flow of UE " << rnti << " (period " << period << " slots, " <<
+                       requested << " B): decision " << static_cast<uint32_t> (decision) <<
+                       ", granted " << granted << " B, utilization " <<
+                       m_cgAdmission.GetUtilization ());
+          m_cgAdmissionTrace (rnti, decision, requested, granted, m_cgAdmission.GetUtilization ());
         }
-      bufSizeUeIt++;
-     }
+
+      if (granted == 0)
+        {
+          continue;
+        }
+
+      admitted.m_srList.push_back (rnti);
+      admitted.m_bufCgr.push_back (granted);
+      admitted.m_TraffPCgr.push_back (params.m_TraffPCgr[i]);
+      if (i < params.m_TraffInitCgr.size ())
+        {
+          admitted.m_TraffInitCgr.push_back (params.m_TraffInitCgr[i]);
+        }
+      if (i < params.m_TraffDeadlineCgr.size ())
+        {
+          admitted.m_TraffDeadlineCgr.push_back (params.m_TraffDeadlineCgr[i]);
+        }
+      if (i < params.m_ageList.size ())
+        {
+          admitted.m_ageList.push_back (params.m_ageList[i]);
+        }
+    }
+
+  return admitted;
 }
 
 void
@@ -2648,18 +3292,42 @@ NrMacSchedulerNs3::GetDlDataSymsF () const
 }
 
 void
-NrMacSchedulerNs3::DoSchedUlCgrInfoReq (const NrMacSchedSapProvider::SchedUlCgrInfoReqParameters &params)
+NrMacSchedulerNs3::DoSchedUlCgrInfoReq (const NrMacSchedSapProvider::SchedUlCgrInfoReqParameters &cgr)
 {
   NS_LOG_FUNCTION (this);
 
+  // With the admission control, only the admitted UEs (with the granted sizes) go on
+  NrMacSchedSapProvider::SchedUlCgrInfoReqParameters admitted;
+  if (m_cgAdmissionEnabled)
+    {
+      admitted = AdmitCgFlows (cgr);
+    }
+  const auto & params = m_cgAdmissionEnabled ? admitted : cgr;
+
+  if (m_cgAdmissionEnabled)
+    {
+      // A UE waiting for its CG that is now rejected (e.g., after a period
+      // change) must not be scheduled with its old request
+      for (const auto & ue : cgr.m_srList)
+        {
+          if (std::find (admitted.m_srList.begin (), admitted.m_srList.end (), ue) == admitted.m_srList.end ()
+              && m_bufCgr.erase (ue) > 0)
+            {
+              NS_LOG_INFO ("UE " << ue << " rejected: removed from the CG scheduling");
+              m_srList.remove (ue);
+              m_cgrTraffP.erase (ue);
+            }
+        }
+    }
+
   // Merge RNTI in our current list
   for (size_t i = 0; i < params.m_srList.size(); ++i)
     {
       auto ue = params.m_srList[i];
       NS_LOG_INFO ("UE " << ue << " asked for a CGR ");
       
-      // UE가 리스트에 없다면 추가
-      if (std::find(m_srList.begin(), m_srList.end(), ue) == m_srList.end())
+      // UE가 리스트에 없다면 추가 (planner: the UE is scheduled from its planned occasions)
+      if (! m_cgPlannerEnabled && std::find(m_srList.begin(), m_srList.end(), ue) == m_srList.end())
       {
         m_srList.push_back(ue);
       }
@@ -2679,16 +3347,26 @@ NrMacSchedulerNs3::DoSchedUlCgrInfoReq (const NrMacSchedSapProvider::SchedUlCgrI
       // }
     }
 
-  for (const auto & buf : params.m_bufCgr)
+  m_lcid_configuredGrant = params.lcid;
+
+  if (m_cgPlannerEnabled)
+    {
+      // The planned occasions drive the CG scheduling (DoScheduleUlCgOccasions):
+      // the CGRs are only used to add the UEs to the layout
+      PlanCgFlows (params);
+      return;
+    }
+
+  // The last CGR of a UE gives its buffer
+  for (size_t i = 0; i < params.m_srList.size () && i < params.m_bufCgr.size (); ++i)
     {
-      m_bufCgr.push_back (buf);
+      m_bufCgr[params.m_srList[i]] = params.m_bufCgr[i];
     }
-  for (const auto & periodTraff : params.m_TraffPCgr)
+  for (size_t i = 0; i < params.m_srList.size () && i < params.m_TraffPCgr.size (); ++i)
     {
-      m_cgrTraffP.push_back (periodTraff);
+      m_cgrTraffP[params.m_srList[i]] = params.m_TraffPCgr[i];
     }
   //m_cgrBufSize = params.m_bufCgr;
-  m_lcid_configuredGrant = params.lcid;
   NS_ASSERT (m_srList.size () >= params.m_srList.size ());
 }
 
@@ -2720,6 +3398,59 @@ uint64_t NrMacSchedulerNs3::GetAge(uint16_t ueRnti) const
   // return 0; // 해당 UE가 없거나 큐가 비어있으면 0 반환
 }
 
+void
+NrMacSchedulerNs3::SetCgPlannerSlotCapacity (uint32_t v)
+{
+  m_cgPlanner.SetSlotCapacity (v);
+}
+
+uint32_t
+NrMacSchedulerNs3::GetCgPlannerSlotCapacity () const
+{
+  return m_cgPlanner.GetSlotCapacity ();
+}
+
+void
+NrMacSchedulerNs3::SetCgPlannerMaxUesPerSlot (uint32_t v)
+{
+  m_cgPlanner.SetMaxOccasionsPerSlot (v);
+}
+
+uint32_t
+NrMacSchedulerNs3::GetCgPlannerMaxUesPerSlot () const
+{
+  return m_cgPlanner.GetMaxOccasionsPerSlot ();
+}
+
+void
+NrMacSchedulerNs3::SetCgAdmissionMaxUtilization (double v)
+{
+  m_cgAdmission.SetMaxUtilization (v);
+}
+
+double
+NrMacSchedulerNs3::GetCgAdmissionMaxUtilization () const
+{
+  return m_cgAdmission.GetMaxUtilization ();
+}
+
+double
+NrMacSchedulerNs3::GetCgUtilization () const
+{
+  return m_cgAdmission.IsConfigured () ? m_cgAdmission.GetUtilization () : 0.0;
+}
+
+uint32_t
+NrMacSchedulerNs3::GetCgAdmissibleBytes (uint32_t periodMs, uint8_t mcs) const
+{
+  if (! m_cgAdmission.IsConfigured ())
+    {
+      return 0;
+    }
+  uint32_t admissible = m_cgAdmission.GetAdmissibleBytes (GetCgPeriodInSlots (periodMs), mcs);
+  return admissible > 10 ? admissible - 10 : 0;
+}
+
 bool
 NrMacSchedulerNs3::GetCG () const
 {
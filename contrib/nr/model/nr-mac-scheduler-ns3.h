@@ -24,14 +24,20 @@
 #include "nr-mac-scheduler-ue-info.h"
 #include "nr-mac-scheduler-lcg.h"
 #include "nr-mac-scheduler-cqi-management.h"
+#include "nr-mac-scheduler-cg-planner.h"
+#include "nr-mac-scheduler-cg-admission.h"
 #include "nr-amc.h"
 #include <memory>
 #include <functional>
 #include <list>
+#include <unordered_map>
+#include <ns3/traced-callback.h>
 
 namespace ns3 {
 
 class NrSchedGeneralTestCase;
+class NrLcQosAssignmentTestCase;
+class NrUlFrequencySelectiveTestCase;
 class NrMacSchedulerHarqRr;
 class NrMacSchedulerSrsDefault;
 
@@ -551,6 +557,71 @@ public:
   void SetCG (bool CGSch);
   bool GetCG () const;
 
+  /**
+   * \brief Set the bytes available for CG occasions in each slot (attribute)
+   * \param v the capacity (0: unlimited)
+   */
+  void SetCgPlannerSlotCapacity (uint32_t v);
+  /**
+   * \return the bytes available for CG occasions in each slot (attribute)
+   */
+  uint32_t GetCgPlannerSlotCapacity () const;
+  /**
+   * \brief Set the maximum number of CG occasions in each slot (attribute)
+   * \param v the maximum (0: unlimited)
+   */
+  void SetCgPlannerMaxUesPerSlot (uint32_t v);
+  /**
+   * \return the maximum number of CG occasions in each slot (attribute)
+   */
+  uint32_t GetCgPlannerMaxUesPerSlot () const;
+
+  /**
+   * \brief Decision of the CG admission control on a new CG flow
+   */
+  enum CgAdmissionDecision : uint8_t
+  {
+    CG_ACCEPTED = 0,   //!< Admitted as requested
+    CG_DOWNGRADED = 1, //!< Admitted with smaller occasions
+    CG_REJECTED = 2    //!< Not admitted
+  };
+
+  /**
+   * \brief TracedCallback signature for the CG admission decisions
+   * \param [in] rnti RNTI of the UE
+   * \param [in] decision the CgAdmissionDecision
+   * \param [in] requested bytes requested for each occasion
+   * \param [in] granted bytes granted for each occasion (0 if rejected)
+   * \param [in] utilization fraction of the CG capacity in use after the decision
+   */
+  typedef void (* CgAdmissionTracedCallback)(uint16_t rnti, uint8_t decision, uint32_t requested,
+                                             uint32_t granted, double utilization);
+
+  /**
+   * \brief Set the fraction of the UL resources that CG flows can reserve (attribute)
+   * \param v the fraction, in (0, 1]
+   */
+  void SetCgAdmissionMaxUtilization (double v);
+  /**
+   * \return the fraction of the UL resources that CG flows can reserve (attribute)
+   */
+  double GetCgAdmissionMaxUtilization () const;
+  /**
+   * \return the fraction of the CG capacity demanded by the admitted CG flows
+   *
+   * It is 0 until the first CGR is received with the admission control enabled.
+   */
+  double GetCgUtilization () const;
+  /**
+   * \brief Get the largest occasion that a new CG flow could be admitted with
+   * \param periodMs period of the flow, in ms
+   * \param mcs UL MCS of the UE
+   * \return the bytes (as reported in the CGR) of the largest admissible occasion
+   *
+   * It is 0 until the first CGR is received with the admission control enabled.
+   */
+  uint32_t GetCgAdmissibleBytes (uint32_t periodMs, uint8_t mcs) const;
+
 protected:
   /**
    * \brief Create an UE representation for the scheduler.
@@ -737,6 +808,12 @@ protected:
       * \param o other instance
       */
     Assignation (Assignation &&o) = default;
+    /**
+      * \brief Assignation move assignment (default)
+      * \param o other instance
+      * \return this instance
+      */
+    Assignation & operator= (Assignation &&o) = default;
     /**
      * \brief Assignation constructor with parameters
      * \param lcg LCG ID
@@ -832,7 +909,41 @@ private:
   };
 
   std::vector<Assignation>
-  AssignBytesToLC (const std::unordered_map<uint8_t, LCGPtr> &ueLCG, uint32_t tbs) const;
+  AssignBytesToLC (const LCGMap &ueLCG, uint32_t tbs, bool isDl) const;
+
+  std::vector<Assignation>
+  AssignBytesToLCEvenly (const LCGMap &ueLCG, uint32_t tbs, bool isDl) const;
+
+  std::vector<Assignation>
+  AssignBytesToLCByQos (const LCGMap &ueLCG, uint32_t tbs, bool isDl) const;
+
+  /**
+   * \brief Update the UL LC queues with the bytes assigned in a TB
+   *
+   * As in DL, the LCs that got no room for data after their MAC subheader
+   * are skipped, and the subheader is not counted as LC data.
+   *
+   * \param ulLCG the UL LCGs of the UE
+   * \param distributedBytes bytes of the TB assigned to each LC
+   */
+  void UpdateUlLCG (const LCGMap &ulLCG, const std::vector<Assignation> &distributedBytes) const;
+
+  /**
+   * \brief Select the method used by AssignBytesToLC
+   * \param v true for AssignBytesToLCByQos, false for AssignBytesToLCEvenly
+   */
+  void SetQosLcAssignment (bool v);
+
+  /**
+   * \brief Is the QoS-aware assignment of bytes to LC in use?
+   * \return true if AssignBytesToLC uses AssignBytesToLCByQos
+   */
+  bool IsQosLcAssignment () const;
+
+  /**
+   * \brief Pointer to the method used by AssignBytesToLC
+   */
+  typedef std::vector<Assignation> (NrMacSchedulerNs3::*AssignBytesToLCFn) (const LCGMap &, uint32_t, bool) const;
 
   void BSRReceivedFromUe (const MacCeElement &bsr);
 
@@ -843,11 +954,99 @@ private:
 
   void ResetExpiredHARQ (uint16_t rnti, NrMacHarqVector *harq);
 
+  /**
+   * \brief Add a UE to the dense UE registry
+   * \param ue the UE representation
+   */
+  void RegisterUe (const UePtr &ue);
+  /**
+   * \brief Remove a UE from the dense UE registry
+   * \param rnti the RNTI of the UE
+   *
+   * The last UE of the registry takes the dense index of the removed one.
+   */
+  void UnregisterUe (uint16_t rnti);
+  /**
+   * \brief Get the dense index of a UE
+   * \param rnti the RNTI of the UE
+   * \return the dense index, or UINT32_MAX if the UE is not registered
+   */
+  uint32_t GetUeIndex (uint16_t rnti) const
+  {
+    return rnti < m_rntiToUeIndex.size () ? m_rntiToUeIndex[rnti] : UINT32_MAX;
+  }
+  /**
+   * \brief Get the representation of a registered UE
+   * \param rnti the RNTI of the UE
+   * \return the UE representation
+   */
+  const UePtr & GetUe (uint16_t rnti) const;
+
+  /**
+   * \brief UEs with data buffered, in one direction
+   *
+   * The set is updated each time the buffer of a UE changes (RLC buffer
+   * status, BSR, SR, CGR, or bytes assigned in a DCI), so ComputeActiveUe
+   * does not need to scan all the UEs at each slot. All the vectors, except
+   * m_ues, are indexed by the dense UE index.
+   */
+  struct ActiveSet
+  {
+    std::vector<uint32_t> m_ues;    //!< Dense indexes of the UEs with data buffered
+    std::vector<uint32_t> m_pos;    //!< Position of each UE in m_ues (UINT32_MAX if not there)
+    std::vector<uint32_t> m_buffer; //!< Total bytes buffered by each UE
+  };
+
+  /**
+   * \brief Recompute the buffer of a UE and add or remove it from an active set
+   * \param set the active set
+   * \param ue the UE whose buffer has changed
+   * \param GetLCGFn Function to retrieve the LCG of the UE in the set direction
+   */
+  void UpdateActiveSet (ActiveSet *set, const UePtr &ue,
+                        const NrMacSchedulerUeInfo::GetLCGFn &GetLCGFn) const;
+  /**
+   * \brief Remove a UE from an active set, if it is there
+   * \param set the active set
+   * \param ueIndex the dense index of the UE
+   */
+  static void RemoveFromActiveSet (ActiveSet *set, uint32_t ueIndex);
+  /**
+   * \brief The DL buffer of a UE has changed
+   * \param ue the UE
+   */
+  void UpdateDlActiveSet (const UePtr &ue) const
+  {
+    UpdateActiveSet (&m_dlActive, ue, &NrMacSchedulerUeInfo::GetDlLCG);
+  }
+  /**
+   * \brief The UL buffer of a UE has changed
+   * \param ue the UE
+   */
+  void UpdateUlActiveSet (const UePtr &ue) const
+  {
+    UpdateActiveSet (&m_ulActive, ue, &NrMacSchedulerUeInfo::GetUlLCG);
+  }
+
   template<typename T>
   void ProcessHARQFeedbacks (std::vector<T> *harqInfo,
                              const NrMacSchedulerUeInfo::GetHarqVectorFn &GetHarqVectorFn,
                              const std::string &direction) const;
 
+  template<typename T>
+  void RemoveStaleHARQFeedbacks (std::vector<T> *harqInfo, uint64_t firstReceived,
+                                 const NrMacSchedulerUeInfo::GetHarqVectorFn &GetHarqVectorFn,
+                                 const std::string &direction) const;
+
+  /**
+   * \brief A HARQ process of a UE has been preempted (PreemptOldestHarq)
+   * \param rnti RNTI of the UE
+   * \param isDl true for a DL process, false for UL
+   * \param id ID of the process
+   * \param process the process, before it is erased
+   */
+  void NotifyHarqPreemption (uint16_t rnti, bool isDl, uint8_t id, const HarqProcess &process);
+
   void
   ScheduleDl (const NrMacSchedSapProvider::SchedDlTriggerReqParameters& params,
               const std::vector <DlHarqInfo> &dlHarqInfo);
@@ -864,7 +1063,8 @@ private:
                           std::deque<VarTtiAllocInfo> *allocations) const;
 
 
-  void ComputeActiveUe (ActiveUeMap *activeDlUe, const NrMacSchedulerUeInfo::GetLCGFn &GetLCGFn,
+  void ComputeActiveUe (ActiveUeMap *activeDlUe, const ActiveSet &activeSet,
+                        const NrMacSchedulerUeInfo::GetLCGFn &GetLCGFn,
                         const NrMacSchedulerUeInfo::GetHarqVectorFn &GetHarqVector,
                         const std::string &mode) const;
   void ComputeActiveHarq (ActiveHarqMap *activeDlHarq, const std::vector <DlHarqInfo> &dlHarqFeedback) const;
@@ -890,6 +1090,76 @@ private:
   //Configured Grant
   void DoScheduleUlresources_configuredGrant (PointInFTPlane *spoint, const std::list<uint16_t> &rntiList) const;
 
+  /**
+   * \brief Load the buffers of the UEs that have a CG occasion in the slot, from the CG planner
+   * \param ulSfn the UL slot
+   */
+  void DoScheduleUlCgOccasions (const SfnSf &ulSfn) const;
+
+  /**
+   * \brief Put the CG bytes in the UL LCG of the UE containing the CG LC
+   * \param rnti RNTI of the UE
+   * \param bytes bytes to put (as if reported in a BSR)
+   */
+  void LoadCgBuffer (uint16_t rnti, uint32_t bytes) const;
+
+  /**
+   * \brief Size of a CG allocation for a buffer
+   * \param bufSize bytes reported in the CGR
+   * \return the bytes, with RLC/MAC overhead, rounded up to a BSR level
+   * (long or short, see the CgLongBsrLevels attribute)
+   */
+  uint32_t GetCgBufferSize (uint32_t bufSize) const;
+
+  /**
+   * \brief RLC/MAC overhead added by GetCgBufferSize
+   * \return the overhead in bytes
+   */
+  uint32_t GetCgOverhead () const;
+
+  /**
+   * \brief Convert a BSR level into bytes
+   * \param level the BSR level
+   * \param longBsr true for a long BSR level, false for a short BSR one
+   * \return the buffer size
+   */
+  static uint64_t FromBsrLevelToBytes (uint8_t level, bool longBsr);
+
+  /**
+   * \brief Convert bytes into a BSR level
+   * \param bytes the buffer size
+   * \param longBsr true for a long BSR level, false for a short BSR one
+   * \return the BSR level
+   */
+  static uint8_t FromBytesToBsrLevel (uint64_t bytes, bool longBsr);
+
+  /**
+   * \brief Add to the CG planner the UEs of a CGR that are not yet in it
+   * \param params the CGR information
+   *
+   * The occasions are placed only in the UL and F slots of the TDD pattern,
+   * the ones for which the UL scheduling runs.
+   */
+  void PlanCgFlows (const NrMacSchedSapProvider::SchedUlCgrInfoReqParameters &params);
+
+  /**
+   * \brief Admit the CG flows of a CGR
+   * \param params the CGR information
+   * \return the CGR information of the admitted UEs, with the sizes of the
+   * downgraded ones reduced
+   *
+   * The UEs that already have an admitted flow with the same period are not
+   * evaluated again: their CGR size is only limited to the granted one.
+   */
+  NrMacSchedSapProvider::SchedUlCgrInfoReqParameters
+  AdmitCgFlows (const NrMacSchedSapProvider::SchedUlCgrInfoReqParameters &params);
+
+  /**
+   * \param periodMs a CG period, in ms
+   * \return the period in slots (at least 1)
+   */
+  uint32_t GetCgPeriodInSlots (uint32_t periodMs) const;
+
 protected:
   std::vector<uint64_t> ageList;
   /**
@@ -911,6 +1181,16 @@ protected:
 
 private:
   std::unordered_map<uint16_t, std::shared_ptr<NrMacSchedulerUeInfo> > m_ueMap; //!< The map of between RNTI and their data
+  /**
+   * \brief Dense UE registry: the UEs of m_ueMap, stored contiguously
+   *
+   * Per-slot passes scan this vector linearly, and per-report handlers
+   * reach a UE through m_rntiToUeIndex, without hashing.
+   */
+  std::vector<UePtr> m_ueVector;
+  std::vector<uint32_t> m_rntiToUeIndex; //!< Dense index in m_ueVector of each RNTI (UINT32_MAX if not registered)
+  mutable ActiveSet m_dlActive; //!< UEs with DL data
+  mutable ActiveSet m_ulActive; //!< UEs with UL data
   /**
    * Map of previous allocated UE per RBG
    * (used to retrieve info from UL-CQI)
@@ -950,17 +1230,32 @@ private:
   uint32_t m_srsSlotCounter {0}; //!< Counter for UL slots
 
   friend NrSchedGeneralTestCase;
+  friend NrLcQosAssignmentTestCase;
+  friend NrUlFrequencySelectiveTestCase;
 
   bool m_enableHarqReTx  {true}; //!< Flag to enable or disable HARQ ReTx (attribute)
+  bool m_preemptOldestHarq {false}; //!< Preempt the oldest HARQ process when the vector is full (attribute)
  
  //Configured Grant
 
   uint8_t m_dlDataSymbolsF {0}; //!< DL Data symbols (attribute)
-  std::list<uint32_t> m_bufCgr;  //!< List of BufSize of UEs that asked for a CGR
-  uint8_t m_lcid_configuredGrant;
-  std::list<uint8_t> m_cgrTraffP;
+  std::unordered_map<uint16_t, uint32_t> m_bufCgr;  //!< BufSize of the UEs that asked for a CGR, by RNTI
+  uint8_t m_lcid_configuredGrant {UINT8_MAX}; //!< LCID of the configured-grant traffic (UINT8_MAX if not configured)
+
+  AssignBytesToLCFn m_assignBytesToLC {&NrMacSchedulerNs3::AssignBytesToLCEvenly}; //!< Method used by AssignBytesToLC
+  std::unordered_map<uint16_t, uint8_t> m_cgrTraffP; //!< Traffic period of the UEs that asked for a CGR, by RNTI
   bool m_cgScheduling;
 
+  bool m_cgPlannerEnabled {false};        //!< Schedule the CG occasions from the hyperperiod layout (attribute)
+  NrMacSchedulerCgPlanner m_cgPlanner;    //!< Layout of the CG occasions
+
+  bool m_cgAdmissionEnabled {false};      //!< Admission control of the CG flows (attribute)
+  double m_cgMinDowngrade {0.5};          //!< Minimum fraction of a CGR that a downgrade grants (attribute)
+  bool m_cgLongBsrLevels {false};         //!< Round the CG allocations to long BSR levels (attribute)
+  NrMacSchedulerCgAdmission m_cgAdmission; //!< Utilization model of the CG flows
+  std::unordered_map<uint16_t, uint32_t> m_cgGranted; //!< CGR bytes granted to the admitted UEs
+  TracedCallback<uint16_t, uint8_t, uint32_t, uint32_t, double> m_cgAdmissionTrace; //!< CG admission decisions
+
 };
 
 } //namespace ns3
@@ -137,6 +137,12 @@ void NrMacSchedulerOfdmaPF::NotAssignedUlResources (const NrMacSchedulerNs3::UeP
   uePtr->UpdateUlPFMetric (totAssigned, m_timeWindow, m_ulAmc);
 }
 
+double NrMacSchedulerOfdmaPF::GetUlFsWeight (const UePtrAndBufferReq &ue) const
+{
+  auto uePtr = std::dynamic_pointer_cast<NrMacSchedulerUeInfoPF> (ue.first);
+  return 1.0 / std::max (1E-9, uePtr->m_avgTputUl);
+}
+
 void NrMacSchedulerOfdmaPF::BeforeDlSched (const UePtrAndBufferReq &ue,
                                           const FTResources &assignableInIteration) const
 {
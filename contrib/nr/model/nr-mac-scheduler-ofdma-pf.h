@@ -171,6 +171,13 @@ protected:
                                        const FTResources &notAssigned,
                                        const FTResources &totalAssigned) const override;
 
+  /**
+   * \brief PF weight of the UE in the frequency-selective UL allocation
+   * \param ue the UE
+   * \return the inverse of the average UL throughput of the UE
+   */
+  virtual double GetUlFsWeight (const UePtrAndBufferReq &ue) const override;
+
   /**
    * \brief Calculate the potential throughput for the DL based on the available resources
    * \param ue UE to which a rgb has been assigned
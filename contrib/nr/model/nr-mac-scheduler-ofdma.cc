@@ -27,7 +27,9 @@
 
 #include "nr-mac-scheduler-ofdma.h"
 #include <ns3/log.h>
+#include <ns3/boolean.h>
 #include <algorithm>
+#include <queue>
 #include "math.h"
 
 namespace ns3 {
@@ -51,6 +53,12 @@ NrMacSchedulerOfdma::GetTypeId (void)
                     MakeUintegerAccessor (&NrMacSchedulerOfdma::SetScheduler,
                                           &NrMacSchedulerOfdma::GetScheduler),
                     MakeUintegerChecker<uint8_t> ())
+     .AddAttribute ("UlFrequencySelective",
+                    "Assign the UL RBGs by policy weight and per-RBG rate (from the sub-band "
+                    "UL CQI), with a non-contiguous RBG mask. Only with schOFDMA equal to 1",
+                    BooleanValue (false),
+                    MakeBooleanAccessor (&NrMacSchedulerOfdma::m_ulFreqSelective),
+                    MakeBooleanChecker ())
   ;
   return tid;
 }
@@ -680,6 +688,13 @@ NrMacSchedulerOfdma::AssignULRBG (uint32_t symAvail, const ActiveUeMap &activeUl
             {
               BeforeUlSched (ue, FTResources (rbgAssignable * beamSym, beamSym));
             }
+
+          if (m_ulFreqSelective)
+            {
+              AssignUlRbgFrequencySelective (beamSym, ueVector);
+              continue;
+            }
+
           NS_LOG_INFO("UE 정렬 전: ");
           for (const auto& ue : ueVector) {
               uint16_t rnti = ue.first->m_rnti;
@@ -1297,6 +1312,11 @@ NrMacSchedulerOfdma::CreateUlDci (PointInFTPlane *spoint,
 {
   NS_LOG_FUNCTION (this);
 
+  if (! ueInfo->m_ulRbgMask.empty ())
+    {
+      return CreateUlFrequencySelectiveDci (spoint, ueInfo);
+    }
+
   uint32_t tbs = m_ulAmc->CalculateTbSize (ueInfo->m_ulMcs,
                                            ueInfo->m_ulRBG * GetNumRbPerRbg ());
 
@@ -1404,6 +1424,11 @@ NrMacSchedulerOfdma::CreateUlCGConfig (PointInFTPlane *spoint,
 {
   NS_LOG_FUNCTION (this);
 
+  if (! ueInfo->m_ulRbgMask.empty ())
+    {
+      return CreateUlFrequencySelectiveDci (spoint, ueInfo);
+    }
+
   uint32_t tbs = m_ulAmc->CalculateTbSize (ueInfo->m_ulMcs,
                                            ueInfo->m_ulRBG * GetNumRbPerRbg ());
 
@@ -1503,6 +1528,150 @@ NrMacSchedulerOfdma::CreateUlCGConfig (PointInFTPlane *spoint,
   return dci;
 }
 
+double
+NrMacSchedulerOfdma::GetUlFsWeight ([[maybe_unused]] const UePtrAndBufferReq &ue) const
+{
+  return 1.0;
+}
+
+double
+NrMacSchedulerOfdma::GetUlRbgRate (const std::shared_ptr<NrMacSchedulerUeInfo> &ue, uint32_t rbg) const
+{
+  uint8_t mcs = ue->m_ulMcs;
+  const auto & ulCqi = ue->m_ulCqi;
+  if (rbg < ulCqi.m_numSb && ulCqi.m_sbReported[rbg])
+    {
+      mcs = ulCqi.m_sbMcs[rbg];
+    }
+  return m_ulAmc->CalculateTbSize (mcs, GetNumRbPerRbg ());
+}
+
+void
+NrMacSchedulerOfdma::AssignUlRbgFrequencySelective (uint32_t beamSym,
+                                                    const std::vector<UePtrAndBufferReq> &ueVector) const
+{
+  NS_LOG_FUNCTION (this);
+  GetFirst GetUe;
+
+  const uint32_t numRbg = GetBandwidthInRbg ();
+  const std::vector<uint8_t> ulNotchedRBGsMask = GetUlNotchedRbgMask ();
+  FTResources assigned (0, 0);
+
+  auto isSatisfied = [&GetUe] (const UePtrAndBufferReq &ue)
+    {
+      return GetUe (ue)->m_ulTbSize >= std::max (ue.second, 7U);
+    };
+
+  // Best (score, UE index) for a RBG, among the UEs that still need resources
+  auto bestFor = [&] (uint32_t rbg) -> std::pair<double, size_t>
+    {
+      std::pair<double, size_t> best (-1.0, ueVector.size ());
+      for (size_t i = 0; i < ueVector.size (); ++i)
+        {
+          if (isSatisfied (ueVector[i]))
+            {
+              continue;
+            }
+          double score = GetUlFsWeight (ueVector[i]) * GetUlRbgRate (GetUe (ueVector[i]), rbg);
+          if (score > best.first)
+            {
+              best = std::make_pair (score, i);
+            }
+        }
+      return best;
+    };
+
+  // Max-heap of (score, RBG); a score is re-evaluated when popped, since the
+  // weights and the needs of the UEs change with each assignment
+  std::priority_queue<std::pair<double, uint32_t> > heap;
+  for (uint32_t rbg = 0; rbg < numRbg; ++rbg)
+    {
+      if (ulNotchedRBGsMask.size () > 0 && ulNotchedRBGsMask.at (rbg) != 1)
+        {
+          continue;
+        }
+      auto best = bestFor (rbg);
+      if (best.second == ueVector.size ())
+        {
+          return; // nobody needs resources
+        }
+      heap.emplace (best.first, rbg);
+    }
+
+  while (! heap.empty ())
+    {
+      double score = heap.top ().first;
+      uint32_t rbg = heap.top ().second;
+      heap.pop ();
+
+      auto best = bestFor (rbg);
+      if (best.second == ueVector.size ())
+        {
+          break; // all the UEs have their requirements fulfilled
+        }
+      if (best.first < score && ! heap.empty () && best.first < heap.top ().first)
+        {
+          heap.emplace (best.first, rbg); // stale score: another RBG is better now
+          continue;
+        }
+
+      const UePtrAndBufferReq & ue = ueVector[best.second];
+      if (GetUe (ue)->m_ulRbgMask.empty ())
+        {
+          GetUe (ue)->m_ulRbgMask.assign (numRbg, 0);
+        }
+      GetUe (ue)->m_ulRbgMask[rbg] = 1;
+      GetUe (ue)->m_ulRBG += beamSym;
+      GetUe (ue)->m_ulSym = beamSym;
+      assigned.m_rbg += beamSym;
+      assigned.m_sym = beamSym;
+
+      NS_LOG_DEBUG ("Assigned UL RBG " << rbg << " (score " << best.first <<
+                    "), spanned over " << beamSym << " SYM, to UE " << GetUe (ue)->m_rnti);
+      AssignedUlResources (ue, FTResources (beamSym, beamSym), assigned);
+
+      // Update metrics for the unsuccessful UEs (who did not get this RBG)
+      for (const auto & other : ueVector)
+        {
+          if (GetUe (other)->m_rnti != GetUe (ue)->m_rnti)
+            {
+              NotAssignedUlResources (other, FTResources (beamSym, beamSym), assigned);
+            }
+        }
+    }
+}
+
+std::shared_ptr<DciInfoElementTdma>
+NrMacSchedulerOfdma::CreateUlFrequencySelectiveDci (PointInFTPlane *spoint,
+                                                    const std::shared_ptr<NrMacSchedulerUeInfo> &ueInfo) const
+{
+  NS_LOG_FUNCTION (this);
+  NS_ASSERT (ueInfo->m_ulRbgMask.size () == GetBandwidthInRbg ());
+
+  uint32_t tbs = m_ulAmc->CalculateTbSize (ueInfo->m_ulMcs,
+                                           ueInfo->m_ulRBG * GetNumRbPerRbg ());
+
+  //Due to MIMO implementation MCS, TB size, ndi, rv, are vectors
+  std::vector<uint8_t> ulMcs = {ueInfo->m_ulMcs};
+  std::vector<uint32_t> ulTbs = {tbs};
+  std::vector<uint8_t> ndi = {1};
+  std::vector<uint8_t> rv = {0};
+
+  // All the UEs of the beam share its symbols: the starting point does not move
+  std::shared_ptr<DciInfoElementTdma> dci = std::make_shared<DciInfoElementTdma>
+      (ueInfo->m_rnti, DciInfoElementTdma::UL, spoint->m_sym, (ueInfo->m_ulSym), ulMcs,
+       ulTbs, ndi, rv, DciInfoElementTdma::DATA, GetBwpId (), GetTpc());
+
+  dci->m_rbgBitmask = ueInfo->m_ulRbgMask;
+
+  NS_LOG_INFO ("UE " << ueInfo->m_rnti << " assigned " <<
+               std::count (dci->m_rbgBitmask.begin (), dci->m_rbgBitmask.end (), 1) <<
+               " UL RBG (frequency-selective) for " <<
+               static_cast<uint32_t> (ueInfo->m_ulSym) << " SYM.");
+
+  return dci;
+}
+
 void
 NrMacSchedulerOfdma::SetScheduler (uint8_t v)
 {
@@ -23,6 +23,8 @@
 
 namespace ns3 {
 
+class NrUlFrequencySelectiveTestCase;
+
 /**
  * \ingroup scheduler
  * \brief The base for all the OFDMA schedulers
@@ -48,6 +50,14 @@ namespace ns3 {
  * The OFDMA scheduling is only done in downlink. In uplink, the division in
  * time is used, and therefore the class is based on top of NrMacSchedulerTdma.
  *
+ * With the attribute UlFrequencySelective (and schOFDMA equal to 1), the UL
+ * RBGs of a beam are not handed out contiguously: each RBG goes to the UE
+ * that maximizes the policy weight (GetUlFsWeight()) times the rate that the
+ * UE can achieve on that RBG, as given by its sub-band UL CQI. The choice is
+ * done greedily, taking the RBGs from a max-heap ordered by their best score,
+ * and the UL DCI carries the resulting (possibly non-contiguous) RBG mask,
+ * as allowed by the CP-OFDM resource allocation type 0.
+ *
  * The implementation details to construct a slot like the one showed before
  * are in the functions AssignDLRBG() and AssignULRBG().
  * The choice of the UEs to be scheduled is, however, demanded to the subclasses.
@@ -121,11 +131,54 @@ protected:
   CreateUlCGConfig (PointInFTPlane *spoint, const std::shared_ptr<NrMacSchedulerUeInfo> &ueInfo,
                uint32_t maxSym) const override;
 
+  /**
+   * \brief Policy weight of an UE in the frequency-selective UL allocation
+   * \param ue the UE
+   * \return the weight that multiplies the per-RBG rate of the UE (default 1.0,
+   * i.e., maximum rate)
+   */
+  virtual double GetUlFsWeight (const UePtrAndBufferReq &ue) const;
+
 private:
+  /**
+   * \brief Assign the UL RBGs of a beam, frequency-selective
+   * \param beamSym symbols of the beam
+   * \param ueVector UEs of the beam
+   *
+   * Fill m_ulRBG, m_ulSym and m_ulRbgMask of the UEs, in the same units of
+   * the contiguous allocation (one RBG for each symbol of the beam).
+   */
+  void AssignUlRbgFrequencySelective (uint32_t beamSym, const std::vector<UePtrAndBufferReq> &ueVector) const;
+
+  /**
+   * \brief Achievable rate of an UE in an UL RBG
+   * \param ue the UE
+   * \param rbg the RBG index
+   * \return the TBS of one RBG at the sub-band MCS of the RBG (or at the wideband MCS, if unknown)
+   *
+   * The sub-band and the wideband MCS come from the same AMC model (see
+   * NrMacSchedulerCQIManagement::UlSBCQIReported), so the rates of all the
+   * RBGs can be compared.
+   */
+  double GetUlRbgRate (const std::shared_ptr<NrMacSchedulerUeInfo> &ue, uint32_t rbg) const;
+
+  /**
+   * \brief Create the UL DCI (or CG configuration) for the RBG mask chosen by the frequency-selective allocation
+   * \param spoint Starting point
+   * \param ueInfo UE representation
+   * \return the DCI
+   */
+  std::shared_ptr<DciInfoElementTdma>
+  CreateUlFrequencySelectiveDci (PointInFTPlane *spoint, const std::shared_ptr<NrMacSchedulerUeInfo> &ueInfo) const;
+
 
   TracedValue<uint32_t> m_tracedValueSymPerBeam;
 
   // Configured Grant
   uint8_t m_schType_OFDMA {1}; //!<
+
+  bool m_ulFreqSelective {false}; //!< Frequency-selective UL allocation (attribute)
+
+  friend NrUlFrequencySelectiveTestCase;
 };
 } // namespace ns3
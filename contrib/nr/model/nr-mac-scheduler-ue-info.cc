@@ -99,13 +99,13 @@ NrMacSchedulerUeInfo::GetUlTBS (const UePtr &ue)
   return ue->m_ulTbSize;
 }
 
-std::unordered_map<uint8_t, LCGPtr> &
+LCGMap &
 NrMacSchedulerUeInfo::GetDlLCG (const UePtr &ue)
 {
   return ue->m_dlLCG;
 }
 
-std::unordered_map<uint8_t, LCGPtr> &
+LCGMap &
 NrMacSchedulerUeInfo::GetUlLCG (const UePtr &ue)
 {
   return ue->m_ulLCG;
@@ -142,6 +142,7 @@ NrMacSchedulerUeInfo::ResetUlSchedInfo ()
   m_ulRBG = 0;
   m_ulSym = 0;
   m_ulTbSize = 0;
+  m_ulRbgMask.clear ();
 }
 
 
@@ -22,6 +22,8 @@
 #include "nr-mac-harq-vector.h"
 #include "nr-mac-scheduler-lcg.h"
 #include "nr-amc.h"
+#include <array>
+#include <bitset>
 #include <unordered_map>
 #include <functional>
 #include "beam-conf-id.h"
@@ -146,13 +148,13 @@ public:
    * \param ue UE pointer from which obtain the value
    * \return
    */
-  static std::unordered_map<uint8_t, LCGPtr> & GetDlLCG (const UePtr &ue);
+  static LCGMap & GetDlLCG (const UePtr &ue);
   /**
    * \brief GetUlLCG
    * \param ue UE pointer from which obtain the value
    * \return
    */
-  static std::unordered_map<uint8_t, LCGPtr> & GetUlLCG (const UePtr &ue);
+  static LCGMap & GetUlLCG (const UePtr &ue);
   /**
    * \brief GetDlHarqVector
    * \param ue UE pointer from which obtain the value
@@ -166,7 +168,7 @@ public:
    */
   static NrMacHarqVector & GetUlHarqVector (const UePtr &ue);
 
-  typedef std::function<std::unordered_map<uint8_t, LCGPtr> &(const UePtr &ue)> GetLCGFn;
+  typedef std::function<LCGMap &(const UePtr &ue)> GetLCGFn;
   typedef std::function<NrMacHarqVector& (const UePtr &ue)> GetHarqVectorFn;
 
   /**
@@ -231,10 +233,20 @@ public:
       SB              //!< Sub-band
     } m_cqiType {WB}; //!< CQI type
 
+    /**
+     * \brief Maximum number of sub-bands (one per RBG: with one RB per RBG, 275 RB)
+     */
+    static const uint16_t MAX_SUBBANDS = 275;
+
     std::vector<double> m_sinr;   //!< Vector of SINR for the entire band
     std::vector<int16_t> m_rbCqi; //!< CQI for each Rsc Block, set to -1 if SINR < Threshold
     uint8_t m_cqi    {0};  //!< CQI reported value
-    uint32_t m_timer {0};  //!< Timer (in slot number). When the timer is 0, the value is discarded
+    uint32_t m_timer {0};  //!< Validity (in slots) given to the last reported value. When it elapses, the value is discarded
+    uint64_t m_expiry {0}; //!< Refresh count at which the last reported value expires (see NrMacSchedulerCQIManagement)
+    std::array<uint8_t, MAX_SUBBANDS> m_sbCqi {}; //!< Last CQI of each sub-band (RBG)
+    std::array<uint8_t, MAX_SUBBANDS> m_sbMcs {}; //!< Last MCS of each sub-band (RBG), with the AMC model of the wideband MCS
+    std::bitset<MAX_SUBBANDS> m_sbReported;       //!< Sub-bands with a CQI and MCS reported
+    uint16_t m_numSb {0};  //!< Number of valid entries in m_sbCqi
   };
 
   /**
@@ -254,14 +266,15 @@ public:
     uint8_t m_ri    {0}; //!< The rank indicator, by default UE would have only one stream
     std::vector<double> m_sinr;   //!< Vector of SINR for the entire band
     std::vector<uint8_t> m_wbCqi; //!< CQI for each stream
-    uint32_t m_timer {0};  //!< Timer (in slot number). When the timer is 0, the value is discarded
+    uint32_t m_timer {0};  //!< Validity (in slots) given to the last reported value. When it elapses, the value is discarded
+    uint64_t m_expiry {0}; //!< Refresh count at which the last reported value expires (see NrMacSchedulerCQIManagement)
   };
 
   uint16_t m_rnti {0};          //!< RNTI of the UE
   BeamConfId   m_beamConfId;    //!< Beam ID of the UE (kept updated as much as possible by MAC)
 
-  std::unordered_map<uint8_t, LCGPtr> m_dlLCG;//!< DL LCG
-  std::unordered_map<uint8_t, LCGPtr> m_ulLCG;//!< UL LCG
+  LCGMap m_dlLCG;//!< DL LCG
+  LCGMap m_ulLCG;//!< UL LCG
 
   uint32_t        m_dlMRBRetx {0};  //!< MRB assigned for retx. To update the name, what is MRB is not defined
   uint32_t        m_ulMRBRetx {0};  //!< MRB assigned for retx. To update the name, what is MRB is not defined
@@ -269,6 +282,7 @@ public:
   uint32_t        m_ulRBG     {0};  //!< UL Resource Block Group assigned in this slot
   uint8_t         m_dlSym     {0};  //!< Number of (new data) symbols assigned in this slot.
   uint8_t         m_ulSym     {0};  //!< Number of (new data) symbols assigned in this slot.
+  std::vector<uint8_t> m_ulRbgMask; //!< UL RBG chosen by the frequency-selective OFDMA scheduler in this slot (empty if not used)
 
   std::vector<uint8_t> m_dlMcs;  //!< DL MCS per stream, it is initialized with a starting MCS upon UE addition to gNB and the scheduler
   uint8_t m_ulMcs     {0};  //!< UL MCS
@@ -27,6 +27,7 @@
 #include <ns3/string.h>
 #include <ns3/attribute-accessor-helper.h>
 #include <algorithm>
+#include <cmath>
 
 namespace ns3 {
 
@@ -146,7 +147,11 @@ std::ostream &operator<< (std::ostream &os, const DlHarqInfo &item)
 
 std::ostream &operator<< (std::ostream &os, const UlHarqInfo &item)
 {
-  if (item.IsReceivedOk ())
+  if (item.m_receptionStatus == UlHarqInfo::Dtx)
+    {
+      os << "DTX feedback ";
+    }
+  else if (item.IsReceivedOk ())
     {
       os << "ACK feedback ";
     }
@@ -291,4 +296,22 @@ std::ostream &operator<< (std::ostream &os, const DciInfoElementTdma &item)
   return os;
 }
 
+uint32_t
+NrCgTrafficProfile::GetGrantSize (uint32_t bufSize) const
+{
+  if (m_maxSize == 0)
+    {
+      return bufSize;
+    }
+  NS_ASSERT (m_minSize <= m_maxSize);
+  NS_ASSERT (m_sizeQuantile >= 0.0 && m_sizeQuantile <= 1.0);
+  return m_minSize + static_cast<uint32_t> (std::ceil (m_sizeQuantile * (m_maxSize - m_minSize)));
+}
+
+Time
+NrCgTrafficProfile::GetSchedulingDeadline () const
+{
+  return m_deadline > m_jitter ? m_deadline - m_jitter : Time (0);
+}
+
 }
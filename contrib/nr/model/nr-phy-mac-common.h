@@ -597,7 +597,8 @@ struct UlHarqInfo : public HarqInfo
 
   enum ReceptionStatus
   {
-    Ok, NotOk, NotValid
+    Ok, NotOk, NotValid,
+    Dtx   //!< The UE did not transmit the TB (e.g., skipped CG occasion): nothing to retransmit
   } m_receptionStatus;
 
   uint8_t m_tpc {UINT8_MAX};       //!< Transmit Power Control
@@ -605,7 +606,8 @@ struct UlHarqInfo : public HarqInfo
 
   virtual bool IsReceivedOk () const override
   {
-    return m_receptionStatus == Ok;
+    // A DTX releases the process as an ACK does
+    return m_receptionStatus == Ok || m_receptionStatus == Dtx;
   }
 
   std::vector<uint8_t> GetNackStreamIndexes ()
@@ -619,6 +621,40 @@ struct UlHarqInfo : public HarqInfo
   }
 };
 
+/**
+ * \ingroup utils
+ * \brief Traffic profile of a configured-grant LC
+ *
+ * It describes the periodic payloads of a LC (e.g., a sensor), so that the
+ * gNB sizes the CG occasions from the profile instead of from the worst
+ * case. The payload sizes are supposed to be uniformly distributed between
+ * m_minSize and m_maxSize; the occasions are sized to fit the fraction
+ * m_sizeQuantile of them.
+ */
+struct NrCgTrafficProfile
+{
+  uint8_t m_period {0};         //!< Period of the payloads, in ms (0: the periodicity reported by the LC)
+  Time m_offset;                //!< Generation time of the payloads after the start of their slot (0: measured)
+  Time m_jitter;                //!< Maximum lateness of a payload with respect to its nominal generation time
+  uint32_t m_minSize {0};       //!< Smallest payload, in bytes
+  uint32_t m_maxSize {0};       //!< Largest payload, in bytes (0: the buffer reported in the CGR)
+  double m_sizeQuantile {1.0};  //!< Fraction of the payloads that an occasion has to fit, in [0, 1]
+  Time m_deadline;              //!< Maximum delay of a payload
+
+  /**
+   * \brief Get the bytes of an occasion
+   * \param bufSize buffer reported in the CGR, used when m_maxSize is 0
+   * \return the m_sizeQuantile quantile of the payload size
+   */
+  uint32_t GetGrantSize (uint32_t bufSize) const;
+
+  /**
+   * \return the deadline for the scheduler: m_deadline minus m_jitter
+   * (the payloads can be generated m_jitter late)
+   */
+  Time GetSchedulingDeadline () const;
+};
+
 std::ostream & operator<< (std::ostream & os, DciInfoElementTdma const & item);
 std::ostream & operator<< (std::ostream & os, DciInfoElementTdma::DciFormat const & item);
 std::ostream & operator<< (std::ostream & os, DlHarqInfo const & item);
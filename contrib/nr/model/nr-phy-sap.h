@@ -25,6 +25,7 @@
 #include <ns3/nr-mac-sched-sap.h>
 #include <ns3/nr-control-messages.h>
 #include "beam-conf-id.h"
+#include "nr-cg-config.h"
 
 namespace ns3 {
 
@@ -148,6 +149,18 @@ public:
 
   // Configured Grant
   virtual Time GetTbUlEncodeLatency () const = 0;
+
+  /**
+   * \brief Retrieve the TDD pattern
+   * \return the type of each slot of the pattern
+   */
+  virtual std::vector<LteNrTddSlotType> GetTddPattern () const = 0;
+
+  /**
+   * \brief Share the configured-grant configuration of the UE with the PHY
+   * \param config the configuration (the PHY keeps the pointer, the object is never modified)
+   */
+  virtual void SetCgConfig (const std::shared_ptr<const NrCgConfig> &config) = 0;
 };
 
 /**
@@ -75,6 +75,10 @@ public:
   // Configured Grant
   virtual Time GetTbUlEncodeLatency () const override;
 
+  virtual std::vector<LteNrTddSlotType> GetTddPattern () const override;
+
+  virtual void SetCgConfig (const std::shared_ptr<const NrCgConfig> &config) override;
+
 private:
   NrPhy* m_phy;
 };
@@ -164,6 +168,18 @@ NrMemberPhySapProvider::GetTbUlEncodeLatency() const
   return m_phy-> GetTbUlEncodeLatency();
 }
 
+std::vector<LteNrTddSlotType>
+NrMemberPhySapProvider::GetTddPattern () const
+{
+  return m_phy->GetTddPattern ();
+}
+
+void
+NrMemberPhySapProvider::SetCgConfig (const std::shared_ptr<const NrCgConfig> &config)
+{
+  m_phy->SetCgConfig (config);
+}
+
 
 /* ======= */
 
@@ -415,6 +431,22 @@ NrPhy::GetTxPowerSpectralDensity (const std::vector<int> &rbIndexVector, uint8_t
   return NrSpectrumValueHelper::CreateTxPowerSpectralDensity (txPowerPerStreamDbm, rbIndexVector, sm, m_powerAllocationType );
 }
 
+Ptr<SpectrumValue>
+NrPhy::GetTxPowerSpectralDensity (const std::vector<uint8_t> &rbgBitmask, uint8_t activeStreams)
+{
+  NS_LOG_FUNCTION (this);
+  Ptr<const SpectrumModel> sm = GetSpectrumModel ();
+  NS_ASSERT_MSG (activeStreams, "There should be at least one active stream.");
+  double txPowerPerStreamDbm = m_txPower;
+  if (activeStreams > 1)
+    {
+      // Share the total transmission power among active streams
+      txPowerPerStreamDbm = 10 * log10 (pow (10, m_txPower / 10) / activeStreams);
+    }
+  return NrSpectrumValueHelper::GetCachedTxPowerSpectralDensity (txPowerPerStreamDbm, rbgBitmask, GetNumRbPerRbg (),
+                                                                 sm, m_powerAllocationType);
+}
+
 double
 NrPhy::GetCentralFrequency() const
 {
@@ -500,6 +532,12 @@ bool NrPhy::HasUlSlot () const
   return NrPhy::HasUlSlot (m_tddPattern);
 }
 
+const std::vector<LteNrTddSlotType> &
+NrPhy::GetTddPattern () const
+{
+  return m_tddPattern;
+}
+
 bool
 NrPhy::HasDlSlot (const std::vector<LteNrTddSlotType> &pattern)
 {
@@ -928,6 +966,11 @@ NrPhy::SetTbUlEncodeLatency (const Time &us)
   m_tbUlEncodeLatencyUs = us;
 }
 
+void
+NrPhy::SetCgConfig ([[maybe_unused]] const std::shared_ptr<const NrCgConfig> &config)
+{
+}
+
 Time
 NrPhy::GetTbUlEncodeLatency (void) const
 {
@@ -363,6 +363,12 @@ public:
    */
   bool HasUlSlot () const;
 
+  /**
+   * \brief Get the TDD pattern
+   * \return the type of each slot of the pattern
+   */
+  const std::vector<LteNrTddSlotType> & GetTddPattern () const;
+
   /**
    * \brief See if at least one slot is DL or F.
    *
@@ -417,6 +423,15 @@ public:
   virtual Time GetTbUlEncodeLatency () const;
   virtual void SetTbUlEncodeLatency (const Time &us);
 
+  /**
+   * \brief Set the configured-grant configuration shared by the MAC
+   * \param config the configuration
+   *
+   * The default implementation ignores it; the UE PHY uses it to insert the
+   * allocations of the CG occasions.
+   */
+  virtual void SetCgConfig (const std::shared_ptr<const NrCgConfig> &config);
+
 protected:
   /**
    * \brief DoDispose method inherited from Object
@@ -495,6 +510,15 @@ protected:
    */
   Ptr<SpectrumValue> GetTxPowerSpectralDensity (const std::vector<int> &rbIndexVector, uint8_t activeStreams);
 
+  /**
+   * Get the Tx Power Spectral Density of a transmission from its RBG bitmask
+   * \param rbgBitmask the RBG bitmask of the transmission
+   * \param activeStreams the number of active streams
+   * \return A shared SpectrumValue, that must not be modified
+   * \see NrSpectrumValueHelper::GetCachedTxPowerSpectralDensity
+   */
+  Ptr<SpectrumValue> GetTxPowerSpectralDensity (const std::vector<uint8_t> &rbgBitmask, uint8_t activeStreams);
+
   /**
    * \brief Store the slot allocation info at the front
    * \param slotAllocInfo the allocation to store
@@ -0,0 +1,176 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#include "nr-profiler.h"
+
+#include <ns3/log.h>
+#include <ns3/simulator.h>
+#include <fstream>
+#include <algorithm>
+
+namespace ns3 {
+
+NS_LOG_COMPONENT_DEFINE ("NrProfiler");
+
+bool NrProfiler::m_enabled = false;
+std::array<NrProfiler::StageStats, NrProfiler::NUM_STAGES> NrProfiler::m_stats;
+std::string NrProfiler::m_filename;
+Time NrProfiler::m_reportPeriod;
+bool NrProfiler::m_firstWrite = true;
+std::chrono::steady_clock::time_point NrProfiler::m_enableTime;
+NrProfilerScope *NrProfilerScope::m_current = nullptr;
+
+void
+NrProfiler::Enable (const std::string &filename, const Time &reportPeriod)
+{
+  NS_LOG_FUNCTION (filename << reportPeriod);
+  if (m_enabled)
+    {
+      NS_LOG_WARN ("NrProfiler already enabled");
+      return;
+    }
+
+  m_enabled = true;
+  m_filename = filename;
+  m_reportPeriod = reportPeriod;
+  m_firstWrite = true;
+  m_enableTime = std::chrono::steady_clock::now ();
+  Reset ();
+
+  if (m_reportPeriod.IsStrictlyPositive ())
+    {
+      Simulator::Schedule (m_reportPeriod, &NrProfiler::PeriodicReport);
+    }
+  Simulator::ScheduleDestroy (&NrProfiler::FinalReport);
+}
+
+void
+NrProfiler::Record (Stage stage, uint64_t ns, uint64_t selfNs)
+{
+  NS_ASSERT (stage < NUM_STAGES);
+  NS_ASSERT (selfNs <= ns);
+  StageStats &stats = m_stats[stage];
+  ++stats.m_calls;
+  stats.m_totalNs += ns;
+  stats.m_selfNs += selfNs;
+  stats.m_maxNs = std::max (stats.m_maxNs, ns);
+
+  uint32_t bucket = 0;
+  while (bucket < NUM_BUCKETS - 1 && (ns >> (bucket + 1)) != 0)
+    {
+      ++bucket;
+    }
+  ++stats.m_histogram[bucket];
+}
+
+void
+NrProfiler::Report (std::ostream &os)
+{
+  double wallClock = std::chrono::duration<double> (std::chrono::steady_clock::now () - m_enableTime).count ();
+  os << "% simTime(s) " << Simulator::Now ().GetSeconds ()
+     << " wallClock(s) " << wallClock << std::endl;
+  os << "% times are inclusive: nested stages are also counted in their parents; self excludes them" << std::endl;
+  os << "% stage\tcalls\ttotal(incl,s)\tself(s)\tmean(incl,us)\tmax(incl,us)"
+     << "\thistogram of the calls in [2^i, 2^(i+1)) ns (incl), i = 0.."
+     << NUM_BUCKETS - 1 << std::endl;
+
+  for (uint32_t stage = 0; stage < NUM_STAGES; ++stage)
+    {
+      const StageStats &stats = m_stats[stage];
+      os << GetStageName (static_cast<Stage> (stage)) << "\t";
+      os << stats.m_calls << "\t";
+      os << stats.m_totalNs * 1e-9 << "\t";
+      os << stats.m_selfNs * 1e-9 << "\t";
+      os << (stats.m_calls > 0 ? stats.m_totalNs * 1e-3 / stats.m_calls : 0.0) << "\t";
+      os << stats.m_maxNs * 1e-3;
+      for (uint64_t count : stats.m_histogram)
+        {
+          os << "\t" << count;
+        }
+      os << std::endl;
+    }
+}
+
+void
+NrProfiler::Reset ()
+{
+  m_stats.fill (StageStats ());
+}
+
+std::string
+NrProfiler::GetStageName (Stage stage)
+{
+  switch (stage)
+    {
+    case GNB_PHY_START_SLOT:
+      return "GnbPhyStartSlot";
+    case GNB_MAC_DL_SLOT_INDICATION:
+      return "GnbMacDlSlotIndication";
+    case GNB_MAC_UL_SLOT_INDICATION:
+      return "GnbMacUlSlotIndication";
+    case SCHED_UL_TRIGGER_REQ:
+      return "SchedUlTriggerReq";
+    case SCHED_UL_DATA:
+      return "SchedUlData";
+    case SPECTRUM_START_RX:
+      return "SpectrumStartRx";
+    case SPECTRUM_END_RX:
+      return "SpectrumEndRx";
+    case ERROR_MODEL:
+      return "ErrorModel";
+    case UE_MAC_CG_SLOT_INDICATION:
+      return "UeMacCgSlotIndication";
+    default:
+      NS_FATAL_ERROR ("Unknown stage " << +stage);
+    }
+  return "";
+}
+
+void
+NrProfiler::WriteReport (bool truncate)
+{
+  std::ofstream outFile (m_filename.c_str (), truncate ? std::ios_base::out : std::ios_base::app);
+  if (!outFile.is_open ())
+    {
+      NS_LOG_ERROR ("Can't open file " << m_filename.c_str ());
+      return;
+    }
+  Report (outFile);
+  outFile << std::endl;
+}
+
+void
+NrProfiler::PeriodicReport ()
+{
+  WriteReport (m_firstWrite);
+  m_firstWrite = false;
+  // Do not keep alive a simulation that has nothing else to do
+  if (!Simulator::IsFinished ())
+    {
+      Simulator::Schedule (m_reportPeriod, &NrProfiler::PeriodicReport);
+    }
+}
+
+void
+NrProfiler::FinalReport ()
+{
+  WriteReport (m_firstWrite);
+  m_firstWrite = false;
+  m_enabled = false;
+}
+
+} // namespace ns3
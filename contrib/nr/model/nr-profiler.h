@@ -0,0 +1,204 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <ns3/nstime.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <ostream>
+#include <string>
+
+namespace ns3 {
+
+/**
+ * \ingroup utils
+ * \brief Wall-clock profiler of the per-slot MAC/PHY pipeline
+ *
+ * Each stage of the pipeline is measured by a NrProfilerScope in the
+ * function that implements it. For every stage the profiler keeps the number
+ * of calls, the cumulative and the maximum wall-clock time, and a histogram
+ * of the duration of the calls in power-of-two buckets of nanoseconds. These
+ * times are inclusive: the time of a stage includes the time of the stages
+ * it calls (e.g., the error model is included in the end of the reception),
+ * so the totals of nested stages must not be summed. The self time of each
+ * stage, that excludes the stages it calls, is reported as well.
+ *
+ * The profiler is disabled by default: a disabled NrProfilerScope only reads
+ * a boolean. Call Enable before the simulation starts; the report is written
+ * at Simulator::Destroy and, optionally, periodically in simulation time.
+ * The profiler is not thread-safe: it is meant for the default simulator.
+ */
+class NrProfiler
+{
+public:
+  /**
+   * \brief The stages measured
+   */
+  enum Stage : uint8_t
+  {
+    GNB_PHY_START_SLOT,          //!< NrGnbPhy::StartSlot
+    GNB_MAC_DL_SLOT_INDICATION,  //!< NrGnbMac::DoSlotDlIndication
+    GNB_MAC_UL_SLOT_INDICATION,  //!< NrGnbMac::DoSlotUlIndication
+    SCHED_UL_TRIGGER_REQ,        //!< NrMacSchedulerNs3::DoSchedUlTriggerReq
+    SCHED_UL_DATA,               //!< NrMacSchedulerNs3::DoScheduleUlData
+    SPECTRUM_START_RX,           //!< NrSpectrumPhy::StartRx
+    SPECTRUM_END_RX,             //!< NrSpectrumPhy::EndRxData, EndRxCtrl and EndRxSrs
+    ERROR_MODEL,                 //!< Error model evaluation of a TB, in NrSpectrumPhy::EndRxData
+    UE_MAC_CG_SLOT_INDICATION,   //!< NrUeMac::DoSlotIndication_configuredGrant
+    NUM_STAGES                   //!< Number of stages, not a stage
+  };
+
+  static const uint32_t NUM_BUCKETS = 32; //!< Buckets of the histograms: [2^i, 2^(i+1)) ns, the last one open
+
+  /**
+   * \brief Enable the profiler
+   * \param filename file of the report
+   * \param reportPeriod period of the report, in simulation time (0 for the final report only)
+   *
+   * The periodic report is an event of the simulation: it stops when it is
+   * the last event left, but a simulation with other periodic events (as
+   * the NR slots) ends only with Simulator::Stop.
+   */
+  static void Enable (const std::string &filename = "NrProfiler.txt", const Time &reportPeriod = Seconds (0));
+
+  /**
+   * \return true if the profiler is enabled
+   */
+  static bool IsEnabled ()
+  {
+    return m_enabled;
+  }
+
+  /**
+   * \brief Account a call of a stage
+   * \param stage the stage
+   * \param ns wall-clock duration of the call, in nanoseconds
+   * \param selfNs part of the duration not spent in the stages called
+   */
+  static void Record (Stage stage, uint64_t ns, uint64_t selfNs);
+
+  /**
+   * \brief Write the statistics of all the stages
+   * \param os the output stream
+   */
+  static void Report (std::ostream &os);
+
+  /**
+   * \brief Forget the statistics collected so far
+   */
+  static void Reset ();
+
+  /**
+   * \param stage the stage
+   * \return the name of the stage
+   */
+  static std::string GetStageName (Stage stage);
+
+private:
+  /**
+   * \brief Statistics of a stage
+   */
+  struct StageStats
+  {
+    uint64_t m_calls {0};                          //!< Number of calls
+    uint64_t m_totalNs {0};                        //!< Cumulative duration
+    uint64_t m_selfNs {0};                         //!< Cumulative duration, without the stages called
+    uint64_t m_maxNs {0};                          //!< Longest call
+    std::array<uint64_t, NUM_BUCKETS> m_histogram {}; //!< Duration histogram
+  };
+
+  /**
+   * \brief Append the report to the output file
+   * \param truncate if true, start a new file
+   */
+  static void WriteReport (bool truncate);
+
+  /**
+   * \brief Write the periodic report and schedule the next one
+   */
+  static void PeriodicReport ();
+
+  /**
+   * \brief Write the final report
+   */
+  static void FinalReport ();
+
+  static bool m_enabled;                             //!< True if enabled
+  static std::array<StageStats, NUM_STAGES> m_stats; //!< Statistics, per stage
+  static std::string m_filename;                     //!< Report file
+  static Time m_reportPeriod;                        //!< Period of the report
+  static bool m_firstWrite;                          //!< True if the report file has not been written yet
+  static std::chrono::steady_clock::time_point m_enableTime; //!< Wall clock when enabled
+};
+
+/**
+ * \ingroup utils
+ * \brief Measures a stage of the pipeline, from its construction to its destruction
+ */
+class NrProfilerScope
+{
+public:
+  /**
+   * \brief NrProfilerScope constructor
+   * \param stage the stage measured
+   */
+  explicit NrProfilerScope (NrProfiler::Stage stage)
+    : m_stage (stage),
+      m_active (NrProfiler::IsEnabled ())
+  {
+    if (m_active)
+      {
+        m_parent = m_current;
+        m_current = this;
+        m_start = std::chrono::steady_clock::now ();
+      }
+  }
+
+  /**
+   * \brief ~NrProfilerScope: accounts the call
+   */
+  ~NrProfilerScope ()
+  {
+    if (m_active)
+      {
+        auto elapsed = std::chrono::steady_clock::now () - m_start;
+        uint64_t ns = std::chrono::duration_cast<std::chrono::nanoseconds> (elapsed).count ();
+        NrProfiler::Record (m_stage, ns, ns - std::min (ns, m_childrenNs));
+        if (m_parent != nullptr)
+          {
+            m_parent->m_childrenNs += ns;
+          }
+        m_current = m_parent;
+      }
+  }
+
+  NrProfilerScope (const NrProfilerScope &) = delete;
+  NrProfilerScope & operator= (const NrProfilerScope &) = delete;
+
+private:
+  NrProfiler::Stage m_stage;                      //!< Stage measured
+  bool m_active;                                  //!< True if the profiler was enabled at construction
+  std::chrono::steady_clock::time_point m_start;  //!< Wall clock at construction
+  NrProfilerScope *m_parent {nullptr};            //!< Scope of the calling stage, if any
+  uint64_t m_childrenNs {0};                      //!< Duration of the stages called, in nanoseconds
+
+  static NrProfilerScope *m_current;              //!< Innermost active scope
+};
+
+} // namespace ns3
@@ -18,6 +18,7 @@
  */
 
 #include "nr-spectrum-phy.h"
+#include "nr-profiler.h"
 #include <ns3/boolean.h>
 #include <ns3/double.h>
 #include <ns3/lte-radio-bearer-tag.h>
@@ -345,6 +346,7 @@ void
 NrSpectrumPhy::StartRx (Ptr<SpectrumSignalParameters> params)
 {
   NS_LOG_FUNCTION (this);
+  NrProfilerScope profilerScope (NrProfiler::SPECTRUM_START_RX);
   Ptr <const SpectrumValue> rxPsd = params->psd;
   Time duration = params->duration;
   NS_LOG_INFO ("Start receiving signal: " << rxPsd <<" duration= " << duration);
@@ -799,6 +801,33 @@ NrSpectrumPhy::AddExpectedTb (uint16_t rnti, uint8_t ndi, uint32_t size, uint8_t
                static_cast<uint32_t> (numSym));
 }
 
+bool
+NrSpectrumPhy::CheckExpectedTbDtx (uint16_t rnti, const SfnSf &sfn, uint8_t symStart,
+                                   uint8_t *harqProcessId, uint8_t *rv)
+{
+  NS_LOG_FUNCTION (this << rnti);
+  auto it = m_transportBlocks.find (rnti);
+  if (it == m_transportBlocks.end ())
+    {
+      // Already received and cleared at the end of the reception
+      return false;
+    }
+
+  const ExpectedTb &expected = it->second.m_expected;
+  if (!(expected.m_sfn == sfn) || expected.m_symStart != symStart || it->second.m_rxStarted)
+    {
+      return false;
+    }
+
+  NS_LOG_INFO ("DTX for rnti " << rnti << " at " << sfn << " symstart=" <<
+               static_cast<uint32_t> (symStart) << " harqId=" <<
+               static_cast<uint32_t> (expected.m_harqProcessId));
+  *harqProcessId = expected.m_harqProcessId;
+  *rv = expected.m_rv;
+  m_transportBlocks.erase (it);
+  return true;
+}
+
 void
 NrSpectrumPhy::AddExpectedSrsRnti (uint16_t rnti)
 {
@@ -898,6 +927,19 @@ NrSpectrumPhy::StartRxData (const Ptr<NrSpectrumSignalParametersDataFrame>& para
         if (params->packetBurst && !params->packetBurst->GetPackets ().empty ())
           {
             m_rxPacketBurstList.push_back (params->packetBurst);
+
+            for (const auto & packet : params->packetBurst->GetPackets ())
+              {
+                LteRadioBearerTag bearerTag;
+                if (packet->PeekPacketTag (bearerTag))
+                  {
+                    auto itTb = m_transportBlocks.find (bearerTag.GetRnti ());
+                    if (itTb != m_transportBlocks.end ())
+                      {
+                        itTb->second.m_rxStarted = true;
+                      }
+                  }
+              }
           }
         //NS_LOG_DEBUG (this << " insert msgs " << params->ctrlMsgList.size ());
         m_rxControlMessageList.insert (m_rxControlMessageList.end (), params->ctrlMsgList.begin (), params->ctrlMsgList.end ());
@@ -1123,6 +1165,7 @@ void
 NrSpectrumPhy::EndRxData ()
 {
   NS_LOG_FUNCTION (this);
+  NrProfilerScope profilerScope (NrProfiler::SPECTRUM_END_RX);
   m_interferenceData->EndRx ();
 
   Ptr<NrGnbNetDevice> enbRx = DynamicCast<NrGnbNetDevice> (GetDevice ());
@@ -1159,13 +1202,25 @@ NrSpectrumPhy::EndRxData ()
 
       std::function < const NrErrorModel::NrErrorModelHistory & (uint16_t, uint8_t) > RetrieveHistory;
 
+      // A new TB never combines with the history of its process: the
+      // previous TB may have been dropped (HARQ preemption) before the end
+      // of its retransmissions
+      bool newData = GetTBInfo (tbIt).m_expected.m_ndi == 1;
       if (GetTBInfo (tbIt).m_expected.m_isDownlink)
         {
+          if (newData)
+            {
+              m_harqPhyModule->ResetDlHarqProcessStatus (GetRnti (tbIt), GetTBInfo (tbIt).m_expected.m_harqProcessId);
+            }
           RetrieveHistory = std::bind (&NrHarqPhy::GetHarqProcessInfoDl, m_harqPhyModule,
                                        std::placeholders::_1, std::placeholders::_2);
         }
       else
         {
+          if (newData)
+            {
+              m_harqPhyModule->ResetUlHarqProcessStatus (GetRnti (tbIt), GetTBInfo (tbIt).m_expected.m_harqProcessId);
+            }
           RetrieveHistory = std::bind (&NrHarqPhy::GetHarqProcessInfoUl, m_harqPhyModule,
                                        std::placeholders::_1, std::placeholders::_2);
         }
@@ -1176,19 +1231,23 @@ NrSpectrumPhy::EndRxData ()
       NS_ABORT_MSG_IF (!m_errorModelType.IsChildOf(NrErrorModel::GetTypeId()),
                        "The error model must be a child of NrErrorModel");
 
-      ObjectFactory emFactory;
-      emFactory.SetTypeId (m_errorModelType);
-      Ptr<NrErrorModel> em = DynamicCast<NrErrorModel> (emFactory.Create ());
-      NS_ABORT_IF (em == nullptr);
+      {
+        NrProfilerScope errorModelScope (NrProfiler::ERROR_MODEL);
+
+        ObjectFactory emFactory;
+        emFactory.SetTypeId (m_errorModelType);
+        Ptr<NrErrorModel> em = DynamicCast<NrErrorModel> (emFactory.Create ());
+        NS_ABORT_IF (em == nullptr);
 
-      // Output is the output of the error model. From the TBLER we decide
-      // if the entire TB is corrupted or not
+        // Output is the output of the error model. From the TBLER we decide
+        // if the entire TB is corrupted or not
 
-      GetTBInfo(tbIt).m_outputOfEM = em->GetTbDecodificationStats (m_sinrPerceived,
-                                                                   GetTBInfo(tbIt).m_expected.m_rbBitmap,
-                                                                   GetTBInfo(tbIt).m_expected.m_tbSize,
-                                                                   GetTBInfo(tbIt).m_expected.m_mcs,
-                                                                   harqInfoList);
+        GetTBInfo(tbIt).m_outputOfEM = em->GetTbDecodificationStats (m_sinrPerceived,
+                                                                     GetTBInfo(tbIt).m_expected.m_rbBitmap,
+                                                                     GetTBInfo(tbIt).m_expected.m_tbSize,
+                                                                     GetTBInfo(tbIt).m_expected.m_mcs,
+                                                                     harqInfoList);
+      }
       GetTBInfo (tbIt).m_isCorrupted = m_random->GetValue () > GetTBInfo(tbIt).m_outputOfEM->m_tbler ? false : true;
 
       if (GetTBInfo (tbIt).m_isCorrupted)
@@ -1379,6 +1438,7 @@ void
 NrSpectrumPhy::EndRxCtrl ()
 {
   NS_LOG_FUNCTION (this);
+  NrProfilerScope profilerScope (NrProfiler::SPECTRUM_END_RX);
   NS_ASSERT (m_state == RX_DL_CTRL || m_state == RX_UL_CTRL);
 
   m_interferenceCtrl->EndRx ();
@@ -1410,6 +1470,7 @@ void
 NrSpectrumPhy::EndRxSrs ()
 {
   NS_LOG_FUNCTION (this);
+  NrProfilerScope profilerScope (NrProfiler::SPECTRUM_END_RX);
   NS_ASSERT (m_state == RX_UL_SRS && m_rxControlMessageList.size() ==1 );
 
   // notify interference calculator that the reception of SRS is finished,
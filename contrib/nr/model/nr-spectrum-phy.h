@@ -355,6 +355,23 @@ public:
   void AddExpectedTb (uint16_t rnti, uint8_t ndi, uint32_t size, uint8_t mcs, const std::vector<int> &rbMap,
                       uint8_t harqId, uint8_t rv, bool downlink, uint8_t symStart, uint8_t numSym,
                       const SfnSf &sfn);
+  /**
+   * \brief Check if an expected TB was discontinuously transmitted (DTX)
+   * \param rnti RNTI of the TB
+   * \param sfn SFN of the TB
+   * \param symStart Sym start of the TB
+   * \param harqProcessId filled with the HARQ process of the TB, in case of DTX
+   * \param rv filled with the redundancy version of the TB, in case of DTX
+   * \return true if the TB is still expected but no data signal carrying it
+   * started to be received; the TB is then forgotten, and the caller reports
+   * the DTX for its HARQ process
+   *
+   * To be called at the end of the var TTI in which the TB was expected.
+   * A TB that was received but could not be decoded is not a DTX: it gets
+   * a NACK through the usual HARQ feedback.
+   */
+  bool CheckExpectedTbDtx (uint16_t rnti, const SfnSf &sfn, uint8_t symStart,
+                           uint8_t *harqProcessId, uint8_t *rv);
 
   /**
    * Assign a fixed random variable stream number to the random variables
@@ -564,6 +581,7 @@ private:
     bool m_isCorrupted {false};           //!< True if the ErrorModel indicates that the TB is corrupted.
                                           //    Filled at the end of data rx/tx
     bool m_harqFeedbackSent {false};      //!< Indicate if the feedback has been sent for an entire TB
+    bool m_rxStarted {false};             //!< True if a data signal carrying this TB started to be received
     Ptr<NrErrorModelOutput> m_outputOfEM; //!< Output of the Error Model (depends on the EM type)
     double m_sinrAvg {0.0};               //!< AVG SINR (only for the RB used to transmit the TB)
     double m_sinrMin {0.0};               //!< MIN SINR (only between the RB used to transmit the TB)
@@ -26,15 +26,18 @@
   while (false);
 
 #include "nr-ue-mac.h"
+#include "nr-profiler.h"
 //#include "nr-ue-phy.h"
 #include <ns3/log.h>
 #include <ns3/boolean.h>
+#include <ns3/nstime.h>
 #include <ns3/lte-radio-bearer-tag.h>
 #include <ns3/random-variable-stream.h>
 #include "nr-phy-sap.h"
 #include "nr-control-messages.h"
 #include "nr-mac-header-vs.h"
 #include "nr-mac-short-bsr-ce.h"
+#include "nr-mac-long-bsr-ce.h"
 
 namespace ns3 {
 
@@ -254,6 +257,34 @@ NrUeMac::GetTypeId (void)
                    MakeUintegerAccessor (&NrUeMac::SetCGPeriod,
                                          &NrUeMac::GetCGPeriod),
                    MakeUintegerChecker<uint8_t> ())
+    .AddAttribute ("CgTrafficDeadline",
+                   "Deadline reported in the CGR of the LCs without a traffic profile "
+                   "(see SetCgTrafficProfile)",
+                   TimeValue (MicroSeconds (150)),
+                   MakeTimeAccessor (&NrUeMac::m_cgTrafficDeadline),
+                   MakeTimeChecker ())
+    .AddAttribute ("LongBsr",
+                   "Report the buffer with the long BSR (8 LCGs, 256 levels) "
+                   "instead of the short BSR (4 LCGs, 32 levels)",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NrUeMac::m_longBsr),
+                   MakeBooleanChecker ())
+    .AddAttribute ("UlTbBatching",
+                   "Collect all the subPDUs of an UL DCI and send them to the PHY "
+                   "as a single packet, with one metadata tag for the whole TB",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NrUeMac::m_ulTbBatching),
+                   MakeBooleanChecker ())
+    .AddAttribute ("CgSkipPadding",
+                   "Skip the CG occasions found with an empty buffer, instead "
+                   "of filling them with a padding PDU",
+                   BooleanValue (false),
+                   MakeBooleanAccessor (&NrUeMac::m_cgSkipPadding),
+                   MakeBooleanChecker ())
+    .AddTraceSource ("CgSkippedOccasions",
+                     "Number of CG occasions skipped because of an empty buffer",
+                     MakeTraceSourceAccessor (&NrUeMac::m_cgSkippedOccasions),
+                     "ns3::TracedValueCallback::Uint32")
   ;
   return tid;
 }
@@ -331,6 +362,20 @@ NrUeMac::GetCellId () const
     }
 }
 
+bool
+NrUeMac::UseLongBsr () const
+{
+  return m_longBsr
+    && m_ulDciTotalUsed + NrMacLongBsrCe ().GetSerializedSize () <= m_ulDci->m_tbSize.at (0);
+}
+
+uint32_t
+NrUeMac::GetBsrSize () const
+{
+  return UseLongBsr () ? NrMacLongBsrCe ().GetSerializedSize ()
+                       : NrMacShortBsrCe ().GetSerializedSize ();
+}
+
 uint32_t
 NrUeMac::GetTotalBufSize () const
 {
@@ -387,19 +432,97 @@ NrUeMac::DoTransmitPdu (LteMacSapProvider::TransmitPduParameters params)
 
   params.pdu->AddHeader (header);
 
-  LteRadioBearerTag bearerTag (params.rnti, params.lcid, params.layer);
-  params.pdu->AddPacketTag (bearerTag);
-
-  m_miUlHarqProcessesPacket.at (params.harqProcessId).m_pktBurst->AddPacket (params.pdu);
   m_miUlHarqProcessesPacketTimer.at (params.harqProcessId) = GetNumHarqProcess();
 
   m_ulDciTotalUsed += params.pdu->GetSize ();
 
   NS_ASSERT_MSG (m_ulDciTotalUsed <= m_ulDci->m_tbSize.at (0), "We used more data than the DCI allowed us.");
 
+  if (m_ulTbBatching)
+    {
+      // The TB is saved for HARQ and sent to the PHY by SendUlTb
+      AddSubPduToUlTb (params.pdu, params.lcid, true);
+      return;
+    }
+
+  LteRadioBearerTag bearerTag (params.rnti, params.lcid, params.layer);
+  params.pdu->AddPacketTag (bearerTag);
+
+  m_miUlHarqProcessesPacket.at (params.harqProcessId).m_pktBurst->AddPacket (params.pdu);
+
   m_phySapProvider->SendMacPdu (params.pdu, m_ulDciSfnsf, m_ulDci->m_symStart, params.layer);
 }
 
+void
+NrUeMac::AddSubPduToUlTb (const Ptr<Packet> &subPdu, uint8_t lcid, bool harq)
+{
+  NS_LOG_FUNCTION (this << static_cast<uint32_t> (lcid) << subPdu->GetSize ());
+
+  if (m_ulTb == nullptr)
+    {
+      m_ulTb = Create<Packet> ();
+      m_ulTbTag = NrUlTbTag ();
+      m_ulTbHarqSubPdus = 0;
+      m_ulTbHarqBytes = 0;
+    }
+
+  if (harq)
+    {
+      // The subPDUs to retransmit must be the first ones of the TB
+      NS_ASSERT (m_ulTbHarqSubPdus == m_ulTbTag.GetSubPdus ().size ());
+      ++m_ulTbHarqSubPdus;
+      m_ulTbHarqBytes += subPdu->GetSize ();
+    }
+
+  // The packet tags of the subPDU do not survive the concatenation: move
+  // the ones we need in the TB tag
+  m_ulTbTag.AddSubPdu (NrUlTbTag::ExtractSubPdu (subPdu, lcid));
+  m_ulTb->AddAtEnd (subPdu);
+}
+
+void
+NrUeMac::SendUlTb ()
+{
+  NS_LOG_FUNCTION (this);
+
+  if (m_ulTb == nullptr)
+    {
+      return;
+    }
+
+  Ptr<Packet> tb = m_ulTb;
+  m_ulTb = nullptr;
+
+  const auto & subPdus = m_ulTbTag.GetSubPdus ();
+  NS_LOG_INFO ("Sending UL TB of " << tb->GetSize () << " B with " <<
+               subPdus.size () << " subPDUs");
+
+  if (m_ulTbHarqSubPdus > 0)
+    {
+      // As without the batching, the CEs at the end of the TB (the BSR)
+      // are not saved for the retransmissions
+      Ptr<Packet> harqTb = m_ulTbHarqBytes == tb->GetSize () ? tb->Copy ()
+                                                             : tb->CreateFragment (0, m_ulTbHarqBytes);
+
+      auto & harqProcess = m_miUlHarqProcessesPacket.at (m_ulDci->m_harqProcess);
+      if (harqProcess.m_pktBurst == nullptr)
+        {
+          harqProcess.m_pktBurst = CreateObject<PacketBurst> ();
+        }
+      harqProcess.m_pktBurst->AddPacket (harqTb);
+      harqProcess.m_ulTbSubPdus.insert (harqProcess.m_ulTbSubPdus.end (), subPdus.begin (),
+                                        subPdus.begin () + m_ulTbHarqSubPdus);
+    }
+
+  tb->AddByteTag (m_ulTbTag);
+  tb->AddPacketTag (LteRadioBearerTag (m_rnti, subPdus.front ().m_lcid, 0));
+
+  //MIMO is not supported for UL yet.
+  //Therefore, there will be only
+  //one stream with stream Id 0.
+  m_phySapProvider->SendMacPdu (tb, m_ulDciSfnsf, m_ulDci->m_symStart, 0);
+}
+
 void
 NrUeMac::DoReportBufferStatus (LteMacSapProvider::ReportBufferStatusParameters params)
 {
@@ -428,17 +551,20 @@ NrUeMac::DoReportBufferStatus (LteMacSapProvider::ReportBufferStatusParameters p
         {
           NS_LOG_INFO ("INACTIVE -> TO_SEND, bufSize " << GetTotalBufSize ());
           m_srState_configuredGrant = TO_SEND_TrafficInfo;
-          if (params.rnti == 4)// Esto lo teno que cambiar, va a ser variable pero por ahroa
-              // solo para probar
-          {
-            m_traffDeadlineTime =  MicroSeconds(200); //80
-          }
-          else
-          {
-            m_traffDeadlineTime = MicroSeconds(150); //60
-          }
+          m_cgTrafficLcid = params.lcid;
           m_traffStartTime = Simulator::Now();
-          m_trafficPeriodicity = params.periodicity;
+
+          const NrCgTrafficProfile *profile = GetCgTrafficProfile (params.lcid);
+          if (profile != nullptr)
+            {
+              m_traffDeadlineTime = profile->m_deadline;
+              m_trafficPeriodicity = profile->m_period > 0 ? profile->m_period : params.periodicity;
+            }
+          else
+            {
+              m_traffDeadlineTime = m_cgTrafficDeadline;
+              m_trafficPeriodicity = params.periodicity;
+            }
         }
 
       if (m_srState_configuredGrant == ACTIVE_CG)
@@ -478,9 +604,13 @@ NrUeMac::SendReportBufferStatus (const SfnSf &dataSfn, uint8_t symStart)
   bsr.m_rnti = m_rnti;
   bsr.m_macCeType = MacCeElement::BSR;
 
+  // A grant too small for the long BSR carries the short one
+  const bool longBsr = UseLongBsr ();
+
   // BSR is reported for each LCG
   std::unordered_map <uint8_t, LteMacSapProvider::ReportBufferStatusParameters>::iterator it;
-  std::vector<uint32_t> queue (4, 0);   // one value per each of the 4 LCGs, initialized to 0
+  // one value per each of the LCGs (4 for the short BSR, 8 for the long one), initialized to 0
+  std::vector<uint32_t> queue (longBsr ? NrMacLongBsrCe::NUM_LCG : 4, 0);
   for (it = m_ulBsrReceived.begin (); it != m_ulBsrReceived.end (); it++)
     {
       uint8_t lcid = it->first;
@@ -492,16 +622,51 @@ NrUeMac::SendReportBufferStatus (const SfnSf &dataSfn, uint8_t symStart)
                                      && ((*it).second.statusPduSize == 0)),
                      "BSR should not be used for LCID 0");
       uint8_t lcg = lcInfoMapIt->second.lcConfig.logicalChannelGroup;
+      NS_ABORT_MSG_IF (lcg >= NrMacLongBsrCe::NUM_LCG || (! m_longBsr && lcg >= queue.size ()),
+                       "LCG " << +lcg << " cannot be reported with a " <<
+                       (m_longBsr ? "long" : "short") << " BSR");
+      if (lcg >= queue.size ())
+        {
+          // Short BSR instead of the long one: the report is truncated
+          NS_LOG_INFO ("LCG " << +lcg << " not reported: no room for the long BSR");
+          continue;
+        }
       queue.at (lcg) += ((*it).second.txQueueSize + (*it).second.retxQueueSize + (*it).second.statusPduSize);
     }
 
   NS_LOG_INFO ("Sending BSR with this info for the LCG: " << queue.at (0) << " " <<
                queue.at (1) << " " << queue.at(2) << " " << queue.at(3));
-  // FF API says that all 4 LCGs are always present
-  bsr.m_macCeValue.m_bufferStatus.push_back (NrMacShortBsrCe::FromBytesToLevel (queue.at (0)));
-  bsr.m_macCeValue.m_bufferStatus.push_back (NrMacShortBsrCe::FromBytesToLevel (queue.at (1)));
-  bsr.m_macCeValue.m_bufferStatus.push_back (NrMacShortBsrCe::FromBytesToLevel (queue.at (2)));
-  bsr.m_macCeValue.m_bufferStatus.push_back (NrMacShortBsrCe::FromBytesToLevel (queue.at (3)));
+
+  // Here we send the real BSR, as a subpdu.
+  Ptr<Packet> p = Create<Packet> ();
+
+  // Please note that the levels are defined from the standard: 5 bit for the
+  // short BSR, 8 bit for the long one. FF API says that all the LCGs are
+  // always present, so the gNB recognizes the long BSR from the number of
+  // values in m_bufferStatus.
+  if (longBsr)
+    {
+      NrMacLongBsrCe header;
+      for (uint32_t lcg = 0; lcg < queue.size (); ++lcg)
+        {
+          header.m_bufferSizeLevel.at (lcg) = NrMacLongBsrCe::FromBytesToLevel (queue.at (lcg));
+          bsr.m_macCeValue.m_bufferStatus.push_back (header.m_bufferSizeLevel.at (lcg));
+        }
+      p->AddHeader (header);
+    }
+  else
+    {
+      NrMacShortBsrCe header;
+      header.m_bufferSizeLevel_0 = NrMacShortBsrCe::FromBytesToLevel (queue.at (0));
+      header.m_bufferSizeLevel_1 = NrMacShortBsrCe::FromBytesToLevel (queue.at (1));
+      header.m_bufferSizeLevel_2 = NrMacShortBsrCe::FromBytesToLevel (queue.at (2));
+      header.m_bufferSizeLevel_3 = NrMacShortBsrCe::FromBytesToLevel (queue.at (3));
+      bsr.m_macCeValue.m_bufferStatus.push_back (header.m_bufferSizeLevel_0);
+      bsr.m_macCeValue.m_bufferStatus.push_back (header.m_bufferSizeLevel_1);
+      bsr.m_macCeValue.m_bufferStatus.push_back (header.m_bufferSizeLevel_2);
+      bsr.m_macCeValue.m_bufferStatus.push_back (header.m_bufferSizeLevel_3);
+      p->AddHeader (header);
+    }
 
   // create the message. It is used only for tracing, but we don't send it...
   Ptr<NrBsrMessage> msg = Create<NrBsrMessage> ();
@@ -510,26 +675,20 @@ NrUeMac::SendReportBufferStatus (const SfnSf &dataSfn, uint8_t symStart)
 
   m_macTxedCtrlMsgsTrace (m_currentSlot, GetCellId (), bsr.m_rnti, GetBwpId (), msg);
 
-  // Here we send the real SHORT_BSR, as a subpdu.
-  Ptr<Packet> p = Create<Packet> ();
+  uint8_t bsrLcid = longBsr ? NrMacHeaderFsUl::LONG_BSR : NrMacHeaderFsUl::SHORT_BSR;
 
-  // Please note that the levels are defined from the standard. In this case,
-  // we have 5 bit available, so use such standard levels. In the future,
-  // when LONG BSR will be implemented, this have to change.
-  NrMacShortBsrCe header;
-  header.m_bufferSizeLevel_0 = NrMacShortBsrCe::FromBytesToLevel (queue.at (0));
-  header.m_bufferSizeLevel_1 = NrMacShortBsrCe::FromBytesToLevel (queue.at (1));
-  header.m_bufferSizeLevel_2 = NrMacShortBsrCe::FromBytesToLevel (queue.at (2));
-  header.m_bufferSizeLevel_3 = NrMacShortBsrCe::FromBytesToLevel (queue.at (3));
+  m_ulDciTotalUsed += p->GetSize ();
+  NS_ASSERT_MSG (m_ulDciTotalUsed <= m_ulDci->m_tbSize.at (0), "We used more data than the DCI allowed us.");
 
-  p->AddHeader (header);
+  if (m_ulTbBatching)
+    {
+      AddSubPduToUlTb (p, bsrLcid, false);
+      return;
+    }
 
-  LteRadioBearerTag bearerTag (m_rnti, NrMacHeaderFsUl::SHORT_BSR, 0);
+  LteRadioBearerTag bearerTag (m_rnti, bsrLcid, 0);
   p->AddPacketTag (bearerTag);
 
-  m_ulDciTotalUsed += p->GetSize ();
-  NS_ASSERT_MSG (m_ulDciTotalUsed <= m_ulDci->m_tbSize.at (0), "We used more data than the DCI allowed us.");
-
   //MIMO is not supported for UL yet.
   //Therefore, there will be only
   //one stream with stream Id 0.
@@ -566,6 +725,7 @@ NrUeMac::RefreshHarqProcessesPacketBuffer (void)
               Ptr<PacketBurst> emptyPb = CreateObject <PacketBurst> ();
               m_miUlHarqProcessesPacket.at (i).m_pktBurst = emptyPb;
               m_miUlHarqProcessesPacket.at (i).m_lcidList.clear ();
+              m_miUlHarqProcessesPacket.at (i).m_ulTbSubPdus.clear ();
             }
         }
       else
@@ -672,35 +832,38 @@ NrUeMac::ProcessUlDci (const Ptr<NrUlDciMessage> &dciMsg)
   // It represents the TO_RECEIVE_CG state
   if (m_cgScheduling)
     {
-      m_dciGranted_stored[cg_slot_counter_DCI] = std::make_shared <DciInfoElementTdma> (m_ulDci->m_rnti,
-                                                                                 m_ulDci->m_format,
-                                                                                 m_ulDci->m_symStart,
-                                                                                 m_ulDci->m_numSym,
-                                                                                 m_ulDci->m_mcs,
-                                                                                 m_ulDci->m_tbSize,
-                                                                                 m_ulDci->m_ndi,
-                                                                                 m_ulDci->m_rv,
-                                                                                 m_ulDci->m_type,
-                                                                                 m_ulDci -> m_bwpIndex,
-                                                                                 m_ulDci->m_harqProcess,
-                                                                                 m_ulDci->m_rbgBitmask,
-                                                                                 m_ulDci->m_tpc);
+      auto dci = std::make_shared <DciInfoElementTdma> (m_ulDci->m_rnti,
+                                                        m_ulDci->m_format,
+                                                        m_ulDci->m_symStart,
+                                                        m_ulDci->m_numSym,
+                                                        m_ulDci->m_mcs,
+                                                        m_ulDci->m_tbSize,
+                                                        m_ulDci->m_ndi,
+                                                        m_ulDci->m_rv,
+                                                        m_ulDci->m_type,
+                                                        m_ulDci -> m_bwpIndex,
+                                                        m_ulDci->m_harqProcess,
+                                                        m_ulDci->m_rbgBitmask,
+                                                        m_ulDci->m_tpc);
 
-      uint8_t streamId = 0;
       SfnSf dataSfn_cg = m_currentSlot;
       uint8_t number_slots_for_processing_configurationPeriod = 5;
       uint8_t numberOfSlot_insideOneSubframe = pow(2,(m_currentSlot.GetNumerology ()));
       m_configurationTime = GetConfigurationTime();
       uint8_t number_slots_configuration = (GetConfigurationTime()*numberOfSlot_insideOneSubframe)-number_slots_for_processing_configurationPeriod;
       dataSfn_cg.Add(number_slots_configuration);
-      uint64_t key = dataSfn_cg.GetEncForStreamWithSymStart (streamId, m_dciGranted_stored[cg_slot_counter_DCI]->m_symStart);
-
-      auto it_1 = m_dci_cg_map.find (key);
 
-      if (it_1 == m_dci_cg_map.end ())
+      if (m_cgConfig == nullptr)
+        {
+          uint32_t period = std::max (1U, static_cast<uint32_t> (GetCGPeriod () * numberOfSlot_insideOneSubframe));
+          m_cgConfig = std::make_shared<const NrCgConfig> (period);
+        }
+      // The MAC and the PHY share the configuration: the PHY derives from it
+      // the slots in which to insert the allocations of the occasions
+      if (! m_cgConfig->HasOccasion (dataSfn_cg.Normalize (), dci->m_symStart))
         {
-          it_1 = m_dci_cg_map.insert (std::make_pair (key, m_dciGranted_stored[cg_slot_counter_DCI])).first;
-          cg_slot_counter_DCI = cg_slot_counter_DCI +1;
+          m_cgConfig = m_cgConfig->AddOccasion (dci, dataSfn_cg.Normalize ());
+          m_phySapProvider->SetCgConfig (m_cgConfig);
         }
     }
 
@@ -715,7 +878,8 @@ NrUeMac::ProcessUlDci (const Ptr<NrUlDciMessage> &dciMsg)
       // This method will retransmit the data saved in the harq buffer
       TransmitRetx ();
 
-      // This method will transmit a new BSR.
+      // This method will transmit a new BSR (with UlTbBatching, in the same
+      // TB as the retransmitted data).
       SendReportBufferStatus (dataSfn, m_ulDci->m_symStart);
     }
   else if (m_ulDci->m_ndi.at (0) == 1)
@@ -765,6 +929,9 @@ NrUeMac::ProcessUlDci (const Ptr<NrUlDciMessage> &dciMsg)
             }
         }
     }
+
+  // All the subPDUs of the DCI are collected: send them in a single TB
+  SendUlTb ();
 }
 
 void
@@ -787,6 +954,30 @@ NrUeMac::TransmitRetx ()
 
   NS_ASSERT (pb->GetNPackets() > 0);
 
+  if (m_ulTbBatching)
+    {
+      // The saved TB opens the TB of this DCI, so that the BSR added by
+      // SendReportBufferStatus goes in the same packet (see SendUlTb); its
+      // subPDUs are already in the HARQ buffer. The saved packet carries
+      // only the byte tags of the subPDUs, that must reach the gNB RLC
+      NS_ASSERT (m_ulTb == nullptr);
+      m_ulTb = Create<Packet> ();
+      m_ulTbTag = NrUlTbTag ();
+      m_ulTbHarqSubPdus = 0;
+      m_ulTbHarqBytes = 0;
+      for (const auto & subPdu : m_miUlHarqProcessesPacket.at (m_ulDci->m_harqProcess).m_ulTbSubPdus)
+        {
+          m_ulTbTag.AddSubPdu (subPdu);
+        }
+      for (std::list<Ptr<Packet> >::const_iterator j = pb->Begin (); j != pb->End (); ++j)
+        {
+          m_ulTb->AddAtEnd (*j);
+          m_ulDciTotalUsed += (*j)->GetSize ();
+        }
+      m_miUlHarqProcessesPacketTimer.at (m_ulDci->m_harqProcess) = GetNumHarqProcess();
+      return;
+    }
+
   for (std::list<Ptr<Packet> >::const_iterator j = pb->Begin (); j != pb->End (); ++j)
     {
       Ptr<Packet> pkt = (*j)->Copy ();
@@ -799,6 +990,7 @@ NrUeMac::TransmitRetx ()
       //Therefore, there will be only
       //one stream with stream Id 0.
       uint8_t streamId = 0;
+      m_ulDciTotalUsed += pkt->GetSize ();
       m_phySapProvider->SendMacPdu (pkt, m_ulDciSfnsf, m_ulDci->m_symStart, streamId);
     }
 
@@ -913,6 +1105,7 @@ NrUeMac::SendNewData ()
   Ptr<PacketBurst> pb = CreateObject <PacketBurst> ();
   m_miUlHarqProcessesPacket.at (m_ulDci->m_harqProcess).m_pktBurst = pb;
   m_miUlHarqProcessesPacket.at (m_ulDci->m_harqProcess).m_lcidList.clear ();
+  m_miUlHarqProcessesPacket.at (m_ulDci->m_harqProcess).m_ulTbSubPdus.clear ();
   NS_LOG_INFO ("Reset HARQP " << +m_ulDci->m_harqProcess);
 
   // Sending the status data has no boundary: let's try to send the ACK as
@@ -942,10 +1135,11 @@ NrUeMac::SendNewData ()
   // Of the TBS we received in the DCI, one part is gone for the status pdu,
   // where we didn't check much as it is the most important data, that has to go
   // out. For the rest that we have left, we can use only a part of it because of
-  // the overhead of the SHORT_BSR, which is 5 bytes.
-  NS_ASSERT_MSG (m_ulDciTotalUsed + 5 <= m_ulDci->m_tbSize.at (0),
-                 "The StatusPDU used " << m_ulDciTotalUsed << " B, we don't have any for the SHORT_BSR.");
-  uint32_t usefulTbs = m_ulDci->m_tbSize.at (0) - m_ulDciTotalUsed - 5;
+  // the overhead of the BSR (5 bytes for the SHORT_BSR, 9 for the LONG_BSR).
+  const uint32_t bsrSize = GetBsrSize ();
+  NS_ASSERT_MSG (m_ulDciTotalUsed + bsrSize <= m_ulDci->m_tbSize.at (0),
+                 "The StatusPDU used " << m_ulDciTotalUsed << " B, we don't have any for the BSR.");
+  uint32_t usefulTbs = m_ulDci->m_tbSize.at (0) - m_ulDciTotalUsed - bsrSize;
 
   // Now, we have 3 bytes of overhead for each subPDU. Let's try to serve all
   // the queues with some RETX data.
@@ -963,9 +1157,9 @@ NrUeMac::SendNewData ()
   // Now we have to update our useful TBS for the next transmission.
   // Remember that m_ulDciTotalUsed keep count of data and overhead that we
   // used till now.
-  NS_ASSERT_MSG (m_ulDciTotalUsed + 5 <= m_ulDci->m_tbSize.at (0),
-                 "The StatusPDU sending required all space, we don't have any for the SHORT_BSR.");
-  usefulTbs = m_ulDci->m_tbSize.at (0) - m_ulDciTotalUsed - 5; // Update the usefulTbs.
+  NS_ASSERT_MSG (m_ulDciTotalUsed + bsrSize <= m_ulDci->m_tbSize.at (0),
+                 "The StatusPDU sending required all space, we don't have any for the BSR.");
+  usefulTbs = m_ulDci->m_tbSize.at (0) - m_ulDciTotalUsed - bsrSize; // Update the usefulTbs.
 
   // The last part is for the queues with some non-RETX data. If there is no space left,
   // then nothing.
@@ -986,6 +1180,7 @@ NrUeMac::SendNewData ()
     {
       m_miUlHarqProcessesPacket.at (m_ulDci->m_harqProcess).m_pktBurst = nullptr;
       m_miUlHarqProcessesPacket.at (m_ulDci->m_harqProcess).m_lcidList.clear ();
+      m_miUlHarqProcessesPacket.at (m_ulDci->m_harqProcess).m_ulTbSubPdus.clear ();
     }
 }
 
@@ -1187,6 +1382,7 @@ NrUeMac::DoSlotIndication_configuredGrant (const SfnSf &sfn)
 {
 
   NS_LOG_FUNCTION (this);
+  NrProfilerScope profilerScope (NrProfiler::UE_MAC_CG_SLOT_INDICATION);
   m_currentSlot = sfn;
   NS_LOG_INFO ("Slot " << m_currentSlot);
 
@@ -1222,49 +1418,33 @@ NrUeMac::DoSlotIndication_configuredGrant (const SfnSf &sfn)
   else if (m_srState_configuredGrant == SCH_CG_DATA)
     {
 
-      if (m_dciGranted_stored[cg_slot_counter_DCI_2] == nullptr)
+      if (m_cgConfig == nullptr || cg_slot_counter_DCI_2 >= m_cgConfig->GetNumOccasions ())
         {
           // The packet has already been transmitted, we switch to the ACTIVE_CG status,
           // We will be in this state until the following periodic transmission.
           m_srState_configuredGrant = ACTIVE_CG;
           cg_slot_counter_DCI_2 = 0;
         }
-      else
+      else if (m_cgConfig->IsOccasionSlot (cg_slot_counter_DCI_2, m_currentSlot.Normalize ()))
         {
-          uint8_t streamId = 0;
-          auto it = m_dci_cg_map.find (m_currentSlot.GetEncForStreamWithSymStart (streamId, m_dciGranted_stored[cg_slot_counter_DCI_2]->m_symStart));
-
-          if (it == m_dci_cg_map.end ())
+          // Processes the current packet
+          m_ulDciSfnsf = m_currentSlot;
+          m_ulDci = m_cgConfig->GetOccasion (cg_slot_counter_DCI_2).m_dci;
+          if (m_cgSkipPadding && m_ulDci->m_ndi.at (0) == 1 && GetTotalBufSize () == 0)
             {
-              // Do nothing
+              // Nothing but padding to send: leave the occasion unused, the
+              // gNB PHY detects the DTX and does not NACK it
+              NS_LOG_INFO ("Skipping CG occasion " << cg_slot_counter_DCI_2 <<
+                           " in slot " << m_ulDciSfnsf << ", empty buffer");
+              m_cgSkippedOccasions++;
             }
           else
             {
-              // Processes the current packet
-              m_ulDciSfnsf = m_currentSlot;
-              m_ulDci = it->second;
-              m_dci_cg_map.erase (it);
               ProcessULPacket();
 
               NS_LOG_INFO ("Sending a packet to PHY layer in slot " << m_ulDciSfnsf);
-
-              // Prepare resources for future transmission
-              SfnSf dataSfn_cg = m_currentSlot;
-              uint8_t numberOfSlot_insideOneSubframe = pow(2,(m_currentSlot.GetNumerology ()));
-              m_cgPeriod = GetCGPeriod();
-              uint8_t number_slots_configuration = (m_cgPeriod*numberOfSlot_insideOneSubframe);
-              dataSfn_cg.Add(number_slots_configuration);
-              uint64_t key = dataSfn_cg.GetEncForStreamWithSymStart (streamId, m_dciGranted_stored[cg_slot_counter_DCI_2]->m_symStart);
-
-              auto it_1 = m_dci_cg_map.find (key);
-
-              if (it_1 == m_dci_cg_map.end ())
-                {
-                  it_1 = m_dci_cg_map.insert (std::make_pair (key, m_dciGranted_stored[cg_slot_counter_DCI_2])).first;
-                  cg_slot_counter_DCI_2 = cg_slot_counter_DCI_2 +1;
-                }
-
             }
+          cg_slot_counter_DCI_2 = cg_slot_counter_DCI_2 +1;
         }
       //Send the SCH_CG_DATA state to UE-PHY
       configuredGrant_state = true;
@@ -1338,6 +1518,9 @@ NrUeMac::ProcessULPacket()
             }
         }
     }
+
+  // All the subPDUs of the DCI are collected: send them in a single TB
+  SendUlTb ();
 }
 
 uint8_t
@@ -1364,6 +1547,36 @@ NrUeMac::SetCGPeriod (uint8_t v)
   m_cgPeriod = v;
 }
 
+void
+NrUeMac::SetCgTrafficProfile (uint8_t lcid, const NrCgTrafficProfile &profile)
+{
+  NS_LOG_FUNCTION (this << static_cast<uint32_t> (lcid));
+  NS_ABORT_MSG_IF (profile.m_maxSize > 0 && profile.m_minSize > profile.m_maxSize,
+                   "Invalid payload size range");
+  NS_ABORT_MSG_IF (profile.m_sizeQuantile < 0.0 || profile.m_sizeQuantile > 1.0,
+                   "The payload size quantile must be in [0, 1]");
+  m_cgTrafficProfiles[lcid] = profile;
+}
+
+void
+NrUeMac::RemoveCgTrafficProfile (uint8_t lcid)
+{
+  m_cgTrafficProfiles.erase (lcid);
+}
+
+uint32_t
+NrUeMac::GetCgSkippedOccasions () const
+{
+  return m_cgSkippedOccasions;
+}
+
+const NrCgTrafficProfile *
+NrUeMac::GetCgTrafficProfile (uint8_t lcid) const
+{
+  auto it = m_cgTrafficProfiles.find (lcid);
+  return it != m_cgTrafficProfiles.end () ? &it->second : nullptr;
+}
+
 void
 NrUeMac::SetCG (bool CGsch)
 {
@@ -1396,6 +1609,13 @@ NrUeMac::SendTrafficInfo () const
   msg -> SetTrafficTimeInit(m_traffStartTime);
   msg -> SetTrafficDeadline(m_traffDeadlineTime);
 
+  const NrCgTrafficProfile *profile = GetCgTrafficProfile (m_cgTrafficLcid);
+  if (profile != nullptr)
+    {
+      // The offset travels in the profile, the start time stays the measured one
+      msg->SetTrafficProfile (*profile);
+    }
+
   for (auto it = m_ulBsrReceived.cbegin (); it != m_ulBsrReceived.cend (); ++it)
     {
       if ((*it).second.rnti == m_rnti)
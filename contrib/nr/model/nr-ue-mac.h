@@ -22,12 +22,15 @@
 
 #include "nr-phy-mac-common.h"
 #include "nr-mac-pdu-info.h"
+#include "nr-cg-config.h"
+#include "nr-ul-tb-tag.h"
 #include "nr-ue-phy.h"
 
 
 #include <ns3/lte-ue-cmac-sap.h>
 #include <ns3/lte-ccm-mac-sap.h>
 #include <ns3/traced-callback.h>
+#include <ns3/traced-value.h>
 
 #include <unordered_map>
 
@@ -35,6 +38,7 @@ namespace ns3 {
 
 class NrUePhySapUser;
 class NrPhySapProvider;
+class NrUlTbBatchingRetxTestCase;
 class NrControlMessage;
 class UniformRandomVariable;
 class PacketBurst;
@@ -122,6 +126,7 @@ class NrUeMac : public Object
   friend class UeMemberNrUeCmacSapProvider;
   friend class UeMemberNrMacSapProvider;
   friend class MacUeMemberPhySapUser;
+  friend class NrUlTbBatchingRetxTestCase;
 
 public:
   /**
@@ -229,6 +234,33 @@ public:
   void SetCGPeriod (uint8_t CGPeriod);
   uint8_t GetCGPeriod () const;
 
+  /**
+   * \brief Set the traffic profile of a configured-grant LC
+   * \param lcid the LC ID
+   * \param profile the profile
+   *
+   * The profile is sent to the gNB in the CGR of the LC, to size its
+   * occasions. The LCs without a profile report their buffer, the
+   * periodicity of the LC, and the CgTrafficDeadline attribute.
+   */
+  void SetCgTrafficProfile (uint8_t lcid, const NrCgTrafficProfile &profile);
+  /**
+   * \brief Remove the traffic profile of a configured-grant LC (if any)
+   * \param lcid the LC ID
+   */
+  void RemoveCgTrafficProfile (uint8_t lcid);
+  /**
+   * \param lcid the LC ID
+   * \return the traffic profile of the LC, or nullptr if it has none
+   */
+  const NrCgTrafficProfile * GetCgTrafficProfile (uint8_t lcid) const;
+  /**
+   * \return the number of CG occasions skipped because the buffer was empty
+   *
+   * Occasions are skipped only when the CgSkipPadding attribute is true.
+   */
+  uint32_t GetCgSkippedOccasions () const;
+
 protected:
   /**
    * \brief DoDispose method inherited from Object
@@ -268,6 +300,20 @@ private:
    */
   uint32_t GetTotalBufSize () const __attribute__((warn_unused_result));
 
+  /**
+   * \brief Check if the BSR of the current UL DCI is a long one
+   * \return true if the LongBsr attribute is set and the long BSR fits in
+   * what is left of the TB; otherwise, the short BSR is sent instead
+   * (reporting only the first four LCGs)
+   */
+  bool UseLongBsr () const;
+
+  /**
+   * \brief Get the size of the BSR subPDU of the current UL DCI (see UseLongBsr)
+   * \return The number of bytes of the BSR, including its subheader
+   */
+  uint32_t GetBsrSize () const;
+
   /**
    * \brief Send to the PHY a SR
    */
@@ -325,6 +371,25 @@ private:
    * not get retransmitted.
    */
   void SendReportBufferStatus (const SfnSf &dataSfn, uint8_t symStart);
+
+  /**
+   * \brief Append a subPDU to the UL TB being built (UlTbBatching attribute)
+   * \param subPdu the subPDU, with its MAC subheader
+   * \param lcid LC ID of the subPDU
+   * \param harq true if the subPDU has to be saved for the HARQ retransmissions
+   */
+  void AddSubPduToUlTb (const Ptr<Packet> &subPdu, uint8_t lcid, bool harq);
+
+  /**
+   * \brief Send to the PHY the UL TB built with AddSubPduToUlTb, if any
+   *
+   * The TB is a single packet, with a LteRadioBearerTag and a NrUlTbTag
+   * describing its subPDUs. The subPDUs to retransmit are saved in the
+   * HARQ process of m_ulDci, as a single packet as well, and their
+   * metadata next to it: the saved packet keeps only the byte tags of the
+   * subPDUs (e.g., the RLC and PDCP timestamps).
+   */
+  void SendUlTb ();
   void RefreshHarqProcessesPacketBuffer (void);
 
   /**
@@ -344,7 +409,8 @@ private:
    *
    * The method uses the DCI stored in m_ulDci to take the HARQ process id,
    * preparing the subPDUs that are waiting in such HARQ process,
-   * and sending them again.
+   * and sending them again. With UlTbBatching, they are put back in the TB
+   * of the DCI, sent by SendUlTb together with the new BSR.
    */
   void TransmitRetx ();
 
@@ -485,6 +551,8 @@ private:
     // maintain list of LCs contained in this TB
     // used to signal HARQ failure to RLC handlers
     std::vector<uint8_t> m_lcidList;
+    // with UlTbBatching, the subPDUs of the TB in m_pktBurst
+    std::vector<NrUlTbTag::SubPdu> m_ulTbSubPdus;
   };
 
   //uint8_t m_harqProcessId;
@@ -550,9 +618,7 @@ private:
   };
   SrCgMachine m_srState_configuredGrant {INACTIVE_CG};   //!< Default state for the configured grant state machine.
 
-  std::shared_ptr<DciInfoElementTdma> m_dciGranted_stored[100]; //!< The stored DCI-s for CG allocation.
-                                                                //!< [num] is the maximum number of
-                                                                //!< slots that can be configured
+  std::shared_ptr<const NrCgConfig> m_cgConfig; //!< The CG occasions, shared with the PHY
 
 
   uint8_t m_totalGrantedSymbols {0};
@@ -563,15 +629,24 @@ private:
   uint8_t cg_slot_counter = 0;
   bool newSlot = false;
   bool newSlot_continue = false;
-  std::unordered_map <uint64_t, std::shared_ptr<DciInfoElementTdma>> m_dci_cg_map;
-  uint8_t cg_slot_counter_DCI = 0;
-  uint8_t cg_slot_counter_DCI_2 = 0;
+  uint8_t cg_slot_counter_DCI_2 = 0; //!< Next occasion to use for the current packet
 
   uint8_t m_configurationTime = 0;
   uint8_t m_cgPeriod = 0;
 
   Time m_traffStartTime;
   Time m_traffDeadlineTime;
+  Time m_cgTrafficDeadline;  //!< Deadline of the LCs without a traffic profile (attribute)
+  uint8_t m_cgTrafficLcid {UINT8_MAX}; //!< LC that started the CG configuration
+  std::unordered_map<uint8_t, NrCgTrafficProfile> m_cgTrafficProfiles; //!< CG traffic profiles, by LC ID
+  bool m_longBsr {false};      //!< Report the buffer with a long BSR (attribute)
+  bool m_ulTbBatching {false};  //!< Send the subPDUs of a DCI as a single packet (attribute)
+  Ptr<Packet> m_ulTb;            //!< UL TB being built, if batching
+  NrUlTbTag m_ulTbTag;           //!< Metadata of the subPDUs of m_ulTb
+  std::size_t m_ulTbHarqSubPdus {0}; //!< Number of subPDUs of m_ulTb to save for HARQ
+  uint32_t m_ulTbHarqBytes {0};  //!< Bytes of m_ulTb to save for HARQ
+  bool m_cgSkipPadding {false}; //!< Skip the CG occasions with an empty buffer (attribute)
+  TracedValue<uint32_t> m_cgSkippedOccasions {0}; //!< Number of skipped CG occasions
   Time m_startSlotTime;
   uint8_t m_trafficPeriodicity;
 };
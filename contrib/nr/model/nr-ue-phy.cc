@@ -298,6 +298,12 @@ NrUePhy::SetSubChannelsForTransmission (const std::vector <int> &mask, uint32_t
 {
   // in uplink we currently support maximum 1 stream for DATA and CTRL, only SRS will be sent using more than 1 stream
   Ptr<SpectrumValue> txPsd = GetTxPowerSpectralDensity (mask, activeStreams);
+  SetTxPsdForTransmission (txPsd, numSym);
+}
+
+void
+NrUePhy::SetTxPsdForTransmission (const Ptr<SpectrumValue> &txPsd, uint32_t numSym)
+{
   NS_ASSERT (txPsd);
 
   m_reportPowerSpectralDensity (m_currentSlot, txPsd, numSym * GetSymbolPeriod (), m_rnti, m_imsi, GetBwpId (), GetCellId ());
@@ -771,45 +777,21 @@ NrUePhy::StartSlot (const SfnSf &s)
 
        if (m_ulPacketToTransmit)
          {
-           if (m_dciGranted[cg_slot_counter_futureTx] == nullptr)
+           if (m_cgConfig == nullptr || cg_slot_counter_futureTx >= m_cgConfig->GetNumOccasions ())
              {
                cg_slot_counter_futureTx = 0;
              }
-           else
+           else if (m_cgConfig->IsOccasionSlot (cg_slot_counter_futureTx, m_currentSlot.Normalize ()))
              {
-               uint8_t streamId = 0;
-               auto it = m_dci_cg_map.find (m_currentSlot.GetEncForStreamWithSymStart (streamId, m_dciGranted[cg_slot_counter_futureTx]->m_symStart));
-
-               if (it == m_dci_cg_map.end ())
-                 {
-                   // Do nothing
-                 }
-               else
-                 {
-                   SfnSf m_sfnsfConfiguredGrantPeriod = m_currentSlot;
-                   uint8_t numberOfSlot_insideOneSubframe = pow(2,GetNumerology ());
-                   // Calculate in which symbol starts the next periodic transmission
-                   m_sfnsfConfiguredGrantPeriod.Add(numberOfSlot_insideOneSubframe*configuredGrant_periodicity);
-
-                   m_ulDci = it->second;
-
-                   InsertFutureAllocation(m_sfnsfConfiguredGrantPeriod, m_ulDci);
-
-                   m_dci_cg_map.erase (it);
+               // Insert the allocation of the same occasion in the next period
+               SfnSf m_sfnsfConfiguredGrantPeriod = m_currentSlot;
+               m_sfnsfConfiguredGrantPeriod.Add (m_cgConfig->GetPeriod ());
 
-                   NS_LOG_INFO ("Sending a packet to PHY layer in slot " << m_sfnsfConfiguredGrantPeriod);
+               InsertFutureAllocation (m_sfnsfConfiguredGrantPeriod,
+                                       m_cgConfig->GetOccasion (cg_slot_counter_futureTx).m_dci);
 
-                   uint64_t key = m_sfnsfConfiguredGrantPeriod.GetEncForStreamWithSymStart (streamId, m_dciGranted[cg_slot_counter_futureTx]->m_symStart);
-
-                   auto it_1 = m_dci_cg_map.find (key);
-
-                   if (it_1 == m_dci_cg_map.end ())
-                     {
-                       it_1 = m_dci_cg_map.insert (std::make_pair (key, m_dciGranted[cg_slot_counter_futureTx])).first;
-                       cg_slot_counter_futureTx = cg_slot_counter_futureTx +1;
-                     }
-
-                 }
+               NS_LOG_INFO ("Sending a packet to PHY layer in slot " << m_sfnsfConfiguredGrantPeriod);
+               cg_slot_counter_futureTx = cg_slot_counter_futureTx +1;
              }
          }
     }
@@ -1058,12 +1040,21 @@ Time
 NrUePhy::UlData(const std::shared_ptr<DciInfoElementTdma> &dci)
 {
   NS_LOG_FUNCTION (this);
-  if (m_enableUplinkPowerControl)
+  int cgIndex = m_cgScheduling ? GetCgOccasionIndex (dci) : -1;
+  if (cgIndex >= 0)
     {
-      m_txPower = m_powerControl->GetPuschTxPower ((FromRBGBitmaskToRBAssignment(dci->m_rbgBitmask)).size());
+      SetTxPsdForTransmission (GetCgTxPsd (static_cast<std::size_t> (cgIndex), dci), dci->m_numSym);
+    }
+  else
+    {
+      if (m_enableUplinkPowerControl)
+        {
+          std::size_t rbNum = std::count (dci->m_rbgBitmask.begin (), dci->m_rbgBitmask.end (), 1) * GetNumRbPerRbg ();
+          m_txPower = m_powerControl->GetPuschTxPower (rbNum);
+        }
+      // Currently uplink DATA is transmitted over only 1 stream
+      SetTxPsdForTransmission (GetTxPowerSpectralDensity (dci->m_rbgBitmask, 1), dci->m_numSym);
     }
-  // Currently uplink DATA is transmitted over only 1 stream
-  SetSubChannelsForTransmission (FromRBGBitmaskToRBAssignment (dci->m_rbgBitmask), dci->m_numSym, 1);
   Time varTtiPeriod = GetSymbolPeriod () * dci->m_numSym;
   std::list<Ptr<NrControlMessage> > ctrlMsg;
   //MIMO is not supported for UL yet.
@@ -1080,6 +1071,15 @@ NrUePhy::UlData(const std::shared_ptr<DciInfoElementTdma> &dci)
           NS_FATAL_ERROR ("No radio bearer tag");
         }
     }
+  else if (cgIndex >= 0)
+    {
+      // The MAC skipped this configured grant occasion, as it had nothing
+      // to send: stay silent, the gNB sees a DTX
+      NS_LOG_DEBUG ("UE" << m_rnti << " skipping CG occasion " << cgIndex <<
+                    " symbols " << +dci->m_symStart <<
+                    "-" << +(dci->m_symStart + dci->m_numSym - 1));
+      return varTtiPeriod;
+    }
   else
     {
       // put an error, as something is wrong. The UE should not be scheduled
@@ -1163,47 +1163,6 @@ NrUePhy::EndVarTti (const std::shared_ptr<DciInfoElementTdma> &dci)
     }
   else
     {
-      // In the case of configured grant scheduling, the CG information
-      // transmitted by the gNB to the UE must be saved in the phy layer.
-      // The UE-MAC is currently in the TO_RECEIVE_CG state.
-      if (m_cgScheduling)
-        {
-          if (dci->m_type == DciInfoElementTdma::DATA && dci->m_format == DciInfoElementTdma::UL && m_ulPacketToTransmit == false)
-            {
-              m_dciGranted[cg_slot_counter] = std::make_shared <DciInfoElementTdma> (dci->m_rnti,
-                                                                                  dci->m_format,
-                                                                                  dci->m_symStart,
-                                                                                  dci->m_numSym,
-                                                                                  dci->m_mcs,
-                                                                                  dci->m_tbSize,
-                                                                                  dci->m_ndi,
-                                                                                  dci->m_rv,
-                                                                                  dci->m_type,
-                                                                                  dci -> m_bwpIndex,
-                                                                                  dci->m_harqProcess,
-                                                                                  dci->m_rbgBitmask,
-                                                                                  dci->m_tpc);
-
-              uint8_t streamId = 0;
-              SfnSf dataSfn_cg = m_currentSlot;
-              uint8_t number_slots_for_processing_configurationPeriod = 7; //5 in the mac 7 in the phy becasue it has 2 slots of processing time in phy
-              uint8_t numberOfSlot_insideOneSubframe = pow(2,(m_currentSlot.GetNumerology ()));
-              uint8_t number_slots_configuration = (configurationTime*numberOfSlot_insideOneSubframe)-number_slots_for_processing_configurationPeriod;
-              dataSfn_cg.Add(number_slots_configuration);
-
-              uint64_t key = dataSfn_cg.GetEncForStreamWithSymStart (streamId, m_dciGranted[cg_slot_counter]->m_symStart);
-
-              auto it = m_dci_cg_map.find (key);
-
-              if (it == m_dci_cg_map.end ())
-                {
-                  it = m_dci_cg_map.insert (std::make_pair (key, m_dciGranted[cg_slot_counter])).first;
-                  cg_slot_counter = cg_slot_counter +1;
-
-                }
-            }
-        }
-
       VarTtiAllocInfo allocation = m_currSlotAllocInfo.m_varTtiAllocInfo.front ();
       m_currSlotAllocInfo.m_varTtiAllocInfo.pop_front ();
 
@@ -1221,6 +1180,52 @@ NrUePhy::EndVarTti (const std::shared_ptr<DciInfoElementTdma> &dci)
   m_receptionEnabled = false;
 }
 
+int
+NrUePhy::GetCgOccasionIndex (const std::shared_ptr<DciInfoElementTdma> &dci) const
+{
+  if (m_cgConfig != nullptr)
+    {
+      for (size_t i = 0; i < m_cgConfig->GetNumOccasions (); ++i)
+        {
+          if (m_cgConfig->GetOccasion (i).m_dci == dci)
+            {
+              return static_cast<int> (i);
+            }
+        }
+    }
+  return -1;
+}
+
+Ptr<SpectrumValue>
+NrUePhy::GetCgTxPsd (std::size_t cgIndex, const std::shared_ptr<DciInfoElementTdma> &dci)
+{
+  NS_LOG_FUNCTION (this << cgIndex);
+
+  std::size_t rbNum = std::count (dci->m_rbgBitmask.begin (), dci->m_rbgBitmask.end (), 1) * GetNumRbPerRbg ();
+  if (m_enableUplinkPowerControl)
+    {
+      // Evaluated at each occasion: it fires the PUSCH power trace, and it
+      // is recomputed by NrUePowerControl only if the pathloss or the TPC
+      // state changed since the last occasion
+      m_txPower = m_powerControl->GetPuschTxPower (rbNum);
+    }
+
+  if (cgIndex >= m_cgTxPsd.size ())
+    {
+      m_cgTxPsd.resize (cgIndex + 1);
+    }
+  CgTxPsd &entry = m_cgTxPsd[cgIndex];
+  if (entry.m_txPsd == nullptr || entry.m_txPower != m_txPower
+      || entry.m_rbgBitmask != dci->m_rbgBitmask)
+    {
+      // Currently uplink DATA is transmitted over only 1 stream
+      entry.m_txPsd = GetTxPowerSpectralDensity (dci->m_rbgBitmask, 1);
+      entry.m_txPower = m_txPower;
+      entry.m_rbgBitmask = dci->m_rbgBitmask;
+    }
+  return entry.m_txPsd;
+}
+
 void
 NrUePhy::PhyDataPacketReceived (const Ptr<Packet> &p)
 {
@@ -1824,6 +1829,14 @@ NrUePhy::SelectRi (const std::vector<double> &avrgSinr)
 
 //Configured Grant
 
+void
+NrUePhy::SetCgConfig (const std::shared_ptr<const NrCgConfig> &config)
+{
+  NS_LOG_FUNCTION (this);
+  m_cgConfig = config;
+  m_cgTxPsd.clear ();
+}
+
 void
 NrUePhy::SetCG (bool CGsch)
 {
@@ -496,6 +496,11 @@ public:
 
   //Configured Grant
 
+  /**
+   * \brief Set the CG occasions of the UE, shared by the MAC
+   * \param config the configuration
+   */
+  void SetCgConfig (const std::shared_ptr<const NrCgConfig> &config) override;
 
   void SetCG (bool CGSch);
   bool GetCG () const;
@@ -638,6 +643,13 @@ private:
    * \param activeStreams the number of active streams for the transmission
    */
   void SetSubChannelsForTransmission (const std::vector<int> &mask, uint32_t numSym, uint8_t activeStreams);
+  /**
+   * \brief Use an already computed Tx power spectral density for the
+   * next transmission
+   * \param txPsd the Tx PSD
+   * \param numSym number of symbols of the transmission
+   */
+  void SetTxPsdForTransmission (const Ptr<SpectrumValue> &txPsd, uint32_t numSym);
   /**
    * \brief Send ctrl msgs considering L1L2CtrlLatency
    * \param msg The ctrl msg to be sent
@@ -925,20 +937,45 @@ private:
   SfnSf m_SlotsGranted = SfnSf (0,0,0,GetNumerology());
   bool m_ulPacketToTransmit{false}; //!< It indicates if a new message is generated
                                     //!< in the transmission phase
-  std::shared_ptr<DciInfoElementTdma> m_dciGranted[100]; //!< The stored DCI-s for CG allocation.
-                                                         //!< [num] is the maximum number of
-                                                         //!< slots that can be configured
+  std::shared_ptr<const NrCgConfig> m_cgConfig; //!< The CG occasions, shared by the MAC
 
   uint8_t configuredGrant_periodicity = 0; //!< Set up CG parameters: CG tx periodicity
   uint8_t configurationTime = 0; //!< Set up CG parameters: Configuration phase
 
 
-  uint8_t cg_slot_counter = 0;
-  uint8_t cg_slot_counter_futureTx = 0;
-  std::unordered_map <uint64_t, std::shared_ptr<DciInfoElementTdma>> m_dci_cg_map;
-  std::shared_ptr<DciInfoElementTdma> m_ulDci;
+  uint8_t cg_slot_counter_futureTx = 0; //!< Next occasion whose allocation is inserted
   bool m_cgScheduling = true;
 
+  /**
+   * \brief Get the index of a CG occasion in m_cgConfig
+   * \param dci the DCI of the transmission
+   * \return the index of the occasion, or -1 if the DCI is not a stored CG occasion
+   */
+  int GetCgOccasionIndex (const std::shared_ptr<DciInfoElementTdma> &dci) const;
+  /**
+   * \brief Get the Tx PSD of a CG occasion, at its transmission time
+   *
+   * The Tx power is evaluated at every occasion; the PSD is rebuilt only
+   * when the Tx power or the RBG allocation of the occasion changed since
+   * its last transmission.
+   *
+   * \param cgIndex index of the occasion in m_cgConfig
+   * \param dci the DCI of the occasion
+   * \return the Tx PSD of the occasion
+   */
+  Ptr<SpectrumValue> GetCgTxPsd (std::size_t cgIndex, const std::shared_ptr<DciInfoElementTdma> &dci);
+
+  /**
+   * \brief Tx PSD of a CG occasion, with the inputs it was built from
+   */
+  struct CgTxPsd
+  {
+    Ptr<SpectrumValue> m_txPsd;         //!< Tx PSD
+    double m_txPower {0.0};             //!< Tx power of the PSD
+    std::vector<uint8_t> m_rbgBitmask;  //!< RBG allocation of the PSD
+  };
+  std::vector<CgTxPsd> m_cgTxPsd;       //!< Tx PSD of each CG occasion
+
 };
 
 }
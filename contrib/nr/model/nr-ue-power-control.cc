@@ -25,11 +25,39 @@
 #include <ns3/math.h>
 #include "nr-ue-power-control.h"
 #include "nr-ue-phy.h"
+#include <array>
 
 namespace ns3 {
 
 NS_LOG_COMPONENT_DEFINE ("NrUePowerControl");
 
+/**
+ * \brief Largest RB allocation (TS 38.101, 275 RBs) covered by the
+ * precomputed 10 * log10 (M_RB) table
+ */
+static const std::size_t MAX_TABLE_RB = 275;
+
+/**
+ * \brief Get the table of 10 * log10 (M_RB) values, for M_RB = 0..MAX_TABLE_RB.
+ * The entry 0 is never used.
+ * \return the table
+ */
+static const std::array<double, MAX_TABLE_RB + 1> &
+GetRbDbTable ()
+{
+  static const std::array<double, MAX_TABLE_RB + 1> table = [] ()
+    {
+      std::array<double, MAX_TABLE_RB + 1> t;
+      t[0] = 0.0;
+      for (std::size_t rb = 1; rb <= MAX_TABLE_RB; ++rb)
+        {
+          t[rb] = 10 * std::log10 (static_cast<double> (rb));
+        }
+      return t;
+    } ();
+  return table;
+}
+
 NS_OBJECT_ENSURE_REGISTERED (NrUePowerControl);
 
 NrUePowerControl::NrUePowerControl ()
@@ -178,6 +206,7 @@ NrUePowerControl::SetClosedLoop (bool value)
 {
   NS_LOG_FUNCTION (this);
   m_closedLoop = value;
+  InvalidatePuschCache ();
 }
 
 void
@@ -185,6 +214,7 @@ NrUePowerControl::SetAccumulationEnabled (bool value)
 {
   NS_LOG_FUNCTION (this);
   m_accumulationEnabled = value;
+  InvalidatePuschCache ();
 }
 
 void
@@ -208,6 +238,7 @@ NrUePowerControl::SetAlpha (double value)
     }
 
   m_alpha = value;
+  InvalidatePuschCache ();
 }
 
 void
@@ -224,7 +255,12 @@ NrUePowerControl::SetRsrp (double value)
 
   double alphaRsrp = std::pow (0.5, m_pcRsrpFilterCoefficient / 4.0);
   m_rsrp = (1 - alphaRsrp) * m_rsrp + alphaRsrp * value;
-  m_pathLoss = m_referenceSignalPower - m_rsrp;
+  double pathLoss = m_referenceSignalPower - m_rsrp;
+  if (pathLoss != m_pathLoss)
+    {
+      m_pathLoss = pathLoss;
+      InvalidatePuschCache ();
+    }
   NS_LOG_INFO ("Pathloss updated to: " << m_pathLoss <<
                " , rsrp updated to:" << m_rsrp << 
                " for cellId/rnti: " << m_cellId << "," << m_rnti);
@@ -249,6 +285,7 @@ NrUePowerControl::SetTechnicalSpec (NrUePowerControl::TechnicalSpec value)
 {
   NS_LOG_FUNCTION (this);
   m_technicalSpec = value;
+  InvalidatePuschCache ();
 }
 
 void
@@ -256,6 +293,7 @@ NrUePowerControl::SetBlCe (bool blCe)
 {
   NS_LOG_FUNCTION (this);
   m_blCe = blCe;
+  InvalidatePuschCache ();
 }
 
 void
@@ -270,6 +308,7 @@ NrUePowerControl::SetDeltaTF (double value)
 {
   NS_LOG_FUNCTION (this);
   m_deltaTF = value;
+  InvalidatePuschCache ();
 }
 
 void
@@ -305,6 +344,7 @@ NrUePowerControl::SetPcmax (double value)
 {
   NS_LOG_FUNCTION (this);
   m_Pcmax = value;
+  InvalidatePuschCache ();
 }
 
 void
@@ -312,6 +352,7 @@ NrUePowerControl::SetPcmin (double value)
 {
   NS_LOG_FUNCTION (this);
   m_Pcmin = value;
+  InvalidatePuschCache ();
 }
 
 void
@@ -319,12 +360,14 @@ NrUePowerControl::SetPoNominalPusch (int16_t value)
 {
   NS_LOG_FUNCTION (this);
   m_PoNominalPusch = value;
+  InvalidatePuschCache ();
 }
 void
 NrUePowerControl::SetPoUePusch (int16_t value)
 {
   NS_LOG_FUNCTION (this);
   m_PoUePusch = value;
+  InvalidatePuschCache ();
 }
 
 void
@@ -341,6 +384,7 @@ NrUePowerControl::ConfigureReferenceSignalPower (double value)
 {
   NS_LOG_FUNCTION (this);
   m_referenceSignalPower = value;
+  InvalidatePuschCache ();
 }
 
 void
@@ -353,6 +397,7 @@ NrUePowerControl::ReportTpcPusch (uint8_t tpc)
      {
        m_fc = 0;
        m_hc = 0;
+       InvalidatePuschCache ();
        return;
      }
 
@@ -381,6 +426,9 @@ NrUePowerControl::ReportTpcPusch (uint8_t tpc)
 
   if (m_technicalSpec == TS_36_213)
     {
+      // m_fc is updated right away
+      InvalidatePuschCache ();
+
       // PUSCH power control accumulation or absolute value configuration
       if (m_accumulationEnabled)
         {
@@ -551,6 +599,12 @@ NrUePowerControl::UpdateFc ()
   NS_LOG_FUNCTION (this);
   NS_ABORT_MSG_IF (m_technicalSpec != TS_38_213, "This function is currently being used only for TS 38.213. ");
 
+  if (m_deltaPusch.empty ())
+    {
+      return; // no new TPC command, fc and the cached power are unchanged
+    }
+  InvalidatePuschCache ();
+
   // PUSCH power control accumulation or absolute value configuration
   if (m_accumulationEnabled)
     {
@@ -600,6 +654,27 @@ NrUePowerControl::CalculatePuschTxPowerNr (std::size_t rbNum)
     {
       return m_Pcmax;
     }
+  NS_ABORT_MSG_IF (rbNum == 0, "Should not be called CalculatePuschTxPowerNr if no RBs are assigned.");
+
+  /**
+   * Depends on the previous occasion timing and on the number
+   * of symbols since the last PDCCH, hence it should be updated
+   * at the transmission occasion time
+   */
+  if (m_technicalSpec == TS_38_213)
+    {
+      UpdateFc ();
+    }
+
+  uint16_t numerology = m_nrUePhy->GetNumerology ();
+  if (m_puschCache.m_valid && m_puschCache.m_rbNum == rbNum
+      && m_puschCache.m_numerology == numerology
+      && m_puschCache.m_pathLoss == m_pathLoss && m_puschCache.m_fc == m_fc)
+    {
+      NS_LOG_INFO ("PUSCH TxPower unchanged: " << m_puschCache.m_txPower << " for cellId/rnti: " << m_cellId << "," << m_rnti);
+      return m_puschCache.m_txPower;
+    }
+
   int32_t PoPusch = m_PoNominalPusch + m_PoUePusch;
 
   NS_LOG_INFO ("RBs: " << rbNum <<
@@ -608,18 +683,9 @@ NrUePowerControl::CalculatePuschTxPowerNr (std::size_t rbNum)
                " PathLoss: " << m_pathLoss <<
                " deltaTF: " << m_deltaTF <<
                " fc: " << m_fc <<
-               " numerology:" << m_nrUePhy->GetNumerology ());
-
-  double puschComponent = 0;
+               " numerology:" << numerology);
 
-  if (rbNum > 0)
-    {
-      puschComponent = 10 * log10 ( std::pow (2, m_nrUePhy->GetNumerology ()) * rbNum);
-    }
-  else
-    {
-      NS_ABORT_MSG ("Should not be called CalculatePuschTxPowerNr if no RBs are assigned.");
-    }
+  double puschComponent = GetRbComponentDb (rbNum);
 
   /**
    *  m_pathloss is a downlink path-loss estimate in dB calculated by the UE using
@@ -637,16 +703,6 @@ NrUePowerControl::CalculatePuschTxPowerNr (std::size_t rbNum)
    *  fc is accumulation or current absolute (calculation by using correction values received in TPC commands)
    */
 
-  /**
-   * Depends on the previous occasion timing and on the number
-   * of symbols since the last PDCCH, hence it should be updated
-   * at the transmission occasion time
-   */
-  if (m_technicalSpec == TS_38_213)
-    {
-      UpdateFc ();
-    }
-
   double txPower = PoPusch + puschComponent + m_alpha * m_pathLoss + m_deltaTF + m_fc;
 
   NS_LOG_INFO ("Calculated PUSCH power:" << txPower << " MinPower: " << m_Pcmin << " MaxPower:" << m_Pcmax);
@@ -655,6 +711,13 @@ NrUePowerControl::CalculatePuschTxPowerNr (std::size_t rbNum)
 
   NS_LOG_INFO ("PUSCH TxPower after min/max constraints: " << txPower << " for cellId/rnti: " << m_cellId << "," << m_rnti);
 
+  m_puschCache.m_valid = true;
+  m_puschCache.m_rbNum = rbNum;
+  m_puschCache.m_numerology = numerology;
+  m_puschCache.m_pathLoss = m_pathLoss;
+  m_puschCache.m_fc = m_fc;
+  m_puschCache.m_txPower = txPower;
+
   return txPower;
 }
 
@@ -674,7 +737,7 @@ NrUePowerControl::CalculatePucchTxPowerNr (std::size_t rbNum)
   double pucchComponent = 0;
   if (rbNum > 0)
     {
-      pucchComponent = 10 * log10 ( std::pow (2, m_nrUePhy->GetNumerology ()) * rbNum);
+      pucchComponent = GetRbComponentDb (rbNum);
     }
   else
     {
@@ -757,7 +820,7 @@ NrUePowerControl::CalculateSrsTxPowerNr (std::size_t rbNum)
 
   if (rbNum > 0)
     {
-      component = 10 * log10 (std::pow (2, m_nrUePhy->GetNumerology ()) * rbNum);
+      component = GetRbComponentDb (rbNum);
     }
   else
     {
@@ -793,6 +856,23 @@ NrUePowerControl::GetPuschTxPower (std::size_t rbNum)
   return m_curPuschTxPower;
 }
 
+double
+NrUePowerControl::GetRbComponentDb (std::size_t rbNum) const
+{
+  NS_ASSERT (rbNum > 0);
+  // 10 * log10 (2^mu)
+  static const double numerologyDbStep = 10 * std::log10 (2.0);
+  double rbDb = rbNum <= MAX_TABLE_RB ? GetRbDbTable ()[rbNum]
+                                      : 10 * std::log10 (static_cast<double> (rbNum));
+  return rbDb + m_nrUePhy->GetNumerology () * numerologyDbStep;
+}
+
+void
+NrUePowerControl::InvalidatePuschCache ()
+{
+  m_puschCache.m_valid = false;
+}
+
 double
 NrUePowerControl::GetPucchTxPower (std::size_t rbNum)
 {
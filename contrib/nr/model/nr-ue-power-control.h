@@ -323,6 +323,18 @@ private:
     * \param rbNum number of RBs
     */
   double CalculateSrsTxPowerNr (std::size_t rbNum);
+  /**
+   * \brief Get the bandwidth term of the TS 38.213 formulas,
+   * 10 * log10 (2^mu * rbNum), from a precomputed table
+   * \param rbNum number of RBs, must be greater than 0
+   * \return the bandwidth component in dB
+   */
+  double GetRbComponentDb (std::size_t rbNum) const;
+  /**
+   * \brief Invalidate the cached PUSCH transmit power. To be called
+   * whenever one of the inputs of the PUSCH formula changes.
+   */
+  void InvalidatePuschCache ();
 
   // general attributes
   bool m_closedLoop {true};                     //!< is closed loop
@@ -366,6 +378,23 @@ private:
   double m_gc {0.0};                            //!< Is the current PUCCH power control adjustment state. This variable is used for calculation of PUCCH transmit power.
   double m_hc {0.0};                            //!< Is the current SRS power control adjustment state. This variable is used for calculation of SRS transmit power.
 
+  /**
+   * \brief PUSCH transmit power computed for the last RB allocation size.
+   * It is reused only for the same RB allocation size, pathloss and TPC
+   * accumulation state, and it is invalidated when one of the PUSCH
+   * parameters changes.
+   */
+  struct PuschPowerCache
+  {
+    bool m_valid {false};     //!< Is the cached value usable?
+    std::size_t m_rbNum {0};  //!< RB allocation size of the cached value
+    uint16_t m_numerology {0};//!< Numerology of the cached value
+    double m_pathLoss {0.0};  //!< Pathloss of the cached value
+    double m_fc {0.0};        //!< PUSCH power control adjustment state of the cached value
+    double m_txPower {0.0};   //!< Cached PUSCH transmit power (dBm)
+  };
+  PuschPowerCache m_puschCache; //!< Cached PUSCH power state
+
   //another attributes needed for function calls
   Ptr<NrUePhy> m_nrUePhy;                       //!< NrUePhy instance owner
 
@@ -0,0 +1,147 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include "nr-ul-tb-tag.h"
+#include "a-packet-tags.h"
+
+namespace ns3 {
+
+NS_OBJECT_ENSURE_REGISTERED (NrUlTbTag);
+
+TypeId
+NrUlTbTag::GetTypeId (void)
+{
+  static TypeId tid = TypeId ("ns3::NrUlTbTag")
+    .SetParent<Tag> ()
+    .SetGroupName ("nr")
+    .AddConstructor<NrUlTbTag> ()
+  ;
+  return tid;
+}
+
+TypeId
+NrUlTbTag::GetInstanceTypeId (void) const
+{
+  return GetTypeId ();
+}
+
+void
+NrUlTbTag::AddSubPdu (const SubPdu &subPdu)
+{
+  m_subPdus.push_back (subPdu);
+}
+
+const std::vector<NrUlTbTag::SubPdu> &
+NrUlTbTag::GetSubPdus () const
+{
+  return m_subPdus;
+}
+
+NrUlTbTag::SubPdu
+NrUlTbTag::ExtractSubPdu (const Ptr<Packet> &p, uint8_t lcid)
+{
+  SubPdu subPdu;
+  subPdu.m_lcid = lcid;
+  subPdu.m_size = p->GetSize ();
+
+  if (p->RemovePacketTag (subPdu.m_metadata))
+    {
+      subPdu.m_hasMetadata = true;
+      subPdu.m_hasSeqNum = true;
+      return subPdu;
+    }
+
+  // Packets tagged with the tags that NrAoiMetadataTag replaces
+  PacketCreationTimeTag creationTimeTag;
+  if (p->RemovePacketTag (creationTimeTag))
+    {
+      subPdu.m_hasMetadata = true;
+      subPdu.m_metadata.SetCreationTime (creationTimeTag.GetCreationTime ());
+
+      PacketUeIdTag ueIdTag;
+      if (p->RemovePacketTag (ueIdTag))
+        {
+          subPdu.m_metadata.SetUeId (ueIdTag.GetUeId ());
+        }
+
+      PacketUrgencyTag urgencyTag;
+      if (p->RemovePacketTag (urgencyTag))
+        {
+          subPdu.m_metadata.SetUrgency (urgencyTag.GetUrgency ());
+        }
+    }
+
+  return subPdu;
+}
+
+void
+NrUlTbTag::Serialize (TagBuffer i) const
+{
+  i.WriteU16 (static_cast<uint16_t> (m_subPdus.size ()));
+  for (const auto & subPdu : m_subPdus)
+    {
+      i.WriteU8 (subPdu.m_lcid);
+      i.WriteU32 (subPdu.m_size);
+      i.WriteU8 ((subPdu.m_hasMetadata ? 1 : 0) | (subPdu.m_hasSeqNum ? 2 : 0));
+      if (subPdu.m_hasMetadata)
+        {
+          subPdu.m_metadata.Serialize (i);
+        }
+    }
+}
+
+void
+NrUlTbTag::Deserialize (TagBuffer i)
+{
+  m_subPdus.resize (i.ReadU16 ());
+  for (auto & subPdu : m_subPdus)
+    {
+      subPdu.m_lcid = i.ReadU8 ();
+      subPdu.m_size = i.ReadU32 ();
+      uint8_t flags = i.ReadU8 ();
+      subPdu.m_hasMetadata = (flags & 1) != 0;
+      subPdu.m_hasSeqNum = (flags & 2) != 0;
+      if (subPdu.m_hasMetadata)
+        {
+          subPdu.m_metadata.Deserialize (i);
+        }
+    }
+}
+
+uint32_t
+NrUlTbTag::GetSerializedSize () const
+{
+  uint32_t size = 2;
+  for (const auto & subPdu : m_subPdus)
+    {
+      size += 1 + 4 + 1;
+      size += subPdu.m_hasMetadata ? subPdu.m_metadata.GetSerializedSize () : 0;
+    }
+  return size;
+}
+
+void
+NrUlTbTag::Print (std::ostream &os) const
+{
+  for (const auto & subPdu : m_subPdus)
+    {
+      os << "(lcid=" << static_cast<uint32_t> (subPdu.m_lcid) << ", size=" << subPdu.m_size << ") ";
+    }
+}
+
+} // namespace ns3
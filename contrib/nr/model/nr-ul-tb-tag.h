@@ -0,0 +1,109 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+#pragma once
+
+#include <ns3/tag.h>
+#include <ns3/packet.h>
+#include "nr-aoi-metadata-tag.h"
+
+#include <vector>
+
+namespace ns3 {
+
+/**
+ * \ingroup ue-mac
+ * \ingroup gnb-mac
+ * \brief Metadata of the subPDUs of an UL TB
+ *
+ * When the UE MAC batches the subPDUs of an UL DCI into a single packet
+ * (see the NrUeMac UlTbBatching attribute), the packet tags of the
+ * subPDUs are lost in the concatenation. This tag, attached once to the
+ * whole TB as a byte tag, keeps for each subPDU (in order) its LC ID, its
+ * size (MAC subheader included), and the AoI metadata of the packet
+ * (NrAoiMetadataTag) that the gNB MAC needs. With it, the gNB
+ * MAC splits the TB in a single pass, without peeking the MAC headers.
+ *
+ * Byte tags have no size limit, and survive the concatenation and the
+ * fragmentation of the packet.
+ */
+class NrUlTbTag : public Tag
+{
+public:
+  /**
+   * \brief Metadata of a subPDU
+   */
+  struct SubPdu
+  {
+    uint8_t m_lcid {0};              //!< LC ID of the subPDU (data or CE)
+    uint32_t m_size {0};             //!< Size of the subPDU, subheader included
+    bool m_hasMetadata {false};      //!< Is m_metadata valid?
+    bool m_hasSeqNum {false};        //!< Does m_metadata carry a sequence number?
+    NrAoiMetadataTag m_metadata;     //!< AoI metadata of the packet
+  };
+
+  /**
+   * \brief Get the object TypeId
+   * \return the object type id
+   */
+  static TypeId GetTypeId (void);
+
+  /**
+   * \brief Get the InstanceTypeId
+   * \return the TypeId of the instance
+   */
+  virtual TypeId GetInstanceTypeId (void) const override;
+
+  /**
+   * \brief Create an empty NrUlTbTag
+   */
+  NrUlTbTag () = default;
+
+  /**
+   * \brief Append the metadata of a subPDU
+   * \param subPdu the metadata
+   */
+  void AddSubPdu (const SubPdu &subPdu);
+
+  /**
+   * \return the metadata of the subPDUs, in the order they are in the TB
+   */
+  const std::vector<SubPdu> & GetSubPdus () const;
+
+  /**
+   * \brief Build the metadata of a subPDU, moving its packet tags into it
+   * \param p the subPDU, from which the NrAoiMetadataTag (or the old creation
+   * time, UE id and urgency tags) are removed
+   * \param lcid LC ID of the subPDU
+   * \return the metadata of the subPDU
+   *
+   * The old tags have no sequence number: their metadata has m_hasSeqNum
+   * unset, and the gNB does not track the losses of their flow.
+   */
+  static SubPdu ExtractSubPdu (const Ptr<Packet> &p, uint8_t lcid);
+
+  // inherited
+  virtual void Serialize (TagBuffer i) const override;
+  virtual void Deserialize (TagBuffer i) override;
+  virtual uint32_t GetSerializedSize () const override;
+  virtual void Print (std::ostream &os) const override;
+
+private:
+  std::vector<SubPdu> m_subPdus; //!< Metadata of the subPDUs
+};
+
+} // namespace ns3
@@ -0,0 +1,163 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <ns3/test.h>
+#include <ns3/nr-mac-harq-vector.h>
+
+/**
+ * \file nr-test-mac-harq-vector.cc
+ * \ingroup test
+ *
+ * \brief Preemption of the HARQ processes in NrMacHarqVector: the feedback
+ * of a preempted TB, that arrives after its process ID has been given to a
+ * new TB, must be recognized as stale and must not touch the new TB.
+ */
+namespace ns3 {
+
+/**
+ * \ingroup test
+ * \brief Fill the vector, preempt a process and deliver the late feedback
+ */
+class NrMacHarqVectorPreemptionTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Create NrMacHarqVectorPreemptionTestCase
+   */
+  NrMacHarqVectorPreemptionTestCase ()
+    : TestCase ("Feedback of a preempted HARQ process")
+  {
+  }
+
+private:
+  virtual void DoRun (void) override;
+};
+
+/**
+ * \brief Create a DL data DCI for a test process
+ * \return the DCI
+ */
+static std::shared_ptr<DciInfoElementTdma>
+CreateDci ()
+{
+  return std::make_shared<DciInfoElementTdma> (0, 1, DciInfoElementTdma::DL, DciInfoElementTdma::DATA,
+                                               std::vector<uint8_t> (1, 1));
+}
+
+void
+NrMacHarqVectorPreemptionTestCase::DoRun ()
+{
+  const uint8_t numProcesses = 4;
+  NrMacHarqVector harq (numProcesses);
+  harq.SetOverflowPolicy (NrMacHarqVector::PREEMPT_OLDEST);
+
+  std::vector<uint8_t> preempted;
+  harq.SetPreemptionCallback ([&preempted] (uint8_t id, const HarqProcess &process)
+    {
+      NS_ASSERT (process.m_active);
+      preempted.push_back (id);
+    });
+
+  // Fill the vector: the lower the ID, the longer the process has waited
+  for (uint8_t i = 0; i < numProcesses; ++i)
+    {
+      uint8_t id;
+      auto dci = CreateDci ();
+      NS_TEST_ASSERT_MSG_EQ (harq.Insert (&id, HarqProcess (true, HarqProcess::WAITING_FEEDBACK, 0, dci)),
+                             true, "Insert failed with free processes");
+      NS_TEST_ASSERT_MSG_EQ (+id, +i, "Unexpected process ID");
+    }
+  for (uint8_t i = 0; i < numProcesses; ++i)
+    {
+      harq.Get (i).m_timer = numProcesses - i;
+    }
+  // A NACKed process is never preempted, even if it is the oldest one
+  harq.Get (0).m_status = HarqProcess::RECEIVED_FEEDBACK;
+
+  NS_TEST_ASSERT_MSG_EQ (harq.CanInsert (), true, "A process should be preemptable");
+
+  uint8_t newId;
+  auto newDci = CreateDci ();
+  NS_TEST_ASSERT_MSG_EQ (harq.Insert (&newId, HarqProcess (true, HarqProcess::WAITING_FEEDBACK, 0, newDci)),
+                         true, "Insert with preemption failed");
+  NS_TEST_ASSERT_MSG_EQ (+newId, 1, "The oldest process waiting for feedback should be preempted");
+  NS_TEST_ASSERT_MSG_EQ (preempted.size (), 1U, "The owner should be notified once");
+  NS_TEST_ASSERT_MSG_EQ (+preempted.front (), +newId, "The owner was notified of the wrong process");
+  NS_TEST_ASSERT_MSG_EQ (harq.GetPreemptedCount (), 1U, "Wrong preemption count");
+  NS_TEST_ASSERT_MSG_EQ (harq.Get (newId).m_dciElement, newDci, "The process should store the new TB");
+
+  // The late feedback of the preempted TB is stale, the next one is not
+  NS_TEST_ASSERT_MSG_EQ (harq.ConsumeStaleFeedback (newId), true,
+                         "The feedback of the preempted TB should be stale");
+  NS_TEST_ASSERT_MSG_EQ (harq.Get (newId).m_active, true, "A stale feedback must not touch the new TB");
+  NS_TEST_ASSERT_MSG_EQ (harq.ConsumeStaleFeedback (newId), false,
+                         "The feedback of the new TB should not be stale");
+
+  // Feedbacks of the processes that were not preempted are never stale
+  for (uint8_t i = 0; i < numProcesses; ++i)
+    {
+      if (i != newId)
+        {
+          NS_TEST_ASSERT_MSG_EQ (harq.ConsumeStaleFeedback (i), false,
+                                 "Feedback of a process not preempted is stale");
+        }
+    }
+
+  // When the new TB expires, the feedback of the preempted TB that never
+  // arrived is forgotten
+  uint8_t otherId;
+  harq.Get (2).m_timer = numProcesses + 1;
+  NS_TEST_ASSERT_MSG_EQ (harq.Insert (&otherId, HarqProcess (true, HarqProcess::WAITING_FEEDBACK, 0, newDci)),
+                         true, "Insert with preemption failed");
+  NS_TEST_ASSERT_MSG_EQ (+otherId, 2, "The oldest process waiting for feedback should be preempted");
+  harq.Erase (otherId);
+  harq.ClearStaleFeedback (otherId);
+  NS_TEST_ASSERT_MSG_EQ (harq.ConsumeStaleFeedback (otherId), false,
+                         "The stale feedback should be forgotten when the process expires");
+
+  // Without the PREEMPT_OLDEST policy a full vector refuses the insertion
+  NrMacHarqVector full (1);
+  uint8_t id;
+  NS_TEST_ASSERT_MSG_EQ (full.Insert (&id, HarqProcess (true, HarqProcess::WAITING_FEEDBACK, 0, newDci)),
+                         true, "Insert failed with free processes");
+  NS_TEST_ASSERT_MSG_EQ (full.CanInsert (), false, "A full vector should not accept processes");
+  NS_TEST_ASSERT_MSG_EQ (full.Insert (&id, HarqProcess (true, HarqProcess::WAITING_FEEDBACK, 0, newDci)),
+                         false, "Insert should fail without the preemption policy");
+  NS_TEST_ASSERT_MSG_EQ (full.ConsumeStaleFeedback (0), false, "No feedback can be stale without preemption");
+}
+
+/**
+ * \ingroup test
+ * \brief The test suite of NrMacHarqVector
+ */
+class NrMacHarqVectorTestSuite : public TestSuite
+{
+public:
+  /**
+   * \brief Create NrMacHarqVectorTestSuite
+   */
+  NrMacHarqVectorTestSuite ()
+    : TestSuite ("nr-test-mac-harq-vector", UNIT)
+  {
+    AddTestCase (new NrMacHarqVectorPreemptionTestCase (), TestCase::QUICK);
+  }
+};
+
+static NrMacHarqVectorTestSuite nrMacHarqVectorTestSuite; //!< NrMacHarqVector test suite
+
+} // namespace ns3
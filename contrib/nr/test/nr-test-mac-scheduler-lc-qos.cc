@@ -0,0 +1,204 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <ns3/test.h>
+#include <ns3/object.h>
+#include <ns3/eps-bearer.h>
+#include <ns3/nr-mac-scheduler-tdma-rr.h>
+
+/**
+ * \file nr-test-mac-scheduler-lc-qos.cc
+ * \ingroup test
+ *
+ * \brief Distribution of the TB bytes between the LCs of a UE with the
+ * QoS-aware method (NrMacSchedulerNs3::AssignBytesToLCByQos): every LC
+ * served gets room for its MAC subheader, the strict-priority LCs are
+ * drained in one TB, no byte of the TB is lost, and in UL the LCs not
+ * served keep their queue.
+ */
+namespace ns3 {
+
+/**
+ * \ingroup test
+ * \brief Test of NrMacSchedulerNs3::AssignBytesToLCByQos
+ */
+class NrLcQosAssignmentTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Create NrLcQosAssignmentTestCase
+   */
+  NrLcQosAssignmentTestCase ()
+    : TestCase ("QoS-aware distribution of the TB bytes between the LCs")
+  {
+  }
+
+private:
+  virtual void DoRun (void) override;
+
+  /**
+   * \brief Add an LC, in its own LCG, with data to transmit
+   * \param lcgs the LCGs of the UE
+   * \param lcId the LC ID (also used as LCG ID)
+   * \param qci QCI of the LC, that sets GBR and priority
+   * \param buffer bytes in the LC buffer
+   */
+  static void AddLc (LCGMap *lcgs, uint8_t lcId, EpsBearer::Qci qci, uint32_t buffer);
+
+  /**
+   * \brief Distribute the bytes and check the invariants of the distribution
+   * \param sched the scheduler
+   * \param lcgs the LCGs of the UE
+   * \param tbs the TBS to distribute
+   * \param isDl the direction
+   * \return the bytes assigned to each LC ID
+   */
+  std::map<uint8_t, uint32_t> Assign (const Ptr<NrMacSchedulerNs3> &sched, const LCGMap &lcgs,
+                                      uint32_t tbs, bool isDl);
+};
+
+void
+NrLcQosAssignmentTestCase::AddLc (LCGMap *lcgs, uint8_t lcId, EpsBearer::Qci qci, uint32_t buffer)
+{
+  LogicalChannelConfigListElement_s conf;
+  conf.m_logicalChannelIdentity = lcId;
+  conf.m_logicalChannelGroup = lcId;
+  conf.m_qci = qci;
+
+  auto lcg = std::unique_ptr<NrMacSchedulerLCG> (new NrMacSchedulerLCG (lcId));
+  lcg->Insert (std::unique_ptr<NrMacSchedulerLC> (new NrMacSchedulerLC (conf)));
+
+  NrMacSchedSapProvider::SchedDlRlcBufferReqParameters params {};
+  params.m_logicalChannelIdentity = lcId;
+  params.m_rlcTransmissionQueueSize = buffer;
+  lcg->UpdateInfo (params);
+
+  lcgs->emplace (std::make_pair (lcId, std::move (lcg)));
+}
+
+std::map<uint8_t, uint32_t>
+NrLcQosAssignmentTestCase::Assign (const Ptr<NrMacSchedulerNs3> &sched, const LCGMap &lcgs,
+                                   uint32_t tbs, bool isDl)
+{
+  std::map<uint8_t, uint32_t> bytes;
+  uint32_t total = 0;
+  for (const auto & assignation : sched->AssignBytesToLCByQos (lcgs, tbs, isDl))
+    {
+      // An LC served must have room for the MAC subheader and for some data
+      NS_TEST_EXPECT_MSG_EQ ((assignation.m_bytes == 0 || assignation.m_bytes > 3), true,
+                             "LC " << +assignation.m_lcId << " got only " << assignation.m_bytes << " bytes");
+      bytes[assignation.m_lcId] = assignation.m_bytes;
+      total += assignation.m_bytes;
+    }
+  NS_TEST_EXPECT_MSG_EQ (total, tbs, "The whole TB should be assigned");
+  return bytes;
+}
+
+void
+NrLcQosAssignmentTestCase::DoRun ()
+{
+  Ptr<NrMacSchedulerNs3> sched = CreateObject<NrMacSchedulerTdmaRR> ();
+
+  {
+    // Small remainder: the GBR LC leaves 2 bytes, too few for the other
+    // LC, and they go to the GBR LC
+    LCGMap lcgs;
+    AddLc (&lcgs, 1, EpsBearer::GBR_CONV_VOICE, 95);
+    AddLc (&lcgs, 2, EpsBearer::NGBR_VIDEO_TCP_DEFAULT, 50);
+    auto bytes = Assign (sched, lcgs, 100, true);
+    NS_TEST_ASSERT_MSG_EQ (bytes.at (1), 100, "The GBR LC should take the small remainder");
+    NS_TEST_ASSERT_MSG_EQ (bytes.at (2), 0, "The proportional LC should not get 2 bytes");
+  }
+
+  {
+    // The GBR LC takes its buffer plus its subheader, and it is drained
+    LCGMap lcgs;
+    AddLc (&lcgs, 1, EpsBearer::GBR_CONV_VOICE, 98);
+    AddLc (&lcgs, 2, EpsBearer::NGBR_VIDEO_TCP_DEFAULT, 50);
+    auto bytes = Assign (sched, lcgs, 100, true);
+    NS_TEST_ASSERT_MSG_EQ (bytes.at (1), 100, "The GBR LC should get the whole TB");
+    NS_TEST_ASSERT_MSG_EQ (bytes.at (2), 0, "No byte should be left to the proportional LC");
+
+    bytes = Assign (sched, lcgs, 200, true);
+    NS_TEST_ASSERT_MSG_EQ (bytes.at (1), 98 + 3, "The GBR LC should get its buffer and its subheader");
+    NS_TEST_ASSERT_MSG_EQ (bytes.at (2), 200 - 98 - 3, "The proportional LC should get the rest");
+  }
+
+  {
+    // A proportional share below the subheader goes to the next LC
+    LCGMap lcgs;
+    AddLc (&lcgs, 1, EpsBearer::NGBR_VIDEO_TCP_DEFAULT, 1);
+    AddLc (&lcgs, 2, EpsBearer::NGBR_VIDEO_TCP_DEFAULT, 1000);
+    auto bytes = Assign (sched, lcgs, 100, true);
+    NS_TEST_ASSERT_MSG_EQ (bytes.at (1), 0, "The share of the small LC is too small");
+    NS_TEST_ASSERT_MSG_EQ (bytes.at (2), 100, "The next LC should take the small share");
+  }
+
+  {
+    // In UL, an LC that gets no byte of the TB keeps its queue
+    LCGMap lcgs;
+    AddLc (&lcgs, 1, EpsBearer::GBR_CONV_VOICE, 95);
+    AddLc (&lcgs, 2, EpsBearer::NGBR_VIDEO_TCP_DEFAULT, 50);
+    auto bytes = Assign (sched, lcgs, 100, false);
+    NS_TEST_ASSERT_MSG_EQ (bytes.at (2), 0, "The proportional LC should not be served");
+
+    sched->UpdateUlLCG (lcgs, sched->AssignBytesToLCByQos (lcgs, 100, false));
+    NS_TEST_ASSERT_MSG_EQ (lcgs.at (2)->GetTotalSizeOfLC (2), 50, "The queue of an LC not served changed");
+    NS_TEST_ASSERT_MSG_EQ (lcgs.at (2)->GetTotalSize (), 50, "The size of an LCG not served changed");
+    NS_TEST_ASSERT_MSG_LT (lcgs.at (1)->GetTotalSizeOfLC (1), 95, "The queue of the LC served should shrink");
+  }
+
+  {
+    // The configured-grant LC has the strict priority only in UL
+    LCGMap lcgs;
+    AddLc (&lcgs, 1, EpsBearer::GBR_CONV_VOICE, 50);
+    AddLc (&lcgs, 2, EpsBearer::NGBR_VIDEO_TCP_DEFAULT, 50);
+    sched->m_lcid_configuredGrant = 2;
+
+    auto bytes = Assign (sched, lcgs, 60, false);
+    NS_TEST_ASSERT_MSG_EQ (bytes.at (2), 53, "In UL the configured-grant LC should be served first");
+    NS_TEST_ASSERT_MSG_EQ (bytes.at (1), 7, "In UL the GBR LC should come after the configured-grant LC");
+
+    bytes = Assign (sched, lcgs, 60, true);
+    NS_TEST_ASSERT_MSG_EQ (bytes.at (1), 53, "In DL the GBR LC should be served first");
+    NS_TEST_ASSERT_MSG_EQ (bytes.at (2), 7, "In DL the configured-grant LC is not prioritized");
+  }
+
+  sched->Dispose ();
+}
+
+/**
+ * \ingroup test
+ * \brief The test suite of the QoS-aware distribution of the TB bytes
+ */
+class NrLcQosAssignmentTestSuite : public TestSuite
+{
+public:
+  /**
+   * \brief Create NrLcQosAssignmentTestSuite
+   */
+  NrLcQosAssignmentTestSuite ()
+    : TestSuite ("nr-test-mac-scheduler-lc-qos", UNIT)
+  {
+    AddTestCase (new NrLcQosAssignmentTestCase (), TestCase::QUICK);
+  }
+};
+
+static NrLcQosAssignmentTestSuite nrLcQosAssignmentTestSuite; //!< QoS-aware LC assignment test suite
+
+} // namespace ns3
@@ -0,0 +1,206 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <ns3/test.h>
+#include <ns3/object.h>
+#include <ns3/nr-amc.h>
+#include <ns3/nr-mac-scheduler-ofdma-rr.h>
+#include <ns3/nr-mac-scheduler-ue-info-rr.h>
+
+/**
+ * \file nr-test-mac-scheduler-ul-freq-selective.cc
+ * \ingroup test
+ *
+ * \brief Frequency-selective UL allocation of the OFDMA scheduler
+ * (NrMacSchedulerOfdma::AssignUlRbgFrequencySelective): each RBG goes to the
+ * UE with the best sub-band MCS on it, and the RBGs without a sub-band
+ * report are scored with the wideband MCS, on the same scale.
+ */
+namespace ns3 {
+
+/**
+ * \ingroup test
+ * \brief Scheduler SAP user that only answers the questions of the UL allocation
+ */
+class NrUlFsTestSchedSapUser : public NrMacSchedSapUser
+{
+public:
+  virtual void SchedConfigInd ([[maybe_unused]] const struct SchedConfigIndParameters& params) override
+  {
+  }
+  virtual Ptr<const SpectrumModel> GetSpectrumModel () const override
+  {
+    return nullptr;
+  }
+  virtual uint32_t GetNumRbPerRbg () const override
+  {
+    return 4;
+  }
+  virtual uint8_t GetNumHarqProcess () const override
+  {
+    return 16;
+  }
+  virtual uint16_t GetBwpId () const override
+  {
+    return 0;
+  }
+  virtual uint16_t GetCellId () const override
+  {
+    return 0;
+  }
+  virtual uint32_t GetSymbolsPerSlot () const override
+  {
+    return 14;
+  }
+  virtual Time GetSlotPeriod () const override
+  {
+    return MilliSeconds (1);
+  }
+  virtual std::vector<LteNrTddSlotType> GetTddPattern () const override
+  {
+    return std::vector<LteNrTddSlotType> (1, LteNrTddSlotType::F);
+  }
+  virtual void NotifyHarqPreemption ([[maybe_unused]] uint16_t rnti,
+                                     [[maybe_unused]] uint8_t harqProcessId,
+                                     [[maybe_unused]] bool isDl) override
+  {
+  }
+  virtual Time GetTbUlEncodeLatency () const override
+  {
+    return Seconds (0);
+  }
+};
+
+/**
+ * \ingroup test
+ * \brief Assign the UL RBGs of a beam to two UEs with different sub-band MCS
+ */
+class NrUlFrequencySelectiveTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Create NrUlFrequencySelectiveTestCase
+   */
+  NrUlFrequencySelectiveTestCase ()
+    : TestCase ("Frequency-selective UL allocation by sub-band MCS")
+  {
+  }
+
+private:
+  virtual void DoRun (void) override;
+
+  /**
+   * \brief Create an UE with a large UL buffer
+   * \param rnti RNTI of the UE
+   * \param wbMcs wideband UL MCS
+   * \param sbMcs sub-band MCS of each RBG, 0 for a RBG not reported
+   * \return the UE and its buffer
+   */
+  static NrMacSchedulerNs3::UePtrAndBufferReq CreateUe (uint16_t rnti, uint8_t wbMcs,
+                                                        const std::vector<uint8_t> &sbMcs);
+
+  /**
+   * \brief Run the allocation and check the RBG mask of each UE
+   * \param ues the UEs
+   * \param expected expected RBG mask of each UE
+   */
+  void CheckAllocation (const std::vector<NrMacSchedulerNs3::UePtrAndBufferReq> &ues,
+                        const std::vector<std::vector<uint8_t> > &expected);
+
+  static const uint16_t NUM_RBG = 4; //!< Bandwidth, in RBG
+  Ptr<NrMacSchedulerOfdmaRR> m_sched; //!< The scheduler
+};
+
+NrMacSchedulerNs3::UePtrAndBufferReq
+NrUlFrequencySelectiveTestCase::CreateUe (uint16_t rnti, uint8_t wbMcs, const std::vector<uint8_t> &sbMcs)
+{
+  auto ue = std::make_shared<NrMacSchedulerUeInfoRR> (rnti, BeamConfId (), [] () { return 4U; });
+  ue->m_ulMcs = wbMcs;
+  ue->m_ulCqi.m_numSb = static_cast<uint16_t> (sbMcs.size ());
+  for (size_t rbg = 0; rbg < sbMcs.size (); ++rbg)
+    {
+      if (sbMcs[rbg] > 0)
+        {
+          ue->m_ulCqi.m_sbMcs[rbg] = sbMcs[rbg];
+          ue->m_ulCqi.m_sbReported[rbg] = true;
+        }
+    }
+  return std::make_pair (ue, 100000U);
+}
+
+void
+NrUlFrequencySelectiveTestCase::CheckAllocation (const std::vector<NrMacSchedulerNs3::UePtrAndBufferReq> &ues,
+                                                 const std::vector<std::vector<uint8_t> > &expected)
+{
+  m_sched->AssignUlRbgFrequencySelective (1, ues);
+  for (size_t i = 0; i < ues.size (); ++i)
+    {
+      const auto & ue = ues[i].first;
+      NS_TEST_ASSERT_MSG_EQ (ue->m_ulRbgMask.size (), static_cast<size_t> (NUM_RBG),
+                             "UE " << ue->m_rnti << " did not get any RBG");
+      for (uint16_t rbg = 0; rbg < NUM_RBG; ++rbg)
+        {
+          NS_TEST_EXPECT_MSG_EQ (+ue->m_ulRbgMask[rbg], +expected[i][rbg],
+                                 "Wrong assignment of RBG " << rbg << " to UE " << ue->m_rnti);
+        }
+    }
+}
+
+void
+NrUlFrequencySelectiveTestCase::DoRun ()
+{
+  NrUlFsTestSchedSapUser sapUser;
+  m_sched = CreateObject<NrMacSchedulerOfdmaRR> ();
+  m_sched->SetMacSchedSapUser (&sapUser);
+  m_sched->InstallUlAmc (CreateObject<NrAmc> ());
+  m_sched->m_bandwidth = NUM_RBG;
+
+  // Each UE gets the RBGs where its sub-band MCS is the highest
+  CheckAllocation ({CreateUe (1, 10, {20, 20, 5, 5}), CreateUe (2, 10, {5, 5, 20, 20})},
+                   {{1, 1, 0, 0}, {0, 0, 1, 1}});
+
+  // The RBGs without a sub-band report are scored with the wideband MCS:
+  // the first UE wins only the RBG where its reported MCS is above the
+  // wideband MCS of the second UE
+  CheckAllocation ({CreateUe (1, 2, {20, 0, 0, 0}), CreateUe (2, 10, {})},
+                   {{1, 0, 0, 0}, {0, 1, 1, 1}});
+
+  m_sched->Dispose ();
+  m_sched = nullptr;
+}
+
+/**
+ * \ingroup test
+ * \brief The test suite of the frequency-selective UL allocation
+ */
+class NrUlFrequencySelectiveTestSuite : public TestSuite
+{
+public:
+  /**
+   * \brief Create NrUlFrequencySelectiveTestSuite
+   */
+  NrUlFrequencySelectiveTestSuite ()
+    : TestSuite ("nr-test-mac-scheduler-ul-freq-selective", UNIT)
+  {
+    AddTestCase (new NrUlFrequencySelectiveTestCase (), TestCase::QUICK);
+  }
+};
+
+static NrUlFrequencySelectiveTestSuite nrUlFrequencySelectiveTestSuite; //!< Frequency-selective UL allocation test suite
+
+} // namespace ns3
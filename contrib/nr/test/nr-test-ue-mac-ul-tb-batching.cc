@@ -0,0 +1,228 @@
+/* -*-  Mode: C++; c-file-style: "gnu"; indent-tabs-mode:nil; -*- */
+/*
+ *
+ *   This program is free software; you can redistribute it and/or modify
+ *   it under the terms of the GNU General Public License version 2 as
+ *   published by the Free Software Foundation;
+ *
+ *   This program is distributed in the hope that it will be useful,
+ *   but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *   GNU General Public License for more details.
+ *
+ *   You should have received a copy of the GNU General Public License
+ *   along with this program; if not, write to the Free Software
+ *   Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ */
+
+#include <ns3/test.h>
+#include <ns3/simulator.h>
+#include <ns3/lte-rlc-tag.h>
+#include <ns3/nr-ue-mac.h>
+#include <ns3/nr-phy-sap.h>
+
+/**
+ * \file nr-test-ue-mac-ul-tb-batching.cc
+ * \ingroup test
+ *
+ * \brief HARQ retransmission of a batched UL TB (NrUeMac UlTbBatching
+ * attribute): the retransmitted TB carries the same subPDUs, with the byte
+ * tags that the gNB RLC needs (RlcTag), and a single NrUlTbTag.
+ */
+namespace ns3 {
+
+/**
+ * \ingroup test
+ * \brief PHY SAP that stores the MAC PDUs sent by the UE MAC
+ */
+class NrUlTbTestPhySapProvider : public NrPhySapProvider
+{
+public:
+  virtual void SendMacPdu (const Ptr<Packet> &p, [[maybe_unused]] const SfnSf & sfn,
+                           [[maybe_unused]] uint8_t symStart,
+                           [[maybe_unused]] uint8_t streamId) override
+  {
+    m_sent.push_back (p);
+  }
+  virtual void SendControlMessage ([[maybe_unused]] Ptr<NrControlMessage> msg) override
+  {
+  }
+  virtual void SendRachPreamble ([[maybe_unused]] uint8_t PreambleId,
+                                 [[maybe_unused]] uint8_t Rnti) override
+  {
+  }
+  virtual void SetSlotAllocInfo ([[maybe_unused]] const SlotAllocInfo &slotAllocInfo) override
+  {
+  }
+  virtual void NotifyConnectionSuccessful () override
+  {
+  }
+  virtual BeamConfId GetBeamConfId ([[maybe_unused]] uint8_t rnti) const override
+  {
+    return BeamConfId ();
+  }
+  virtual Ptr<const SpectrumModel> GetSpectrumModel () override
+  {
+    return nullptr;
+  }
+  virtual uint16_t GetBwpId () const override
+  {
+    return 0;
+  }
+  virtual uint16_t GetCellId () const override
+  {
+    return 0;
+  }
+  virtual uint32_t GetSymbolsPerSlot () const override
+  {
+    return 14;
+  }
+  virtual Time GetSlotPeriod () const override
+  {
+    return MilliSeconds (1);
+  }
+  virtual uint32_t GetRbNum () const override
+  {
+    return 100;
+  }
+  virtual Time GetTbUlEncodeLatency () const override
+  {
+    return Seconds (0);
+  }
+  virtual std::vector<LteNrTddSlotType> GetTddPattern () const override
+  {
+    return std::vector<LteNrTddSlotType> (1, LteNrTddSlotType::F);
+  }
+  virtual void SetCgConfig ([[maybe_unused]] const std::shared_ptr<const NrCgConfig> &config) override
+  {
+  }
+
+  std::vector<Ptr<Packet> > m_sent; //!< MAC PDUs sent
+};
+
+/**
+ * \ingroup test
+ * \brief Send a batched UL TB, retransmit it, and check the retransmission
+ */
+class NrUlTbBatchingRetxTestCase : public TestCase
+{
+public:
+  /**
+   * \brief Create NrUlTbBatchingRetxTestCase
+   */
+  NrUlTbBatchingRetxTestCase ()
+    : TestCase ("HARQ retransmission of a batched UL TB")
+  {
+  }
+
+private:
+  virtual void DoRun (void) override;
+
+  /**
+   * \brief Check a TB sent to the PHY
+   * \param tb the TB
+   * \param size expected size of the TB
+   * \param subPdus expected number of subPDUs
+   */
+  void CheckTb (const Ptr<Packet> &tb, uint32_t size, std::size_t subPdus);
+};
+
+void
+NrUlTbBatchingRetxTestCase::CheckTb (const Ptr<Packet> &tb, uint32_t size, std::size_t subPdus)
+{
+  NS_TEST_ASSERT_MSG_EQ (tb->GetSize (), size, "Wrong TB size");
+
+  uint32_t ulTbTags = 0;
+  uint32_t rlcTags = 0;
+  ByteTagIterator it = tb->GetByteTagIterator ();
+  while (it.HasNext ())
+    {
+      ByteTagIterator::Item item = it.Next ();
+      if (item.GetTypeId () == NrUlTbTag::GetTypeId ())
+        {
+          ++ulTbTags;
+          NrUlTbTag tag;
+          item.GetTag (tag);
+          NS_TEST_EXPECT_MSG_EQ (tag.GetSubPdus ().size (), subPdus, "Wrong number of subPDUs");
+        }
+      else if (item.GetTypeId () == RlcTag::GetTypeId ())
+        {
+          ++rlcTags;
+        }
+    }
+  NS_TEST_EXPECT_MSG_EQ (ulTbTags, 1, "The TB should have a single NrUlTbTag");
+  NS_TEST_EXPECT_MSG_EQ (rlcTags, subPdus, "Each subPDU should keep its RlcTag");
+}
+
+void
+NrUlTbBatchingRetxTestCase::DoRun ()
+{
+  NrUlTbTestPhySapProvider phySap;
+  Ptr<NrUeMac> mac = CreateObject<NrUeMac> ();
+  mac->SetPhySapProvider (&phySap);
+  mac->SetNumHarqProcess (4);
+  mac->m_ulTbBatching = true;
+  mac->m_rnti = 1;
+
+  const uint8_t harqId = 2;
+  mac->m_ulDci = std::make_shared<DciInfoElementTdma> (1, DciInfoElementTdma::UL, 0, 14,
+                                                       std::vector<uint8_t> (1, 10),
+                                                       std::vector<uint32_t> (1, 1000),
+                                                       std::vector<uint8_t> (1, 1),
+                                                       std::vector<uint8_t> (1, 0),
+                                                       DciInfoElementTdma::DATA, 0, harqId,
+                                                       std::vector<uint8_t> (1, 1), 0);
+  mac->m_ulDci->m_harqProcess = harqId;
+
+  // Two data subPDUs, saved for HARQ, and a CE that is not
+  for (uint8_t lcid = 3; lcid <= 4; ++lcid)
+    {
+      Ptr<Packet> subPdu = Create<Packet> (100);
+      subPdu->AddByteTag (RlcTag (Simulator::Now ()));
+      mac->AddSubPduToUlTb (subPdu, lcid, true);
+    }
+  mac->AddSubPduToUlTb (Create<Packet> (5), 62, false);
+  mac->SendUlTb ();
+
+  NS_TEST_ASSERT_MSG_EQ (phySap.m_sent.size (), 1, "The TB was not sent");
+  NS_TEST_ASSERT_MSG_EQ (phySap.m_sent.back ()->GetSize (), 205, "Wrong size of the new TB");
+
+  // The retransmission carries the saved subPDUs, with their byte tags
+  mac->m_ulDciTotalUsed = 0;
+  mac->TransmitRetx ();
+  NS_TEST_ASSERT_MSG_EQ (mac->m_ulDciTotalUsed, 200, "The retransmitted bytes are not accounted");
+  mac->SendUlTb ();
+  NS_TEST_ASSERT_MSG_EQ (phySap.m_sent.size (), 2, "The retransmission was not sent");
+  CheckTb (phySap.m_sent.back (), 200, 2);
+
+  // A second retransmission does not accumulate tags
+  mac->TransmitRetx ();
+  mac->SendUlTb ();
+  NS_TEST_ASSERT_MSG_EQ (phySap.m_sent.size (), 3, "The second retransmission was not sent");
+  CheckTb (phySap.m_sent.back (), 200, 2);
+
+  mac->Dispose ();
+  Simulator::Destroy ();
+}
+
+/**
+ * \ingroup test
+ * \brief The test suite of the UL TB batching of NrUeMac
+ */
+class NrUlTbBatchingTestSuite : public TestSuite
+{
+public:
+  /**
+   * \brief Create NrUlTbBatchingTestSuite
+   */
+  NrUlTbBatchingTestSuite ()
+    : TestSuite ("nr-test-ue-mac-ul-tb-batching", UNIT)
+  {
+    AddTestCase (new NrUlTbBatchingRetxTestCase (), TestCase::QUICK);
+  }
+};
+
+static NrUlTbBatchingTestSuite nrUlTbBatchingTestSuite; //!< UL TB batching test suite
+
+} // namespace ns3
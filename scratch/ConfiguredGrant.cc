@@ -43,7 +43,10 @@
 #include "ns3/log.h"
 #include "ns3/antenna-module.h"
 #include "ns3/flow-monitor-module.h"
-#include "ns3/a-packet-tags.h"
+#include "ns3/nr-aoi-metadata-tag.h"
+#include "ns3/nr-aoi-stats-calculator.h"
+#include "ns3/nr-profiler.h"
+#include "ns3/file-scenario-helper.h"
 #include <cstdlib>  // 랜덤 값 생성에 필요
 #include <ctime>    // 시간 기반 시드 설정에 필요
 
@@ -83,7 +86,7 @@ public:
   MyModel ();
   virtual ~MyModel();
 
-  void Setup (Ptr<NetDevice> device, Address address, uint32_t packetSize, uint32_t nPackets, DataRate dataRate, uint8_t period, uint32_t deadline);
+  void Setup (Ptr<NetDevice> device, Address address, uint32_t packetSize, uint32_t nPackets, DataRate dataRate, uint8_t period, uint32_t deadline, uint32_t urgency = 0);
 
   // 하향링크(DL)
   void SendPacketDl ();
@@ -105,8 +108,10 @@ private:
   EventId         m_sendEvent;
   bool            m_running;
   uint32_t        m_packetsSent;
+  uint32_t        m_ulSeqNum;     // sequence number of the next UL packet of the flow
   uint8_t         m_periodicity;
   uint32_t        m_deadline;
+  uint32_t        m_urgency;      // 0이면 패킷마다 무작위 긴급도
 };
 
 
@@ -119,8 +124,10 @@ MyModel::MyModel ()
     m_sendEvent (),
     m_running (false),
     m_packetsSent (0),
+    m_ulSeqNum (0),
     m_periodicity(0),
-    m_deadline(0)
+    m_deadline(0),
+    m_urgency(0)
 {
 }
 
@@ -130,7 +137,7 @@ MyModel::~MyModel()
 }
 
 
-void MyModel::Setup (Ptr<NetDevice> device, Address address, uint32_t packetSize, uint32_t nPackets, DataRate dataRate, uint8_t period, uint32_t deadline)
+void MyModel::Setup (Ptr<NetDevice> device, Address address, uint32_t packetSize, uint32_t nPackets, DataRate dataRate, uint8_t period, uint32_t deadline, uint32_t urgency)
 {
   m_device = device;
   m_packetSize = packetSize;
@@ -138,8 +145,10 @@ void MyModel::Setup (Ptr<NetDevice> device, Address address, uint32_t packetSize
   m_dataRate = dataRate;
   m_running = true;
   m_packetsSent = 0;
+  m_ulSeqNum = 0;
   m_periodicity = period;
   m_deadline = deadline;
+  m_urgency = urgency;
 }
 
 /*
@@ -207,14 +216,14 @@ void MyModel::SendPacketUl ()
 
   // 패킷에 생성 시간 태그 추가
   uint64_t creationTime = Simulator::Now().GetMilliSeconds();
-  PacketCreationTimeTag creationTimeTag(creationTime);
-  pkt->AddPacketTag(creationTimeTag);
   std::cout << "\n 패킷 생성 시간:" << creationTime << "ms" << std::endl;
 
-  // 무작위로 긴급한 패킷인지 여부를 결정
-  uint32_t Urgent = (std::rand() % 8 + 1);  // 긴급도를 1 ~ 8로 결정
-  PacketUrgencyTag urgencyTag(Urgent);
-  pkt->AddPacketTag(urgencyTag);
+  // 시나리오 파일에 긴급도가 없으면 무작위로 긴급한 패킷인지 여부를 결정
+  uint32_t Urgent = m_urgency != 0 ? m_urgency : (std::rand() % 8 + 1);  // 긴급도를 1 ~ 8로 결정
+
+  // 생성 시간, UE id, 긴급도, 순서 번호를 하나의 태그로 추가
+  NrAoiMetadataTag metadataTag (Simulator::Now (), m_device->GetNode ()->GetId (), Urgent, m_ulSeqNum++);
+  pkt->AddPacketTag(metadataTag);
 
   Ipv4Header ipv4Header;
   ipv4Header.SetProtocol(Ipv4L3Protocol::PROT_NUMBER);
@@ -266,9 +275,7 @@ void RxRlcPDU (std::string path, uint16_t rnti, uint8_t lcid, uint32_t bytes, ui
 
   //std::cout<<"\n\n Data received at RLC layer at:"<<Simulator::Now()<<std::endl;
 
-  m_ScenarioFile << "\n\n Data received at RLC layer at:"  << Simulator::Now () << std::endl;
-  m_ScenarioFile << "\n rnti:" << rnti  << std::endl;
-  m_ScenarioFile << "\n delay :" << rlcDelay << std::endl;
+  // 패킷별 지연과 AoI 통계는 NrAoiStatsCalculator가 계산합니다 (NrAoiStats.txt, NrAoiStatsSummary.txt)
 }
 
 void RxPdcpPDU (std::string path, uint16_t rnti, uint8_t lcid, uint32_t bytes, uint64_t pdcpDelay)
@@ -277,6 +284,18 @@ void RxPdcpPDU (std::string path, uint16_t rnti, uint8_t lcid, uint32_t bytes, u
   g_rxPdcpCallbackCalled = true;
 }
 
+/*
+ * UE별 마감 시간을 AoI 통계에 설정합니다. RNTI는 RRC 연결 이후에만 알 수 있습니다.
+ */
+void SetAoiDeadlines (Ptr<NrAoiStatsCalculator> aoiStats, NetDeviceContainer ueNetDev, std::vector<uint32_t> v_deadline)
+{
+  for (uint32_t ii = 0; ii < ueNetDev.GetN (); ++ii)
+  {
+    Ptr<LteUeRrc> rrc = ueNetDev.Get (ii)->GetObject<NrUeNetDevice> ()->GetRrc ();
+    aoiStats->SetDeadline (rrc->GetCellId (), rrc->GetRnti (), MicroSeconds (v_deadline[ii]));
+  }
+}
+
 void ConnectUlPdcpRlcTraces ()
 {
   Config::Connect ("/NodeList/*/DeviceList/*/LteEnbRrc/UeMap/*/DataRadioBearerMap/*/LtePdcp/RxPDU",
@@ -299,6 +318,8 @@ int main (int argc, char *argv[])
   
   uint16_t gNbNum = 1;                      // 기지국 수
   uint16_t ueNumPergNb = 37;                // 단말 수
+  bool profile = false;                     // MAC/PHY 슬롯 파이프라인의 실행 시간 측정 (NrProfiler.txt)
+  std::string scenarioFile = "";            // UE 위치 및 트래픽 속성 바이너리 파일 (FileScenarioHelper::ConvertCsvToBinary)
 
   bool enableUl = true;                     // 상향 트래픽 추적
   uint32_t nPackets = 1000;                 // 패킷 총 개수
@@ -318,8 +339,23 @@ int main (int argc, char *argv[])
   //cmd.AddValue ("packetSize", "packet size in bytes", packetSize);
   cmd.AddValue ("enableUl", "Enable Uplink", enableUl);
   cmd.AddValue ("scheduler", "Scheduler", sch);
+  cmd.AddValue ("scenarioFile", "Binary file with the UE positions and CG traffic attributes", scenarioFile);
+  cmd.AddValue ("profile", "Measure the wall-clock time of the MAC/PHY slot pipeline stages", profile);
   cmd.Parse (argc, argv);
 
+  if (profile)
+  {
+    NrProfiler::Enable ("NrProfiler.txt", Seconds (1));
+  }
+
+  // 시나리오 파일이 주어지면 UE 수, 위치 및 트래픽 속성을 파일에서 읽습니다.
+  FileScenarioHelper fileScenario;
+  if (!scenarioFile.empty ())
+  {
+    fileScenario.AddBinary (scenarioFile);
+    ueNumPergNb = static_cast<uint16_t> (fileScenario.GetUtPositions ().size ());
+  }
+
   /*********************************************************< Age가 넘어가는 경로의 gNB, Scheduler NS3 LOG INFO >******************************************************/
   
   LogComponentEnable("NrGnbMac", LOG_INFO);
@@ -333,6 +369,7 @@ int main (int argc, char *argv[])
   std::vector<uint32_t> v_period(ueNumPergNb);      // 주기적인 전송 간격을 설정하여 각 UE가 상향 링크 패킷을 주기적으로 전송
   std::vector<uint32_t> v_deadline(ueNumPergNb);    // 각 패킷이 전송되어야 하는 마감 시간을 설정하여 패킷이 전송되는 데 필요한 최대 시간
   std::vector<uint32_t> v_packet(ueNumPergNb);      // 각 패킷의 크기를 바이트 단위로 설정
+  std::vector<uint32_t> v_urgency(ueNumPergNb, 0);  // 각 UE의 패킷 긴급도 (0: 무작위)
 
   //std::cout << "\n Init values: " << '\n';
   v_init = std::vector<uint32_t> (ueNumPergNb,{100});           // μs
@@ -345,7 +382,7 @@ int main (int argc, char *argv[])
   //          std::cout << val << std::endl;
 
   std::cout << "Packet values: " << '\n';
-  for (uint8_t i = 0; i < ueNumPergNb; ++i)
+  for (uint32_t i = 0; i < ueNumPergNb; ++i)
   {
     uint32_t randomPacketSize = 10 + (std::rand() % 291);  // 10 ~ 300 바이트 사이의 랜덤 크기
     v_packet[i] = randomPacketSize;
@@ -357,6 +394,28 @@ int main (int argc, char *argv[])
 
   //std::cout << "Period values: " << '\n';
   v_period = std::vector<uint32_t> (ueNumPergNb,{period});
+
+  // 파일에 있는 UE별 속성으로 기본값을 덮어씁니다.
+  if (fileScenario.HasUtTrafficAttributes ())
+  {
+    for (uint32_t i = 0; i < ueNumPergNb; ++i)
+    {
+      const auto &attr = fileScenario.GetUtTrafficAttributes (i);
+      if (attr.m_cgPeriod != 0)
+      {
+        v_period[i] = attr.m_cgPeriod;
+      }
+      if (attr.m_deadline != 0)
+      {
+        v_deadline[i] = attr.m_deadline;
+      }
+      if (attr.m_packetSize != 0)
+      {
+        v_packet[i] = attr.m_packetSize;
+      }
+      v_urgency[i] = attr.m_urgency;
+    }
+  }
   // for (int val : v_period)
   //         std::cout << val << "\t";
 
@@ -396,13 +455,26 @@ int main (int argc, char *argv[])
   mobility.Install(gNBNodes);
 
   // UE 위치 및 이동성 설정
-  mobility.SetPositionAllocator("ns3::RandomBoxPositionAllocator",
-                                "X", StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=10.0]"),
-                                "Y", StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=10.0]"));
-  mobility.SetMobilityModel("ns3::RandomWalk2dMobilityModel",
-                            "Bounds", RectangleValue(Rectangle(0, 100, 0, 100)),
-                            "Speed", StringValue("ns3::UniformRandomVariable[Min=1.0|Max=14.0]"));
-  mobility.Install(ueNodes);
+  if (!scenarioFile.empty ())
+  {
+    // 파일의 UE 위치를 한 번에 할당합니다. (고정 위치)
+    for (uint32_t i = 0; i < ueNodes.GetN (); ++i)
+    {
+      Ptr<ConstantPositionMobilityModel> mob = CreateObject<ConstantPositionMobilityModel> ();
+      mob->SetPosition (fileScenario.GetUtPositions ()[i % ueNumPergNb]);
+      ueNodes.Get (i)->AggregateObject (mob);
+    }
+  }
+  else
+  {
+    mobility.SetPositionAllocator("ns3::RandomBoxPositionAllocator",
+                                  "X", StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=10.0]"),
+                                  "Y", StringValue ("ns3::UniformRandomVariable[Min=0.0|Max=10.0]"));
+    mobility.SetMobilityModel("ns3::RandomWalk2dMobilityModel",
+                              "Bounds", RectangleValue(Rectangle(0, 100, 0, 100)),
+                              "Speed", StringValue("ns3::UniformRandomVariable[Min=1.0|Max=14.0]"));
+    mobility.Install(ueNodes);
+  }
 
 
   Ptr<NrPointToPointEpcHelper> epcHelper = CreateObject<NrPointToPointEpcHelper> ();
@@ -574,10 +646,10 @@ int main (int argc, char *argv[])
   // 상향링크(UL) 트래픽
   std::vector <Ptr<MyModel>> v_modelUl;
   v_modelUl = std::vector<Ptr<MyModel>> (ueNumPergNb,{0});
-  for (uint8_t ii=0; ii<ueNumPergNb; ++ii)
+  for (uint32_t ii=0; ii<ueNumPergNb; ++ii)
   {
     Ptr<MyModel> modelUl = CreateObject<MyModel> ();
-    modelUl -> Setup(ueNetDev.Get(ii), enbNetDev.Get(0)->GetAddress(), v_packet[ii], nPackets, DataRate("1Mbps"),v_period[ii], v_deadline[ii]);
+    modelUl -> Setup(ueNetDev.Get(ii), enbNetDev.Get(0)->GetAddress(), v_packet[ii], nPackets, DataRate("1Mbps"),v_period[ii], v_deadline[ii], v_urgency[ii]);
     v_modelUl[ii] = modelUl;
     Simulator::Schedule(MicroSeconds(v_init[ii]), &StartApplicationUl, v_modelUl[ii]);
   }
@@ -592,7 +664,9 @@ int main (int argc, char *argv[])
   nrHelper->AttachToClosestEnb (ueNetDev, enbNetDev);
 
   nrHelper->EnableTraces();
+  nrHelper->EnableAoiTraces ();
   Simulator::Schedule (Seconds (0.16), &ConnectUlPdcpRlcTraces);
+  Simulator::Schedule (Seconds (0.16), &SetAoiDeadlines, nrHelper->GetAoiStatsCalculator (), ueNetDev, v_deadline);
 
   Simulator::Stop (Seconds (10.0));
    // gNB의 MAC 객체에 대한 포인터를 얻습니다.
@@ -604,6 +678,9 @@ int main (int argc, char *argv[])
 
   std::cout<<"\n FIN. "<<std::endl;
 
+  // AoI 통계 요약은 Simulator::Destroy에서 기록됩니다
+  Simulator::Destroy ();
+
   if (g_rxPdcpCallbackCalled && g_rxRxRlcPDUCallbackCalled)
   {
     return EXIT_SUCCESS;
@@ -612,7 +689,4 @@ int main (int argc, char *argv[])
   {
     return EXIT_FAILURE;
   }
-
-  Simulator::Destroy ();
-
 }
\ No newline at end of file